@@ -1,9 +1,15 @@
+#include <algorithm>
 #include <array>
 #include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
 
 #include <boost/asio/io_context.hpp>
 
 #include <ready_trader_go/logging.h>
+#include <ready_trader_go/trace.h>
 
 #include "autotrader.h"
 
@@ -11,18 +17,118 @@ using namespace ReadyTraderGo;
 
 RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_AT, "AUTO")
 
-constexpr int LOT_SIZE = 10;
 constexpr int POSITION_LIMIT = 100;
-constexpr int TICK_SIZE_IN_CENTS = 100;
-constexpr int MIN_BID_NEARST_TICK = (MINIMUM_BID + TICK_SIZE_IN_CENTS) / TICK_SIZE_IN_CENTS * TICK_SIZE_IN_CENTS;
-constexpr int MAX_ASK_NEAREST_TICK = MAXIMUM_ASK / TICK_SIZE_IN_CENTS * TICK_SIZE_IN_CENTS;
+
+// The mid as the pairs strategy has always taken it: a book with only asks
+// takes the ask, but one with only bids falls through to the average and so
+// takes half the bid.
+static MidPrice midPrice(Price bid, Price ask)
+{
+    if (ask && !bid)
+    {
+        return MidPrice(ask);
+    }
+    return MidPrice(bid, ask);
+}
 
 // Pairs trading - uses standard deviation to make orders
 
-AutoTrader::AutoTrader(boost::asio::io_context& context) : BaseAutoTrader(context)
+AutoTrader::AutoTrader(boost::asio::io_context& context, AutoTraderParameters parameters)
+    : BaseAutoTrader(context), mParameters(parameters), spread_stats(parameters.mWindowSize),
+      mLeastSquares(parameters.mForgettingFactor)
 {
 }
 
+void AutoTrader::SetCheckpointFile(const std::string& filename)
+{
+    mCheckpoint = std::make_unique<Checkpoint<AutoTraderCheckpoint>>(filename, AutoTraderCheckpoint::VERSION);
+    if (!mCheckpoint->Restore(mCheckpointState))
+    {
+        RLOG(LG_AT, LogLevel::LL_INFO) << "no checkpoint in '" << filename << "', starting cold";
+        return;
+    }
+
+    const AutoTraderCheckpoint& state = mCheckpointState;
+    mPosition = state.mPosition;
+    for (std::size_t i = 0; i < state.mAskCount; ++i)
+    {
+        mAsks.emplace(state.mAsks[i]);
+    }
+    for (std::size_t i = 0; i < state.mBidCount; ++i)
+    {
+        mBids.emplace(state.mBids[i]);
+    }
+
+    last_etf_bid_price = state.mLastEtfBidPrice;
+    last_etf_ask_price = state.mLastEtfAskPrice;
+    last_etf_mid_price = midPrice(last_etf_bid_price, last_etf_ask_price);
+    last_future_bid_price = state.mLastFutureBidPrice;
+    last_future_ask_price = state.mLastFutureAskPrice;
+    last_future_mid_price = midPrice(last_future_bid_price, last_future_ask_price);
+    mSpreadDirection = state.mSpreadDirection;
+    mLeastSquares.SetState(state.mLeastSquares);
+    mKalman.SetState(state.mKalman);
+    spread_stats.restore(state.mSpreads.data(), state.mSpreadCount);
+
+    RLOG(LG_AT, LogLevel::LL_INFO) << "restored checkpoint from '" << filename << "': position " << mPosition
+                                   << ", last order " << state.mLastClientOrderId << ", "
+                                   << (state.mAskCount + state.mBidCount) << " live orders, "
+                                   << spread_stats.size() << " spreads with mean " << spread_stats.mean();
+}
+
+void AutoTrader::SetExecutionConnection(std::unique_ptr<IConnection>&& connection)
+{
+    BaseAutoTrader::SetExecutionConnection(std::move(connection));
+    if (!mCheckpoint)
+    {
+        return;
+    }
+
+    if (mCheckpointState.mLastClientOrderId > mExecutionConnection->GetLastClientOrderId())
+    {
+        mExecutionConnection->SetLastClientOrderId(mCheckpointState.mLastClientOrderId);
+    }
+    // Orders left open by the earlier run may or may not still rest on the
+    // exchange; each is forgotten on its order status or error.
+    for (unsigned long clientOrderId: mAsks)
+    {
+        SendCancelOrder(clientOrderId);
+    }
+    for (unsigned long clientOrderId: mBids)
+    {
+        SendCancelOrder(clientOrderId);
+    }
+}
+
+void AutoTrader::SaveCheckpoint()
+{
+    if (!mCheckpoint)
+    {
+        return;
+    }
+
+    AutoTraderCheckpoint& state = mCheckpointState;
+    state.mPosition = mPosition;
+    state.mLastClientOrderId = std::max(state.mLastClientOrderId, mExecutionConnection->GetLastClientOrderId());
+    state.mAskCount = std::min(mAsks.size(), AutoTraderCheckpoint::MAX_ORDERS);
+    std::copy_n(mAsks.begin(), state.mAskCount, state.mAsks.begin());
+    state.mBidCount = std::min(mBids.size(), AutoTraderCheckpoint::MAX_ORDERS);
+    std::copy_n(mBids.begin(), state.mBidCount, state.mBids.begin());
+
+    state.mLastEtfBidPrice = last_etf_bid_price;
+    state.mLastEtfAskPrice = last_etf_ask_price;
+    state.mLastFutureBidPrice = last_future_bid_price;
+    state.mLastFutureAskPrice = last_future_ask_price;
+    state.mSpreadDirection = mSpreadDirection;
+    state.mLeastSquares = mLeastSquares.GetState();
+    state.mKalman = mKalman.GetState();
+
+    state.mSpreadCount = std::min(spread_stats.size(), AutoTraderCheckpoint::MAX_SPREADS);
+    spread_stats.copy_window(state.mSpreads.data(), state.mSpreadCount);
+
+    mCheckpoint->Save(state);
+}
+
 void AutoTrader::DisconnectHandler()
 {
     BaseAutoTrader::DisconnectHandler();
@@ -30,66 +136,125 @@ void AutoTrader::DisconnectHandler()
 }
 
 void AutoTrader::ErrorMessageHandler(unsigned long clientOrderId,
-                                     const std::string& errorMessage)
+                                     ErrorCode errorCode,
+                                     std::string_view errorMessage)
 {
-    RLOG(LG_AT, LogLevel::LL_INFO) << "error with order " << clientOrderId << ": " << errorMessage;
+    RLOG(LG_AT, LogLevel::LL_INFO) << "error " << errorCode << " with order " << clientOrderId << ": "
+                                   << errorMessage;
+    // A refused amend leaves the order as it was; any other error about one
+    // of our orders means the exchange no longer has it.
+    if (errorCode == ErrorCode::AMEND_INCREASES_VOLUME)
+    {
+        return;
+    }
     if (clientOrderId != 0 && ((mAsks.count(clientOrderId) == 1) || (mBids.count(clientOrderId) == 1)))
     {
-        OrderStatusMessageHandler(clientOrderId, 0, 0, 0);
+        OrderStatusMessageHandler(clientOrderId, Volume(), Volume(), 0);
+    }
+}
+
+void AutoTrader::CheckRisk()
+{
+    RTG_TRACE_SPAN("CheckRisk");
+    if (mBidId != 0 && mPosition + (long)mParameters.mLotSize > POSITION_LIMIT)
+    {
+        RLOG(LG_AT, LogLevel::LL_INFO) << "risk check cancelling bid " << mBidId << " at position " << mPosition;
+        SendCancelOrder(mBidId);
+        GetScheduler().Cancel(mBidTimer);
+        mBidId = 0;
+    }
+
+    if (mAskId != 0 && mPosition - (long)mParameters.mLotSize < -POSITION_LIMIT)
+    {
+        RLOG(LG_AT, LogLevel::LL_INFO) << "risk check cancelling ask " << mAskId << " at position " << mPosition;
+        SendCancelOrder(mAskId);
+        GetScheduler().Cancel(mAskTimer);
+        mAskId = 0;
+    }
+}
+
+TimerId AutoTrader::ScheduleExpiry(unsigned long clientOrderId)
+{
+    if (mParameters.mOrderLifetime <= 0.0)
+    {
+        return NO_TIMER;
     }
+    return GetScheduler().ScheduleAfter(
+        static_cast<std::uint64_t>(mParameters.mOrderLifetime * NANOSECONDS_PER_SECOND),
+        [this, clientOrderId] { ExpireOrder(clientOrderId); });
+}
+
+void AutoTrader::ExpireOrder(unsigned long clientOrderId)
+{
+    RTG_TRACE_SPAN("ExpireOrder");
+    if (mAsks.count(clientOrderId) == 0 && mBids.count(clientOrderId) == 0)
+    {
+        return;
+    }
+
+    RLOG(LG_AT, LogLevel::LL_INFO) << "order " << clientOrderId << " expired";
+    SendCancelOrder(clientOrderId);
+    if (clientOrderId == mAskId)
+    {
+        mAskId = 0;
+    }
+    else if (clientOrderId == mBidId)
+    {
+        mBidId = 0;
+    }
+}
+
+bool AutoTrader::ShouldReprice(unsigned long clientOrderId) const
+{
+    return mParameters.mRequeueFillProbability <= 0.0
+        || mQueuePositions.GetFillProbability(clientOrderId) < mParameters.mRequeueFillProbability;
 }
 
 void AutoTrader::HedgeFilledMessageHandler(unsigned long clientOrderId,
-                                           unsigned long price,
-                                           unsigned long volume)
+                                           Price price,
+                                           Volume volume)
 {
     RLOG(LG_AT, LogLevel::LL_INFO) << "hedge order " << clientOrderId << " filled for " << volume
                                    << " lots at $" << price << " average price in cents";
 }
 
-double AutoTrader::UpdateSpreadInfo(Instrument instrument, unsigned long bid_price, unsigned long ask_price ) { 
+double AutoTrader::UpdateSpreadInfo(Instrument instrument, Price bid_price, Price ask_price ) { 
+    RTG_TRACE_SPAN("UpdateSpreadInfo");
 
     if ( instrument == Instrument::FUTURE ) { 
         last_future_bid_price = bid_price;
         last_future_ask_price = ask_price;
-
-        if ( last_future_ask_price == 0 && last_future_bid_price != 0 ) { 
-            last_future_mid_price = last_future_bid_price;           
-        }
-
-        if ( last_future_ask_price != 0 && last_future_bid_price == 0 ) { 
-            last_future_mid_price = last_future_ask_price;           
-        }
-
-        else { 
-            last_future_mid_price = (last_future_ask_price + last_future_bid_price) / 2;
-        }
+        last_future_mid_price = midPrice(last_future_bid_price, last_future_ask_price);
     }
 
     if ( instrument == Instrument::ETF ) { 
         last_etf_bid_price = bid_price;
         last_etf_ask_price = ask_price;
+        last_etf_mid_price = midPrice(last_etf_bid_price, last_etf_ask_price);
+        RLOG(LG_AT, LogLevel::LL_DEBUG) << "Spread Info Updated - last future mid price: " << last_future_mid_price << "; last etf mid price:" << last_etf_mid_price;
+    }
 
-        if ( last_etf_ask_price == 0 && last_etf_bid_price != 0 ) { 
-            last_etf_mid_price = last_etf_bid_price;           
-        }
+    double standard_dev = 0;
 
-        if ( last_etf_ask_price != 0 && last_etf_bid_price == 0 ) { 
-            last_etf_mid_price = last_etf_ask_price;           
+    if (mParameters.mSpreadModel != SpreadModel::FIXED) {
+        if (!last_future_mid_price || !last_etf_mid_price) {
+            return 0;
         }
 
-        else { 
-            last_etf_mid_price = (last_etf_ask_price + last_etf_bid_price) / 2;
-        }
-        RLOG(LG_AT, LogLevel::LL_INFO) << "Spread Info Updated - last future mid price: " << last_future_mid_price << "; last etf mid price:" << last_etf_mid_price;
+        const double future = last_future_mid_price.ToDouble();
+        const double etf = last_etf_mid_price.ToDouble();
+        const HedgeRatioEstimate& estimate = (mParameters.mSpreadModel == SpreadModel::KALMAN)
+            ? mKalman.Update(future, etf)
+            : mLeastSquares.Update(future, etf);
+        mSpreadDirection = estimate.mResidual;
+        return std::abs(estimate.mZScore);
     }
 
-    double standard_dev = 0;
+    mSpreadDirection = last_etf_mid_price.ToDouble() - last_future_mid_price.ToDouble();
 
-    if (last_future_mid_price != 0 && last_etf_bid_price != 0) { 
+    if (last_future_mid_price && last_etf_bid_price) { 
 
-        double spread = last_future_mid_price > last_etf_mid_price ? 
-        static_cast<double>( (last_future_mid_price - last_etf_mid_price)) : static_cast<double>((last_etf_mid_price - last_future_mid_price));
+        const double spread = static_cast<double>(std::labs(last_etf_mid_price - last_future_mid_price));
 
         double std_gang = spread_stats.std_hard_moded();
         if ( std_gang != 0  ) { 
@@ -105,102 +270,142 @@ double AutoTrader::UpdateSpreadInfo(Instrument instrument, unsigned long bid_pri
 
 void AutoTrader::OrderBookMessageHandler(Instrument instrument,
                                          unsigned long sequenceNumber,
-                                         const std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
-                                         const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
-                                         const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
-                                         const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes)
+                                         const PriceLevels& askPrices,
+                                         const VolumeLevels& askVolumes,
+                                         const PriceLevels& bidPrices,
+                                         const VolumeLevels& bidVolumes)
 {
     
+    if (mRiskTimer == NO_TIMER && mParameters.mRiskCheckInterval > 0.0)
+    {
+        mRiskTimer = GetScheduler().ScheduleEvery(
+            static_cast<std::uint64_t>(mParameters.mRiskCheckInterval * NANOSECONDS_PER_SECOND),
+            [this] { CheckRisk(); });
+    }
+
+    if (instrument == Instrument::ETF)
+    {
+        mQueuePositions.OnOrderBook(askPrices, askVolumes, bidPrices, bidVolumes);
+    }
+
+    mTrades[static_cast<std::size_t>(instrument)].Advance(GetClock().Now());
+
     double standard_dev = UpdateSpreadInfo(instrument, bidPrices[0], askPrices[0]);
 
-    RLOG(LG_AT, LogLevel::LL_INFO) << "order book received for " << instrument << " instrument"
-                                   << ": ask prices: " << askPrices[0]
-                                   << "; ask volumes: " << askVolumes[0]
-                                   << "; bid prices: " << bidPrices[0]
-                                   << "; bid volumes: " << bidVolumes[0]
-                                   << "; standard_dev: " << std::to_string(standard_dev);
+    RLOG(LG_AT, LogLevel::LL_DEBUG) << "order book received for " << instrument << " instrument"
+                                    << ": ask prices: " << askPrices[0]
+                                    << "; ask volumes: " << askVolumes[0]
+                                    << "; bid prices: " << bidPrices[0]
+                                    << "; bid volumes: " << bidVolumes[0]
+                                    << "; standard_dev: " << standard_dev;
 
-    if (mAskId != 0 && askPrices[0] != 0 && askPrices[0] != mAskPrice) {
+    if (mAskId != 0 && askPrices[0] && askPrices[0] != mAskPrice && ShouldReprice(mAskId)) {
         SendCancelOrder(mAskId);
+        GetScheduler().Cancel(mAskTimer);
         mAskId = 0;
     }
 
-    if (mBidId != 0 && bidPrices[0] != 0 && bidPrices[0] != mBidPrice) {
+    if (mBidId != 0 && bidPrices[0] && bidPrices[0] != mBidPrice && ShouldReprice(mBidId)) {
         SendCancelOrder(mBidId);
+        GetScheduler().Cancel(mBidTimer);
         mBidId = 0;
     }
 
 
-    if ( standard_dev > 1 ) { 
-        if ( last_future_mid_price > last_etf_mid_price && mPosition < POSITION_LIMIT ) { 
-            mBidId = mNextMessageId++;
-            mBidPrice = bidPrices[0]+TICK_SIZE_IN_CENTS;
-            SendInsertOrder(mBidId, Side::BUY, bidPrices[0]+TICK_SIZE_IN_CENTS, LOT_SIZE, Lifespan::GOOD_FOR_DAY);
+    if ( standard_dev > mParameters.mThreshold ) { 
+        RTG_TRACE_SPAN("quote");
+        if ( mSpreadDirection < 0 && mPosition < POSITION_LIMIT ) { 
+            mBidId = NextClientOrderId();
+            mBidPrice = bidPrices[0] + Ticks(1);
+            SendInsertOrder(mBidId, Side::BUY, mBidPrice, Volume(mParameters.mLotSize), Lifespan::GOOD_FOR_DAY);
             mBids.emplace(mBidId);
+            mQueuePositions.OnInsert(mBidId, Side::BUY, mBidPrice, Volume(mParameters.mLotSize));
+            mBidTimer = ScheduleExpiry(mBidId);
         }
 
-        if ( last_future_mid_price < last_etf_mid_price && mPosition > -POSITION_LIMIT ) { 
+        if ( mSpreadDirection > 0 && mPosition > -POSITION_LIMIT ) { 
 
-            mAskId = mNextMessageId++;
-            mAskPrice = askPrices[0]-TICK_SIZE_IN_CENTS;
-            SendInsertOrder(mAskId, Side::SELL, askPrices[0]-TICK_SIZE_IN_CENTS, LOT_SIZE, Lifespan::GOOD_FOR_DAY);
+            mAskId = NextClientOrderId();
+            mAskPrice = askPrices[0] - Ticks(1);
+            SendInsertOrder(mAskId, Side::SELL, mAskPrice, Volume(mParameters.mLotSize), Lifespan::GOOD_FOR_DAY);
             mAsks.emplace(mAskId);
+            mQueuePositions.OnInsert(mAskId, Side::SELL, mAskPrice, Volume(mParameters.mLotSize));
+            mAskTimer = ScheduleExpiry(mAskId);
         }  
     }
+
+    SaveCheckpoint();
 }
 
 
 void AutoTrader::OrderFilledMessageHandler(unsigned long clientOrderId,
-                                           unsigned long price,
-                                           unsigned long volume)
+                                           Price price,
+                                           Volume volume)
 {
     RLOG(LG_AT, LogLevel::LL_INFO) << "order " << clientOrderId << " filled for " << volume
                                    << " lots at $" << price << " cents";
+    mQueuePositions.OnFill(clientOrderId, volume);
     if (mAsks.count(clientOrderId) == 1)
     {
-        mPosition -= (long)volume;
-        SendHedgeOrder(mNextMessageId++, Side::BUY, MAX_ASK_NEAREST_TICK, volume);
+        mPosition -= (long)volume.Lots();
+        SendHedgeOrder(NextClientOrderId(), Side::BUY, MAXIMUM_ASK_TICK, volume);
     }
     else if (mBids.count(clientOrderId) == 1)
     {
-        mPosition += (long)volume;
-        SendHedgeOrder(mNextMessageId++, Side::SELL, MIN_BID_NEARST_TICK, volume);
+        mPosition += (long)volume.Lots();
+        SendHedgeOrder(NextClientOrderId(), Side::SELL, MINIMUM_BID_TICK, volume);
     }
+    SaveCheckpoint();
 }
 
 void AutoTrader::OrderStatusMessageHandler(unsigned long clientOrderId,
-                                           unsigned long fillVolume,
-                                           unsigned long remainingVolume,
+                                           Volume fillVolume,
+                                           Volume remainingVolume,
                                            signed long fees)
 {
 
-    RLOG(LG_AT, LogLevel::LL_INFO) << "OrderStatusMessageHandler called";
-    if (remainingVolume == 0)
+    RLOG(LG_AT, LogLevel::LL_DEBUG) << "OrderStatusMessageHandler called";
+    if (!remainingVolume)
     {
         if (clientOrderId == mAskId)
         {
+            GetScheduler().Cancel(mAskTimer);
             mAskId = 0;
         }
         else if (clientOrderId == mBidId)
         {
+            GetScheduler().Cancel(mBidTimer);
             mBidId = 0;
         }
 
         mAsks.erase(clientOrderId);
         mBids.erase(clientOrderId);
+        mQueuePositions.OnRemove(clientOrderId);
+        SaveCheckpoint();
     }
 }
 
 void AutoTrader::TradeTicksMessageHandler(Instrument instrument,
                                           unsigned long sequenceNumber,
-                                          const std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
-                                          const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
-                                          const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
-                                          const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes)
-{
-    RLOG(LG_AT, LogLevel::LL_INFO) << "trade ticks received for " << instrument << " instrument"
-                                   << ": ask prices: " << askPrices[0]
-                                   << "; ask volumes: " << askVolumes[0]
-                                   << "; bid prices: " << bidPrices[0]
-                                   << "; bid volumes: " << bidVolumes[0];
+                                          const PriceLevels& askPrices,
+                                          const VolumeLevels& askVolumes,
+                                          const PriceLevels& bidPrices,
+                                          const VolumeLevels& bidVolumes)
+{
+    TradeAggregator& trades = mTrades[static_cast<std::size_t>(instrument)];
+    trades.OnTradeTicks(GetClock().Now(), askPrices, askVolumes, bidPrices, bidVolumes);
+
+    const TradeWindow& window = trades.GetSnapshot().mWindows[0];
+    RLOG(LG_AT, LogLevel::LL_DEBUG) << "trade ticks received for " << instrument << " instrument"
+                                    << ": ask prices: " << askPrices[0]
+                                    << "; ask volumes: " << askVolumes[0]
+                                    << "; bid prices: " << bidPrices[0]
+                                    << "; bid volumes: " << bidVolumes[0]
+                                    << "; vwap: " << window.mVwap
+                                    << "; buy/sell volume: " << window.mBuyVolume << '/' << window.mSellVolume;
+
+    if (instrument == Instrument::ETF)
+    {
+        mQueuePositions.OnTradeTicks(askPrices, askVolumes, bidPrices, bidVolumes);
+    }
 }
@@ -21,12 +21,17 @@
 #include <array>
 #include <memory>
 #include <string>
-#include <unordered_set>
+#include <string_view>
+#include <algorithm>
 #include <boost/asio/io_context.hpp>
 #include <ready_trader_go/baseautotrader.h>
+#include <ready_trader_go/checkpoint.h>
+#include <ready_trader_go/hedgeratio.h>
+#include <ready_trader_go/queueposition.h>
+#include <ready_trader_go/tradeaggregator.h>
 #include <ready_trader_go/types.h>
 #include <cmath>
-#include <deque>
+#include <vector>
 
 
 
@@ -35,6 +40,8 @@
 class RunningStats { 
 public:
 
+    explicit RunningStats(size_t window = 100) : n(window) { data.reserve(n); }
+
     void push(unsigned long num) {
 
         if ( data.size() < n ) { 
@@ -45,11 +52,12 @@ public:
         }
 
         else {
-            double front = data.front();
-            data.pop_front();
-            data.push_back(num);
+            // The window is a ring once full, so pushing never allocates.
+            double front = data[oldest];
+            data[oldest] = num;
+            oldest = (oldest + 1) % n;
 
-            new_m = (num + old_m*n - front)/100;
+            new_m = (num + old_m*n - front)/n;
             new_s = old_s + (num - old_m)*(num - new_m) - (front - old_m)*(front - new_m) ;
         }
 
@@ -59,7 +67,8 @@ public:
 
     double std_hard_moded() {
         double sum = 0; 
-        for (double d : data) { 
+        for (size_t i = 0; i < data.size(); ++i) { 
+            double d = data[(oldest + i) % data.size()];
             sum += pow((d - new_m),2);
         }
 
@@ -80,9 +89,34 @@ public:
         return sqrt(variance());
     }
 
+    size_t size() const {
+        return data.size();
+    }
+
+    // Copies the newest count values of the window (at most its size) into
+    // out, oldest first.
+    void copy_window(double* out, size_t count) const {
+        const size_t skip = data.size() - count;
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = data[(oldest + skip + i) % data.size()];
+        }
+    }
+
+    // Starts again from a window copied out earlier, keeping its newest
+    // values if it is longer than this one's.
+    void restore(const double* window, size_t count) {
+        data.clear();
+        oldest = 0;
+        old_m = new_m = old_s = new_s = 0;
+        for (size_t i = 0; i < count; ++i) {
+            push(static_cast<unsigned long>(window[i]));
+        }
+    }
+
 private:
 
-    std::deque<double> data;
+    std::vector<double> data;
+    size_t oldest = 0;
 
     size_t n = 100;
 
@@ -95,10 +129,130 @@ private:
 };
 
 
+// The ids of live orders on one side, kept in preallocated storage so that
+// adding and removing them never allocates.
+class OrderIdSet
+{
+public:
+    explicit OrderIdSet(std::size_t capacity = 64) { mIds.reserve(capacity); }
+
+    std::size_t count(unsigned long id) const
+    {
+        return (std::find(mIds.begin(), mIds.end(), id) != mIds.end()) ? 1 : 0;
+    }
+
+    void emplace(unsigned long id)
+    {
+        if (count(id) == 0)
+        {
+            mIds.push_back(id);
+        }
+    }
+
+    void erase(unsigned long id)
+    {
+        auto it = std::find(mIds.begin(), mIds.end(), id);
+        if (it != mIds.end())
+        {
+            *it = mIds.back();
+            mIds.pop_back();
+        }
+    }
+
+    std::size_t size() const { return mIds.size(); }
+    std::vector<unsigned long>::const_iterator begin() const { return mIds.begin(); }
+    std::vector<unsigned long>::const_iterator end() const { return mIds.end(); }
+
+private:
+    std::vector<unsigned long> mIds;
+};
+
+
+// How the spread between the ETF and the future is measured.
+enum class SpreadModel
+{
+    // The difference of the mid prices, i.e. a hedge ratio of one, scored
+    // against the statistics of the last few spreads.
+    FIXED,
+    // The residual of the ETF regressed on the future by recursive least
+    // squares, in standard deviations.
+    RECURSIVE_LEAST_SQUARES,
+    // As above, but regressed by a Kalman filter.
+    KALMAN
+};
+
+// Tunable settings for the strategy. The defaults are the values used in
+// competition.
+struct AutoTraderParameters
+{
+    // Volume of each order.
+    unsigned long mLotSize = 10;
+    // Number of standard deviations the spread must move before trading.
+    double mThreshold = 1.0;
+    // Number of spreads kept for the running statistics.
+    size_t mWindowSize = 100;
+    // Seconds a good-for-day order may rest before it is cancelled. Zero
+    // leaves orders resting until the touch moves.
+    double mOrderLifetime = 0.0;
+    // Seconds between checks that cancel any resting order which, if
+    // filled, would take the position past the limit. Zero disables them.
+    double mRiskCheckInterval = 0.0;
+    SpreadModel mSpreadModel = SpreadModel::FIXED;
+    // For recursive least squares, the weight of each pair relative to the
+    // next.
+    double mForgettingFactor = 0.999;
+    // A resting order whose estimated chance of filling is at least this is
+    // kept, rather than cancelled, when the touch moves away from it. Zero
+    // cancels every such order.
+    double mRequeueFillProbability = 0.0;
+};
+
+
+// The strategy's state as kept in its checkpoint file; VERSION must change
+// whenever the members or their units do. Timers and queue positions are not
+// kept: orders left open by an earlier run are cancelled once connected again.
+struct AutoTraderCheckpoint
+{
+    static constexpr std::uint32_t VERSION = 2;
+    static constexpr std::size_t MAX_ORDERS = 32;
+    static constexpr std::size_t MAX_SPREADS = 256;
+
+    signed long mPosition;
+    unsigned long mLastClientOrderId;
+
+    // Live orders on each side.
+    std::size_t mAskCount;
+    std::array<unsigned long, MAX_ORDERS> mAsks;
+    std::size_t mBidCount;
+    std::array<unsigned long, MAX_ORDERS> mBids;
+
+    ReadyTraderGo::Price mLastEtfBidPrice;
+    ReadyTraderGo::Price mLastEtfAskPrice;
+    ReadyTraderGo::Price mLastFutureBidPrice;
+    ReadyTraderGo::Price mLastFutureAskPrice;
+    double mSpreadDirection;
+    ReadyTraderGo::HedgeRatioState mLeastSquares;
+    ReadyTraderGo::HedgeRatioState mKalman;
+
+    // The running statistics' window, oldest first; only the newest spreads
+    // are kept if it is longer.
+    std::size_t mSpreadCount;
+    std::array<double, MAX_SPREADS> mSpreads;
+};
+
+
 class AutoTrader : public ReadyTraderGo::BaseAutoTrader
 {
 public:
-    explicit AutoTrader(boost::asio::io_context& context);
+    explicit AutoTrader(boost::asio::io_context& context, AutoTraderParameters parameters = {});
+
+    // Restores the state kept in the file, if any, and then keeps it there
+    // after every change.
+    void SetCheckpointFile(const std::string& filename) override;
+
+    // Once logged in, carries on the client order ids of a restored state
+    // and cancels the orders it had open.
+    void SetExecutionConnection(std::unique_ptr<ReadyTraderGo::IConnection>&& connection) override;
 
     // Called when the execution connection is lost.
     void DisconnectHandler() override;
@@ -106,8 +260,10 @@ public:
     // Called when the matching engine detects an error.
     // If the error pertains to a particular order, then the client_order_id
     // will identify that order, otherwise the client_order_id will be zero.
+    // Known errors have a code other than UNKNOWN.
     void ErrorMessageHandler(unsigned long clientOrderId,
-                             const std::string& errorMessage) override;
+                             ReadyTraderGo::ErrorCode errorCode,
+                             std::string_view errorMessage) override;
 
     // Called when one of your hedge orders is filled, partially or fully.
     //
@@ -117,8 +273,8 @@ public:
     //
     // If the order was unsuccessful, both the price and volume will be zero.
     void HedgeFilledMessageHandler(unsigned long clientOrderId,
-                                   unsigned long price,
-                                   unsigned long volume) override;
+                                   ReadyTraderGo::Price price,
+                                   ReadyTraderGo::Volume volume) override;
 
     // Called periodically to report the status of an order book.
     // The sequence number can be used to detect missed or out-of-order
@@ -127,15 +283,15 @@ public:
     // price levels.
     void OrderBookMessageHandler(ReadyTraderGo::Instrument instrument,
                                  unsigned long sequenceNumber,
-                                 const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& askPrices,
-                                 const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& askVolumes,
-                                 const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& bidPrices,
-                                 const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& bidVolumes) override;
+                                 const ReadyTraderGo::PriceLevels& askPrices,
+                                 const ReadyTraderGo::VolumeLevels& askVolumes,
+                                 const ReadyTraderGo::PriceLevels& bidPrices,
+                                 const ReadyTraderGo::VolumeLevels& bidVolumes) override;
 
     // Called when one of your orders is filled, partially or fully.
     void OrderFilledMessageHandler(unsigned long clientOrderId,
-                                   unsigned long price,
-                                   unsigned long volume) override;
+                                   ReadyTraderGo::Price price,
+                                   ReadyTraderGo::Volume volume) override;
 
     // Called when the status of one of your orders changes.
     // The fill volume is the number of lots already traded, remaining volume
@@ -143,8 +299,8 @@ public:
     // or received for this order.
     // Remaining volume will be set to zero if the order is cancelled.
     void OrderStatusMessageHandler(unsigned long clientOrderId,
-                                   unsigned long fillVolume,
-                                   unsigned long remainingVolume,
+                                   ReadyTraderGo::Volume fillVolume,
+                                   ReadyTraderGo::Volume remainingVolume,
                                    signed long fees) override;
 
     // Called periodically when there is trading activity on the market.
@@ -155,46 +311,77 @@ public:
     // the end of both the prices and volumes arrays.
     void TradeTicksMessageHandler(ReadyTraderGo::Instrument instrument,
                                   unsigned long sequenceNumber,
-                                  const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& askPrices,
-                                  const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& askVolumes,
-                                  const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& bidPrices,
-                                  const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& bidVolumes) override;
+                                  const ReadyTraderGo::PriceLevels& askPrices,
+                                  const ReadyTraderGo::VolumeLevels& askVolumes,
+                                  const ReadyTraderGo::PriceLevels& bidPrices,
+                                  const ReadyTraderGo::VolumeLevels& bidVolumes) override;
 
 
 
     // Updates the spread info - e.g. last future bid price, last future ask price, mid price, etc, returns std of current spread 
-    double UpdateSpreadInfo(ReadyTraderGo::Instrument instrument, unsigned long bid_price, unsigned long ask_price );
+    double UpdateSpreadInfo(ReadyTraderGo::Instrument instrument, ReadyTraderGo::Price bid_price, ReadyTraderGo::Price ask_price );
+
+    // Cancels any resting order that could take the position past the limit.
+    void CheckRisk();
+
+    // Cancels an order whose lifetime has expired, if it is still live.
+    void ExpireOrder(unsigned long clientOrderId);
+
+    // Schedules the expiry of a newly inserted order, if orders expire.
+    ReadyTraderGo::TimerId ScheduleExpiry(unsigned long clientOrderId);
+
+    // True if a resting order should be cancelled now that the touch has
+    // moved away from it.
+    bool ShouldReprice(unsigned long clientOrderId) const;
 
 
 private:
-    unsigned long mNextMessageId = 1;
+    AutoTraderParameters mParameters;
+
     unsigned long mAskId = 0;
-    unsigned long mAskPrice = 0;
+    ReadyTraderGo::Price mAskPrice;
     unsigned long mBidId = 0;
-    unsigned long mBidPrice = 0;
+    ReadyTraderGo::Price mBidPrice;
     signed long mPosition = 0;
 
+    ReadyTraderGo::TimerId mAskTimer = ReadyTraderGo::NO_TIMER;
+    ReadyTraderGo::TimerId mBidTimer = ReadyTraderGo::NO_TIMER;
+    ReadyTraderGo::TimerId mRiskTimer = ReadyTraderGo::NO_TIMER;
+
 
 
-    std::unordered_set<unsigned long> mAsks;
-    std::unordered_set<unsigned long> mBids;
+    OrderIdSet mAsks;
+    OrderIdSet mBids;
+    ReadyTraderGo::QueuePositionEstimator mQueuePositions;
+    // Indexed by instrument.
+    std::array<ReadyTraderGo::TradeAggregator, 2> mTrades;
 
-    // Holds order ID as well as 
-    // std::priority_queue<std::tuple<unsigned long, /*time data*/ > order_ids_x_time; 
 
-    unsigned long last_etf_mid_price = 0;
-    unsigned long last_etf_bid_price = 0;
-    unsigned long last_etf_ask_price = 0;
+    ReadyTraderGo::MidPrice last_etf_mid_price;
+    ReadyTraderGo::Price last_etf_bid_price;
+    ReadyTraderGo::Price last_etf_ask_price;
 
-    unsigned long last_future_mid_price = 0;
-    unsigned long last_future_bid_price = 0; 
-    unsigned long last_future_ask_price = 0;
+    ReadyTraderGo::MidPrice last_future_mid_price;
+    ReadyTraderGo::Price last_future_bid_price; 
+    ReadyTraderGo::Price last_future_ask_price;
 
-    unsigned long last_spread = 0;
     RunningStats spread_stats;
 
+    ReadyTraderGo::RecursiveLeastSquares mLeastSquares;
+    ReadyTraderGo::KalmanHedgeRatio mKalman;
+    // Positive when the ETF is rich relative to the future, negative when it
+    // is cheap.
+    double mSpreadDirection = 0.0;
+
+
+    std::unique_ptr<ReadyTraderGo::Checkpoint<AutoTraderCheckpoint>> mCheckpoint;
+    AutoTraderCheckpoint mCheckpointState{};
+
 
     // Helper methods
     // bool CanPlaceOrders() { }
+
+    // Copies the state into the checkpoint file, if there is one.
+    void SaveCheckpoint();
 };
 #endif //CPPREADY_TRADER_GO_AUTOTRADER_H
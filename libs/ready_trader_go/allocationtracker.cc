@@ -0,0 +1,392 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#ifdef RTG_ALLOCATION_TRACKING
+#include <cxxabi.h>
+#include <execinfo.h>
+#include <unistd.h>
+#endif
+
+#include "allocationtracker.h"
+
+#ifdef RTG_ALLOCATION_TRACKING
+
+// glibc's own allocator, which the interposed functions below forward to.
+extern "C" void* __libc_malloc(std::size_t size);
+extern "C" void* __libc_calloc(std::size_t count, std::size_t size);
+extern "C" void* __libc_realloc(void* pointer, std::size_t size);
+extern "C" void* __libc_memalign(std::size_t alignment, std::size_t size);
+extern "C" void __libc_free(void* pointer);
+
+namespace ReadyTraderGo {
+
+namespace {
+
+constexpr std::size_t CALL_SITE_CAPACITY = 256; // a power of two
+constexpr int CALL_SITE_DEPTH = 16;
+constexpr int CALL_SITE_SKIP = 2; // recordViolation and the interposed function
+
+struct CallSite
+{
+    std::uint64_t mHash;
+    std::uint64_t mCount;
+    std::uint64_t mBytes;
+    int mDepth;
+    void* mFrames[CALL_SITE_DEPTH];
+};
+
+// Constant-initialised so that reaching it never allocates or runs a
+// constructor, even from inside malloc.
+struct ThreadState
+{
+    AllocationCounters mCounters;
+    bool mTrading;
+    bool mInHook;
+};
+
+__attribute__((tls_model("initial-exec"))) thread_local ThreadState tState{};
+
+// Only the trading thread writes these (other than at start and stop).
+AllocationPolicy gPolicy = AllocationPolicy::REPORT;
+AllocationCounters gStartCounters;
+AllocationCounters gStopCounters;
+std::atomic<bool> gTrading{false};
+std::uint64_t gTradingAllocations = 0;
+std::uint64_t gUnrecordedAllocations = 0;
+CallSite gCallSites[CALL_SITE_CAPACITY];
+
+void writeError(const char* text)
+{
+    [[maybe_unused]] auto result = ::write(STDERR_FILENO, text, std::strlen(text));
+}
+
+void __attribute__((noinline)) recordViolation(std::size_t size)
+{
+    void* frames[CALL_SITE_DEPTH + CALL_SITE_SKIP];
+    const int depth = ::backtrace(frames, CALL_SITE_DEPTH + CALL_SITE_SKIP) - CALL_SITE_SKIP;
+    void** const caller = frames + CALL_SITE_SKIP;
+
+    if (gPolicy == AllocationPolicy::ABORT)
+    {
+        writeError("allocation on the trading thread after trading started:\n");
+        ::backtrace_symbols_fd(caller, std::max(depth, 0), STDERR_FILENO);
+        std::abort();
+    }
+
+    ++gTradingAllocations;
+
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (int i = 0; i < depth; ++i)
+    {
+        hash = (hash ^ reinterpret_cast<std::uintptr_t>(caller[i])) * 1099511628211ULL;
+    }
+    hash |= 1; // zero marks an empty slot
+
+    for (std::size_t probe = 0; probe < CALL_SITE_CAPACITY; ++probe)
+    {
+        CallSite& site = gCallSites[(hash + probe) & (CALL_SITE_CAPACITY - 1)];
+        if (site.mHash == 0)
+        {
+            site.mHash = hash;
+            site.mDepth = std::max(depth, 0);
+            std::memcpy(site.mFrames, caller, site.mDepth * sizeof(void*));
+        }
+        if (site.mHash == hash)
+        {
+            ++site.mCount;
+            site.mBytes += size;
+            return;
+        }
+    }
+    ++gUnrecordedAllocations;
+}
+
+inline __attribute__((always_inline)) void countAllocation(std::size_t size)
+{
+    ThreadState& state = tState;
+    ++state.mCounters.mAllocations;
+    state.mCounters.mBytes += size;
+    if (state.mTrading && !state.mInHook)
+    {
+        state.mInHook = true;
+        recordViolation(size);
+        state.mInHook = false;
+    }
+}
+
+inline __attribute__((always_inline)) void countDeallocation(void* pointer)
+{
+    if (pointer)
+    {
+        ++tState.mCounters.mDeallocations;
+    }
+}
+
+inline __attribute__((always_inline)) void* allocate(std::size_t size)
+{
+    countAllocation(size);
+    return __libc_malloc(size ? size : 1);
+}
+
+inline __attribute__((always_inline)) void* allocateAligned(std::size_t size, std::align_val_t alignment)
+{
+    countAllocation(size);
+    return __libc_memalign(static_cast<std::size_t>(alignment), size ? size : 1);
+}
+
+inline __attribute__((always_inline)) void deallocate(void* pointer)
+{
+    countDeallocation(pointer);
+    __libc_free(pointer);
+}
+
+std::string describeFrame(const char* symbol)
+{
+    // backtrace_symbols gives "module(mangled+offset) [address]".
+    std::string text{symbol};
+    const auto open = text.find('(');
+    const auto plus = text.find('+', open);
+    if (open == std::string::npos || plus == std::string::npos || plus == open + 1)
+    {
+        return text;
+    }
+
+    int status = 0;
+    const std::string mangled = text.substr(open + 1, plus - open - 1);
+    char* demangled = abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status);
+    if (status == 0 && demangled)
+    {
+        text = std::string(demangled) + " (" + text.substr(0, open) + ")";
+    }
+    std::free(demangled);
+    return text;
+}
+
+}
+
+AllocationCounters getThreadAllocationCounters()
+{
+    return tState.mCounters;
+}
+
+void markTradingStarted(AllocationPolicy policy)
+{
+    // The first backtrace loads the unwinder, which allocates.
+    void* frames[1];
+    ::backtrace(frames, 1);
+
+    gPolicy = policy;
+    gStartCounters = tState.mCounters;
+    tState.mTrading = true;
+    gTrading.store(true, std::memory_order_release);
+}
+
+void markTradingStopped()
+{
+    if (tState.mTrading)
+    {
+        tState.mTrading = false;
+        gStopCounters = tState.mCounters;
+        gTrading.store(false, std::memory_order_release);
+    }
+}
+
+std::uint64_t getTradingAllocationCount()
+{
+    return gTradingAllocations;
+}
+
+void writeAllocationReport(std::ostream& out, const char* filter)
+{
+    const AllocationCounters& stop = gTrading.load(std::memory_order_acquire) ? tState.mCounters : gStopCounters;
+    out << "trading thread allocations while trading: " << stop.mAllocations - gStartCounters.mAllocations
+        << " (" << stop.mBytes - gStartCounters.mBytes << " bytes), deallocations: "
+        << stop.mDeallocations - gStartCounters.mDeallocations << '\n';
+
+    std::vector<const CallSite*> sites;
+    for (const auto& site: gCallSites)
+    {
+        if (site.mHash != 0)
+        {
+            sites.push_back(&site);
+        }
+    }
+    std::sort(sites.begin(), sites.end(), [](auto* a, auto* b) { return a->mCount > b->mCount; });
+
+    std::uint64_t filteredCount = 0;
+    std::size_t filteredSites = 0;
+    for (const CallSite* site: sites)
+    {
+        std::vector<std::string> frames;
+        char** symbols = ::backtrace_symbols(site->mFrames, site->mDepth);
+        for (int i = 0; symbols && i < site->mDepth; ++i)
+        {
+            frames.push_back(describeFrame(symbols[i]));
+        }
+        std::free(symbols);
+
+        if (filter && std::none_of(frames.begin(), frames.end(), [filter](const std::string& frame) {
+            return frame.find(filter) != std::string::npos;
+        }))
+        {
+            filteredCount += site->mCount;
+            ++filteredSites;
+            continue;
+        }
+
+        out << site->mCount << " allocations (" << site->mBytes << " bytes) from:\n";
+        for (const auto& frame: frames)
+        {
+            out << "    " << frame << '\n';
+        }
+    }
+    if (filteredSites != 0)
+    {
+        out << filteredCount << " allocations from " << filteredSites << " call sites without '" << filter
+            << "' in their stacks\n";
+    }
+    if (gUnrecordedAllocations != 0)
+    {
+        out << gUnrecordedAllocations << " allocations from call sites beyond the first " << CALL_SITE_CAPACITY
+            << '\n';
+    }
+}
+
+}
+
+using ReadyTraderGo::allocate;
+using ReadyTraderGo::allocateAligned;
+using ReadyTraderGo::deallocate;
+
+void* operator new(std::size_t size)
+{
+    if (void* pointer = allocate(size))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (void* pointer = allocateAligned(size, alignment))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer) noexcept { deallocate(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { deallocate(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { deallocate(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { deallocate(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { deallocate(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { deallocate(pointer); }
+
+extern "C" void* malloc(std::size_t size)
+{
+    return allocate(size);
+}
+
+extern "C" void* calloc(std::size_t count, std::size_t size)
+{
+    ReadyTraderGo::countAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* pointer, std::size_t size)
+{
+    ReadyTraderGo::countAllocation(size);
+    return __libc_realloc(pointer, size);
+}
+
+extern "C" void free(void* pointer)
+{
+    deallocate(pointer);
+}
+
+#else
+
+namespace ReadyTraderGo {
+
+AllocationCounters getThreadAllocationCounters()
+{
+    return {};
+}
+
+void markTradingStarted(AllocationPolicy)
+{
+}
+
+void markTradingStopped()
+{
+}
+
+std::uint64_t getTradingAllocationCount()
+{
+    return 0;
+}
+
+void writeAllocationReport(std::ostream& out, const char*)
+{
+    out << "allocation tracking is not compiled in (configure with -DRTG_ALLOCATION_TRACKING=ON)\n";
+}
+
+}
+
+#endif
@@ -0,0 +1,70 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ALLOCATIONTRACKER_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ALLOCATIONTRACKER_H
+
+#include <cstdint>
+#include <ostream>
+
+namespace ReadyTraderGo {
+
+// Whether operator new and malloc are interposed to count allocations (see
+// the RTG_ALLOCATION_TRACKING CMake option). Without it every function below
+// is a no-op and every counter reads zero.
+#ifdef RTG_ALLOCATION_TRACKING
+constexpr bool ALLOCATION_TRACKING_ENABLED = true;
+#else
+constexpr bool ALLOCATION_TRACKING_ENABLED = false;
+#endif
+
+// What to do when the trading thread allocates after trading has started.
+enum class AllocationPolicy
+{
+    // Count the allocation and record its call stack for the report.
+    REPORT,
+    // Print the call stack to stderr and abort.
+    ABORT
+};
+
+struct AllocationCounters
+{
+    std::uint64_t mAllocations = 0;
+    std::uint64_t mDeallocations = 0;
+    std::uint64_t mBytes = 0;
+};
+
+// Return the calling thread's allocation counters.
+AllocationCounters getThreadAllocationCounters();
+
+// Mark the calling thread as the trading thread. Every allocation it makes
+// from now on, until markTradingStopped is called, is a violation.
+void markTradingStarted(AllocationPolicy policy = AllocationPolicy::REPORT);
+void markTradingStopped();
+
+// Return the number of allocations made by the trading thread while trading.
+std::uint64_t getTradingAllocationCount();
+
+// Write the trading thread's counters and its violations grouped by call
+// site, most frequent first. With a filter, only call sites with a frame
+// whose symbol contains it are listed (e.g. "AutoTrader" leaves out a
+// simulated exchange sharing the thread). Call this after markTradingStopped.
+void writeAllocationReport(std::ostream& out, const char* filter = nullptr);
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ALLOCATIONTRACKER_H
@@ -16,13 +16,17 @@
 //     License along with Ready Trader Go.  If not, see
 //     <https://www.gnu.org/licenses/>.
 #include <csignal>
+#include <cstdint>
 #include <cstring>
+#include <ctime>
 #include <fstream>
 #include <iomanip>
 #include <string>
 
 #define BOOST_BIND_GLOBAL_PLACEHOLDERS
-#include <boost/log/attributes/clock.hpp>
+#include <boost/date_time/c_local_time_adjustor.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/log/attributes/function.hpp>
 #include <boost/log/core.hpp>
 #include <boost/log/expressions.hpp>
 #include <boost/log/sinks/text_ostream_backend.hpp>
@@ -60,6 +64,15 @@ static inline std::string stem(const std::string& path)
     return filename;
 }
 
+// Convert nanoseconds since the epoch to local time.
+static boost::posix_time::ptime toLocalTime(std::uint64_t nanoseconds)
+{
+    const auto seconds = static_cast<std::time_t>(nanoseconds / NANOSECONDS_PER_SECOND);
+    const auto microseconds = static_cast<long>((nanoseconds % NANOSECONDS_PER_SECOND) / 1000);
+    const auto utc = boost::posix_time::from_time_t(seconds) + boost::posix_time::microseconds(microseconds);
+    return boost::date_time::c_local_adjustor<boost::posix_time::ptime>::utc_to_local(utc);
+}
+
 Application::~Application()
 {
     if (!mContext.stopped())
@@ -128,7 +141,10 @@ void Application::SetUpLogging()
     }
 
     boost::shared_ptr<boost::log::core> core = logging::core::get();
-    core->add_global_attribute("TimeStamp", attrs::local_clock());
+    auto timeStamp = core->add_global_attribute(
+        "TimeStamp", attrs::make_function([this] { return toLocalTime(mClock->Now()); }));
+    mTimeStamp = timeStamp.first;
+    mHasTimeStamp = timeStamp.second;
 
     auto backend = boost::make_shared<sinks::text_ostream_backend>();
     backend->add_stream(boost::make_shared<std::ofstream>(std::move(logStream)));
@@ -144,6 +160,7 @@ void Application::SetUpLogging()
 
 #ifdef NDEBUG
     mSink->set_filter(rtg_severity > LogLevel::LL_DEBUG);
+    gLogLevelThreshold = LogLevel::LL_INFO;
 #endif
 }
 
@@ -168,6 +185,12 @@ void Application::SignalHandler(const boost::system::error_code& error, int sign
 
 void Application::TearDownLogging()
 {
+    if (mHasTimeStamp)
+    {
+        logging::core::get()->remove_global_attribute(mTimeStamp);
+        mHasTimeStamp = false;
+    }
+
     if (mSink)
     {
         logging::core::get()->remove_sink(mSink);
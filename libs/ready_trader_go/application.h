@@ -25,6 +25,7 @@
 
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/signal_set.hpp>
+#include <boost/log/attributes/attribute_set.hpp>
 #include <boost/log/sinks/async_frontend.hpp>
 #include <boost/log/sinks/bounded_fifo_queue.hpp>
 #include <boost/log/sinks/drop_on_overflow.hpp>
@@ -33,6 +34,8 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/system/error_code.hpp>
 
+#include "clock.h"
+
 namespace ReadyTraderGo {
 
 constexpr std::size_t LOG_QUEUE_SIZE = 1024;
@@ -51,6 +54,11 @@ public:
 
     boost::asio::io_context& GetContext() { return mContext; }
 
+    // The clock used to time stamp log records (and handed to the
+    // auto-trader). Set it before calling Run() to run in simulated time.
+    const IClock& GetClock() const { return *mClock; }
+    void SetClock(const IClock& clock) { mClock = &clock; }
+
     void Run(int argc, char* argv[]);
 
     std::function<void(const boost::property_tree::ptree&)> ConfigLoaded;
@@ -68,11 +76,14 @@ private:
     boost::asio::io_context mContext;
     std::string mName;
     boost::asio::signal_set mSignals;
+    const IClock* mClock = &GetSystemClock();
 
     using sink_t = boost::log::sinks::asynchronous_sink<
         boost::log::sinks::text_ostream_backend,
         boost::log::sinks::bounded_fifo_queue<LOG_QUEUE_SIZE, boost::log::sinks::drop_on_overflow>>;
     boost::shared_ptr<sink_t> mSink;
+    boost::log::attribute_set::iterator mTimeStamp;
+    bool mHasTimeStamp = false;
 };
 
 inline void Application::OnConfigLoaded(const boost::property_tree::ptree& tree) const
@@ -15,7 +15,14 @@
 //     You should have received a copy of the GNU Affero General Public
 //     License along with Ready Trader Go.  If not, see
 //     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <csignal>
+#include <exception>
+#include <fstream>
+#include <iomanip>
 #include <memory>
+#include <sstream>
+#include <string>
 
 #include <boost/property_tree/ptree.hpp>
 
@@ -23,9 +30,84 @@
 #include "connectivity.h"
 #include "config.h"
 #include "error.h"
+#include "journal.h"
+#include "logging.h"
+
+RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_ALC, "ALLOC")
+RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_RCN, "RECONNECT")
+RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_ERR, "ERRORS")
+RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_PRF, "PROFILE")
+RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_TRC, "TRACE")
 
 namespace ReadyTraderGo {
 
+AutoTraderAppHandler::~AutoTraderAppHandler()
+{
+    if (!mTraceFile.empty())
+    {
+        DumpTrace();
+    }
+
+    if (mAllocationWatched)
+    {
+        markTradingStopped();
+        std::ostringstream report;
+        writeAllocationReport(report);
+        std::string text = report.str();
+        if (!text.empty() && text.back() == '\n')
+        {
+            text.pop_back();
+        }
+        RLOG(LG_ALC, getTradingAllocationCount() ? LogLevel::LL_WARNING : LogLevel::LL_INFO) << text;
+    }
+
+    const ReconnectCounters& reconnects = mAutoTrader.GetReconnectCounters();
+    if (reconnects.mDisconnects != 0)
+    {
+        RLOG(LG_RCN, LogLevel::LL_INFO) << "execution connection lost " << reconnects.mDisconnects << " times, "
+                                        << reconnects.mReconnects << " reconnects (" << reconnects.mFailedAttempts
+                                        << " failed attempts), resumed in (last/max) "
+                                        << reconnects.mLastResumeNanoseconds / 1000 << '/'
+                                        << reconnects.mMaxResumeNanoseconds / 1000 << " us; orders refused="
+                                        << reconnects.mRefusedOrders << " reconciled="
+                                        << reconnects.mReconciledOrders << " abandoned="
+                                        << reconnects.mAbandonedOrders;
+    }
+
+    const ErrorCounts& errors = mAutoTrader.GetErrorCounts();
+    if (std::any_of(errors.begin(), errors.end(), [](std::uint64_t count) { return count != 0; }))
+    {
+        std::ostringstream counts;
+        WriteErrorCounts(counts, errors);
+        RLOG(LG_ERR, LogLevel::LL_INFO) << "error messages received: " << counts.str();
+    }
+
+    if (!mProfiler)
+    {
+        return;
+    }
+    mAutoTrader.SetHandlerProfiler(nullptr);
+
+    std::ostringstream report;
+    mProfiler->WriteReport(report);
+    std::string text = report.str();
+    if (!text.empty() && text.back() == '\n')
+    {
+        text.pop_back();
+    }
+    RLOG(LG_PRF, LogLevel::LL_INFO) << text;
+
+    if (!mMetricsFile.empty())
+    {
+        std::ofstream metrics{mMetricsFile};
+        mProfiler->WriteMetrics(metrics);
+        if (!metrics)
+        {
+            RLOG(LG_PRF, LogLevel::LL_ERROR) << "failed to write metrics to '" << mMetricsFile << "'";
+        }
+    }
+}
+
 void AutoTraderAppHandler::ConfigLoadedHandler(const boost::property_tree::ptree& tree)
 {
     Config config;
@@ -40,19 +122,116 @@ void AutoTraderAppHandler::ConfigLoadedHandler(const boost::property_tree::ptree
     mExecConnectionFactory = std::make_unique<ConnectionFactory>(mContext,
                                                                  config.mExecHost,
                                                                  config.mExecPort);
+    mExecConnectionFactory->SetReceiveTimestamping(config.mExecTimestamping);
+    if (config.mExecTransport == "io_uring")
+    {
+        IoUringOptions options;
+        options.mSqPoll = config.mExecSqPoll;
+        mExecConnectionFactory->SetIoUring(options, config.mExecBusyPoll);
+    }
+    else if (config.mExecTransport != "asio")
+    {
+        throw ReadyTraderGoError("configured execution transport must be 'asio' or 'io_uring'");
+    }
+    if (config.mExecReconnect)
+    {
+        if (config.mExecReconnectInterval < 0.0 || config.mExecConnectTimeout < 0.0
+            || config.mExecReconcileTimeout < 0.0)
+            throw ReadyTraderGoError("configured reconnect interval, connect timeout and reconcile timeout must "
+                                     "not be negative");
+
+        ReconnectPolicy policy;
+        policy.mAttempts = config.mExecReconnectAttempts;
+        policy.mInterval = static_cast<std::uint64_t>(config.mExecReconnectInterval * NANOSECONDS_PER_SECOND);
+        policy.mConnectTimeout = static_cast<std::uint64_t>(config.mExecConnectTimeout * NANOSECONDS_PER_SECOND);
+        policy.mReconcileTimeout = static_cast<std::uint64_t>(config.mExecReconcileTimeout * NANOSECONDS_PER_SECOND);
+        mAutoTrader.SetReconnectPolicy(mExecConnectionFactory.get(), policy);
+        mExecConnectionFactory->SetSpareSocket(true);
+    }
     mInfoSubscriptionFactory = std::make_unique<SubscriptionFactory>(mContext,
                                                                      config.mInfoType,
                                                                      config.mInfoName);
 
+    if (!config.mJournalName.empty())
+    {
+        mJournal = std::make_unique<Journal>(config.mJournalName, config.mJournalSegmentSize);
+        mExecConnectionFactory->SetJournal(mJournal.get());
+        mInfoSubscriptionFactory->SetJournal(mJournal.get());
+    }
+
+    if (!config.mCheckpointFile.empty())
+    {
+        mAutoTrader.SetCheckpointFile(config.mCheckpointFile);
+    }
+
+    if (HANDLER_PROFILING_ENABLED)
+    {
+        mProfiler = std::make_unique<HandlerProfiler>();
+        mMetricsFile = config.mMetricsFile;
+        mAutoTrader.SetHandlerProfiler(mProfiler.get());
+    }
+
+    if (ALLOCATION_TRACKING_ENABLED && config.mAllocationWarmupMessages != 0)
+    {
+        AllocationPolicy policy;
+        if (config.mAllocationPolicy == "report")
+            policy = AllocationPolicy::REPORT;
+        else if (config.mAllocationPolicy == "abort")
+            policy = AllocationPolicy::ABORT;
+        else
+            throw ReadyTraderGoError("configured allocation policy must be 'report' or 'abort'");
+        mAutoTrader.SetAllocationWatch(config.mAllocationWarmupMessages, policy);
+        mAllocationWatched = true;
+    }
+
+    if (TRACING_ENABLED && !config.mTraceFile.empty())
+    {
+        mTraceFile = config.mTraceFile;
+        mTraceSeconds = config.mTraceSeconds;
+        mTraceSignals.add(SIGUSR2);
+        mTraceSignals.async_wait([this](const boost::system::error_code& e, int s) { TraceSignalHandler(e, s); });
+    }
+
     mAutoTrader.SetLoginDetails(config.mTeamName, config.mSecret);
 }
 
+void AutoTraderAppHandler::DumpTrace()
+{
+    std::ostringstream filename;
+    filename << mTraceFile << '.' << std::setw(3) << std::setfill('0') << mTraceCount++ << ".json";
+    try
+    {
+        dumpChromeTrace(filename.str(), mTraceSeconds);
+        RLOG(LG_TRC, LogLevel::LL_INFO) << "wrote the last " << mTraceSeconds << " seconds of spans to '"
+                                        << filename.str() << "'";
+    }
+    catch (const std::exception& e)
+    {
+        RLOG(LG_TRC, LogLevel::LL_ERROR) << e.what();
+    }
+}
+
 void AutoTraderAppHandler::ReadyToRunHandler()
 {
+    if (TRACING_ENABLED)
+    {
+        setTraceThreadName("trading");
+    }
+    mAutoTrader.SetClock(mApplication.GetClock());
     auto connection = mExecConnectionFactory->Create();
     mAutoTrader.SetExecutionConnection(std::move(connection));
     auto subscription = mInfoSubscriptionFactory->Create();
     mAutoTrader.SetInformationSubscription(std::move(subscription));
 }
 
+void AutoTraderAppHandler::TraceSignalHandler(const boost::system::error_code& error, int)
+{
+    if (error)
+    {
+        return;
+    }
+    DumpTrace();
+    mTraceSignals.async_wait([this](const boost::system::error_code& e, int s) { TraceSignalHandler(e, s); });
+}
+
 }
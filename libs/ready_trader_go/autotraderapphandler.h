@@ -19,12 +19,18 @@
 #define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_AUTOTRADERAPPHANDLER_H
 
 #include <memory>
+#include <string>
 
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/signal_set.hpp>
 
+#include "allocationtracker.h"
 #include "application.h"
 #include "baseautotrader.h"
 #include "connectivity.h"
+#include "handlerprofiler.h"
+#include "journal.h"
+#include "trace.h"
 
 namespace ReadyTraderGo {
 
@@ -32,20 +38,32 @@ class AutoTraderAppHandler
 {
 public:
     explicit AutoTraderAppHandler(Application& application, BaseAutoTrader& autoTrader)
-        : mApplication(application), mAutoTrader(autoTrader), mContext(mApplication.GetContext())
+        : mApplication(application), mAutoTrader(autoTrader), mContext(mApplication.GetContext()),
+          mTraceSignals(mContext)
     {
         mApplication.ConfigLoaded = [this](auto& tree) { ConfigLoadedHandler(tree); };
         mApplication.ReadyToRun = [this] { ReadyToRunHandler(); };
     }
+    ~AutoTraderAppHandler();
 
 private:
     void ConfigLoadedHandler(const boost::property_tree::ptree&);
     void ReadyToRunHandler();
+    void DumpTrace();
+    void TraceSignalHandler(const boost::system::error_code& error, int signal);
 
     Application& mApplication;
     BaseAutoTrader& mAutoTrader;
     boost::asio::io_context& mContext;
 
+    std::unique_ptr<Journal> mJournal;
+    std::unique_ptr<HandlerProfiler> mProfiler;
+    std::string mMetricsFile;
+    bool mAllocationWatched = false;
+    boost::asio::signal_set mTraceSignals;
+    std::string mTraceFile;
+    double mTraceSeconds = TRACE_DEFAULT_SECONDS;
+    unsigned mTraceCount = 0;
     std::unique_ptr<ConnectionFactory> mExecConnectionFactory;
     std::unique_ptr<SubscriptionFactory> mInfoSubscriptionFactory;
 };
@@ -15,19 +15,242 @@
 //     You should have received a copy of the GNU Affero General Public
 //     License along with Ready Trader Go.  If not, see
 //     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+#include <boost/asio/post.hpp>
+
 #include "baseautotrader.h"
 #include "error.h"
 #include "logging.h"
 #include "protocol.h"
+#include "trace.h"
 
 RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_BAT, "BASE")
 
 namespace ReadyTraderGo {
 
+static constexpr char NOT_CONNECTED_MESSAGE[] = "execution connection is down";
+
+
+void BaseAutoTrader::ArmTimerPoll()
+{
+    const std::uint64_t deadline = mScheduler.GetNextDeadline();
+    if (deadline == mTimerPollDeadline)
+    {
+        return;
+    }
+
+    mTimerPollDeadline = deadline;
+    if (deadline == NO_TIMER_DEADLINE)
+    {
+        mTimerPoll.cancel();
+        return;
+    }
+
+    // Under a virtual or replay clock the reactor is not run, so this never
+    // fires and whoever advances the clock polls the scheduler instead.
+    const std::uint64_t now = mClock->Now();
+    mTimerPoll.expires_after(std::chrono::nanoseconds(deadline > now ? deadline - now : 0));
+    mTimerPoll.async_wait([this](const boost::system::error_code& error) {
+        if (!error)
+        {
+            mTimerPollDeadline = NO_TIMER_DEADLINE;
+            mScheduler.Poll();
+            ArmTimerPoll();
+        }
+    });
+}
+
+void BaseAutoTrader::DisconnectHandler()
+{
+    if (!mReconnectFactory)
+    {
+        mContext.stop();
+        return;
+    }
+
+    mIsConnected = false;
+    mReconnectAttempts = 0;
+    mDisconnectTime = mClock->Now();
+    ++mReconnectCounters.mDisconnects;
+    for (TrackedOrder& order : mTrackedOrders)
+    {
+        order.mIsUnknown = true;
+    }
+    RLOG(LG_BAT, LogLevel::LL_WARNING) << "execution connection lost with " << mTrackedOrders.size()
+                                       << " orders open, reconnecting";
+
+    // Not from inside the lost connection's own callback.
+    mReconnectTimer.expires_after(std::chrono::nanoseconds(0));
+    mReconnectTimer.async_wait([this](const boost::system::error_code& error) {
+        if (!error)
+        {
+            Reconnect();
+        }
+    });
+}
+
+void BaseAutoTrader::Reconnect()
+{
+    ++mReconnectAttempts;
+    // Connecting can take a while, so it is done without blocking: market
+    // data is handled meanwhile.
+    mReconnectFactory->AsyncCreate(std::chrono::nanoseconds(mReconnectPolicy.mConnectTimeout),
+                                   [this](std::unique_ptr<IConnection> connection, const std::string& error) {
+        if (connection)
+        {
+            Resume(std::move(connection));
+        }
+        else
+        {
+            ReconnectFailed(error);
+        }
+    });
+}
+
+void BaseAutoTrader::ReconnectFailed(const std::string& reason)
+{
+    ++mReconnectCounters.mFailedAttempts;
+    if (mReconnectAttempts >= mReconnectPolicy.mAttempts)
+    {
+        RLOG(LG_BAT, LogLevel::LL_ERROR) << "giving up reconnecting after " << mReconnectAttempts
+                                         << " attempts: " << reason;
+        mContext.stop();
+        return;
+    }
+    mReconnectTimer.expires_after(std::chrono::nanoseconds(mReconnectPolicy.mInterval));
+    mReconnectTimer.async_wait([this](const boost::system::error_code& error) {
+        if (!error)
+        {
+            Reconnect();
+        }
+    });
+}
+
+void BaseAutoTrader::Resume(std::unique_ptr<IConnection>&& connection)
+{
+    connection->SetLastClientOrderId(mExecutionConnection->GetLastClientOrderId());
+    mExecutionConnection->Disconnected = nullptr;
+    mExecutionConnection->MessageReceived = nullptr;
+    mLostConnection = std::move(mExecutionConnection);
+    BaseAutoTrader::SetExecutionConnection(std::move(connection));
+    mIsConnected = true;
+
+    const std::uint64_t resume = mClock->Now() - mDisconnectTime;
+    ++mReconnectCounters.mReconnects;
+    mReconnectCounters.mLastResumeNanoseconds = resume;
+    mReconnectCounters.mMaxResumeNanoseconds = std::max(mReconnectCounters.mMaxResumeNanoseconds, resume);
+
+    std::size_t unknown = 0;
+    for (const TrackedOrder& order : mTrackedOrders)
+    {
+        if (order.mIsUnknown)
+        {
+            ++unknown;
+            if (!order.mIsHedge)
+            {
+                SendCancelOrder(order.mClientOrderId);
+            }
+        }
+    }
+    RLOG(LG_BAT, LogLevel::LL_INFO) << "logged in again " << resume / 1000 << " us after the connection was lost ("
+                                    << mReconnectAttempts << " attempts), " << unknown << " orders unknown";
+
+    if (unknown != 0)
+    {
+        mReconnectTimer.expires_after(std::chrono::nanoseconds(mReconnectPolicy.mReconcileTimeout));
+        mReconnectTimer.async_wait([this](const boost::system::error_code& error) {
+            if (!error)
+            {
+                ReconcileTimeout();
+            }
+        });
+    }
+}
+
+void BaseAutoTrader::ReconcileTimeout()
+{
+    // Handlers may send orders, so the order is taken out before they run.
+    for (std::size_t i = 0; i < mTrackedOrders.size();)
+    {
+        if (!mTrackedOrders[i].mIsUnknown)
+        {
+            ++i;
+            continue;
+        }
+
+        const TrackedOrder order = mTrackedOrders[i];
+        EraseTrackedOrder(&mTrackedOrders[i]);
+        ++mReconnectCounters.mAbandonedOrders;
+        RLOG(LG_BAT, LogLevel::LL_WARNING) << "taking order " << order.mClientOrderId
+                                           << " to be lost with the connection";
+        if (order.mIsHedge)
+        {
+            ++mErrorCounts[static_cast<std::size_t>(ErrorCode::NOT_CONNECTED)];
+            ErrorMessageHandler(order.mClientOrderId, ErrorCode::NOT_CONNECTED, NOT_CONNECTED_MESSAGE);
+        }
+        else
+        {
+            OrderStatusMessageHandler(order.mClientOrderId, Volume(), Volume(), 0);
+        }
+    }
+    ArmTimerPoll();
+}
+
+void BaseAutoTrader::RefuseOrder(unsigned long clientOrderId)
+{
+    ++mReconnectCounters.mRefusedOrders;
+    ++mErrorCounts[static_cast<std::size_t>(ErrorCode::NOT_CONNECTED)];
+    // As if from the exchange, rather than from inside the call that sent it.
+    boost::asio::post(mContext, [this, clientOrderId] {
+        ErrorMessageHandler(clientOrderId, ErrorCode::NOT_CONNECTED, NOT_CONNECTED_MESSAGE);
+        ArmTimerPoll();
+    });
+}
+
+BaseAutoTrader::TrackedOrder* BaseAutoTrader::FindTrackedOrder(unsigned long clientOrderId)
+{
+    for (TrackedOrder& order : mTrackedOrders)
+    {
+        if (order.mClientOrderId == clientOrderId)
+        {
+            return &order;
+        }
+    }
+    return nullptr;
+}
+
+void BaseAutoTrader::EraseTrackedOrder(TrackedOrder* order)
+{
+    *order = mTrackedOrders.back();
+    mTrackedOrders.pop_back();
+}
+
+void BaseAutoTrader::SetCheckpointFile(const std::string&)
+{
+    throw ReadyTraderGoError("this autotrader does not keep a checkpoint");
+}
+
+void BaseAutoTrader::SetReconnectPolicy(IConnectionFactory* factory, const ReconnectPolicy& policy)
+{
+    if (policy.mAttempts == 0)
+        throw ReadyTraderGoError("reconnect attempts must be positive");
+
+    mReconnectFactory = factory;
+    mReconnectPolicy = policy;
+    // The exchange limits how many orders are open at once.
+    mTrackedOrders.reserve(64);
+}
+
 void BaseAutoTrader::SetExecutionConnection(std::unique_ptr<IConnection>&& connection)
 {
     mExecutionConnection = std::move(connection);
     mExecutionConnection->SetName("Exec");
+    // Losing the connection part way through a send is then no worse than
+    // losing it between sends.
+    mExecutionConnection->SetDisconnectOnSendError(mReconnectFactory != nullptr);
     mExecutionConnection->Disconnected = [this] { DisconnectHandler(); };
     mExecutionConnection->MessageReceived = [this](IConnection* c,
                                                    unsigned char t,
@@ -47,29 +270,79 @@ void BaseAutoTrader::MessageHandler(IConnection* connection,
                                     unsigned char const* data,
                                     std::size_t size)
 {
+    RTG_TRACE_SPAN("exec dispatch");
+    mScheduler.Poll();
+
     switch (messageType)
     {
     case MessageType::ERROR_MESSAGE:
     {
-        auto err = makeMessage<ErrorMessage>(data, size);
-        ErrorMessageHandler(err.mClientOrderId, err.mMessage);
+        // Read in place: the text is classified, not copied.
+        MessageView<ErrorMessage> error(data, size);
+        const std::string_view text = error.Get<&ErrorMessage::mMessage>();
+        const ErrorCode code = ClassifyError(text);
+        ++mErrorCounts[static_cast<std::size_t>(code)];
+        const unsigned long clientOrderId = error.Get<&ErrorMessage::mClientOrderId>();
+        // A refused amend leaves the order as it was; otherwise the exchange
+        // no longer has it.
+        TrackedOrder* order = (code != ErrorCode::AMEND_INCREASES_VOLUME) ? FindTrackedOrder(clientOrderId) : nullptr;
+        if (order)
+        {
+            const bool wasUnknown = order->mIsUnknown;
+            EraseTrackedOrder(order);
+            if (wasUnknown && code == ErrorCode::OUT_OF_ORDER_CANCEL)
+            {
+                // The cancel sent on logging in again was for an order the
+                // exchange does not have.
+                ++mReconnectCounters.mReconciledOrders;
+                OrderStatusMessageHandler(clientOrderId, Volume(), Volume(), 0);
+                break;
+            }
+        }
+        RTG_PROFILE_RECEIVE(mProfiler, Handler::ERROR_MESSAGE, connection->GetReceiveTimestamps());
+        RTG_PROFILE_HANDLER(mProfiler, Handler::ERROR_MESSAGE);
+        RTG_TRACE_SPAN("ErrorMessageHandler");
+        ErrorMessageHandler(clientOrderId, code, text);
         break;
     }
     case MessageType::HEDGE_FILLED:
     {
         auto filled = makeMessage<HedgeFilledMessage>(data, size);
+        if (TrackedOrder* order = FindTrackedOrder(filled.mClientOrderId))
+        {
+            mReconnectCounters.mReconciledOrders += order->mIsUnknown ? 1 : 0;
+            EraseTrackedOrder(order);
+        }
+        RTG_PROFILE_RECEIVE(mProfiler, Handler::HEDGE_FILLED, connection->GetReceiveTimestamps());
+        RTG_PROFILE_HANDLER(mProfiler, Handler::HEDGE_FILLED);
+        RTG_TRACE_SPAN("HedgeFilledMessageHandler");
         HedgeFilledMessageHandler(filled.mClientOrderId, filled.mPrice, filled.mVolume);
         break;
     }
     case MessageType::ORDER_FILLED:
     {
         auto filled = makeMessage<OrderFilledMessage>(data, size);
+        RTG_PROFILE_RECEIVE(mProfiler, Handler::ORDER_FILLED, connection->GetReceiveTimestamps());
+        RTG_PROFILE_HANDLER(mProfiler, Handler::ORDER_FILLED);
+        RTG_TRACE_SPAN("OrderFilledMessageHandler");
         OrderFilledMessageHandler(filled.mClientOrderId, filled.mPrice, filled.mVolume);
         break;
     }
     case MessageType::ORDER_STATUS:
     {
         auto status = makeMessage<OrderStatusMessage>(data, size);
+        if (TrackedOrder* order = FindTrackedOrder(status.mClientOrderId))
+        {
+            mReconnectCounters.mReconciledOrders += order->mIsUnknown ? 1 : 0;
+            order->mIsUnknown = false;
+            if (!status.mRemainingVolume)
+            {
+                EraseTrackedOrder(order);
+            }
+        }
+        RTG_PROFILE_RECEIVE(mProfiler, Handler::ORDER_STATUS, connection->GetReceiveTimestamps());
+        RTG_PROFILE_HANDLER(mProfiler, Handler::ORDER_STATUS);
+        RTG_TRACE_SPAN("OrderStatusMessageHandler");
         OrderStatusMessageHandler(status.mClientOrderId, status.mFillVolume,
                                   status.mRemainingVolume, status.mFees);
         break;
@@ -81,6 +354,8 @@ void BaseAutoTrader::MessageHandler(IConnection* connection,
         throw ReadyTraderGoError("received execution message with unexpected type");
     }
     }
+
+    ArmTimerPoll();
 }
 
 void BaseAutoTrader::MessageHandler(ISubscription* subscription,
@@ -91,19 +366,11 @@ void BaseAutoTrader::MessageHandler(ISubscription* subscription,
     switch (messageType)
     {
     case MessageType::ORDER_BOOK_UPDATE:
-    {
-        auto book = makeMessage<OrderBookMessage>(data, size);
-        OrderBookMessageHandler(book.mInstrument, book.mSequenceNumber, book.mAskPrices,
-                                book.mAskVolumes, book.mBidPrices, book.mBidVolumes);
+        DeliverOrderBook(makeMessage<OrderBookMessage>(data, size));
         break;
-    }
     case MessageType::TRADE_TICKS:
-    {
-        auto ticks = makeMessage<TradeTicksMessage>(data, size);
-        TradeTicksMessageHandler(ticks.mInstrument, ticks.mSequenceNumber, ticks.mAskPrices,
-                                 ticks.mAskVolumes, ticks.mBidPrices, ticks.mBidVolumes);
+        DeliverTradeTicks(makeMessage<TradeTicksMessage>(data, size));
         break;
-    }
     default:
     {
         RLOG(LG_BAT, LogLevel::LL_ERROR) << "received information message with unexpected type: "
@@ -113,4 +380,44 @@ void BaseAutoTrader::MessageHandler(ISubscription* subscription,
     }
 }
 
+void BaseAutoTrader::DeliverOrderBook(const OrderBookMessage& book)
+{
+    RTG_TRACE_SPAN("info dispatch");
+    mScheduler.Poll();
+
+    {
+        RTG_PROFILE_HANDLER(mProfiler, Handler::ORDER_BOOK);
+        RTG_TRACE_SPAN("OrderBookMessageHandler");
+        OrderBookMessageHandler(book.mInstrument, book.mSequenceNumber, book.mAskPrices,
+                                book.mAskVolumes, book.mBidPrices, book.mBidVolumes);
+    }
+
+    InformationHandled();
+}
+
+void BaseAutoTrader::DeliverTradeTicks(const TradeTicksMessage& ticks)
+{
+    RTG_TRACE_SPAN("info dispatch");
+    mScheduler.Poll();
+
+    {
+        RTG_PROFILE_HANDLER(mProfiler, Handler::TRADE_TICKS);
+        RTG_TRACE_SPAN("TradeTicksMessageHandler");
+        TradeTicksMessageHandler(ticks.mInstrument, ticks.mSequenceNumber, ticks.mAskPrices,
+                                 ticks.mAskVolumes, ticks.mBidPrices, ticks.mBidVolumes);
+    }
+
+    InformationHandled();
+}
+
+void BaseAutoTrader::InformationHandled()
+{
+    ArmTimerPoll();
+
+    if (ALLOCATION_TRACKING_ENABLED && mAllocationWarmup != 0 && --mAllocationWarmup == 0)
+    {
+        markTradingStarted(mAllocationPolicy);
+    }
+}
+
 }
\ No newline at end of file
@@ -22,40 +22,148 @@
 #include <cstddef>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
 
+#include "allocationtracker.h"
+#include "clock.h"
 #include "connectivitytypes.h"
+#include "errorcode.h"
+#include "handlerprofiler.h"
 #include "protocol.h"
+#include "scheduler.h"
 #include "types.h"
 
 namespace ReadyTraderGo {
 
+// How the autotrader reconnects when the execution connection is lost.
+struct ReconnectPolicy
+{
+    // Attempts to connect, made this far apart, before giving up.
+    unsigned mAttempts = 50;
+    std::uint64_t mInterval = NANOSECONDS_PER_SECOND / 10;
+    // How long an attempt may take to connect before it fails.
+    std::uint64_t mConnectTimeout = NANOSECONDS_PER_SECOND;
+    // How long orders open when the connection was lost may stay unknown
+    // once logged in again, before they are taken to be gone.
+    std::uint64_t mReconcileTimeout = NANOSECONDS_PER_SECOND;
+};
+
+struct ReconnectCounters
+{
+    std::uint64_t mDisconnects = 0;
+    std::uint64_t mReconnects = 0;
+    std::uint64_t mFailedAttempts = 0;
+    // Nanoseconds from losing the connection to logging in again.
+    std::uint64_t mLastResumeNanoseconds = 0;
+    std::uint64_t mMaxResumeNanoseconds = 0;
+    // Orders sent while reconnecting, which were refused.
+    std::uint64_t mRefusedOrders = 0;
+    // Unknown orders settled by the exchange, and those taken to be gone
+    // when the reconcile timeout passed.
+    std::uint64_t mReconciledOrders = 0;
+    std::uint64_t mAbandonedOrders = 0;
+};
+
 class BaseAutoTrader
 {
 public:
-    explicit BaseAutoTrader(boost::asio::io_context& context) : mContext(context) {};
+    explicit BaseAutoTrader(boost::asio::io_context& context) : mContext(context) {}
 
-    virtual void SendAmendOrder(unsigned long clientOrderId, unsigned long volume);
+    // The clock that strategy code should use for "now". Timers scheduled
+    // with the scheduler are measured against the same clock. They fire as
+    // messages arrive and, between messages, from a single reactor timer
+    // armed for the earliest deadline.
+    const IClock& GetClock() const { return *mClock; }
+    TimerScheduler& GetScheduler() { return mScheduler; }
+
+    // Hand an already decoded information message to the message handlers,
+    // exactly as if it had arrived on the information subscription.
+    void DeliverOrderBook(const OrderBookMessage& book);
+    void DeliverTradeTicks(const TradeTicksMessage& ticks);
+
+    // Error messages received so far, by code.
+    const ErrorCounts& GetErrorCounts() const { return mErrorCounts; }
+    const ReconnectCounters& GetReconnectCounters() const { return mReconnectCounters; }
+
+    virtual void SendAmendOrder(unsigned long clientOrderId, Volume volume);
     virtual void SendCancelOrder(unsigned long clientOrderId);
     virtual void SendHedgeOrder(unsigned long clientOrderId,
                                 Side side,
-                                unsigned long price,
-                                unsigned long volume);
+                                Price price,
+                                Volume volume);
     virtual void SendInsertOrder(unsigned long clientOrderId,
                                  Side side,
-                                 unsigned long price,
-                                 unsigned long volume,
+                                 Price price,
+                                 Volume volume,
                                  Lifespan lifespan);
 
+    // Once this many information messages have been handled, every
+    // allocation made by the trading thread is reported (or aborts). Only
+    // has an effect when built with the RTG_ALLOCATION_TRACKING option.
+    void SetAllocationWatch(std::uint64_t warmupMessages, AllocationPolicy policy)
+    {
+        mAllocationWarmup = warmupMessages;
+        mAllocationPolicy = policy;
+    }
+    virtual void SetClock(const IClock& clock);
+    // Only has an effect when built with the RTG_PERF_COUNTERS option.
+    void SetHandlerProfiler(HandlerProfiler* profiler) { mProfiler = profiler; }
     virtual void SetExecutionConnection(std::unique_ptr<IConnection>&& connection);
     virtual void SetInformationSubscription(std::shared_ptr<ISubscription>&& subscription);
     virtual void SetLoginDetails(std::string teamName, std::string secret);
 
+    // Rather than stop when the execution connection is lost, connect again
+    // with the factory, without blocking, and log in. A failed send loses
+    // the connection as a failed read does. Orders sent while disconnected are
+    // refused with a NOT_CONNECTED error. Orders that were open when the
+    // connection was lost are unknown until the exchange settles them: once
+    // logged in again they are cancelled, and each is finished by its order
+    // status (or by the error for an order the exchange does not have), or,
+    // failing that, when the reconcile timeout passes (hedge orders, which
+    // cannot be cancelled, then get a NOT_CONNECTED error). Market data is
+    // handled throughout.
+    virtual void SetReconnectPolicy(IConnectionFactory* factory, const ReconnectPolicy& policy);
+
+    // Keep the strategy's state in the given memory-mapped file, first
+    // restoring it from the file if that holds a copy, so that a restarted
+    // strategy carries on warm. Must be called before the execution
+    // connection is set. Strategies that keep no checkpoint throw.
+    virtual void SetCheckpointFile(const std::string& filename);
+
 protected:
     boost::asio::io_context& mContext;
+    const IClock* mClock = &GetSystemClock();
+    TimerScheduler mScheduler{GetSystemClock()};
+    boost::asio::steady_timer mTimerPoll{mContext};
+    std::uint64_t mTimerPollDeadline = NO_TIMER_DEADLINE;
+    HandlerProfiler* mProfiler = nullptr;
+    std::uint64_t mAllocationWarmup = 0;
+    AllocationPolicy mAllocationPolicy = AllocationPolicy::REPORT;
+    ErrorCounts mErrorCounts{};
+
+    // Reconnection; orders are only tracked if a factory is set.
+    struct TrackedOrder
+    {
+        unsigned long mClientOrderId;
+        bool mIsHedge;
+        // Open when the connection was lost, and not yet settled.
+        bool mIsUnknown;
+    };
+    IConnectionFactory* mReconnectFactory = nullptr;
+    ReconnectPolicy mReconnectPolicy;
+    ReconnectCounters mReconnectCounters;
+    boost::asio::steady_timer mReconnectTimer{mContext};
+    bool mIsConnected = true;
+    unsigned mReconnectAttempts = 0;
+    std::uint64_t mDisconnectTime = 0;
+    std::vector<TrackedOrder> mTrackedOrders;
+    // Kept until the next is lost, as it may still have operations pending.
+    std::unique_ptr<IConnection> mLostConnection;
     std::unique_ptr<IConnection> mExecutionConnection = nullptr;
     std::shared_ptr<ISubscription> mInformationSubscription = nullptr;
 
@@ -63,6 +171,17 @@ protected:
     std::string mSecret;
 
     virtual void DisconnectHandler();
+    void Reconnect();
+    void ReconnectFailed(const std::string& reason);
+    void Resume(std::unique_ptr<IConnection>&& connection);
+    void ReconcileTimeout();
+    void RefuseOrder(unsigned long clientOrderId);
+    TrackedOrder* FindTrackedOrder(unsigned long clientOrderId);
+    void EraseTrackedOrder(TrackedOrder* order);
+    // The id to give the next inserted or hedge order.
+    unsigned long NextClientOrderId() { return mExecutionConnection->NextClientOrderId(); }
+    void ArmTimerPoll();
+    void InformationHandled();
     virtual void MessageHandler(IConnection*, unsigned char, unsigned char const*, std::size_t);
     virtual void MessageHandler(ISubscription* subscription,
                                 unsigned char messageType,
@@ -70,35 +189,38 @@ protected:
                                 std::size_t size);
 
     // Message callbacks
+    // The text is only valid for the duration of the call.
     virtual void ErrorMessageHandler(unsigned long clientOrderId,
-                                     const std::string& errorMessage) {};
+                                     ErrorCode errorCode,
+                                     std::string_view errorMessage) {};
     virtual void HedgeFilledMessageHandler(unsigned long clientOrderId,
-                                           unsigned long price,
-                                           unsigned long volume) {};
+                                           Price price,
+                                           Volume volume) {};
     virtual void OrderBookMessageHandler(Instrument instrument,
                                          unsigned long sequenceNumber,
-                                         const std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
-                                         const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
-                                         const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
-                                         const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes) {};
+                                         const PriceLevels& askPrices,
+                                         const VolumeLevels& askVolumes,
+                                         const PriceLevels& bidPrices,
+                                         const VolumeLevels& bidVolumes) {};
     virtual void OrderFilledMessageHandler(unsigned long clientOrderId,
-                                           unsigned long price,
-                                           unsigned long volume) {};
+                                           Price price,
+                                           Volume volume) {};
     virtual void OrderStatusMessageHandler(unsigned long clientOrderId,
-                                           unsigned long fillVolume,
-                                           unsigned long remainingVolume,
+                                           Volume fillVolume,
+                                           Volume remainingVolume,
                                            signed long fees) {};
     virtual void TradeTicksMessageHandler(Instrument instrument,
                                           unsigned long sequenceNumber,
-                                          const std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
-                                          const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
-                                          const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
-                                          const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes) {};
+                                          const PriceLevels& askPrices,
+                                          const VolumeLevels& askVolumes,
+                                          const PriceLevels& bidPrices,
+                                          const VolumeLevels& bidVolumes) {};
 };
 
-inline void BaseAutoTrader::DisconnectHandler()
+inline void BaseAutoTrader::SetClock(const IClock& clock)
 {
-    mContext.stop();
+    mClock = &clock;
+    mScheduler.SetClock(clock);
 }
 
 inline void BaseAutoTrader::SetInformationSubscription(std::shared_ptr<ISubscription>&& subscription)
@@ -112,23 +234,42 @@ inline void BaseAutoTrader::SetInformationSubscription(std::shared_ptr<ISubscrip
     mInformationSubscription->AsyncReceive();
 }
 
-inline void BaseAutoTrader::SendAmendOrder(unsigned long clientOrderId, unsigned long volume)
+inline void BaseAutoTrader::SendAmendOrder(unsigned long clientOrderId, Volume volume)
 {
+    // While reconnecting, amends and cancels are dropped: the orders they
+    // are for will be cancelled once logged in again.
+    if (!mIsConnected)
+    {
+        return;
+    }
     mExecutionConnection->SendMessage(MessageType::AMEND_ORDER,
                                       AmendMessage{clientOrderId, volume});
 }
 
 inline void BaseAutoTrader::SendCancelOrder(unsigned long clientOrderId)
 {
+    if (!mIsConnected)
+    {
+        return;
+    }
     mExecutionConnection->SendMessage(MessageType::CANCEL_ORDER,
                                       CancelMessage{clientOrderId});
 }
 
 inline void BaseAutoTrader::SendHedgeOrder(unsigned long clientOrderId,
                                            Side side,
-                                           unsigned long price,
-                                           unsigned long volume)
+                                           Price price,
+                                           Volume volume)
 {
+    if (!mIsConnected)
+    {
+        RefuseOrder(clientOrderId);
+        return;
+    }
+    if (mReconnectFactory)
+    {
+        mTrackedOrders.push_back(TrackedOrder{clientOrderId, true, false});
+    }
     mExecutionConnection->SendMessage(MessageType::HEDGE_ORDER,
                                       HedgeMessage{clientOrderId,
                                                    side,
@@ -138,10 +279,19 @@ inline void BaseAutoTrader::SendHedgeOrder(unsigned long clientOrderId,
 
 inline void BaseAutoTrader::SendInsertOrder(unsigned long clientOrderId,
                                             Side side,
-                                            unsigned long price,
-                                            unsigned long volume,
+                                            Price price,
+                                            Volume volume,
                                             Lifespan lifespan)
 {
+    if (!mIsConnected)
+    {
+        RefuseOrder(clientOrderId);
+        return;
+    }
+    if (mReconnectFactory)
+    {
+        mTrackedOrders.push_back(TrackedOrder{clientOrderId, false, false});
+    }
     mExecutionConnection->SendMessage(MessageType::INSERT_ORDER,
                                       InsertMessage{clientOrderId,
                                                     side,
@@ -0,0 +1,219 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <cfloat>
+#include <string>
+
+#include "bookfeatures.h"
+#include "error.h"
+
+namespace ReadyTraderGo {
+
+// A depth of whole lots is unchanged by this, while dividing the zero
+// numerator of an empty book by it gives zero. Unlike a comparison, it
+// leaves the kernels free of branches, which would stop them vectorising.
+static inline double nonZero(double depth)
+{
+    return depth + DBL_MIN;
+}
+
+// The kinds each kind is computed from.
+static std::uint32_t getDependencies(BookFeature feature)
+{
+    auto bit = [](BookFeature f) { return std::uint32_t(1) << static_cast<unsigned>(f); };
+    switch (feature)
+    {
+    case BookFeature::DEPTH_WEIGHTED_MID:
+        return bit(BookFeature::ASK_VWAP) | bit(BookFeature::BID_VWAP);
+    case BookFeature::BASIS_TICKS:
+        return bit(BookFeature::MID);
+    default:
+        return 0;
+    }
+}
+
+BookFeaturePipeline::BookFeaturePipeline(unsigned long tickSize) : mTickSize(static_cast<double>(tickSize))
+{
+    if (tickSize == 0)
+        throw ReadyTraderGoError("book feature tick size must be positive");
+}
+
+std::size_t BookFeaturePipeline::Add(BookFeature feature, Instrument instrument, std::size_t levels)
+{
+    if (levels == 0 || levels > TOP_LEVEL_COUNT)
+        throw ReadyTraderGoError("book feature levels must be from 1 to " + std::to_string(TOP_LEVEL_COUNT));
+
+    Registration registration{feature, static_cast<unsigned char>(1u << static_cast<unsigned>(instrument)),
+                              GetLane(instrument, levels - 1)};
+    switch (feature)
+    {
+    case BookFeature::MID:
+    case BookFeature::SPREAD_TICKS:
+        registration.mLane = GetLane(instrument, 0);
+        break;
+    case BookFeature::BASIS_TICKS:
+        registration.mInstrumentMask = 3;
+        registration.mLane = 0;
+        break;
+    default:
+        break;
+    }
+
+    mNeededKinds |= (std::uint32_t(1) << static_cast<unsigned>(feature)) | getDependencies(feature);
+    mRegistrations.push_back(registration);
+    mValues.push_back(0.0);
+    mUpdated.push_back(0);
+    // The new feature has no value yet.
+    mChangedInstruments |= registration.mInstrumentMask;
+    return mValues.size() - 1;
+}
+
+void BookFeaturePipeline::OnOrderBook(Instrument instrument,
+                                      const PriceLevels& askPrices,
+                                      const VolumeLevels& askVolumes,
+                                      const PriceLevels& bidPrices,
+                                      const VolumeLevels& bidVolumes)
+{
+    Book& last = mLastBooks[static_cast<std::size_t>(instrument)];
+    if (askPrices == last.mAskPrices && askVolumes == last.mAskVolumes
+        && bidPrices == last.mBidPrices && bidVolumes == last.mBidVolumes)
+    {
+        return;
+    }
+    last = Book{askPrices, askVolumes, bidPrices, bidVolumes};
+
+    for (std::size_t i = 0; i < TOP_LEVEL_COUNT; ++i)
+    {
+        const std::size_t lane = GetLane(instrument, i);
+        mAskPrices[lane] = static_cast<double>(askPrices[i].Cents());
+        mAskVolumes[lane] = static_cast<double>(askVolumes[i].Lots());
+        mBidPrices[lane] = static_cast<double>(bidPrices[i].Cents());
+        mBidVolumes[lane] = static_cast<double>(bidVolumes[i].Lots());
+        mIsTwoSided[lane] = (askPrices[i] && bidPrices[i]) ? 1.0 : 0.0;
+    }
+    mChangedInstruments |= static_cast<unsigned char>(1u << static_cast<unsigned>(instrument));
+}
+
+void BookFeaturePipeline::RunKernels()
+{
+    auto needs = [this](BookFeature f) { return (mNeededKinds & (std::uint32_t(1) << static_cast<unsigned>(f))) != 0; };
+
+    // Running sums over the levels, both instruments at once (a level's two
+    // lanes are adjacent). Padding lanes hold zeros, so they stay zero.
+    for (std::size_t i = 0; i < LANES; ++i)
+    {
+        mAskDepth[i] = mAskVolumes[i];
+        mBidDepth[i] = mBidVolumes[i];
+        mAskTurnover[i] = mAskPrices[i] * mAskVolumes[i];
+        mBidTurnover[i] = mBidPrices[i] * mBidVolumes[i];
+    }
+    for (std::size_t i = 2; i < 2 * TOP_LEVEL_COUNT; ++i)
+    {
+        mAskDepth[i] += mAskDepth[i - 2];
+        mBidDepth[i] += mBidDepth[i - 2];
+        mAskTurnover[i] += mAskTurnover[i - 2];
+        mBidTurnover[i] += mBidTurnover[i - 2];
+    }
+
+    const double tickSize = mTickSize;
+    if (needs(BookFeature::MID) || needs(BookFeature::SPREAD_TICKS))
+    {
+        Lanes& mid = GetTable(BookFeature::MID);
+        Lanes& spread = GetTable(BookFeature::SPREAD_TICKS);
+        for (std::size_t i = 0; i < LANES; ++i)
+        {
+            mid[i] = (mAskPrices[i] + mBidPrices[i]) * 0.5 * mIsTwoSided[i];
+            spread[i] = (mAskPrices[i] - mBidPrices[i]) / tickSize * mIsTwoSided[i];
+        }
+    }
+    if (needs(BookFeature::ASK_DEPTH))
+    {
+        GetTable(BookFeature::ASK_DEPTH) = mAskDepth;
+    }
+    if (needs(BookFeature::BID_DEPTH))
+    {
+        GetTable(BookFeature::BID_DEPTH) = mBidDepth;
+    }
+    if (needs(BookFeature::ASK_VWAP) || needs(BookFeature::BID_VWAP))
+    {
+        Lanes& askVwap = GetTable(BookFeature::ASK_VWAP);
+        Lanes& bidVwap = GetTable(BookFeature::BID_VWAP);
+        for (std::size_t i = 0; i < LANES; ++i)
+        {
+            askVwap[i] = mAskTurnover[i] / nonZero(mAskDepth[i]);
+            bidVwap[i] = mBidTurnover[i] / nonZero(mBidDepth[i]);
+        }
+    }
+    if (needs(BookFeature::DEPTH_WEIGHTED_MID))
+    {
+        const Lanes& askVwap = GetTable(BookFeature::ASK_VWAP);
+        const Lanes& bidVwap = GetTable(BookFeature::BID_VWAP);
+        Lanes& out = GetTable(BookFeature::DEPTH_WEIGHTED_MID);
+        for (std::size_t i = 0; i < LANES; ++i)
+        {
+            out[i] = (askVwap[i] * mBidDepth[i] + bidVwap[i] * mAskDepth[i])
+                     / nonZero(mAskDepth[i] + mBidDepth[i]);
+        }
+    }
+    if (needs(BookFeature::IMBALANCE))
+    {
+        Lanes& out = GetTable(BookFeature::IMBALANCE);
+        for (std::size_t i = 0; i < LANES; ++i)
+        {
+            out[i] = (mBidDepth[i] - mAskDepth[i]) / nonZero(mAskDepth[i] + mBidDepth[i]);
+        }
+    }
+    if (needs(BookFeature::SLOPE))
+    {
+        Lanes& out = GetTable(BookFeature::SLOPE);
+        for (std::size_t i = 0; i < LANES; ++i)
+        {
+            out[i] = (mAskPrices[i] - mBidPrices[i]) / tickSize * mIsTwoSided[i] / nonZero(mAskDepth[i] + mBidDepth[i]);
+        }
+    }
+    if (needs(BookFeature::BASIS_TICKS))
+    {
+        const Lanes& mid = GetTable(BookFeature::MID);
+        const double etf = mid[GetLane(Instrument::ETF, 0)];
+        const double future = mid[GetLane(Instrument::FUTURE, 0)];
+        GetTable(BookFeature::BASIS_TICKS)[0] = (etf > 0.0 && future > 0.0) ? (etf - future) / tickSize : 0.0;
+    }
+}
+
+void BookFeaturePipeline::Evaluate()
+{
+    if (mChangedInstruments == 0)
+    {
+        return;
+    }
+
+    RunKernels();
+    const std::size_t count = mRegistrations.size();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const Registration& r = mRegistrations[i];
+        mUpdated[i] = (r.mInstrumentMask & mChangedInstruments) != 0;
+        if (mUpdated[i])
+        {
+            mValues[i] = mTables[static_cast<std::size_t>(r.mFeature)][r.mLane];
+        }
+    }
+    mChangedInstruments = 0;
+}
+
+}
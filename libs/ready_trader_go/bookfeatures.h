@@ -0,0 +1,160 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_BOOKFEATURES_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_BOOKFEATURES_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "price.h"
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+// Features of one instrument's order book over its best few levels. "Depth"
+// is the volume on a side summed over the levels.
+enum class BookFeature : unsigned char
+{
+    // Mid price and bid-ask spread in ticks; the levels are ignored.
+    MID,
+    SPREAD_TICKS,
+    ASK_DEPTH,
+    BID_DEPTH,
+    // Volume weighted average price of each side.
+    ASK_VWAP,
+    BID_VWAP,
+    // The sides' average prices, each weighted by the other side's depth
+    // (over one level, the micro-price).
+    DEPTH_WEIGHTED_MID,
+    // (bid depth - ask depth) / (bid depth + ask depth), from -1 to 1.
+    IMBALANCE,
+    // Ticks between the furthest levels per lot of depth on both sides.
+    SLOPE,
+    // ETF mid less future mid, in ticks; the instrument and levels are
+    // ignored.
+    BASIS_TICKS
+};
+
+constexpr std::size_t BOOK_FEATURE_COUNT = static_cast<std::size_t>(BookFeature::BASIS_TICKS) + 1;
+
+template<typename C, typename T>
+std::basic_ostream<C, T>& operator<<(std::basic_ostream<C, T>& strm, BookFeature feature)
+{
+    static const char* const NAMES[] = {"mid", "spread_ticks", "ask_depth", "bid_depth", "ask_vwap", "bid_vwap",
+                                        "depth_weighted_mid", "imbalance", "slope", "basis_ticks"};
+    return strm << NAMES[static_cast<std::size_t>(feature)];
+}
+
+// Computes a fixed set of order book features for both instruments.
+//
+// Features are registered once and then read, by the index Add returned,
+// from a flat vector of values. The books are held as a structure of arrays
+// with one lane per (level, instrument), padded to a power of two, and each
+// kind of feature is computed for every lane at once by a fixed-length,
+// branch-free loop the compiler vectorises; only the kinds some registered
+// feature needs are computed. The feature vector is then filled from those
+// tables, skipping features of instruments whose book has not changed.
+//
+// Order books are stored as they arrive; Evaluate does the work, so the
+// books of both instruments for one tick cost one pass.
+class BookFeaturePipeline
+{
+public:
+    static constexpr std::size_t LEVEL_LANES = 8;
+    static constexpr std::size_t LANES = 2 * LEVEL_LANES;
+
+    explicit BookFeaturePipeline(unsigned long tickSize = 100);
+
+    // Returns the feature's index in the feature vector. Levels are counted
+    // from one.
+    std::size_t Add(BookFeature feature, Instrument instrument, std::size_t levels = 1);
+
+    void OnOrderBook(Instrument instrument,
+                     const PriceLevels& askPrices,
+                     const VolumeLevels& askVolumes,
+                     const PriceLevels& bidPrices,
+                     const VolumeLevels& bidVolumes);
+
+    // Brings the feature vector up to date with the books, doing nothing if
+    // neither has changed since the last evaluation.
+    void Evaluate();
+
+    std::size_t Size() const { return mValues.size(); }
+    const double* GetValues() const { return mValues.data(); }
+    double operator[](std::size_t index) const { return mValues[index]; }
+    // True if the feature was recomputed by the last evaluation that did
+    // any work.
+    bool IsUpdated(std::size_t index) const { return mUpdated[index] != 0; }
+
+private:
+    struct Registration
+    {
+        BookFeature mFeature;
+        unsigned char mInstrumentMask;
+        // Lane of the feature's table that holds its value.
+        std::size_t mLane;
+    };
+
+    using Lanes = std::array<double, LANES>;
+
+    static std::size_t GetLane(Instrument instrument, std::size_t level)
+    {
+        return level * 2 + static_cast<std::size_t>(instrument);
+    }
+    Lanes& GetTable(BookFeature feature) { return mTables[static_cast<std::size_t>(feature)]; }
+    void RunKernels();
+
+    const double mTickSize;
+    std::vector<Registration> mRegistrations;
+    std::vector<double> mValues;
+    std::vector<unsigned char> mUpdated;
+    // Bit n is set if BookFeature n is needed, by a feature or another kind.
+    std::uint32_t mNeededKinds = 0;
+    // Bit n is set if instrument n's book has changed since it was used.
+    unsigned char mChangedInstruments = 0;
+
+    // The books as they arrived, to tell whether a new one differs.
+    struct Book
+    {
+        PriceLevels mAskPrices;
+        VolumeLevels mAskVolumes;
+        PriceLevels mBidPrices;
+        VolumeLevels mBidVolumes;
+    };
+    std::array<Book, 2> mLastBooks{};
+
+    alignas(64) Lanes mAskPrices{};
+    alignas(64) Lanes mAskVolumes{};
+    alignas(64) Lanes mBidPrices{};
+    alignas(64) Lanes mBidVolumes{};
+    // One where a level has both an ask and a bid, otherwise zero.
+    alignas(64) Lanes mIsTwoSided{};
+    // Running sums of volume and of price times volume over the levels.
+    alignas(64) Lanes mAskDepth{};
+    alignas(64) Lanes mBidDepth{};
+    alignas(64) Lanes mAskTurnover{};
+    alignas(64) Lanes mBidTurnover{};
+    alignas(64) std::array<Lanes, BOOK_FEATURE_COUNT> mTables{};
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_BOOKFEATURES_H
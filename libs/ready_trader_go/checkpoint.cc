@@ -0,0 +1,136 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "checkpoint.h"
+#include "error.h"
+#include "logging.h"
+
+namespace interprocess = boost::interprocess;
+
+RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_CKP, "CKPT")
+
+namespace ReadyTraderGo {
+
+constexpr std::size_t CHECKPOINT_PAGE_SIZE = 4096;
+
+CheckpointFile::CheckpointFile(const std::string& filename, std::uint32_t stateVersion, std::size_t stateSize)
+    : mFilename(filename), mStateVersion(stateVersion), mStateSize(stateSize),
+      mSlotSize(CHECKPOINT_ALIGNMENT + (stateSize + CHECKPOINT_ALIGNMENT - 1) / CHECKPOINT_ALIGNMENT
+                                       * CHECKPOINT_ALIGNMENT)
+{
+    if (stateSize == 0 || stateSize > UINT32_MAX)
+        throw ReadyTraderGoError("checkpoint state size must be positive and less than 4GB");
+
+    const std::size_t fileSize = CHECKPOINT_ALIGNMENT + 2 * mSlotSize;
+    if (!Open(fileSize))
+    {
+        Create(fileSize);
+    }
+
+    // Write to every page now so that a save never takes a page fault.
+    volatile unsigned char* address = GetAddress();
+    for (std::size_t offset = 0; offset < fileSize; offset += CHECKPOINT_PAGE_SIZE)
+    {
+        address[offset] = address[offset];
+    }
+}
+
+bool CheckpointFile::Open(std::size_t fileSize)
+{
+    std::error_code error;
+    const std::uintmax_t size = std::filesystem::file_size(mFilename, error);
+    if (error)
+    {
+        return false;
+    }
+    if (size != fileSize)
+    {
+        RLOG(LG_CKP, LogLevel::LL_WARNING) << "checkpoint file '" << mFilename << "' is " << size
+                                           << " bytes rather than " << fileSize << " and will be started afresh";
+        return false;
+    }
+
+    mFile = interprocess::file_mapping{mFilename.c_str(), interprocess::read_write};
+    mRegion = interprocess::mapped_region{mFile, interprocess::read_write};
+
+    const auto* header = reinterpret_cast<const CheckpointHeader*>(GetAddress());
+    if (header->mMagic != CHECKPOINT_MAGIC || header->mVersion != CHECKPOINT_VERSION
+        || header->mStateVersion != mStateVersion || header->mStateSize != mStateSize
+        || header->mSlotSize != mSlotSize)
+    {
+        RLOG(LG_CKP, LogLevel::LL_WARNING) << "checkpoint file '" << mFilename
+                                           << "' was written for another version of the state and will be "
+                                              "started afresh";
+        return false;
+    }
+
+    for (std::uint64_t i = 0; i < 2; ++i)
+    {
+        const CheckpointSlotHeader* slot = GetSlot(i);
+        const std::uint64_t end = slot->mEnd.load(std::memory_order_acquire);
+        if (end != 0 && end == slot->mBegin.load(std::memory_order_relaxed) && end > mGeneration)
+        {
+            mGeneration = end;
+            mSaved = reinterpret_cast<const unsigned char*>(slot) + CHECKPOINT_ALIGNMENT;
+        }
+    }
+    return true;
+}
+
+void CheckpointFile::Create(std::size_t fileSize)
+{
+    mRegion = interprocess::mapped_region{};
+    {
+        std::ofstream stream{mFilename, std::ios_base::binary | std::ios_base::trunc};
+        if (!stream)
+        {
+            throw ReadyTraderGoError("failed to create checkpoint file '" + mFilename + "': "
+                                     + std::strerror(errno));
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::resize_file(mFilename, fileSize, error);
+    if (error)
+    {
+        throw ReadyTraderGoError("failed to size checkpoint file '" + mFilename + "': " + error.message());
+    }
+
+    mFile = interprocess::file_mapping{mFilename.c_str(), interprocess::read_write};
+    mRegion = interprocess::mapped_region{mFile, interprocess::read_write};
+
+    auto* header = reinterpret_cast<CheckpointHeader*>(GetAddress());
+    header->mMagic = CHECKPOINT_MAGIC;
+    header->mVersion = CHECKPOINT_VERSION;
+    header->mStateVersion = mStateVersion;
+    header->mStateSize = static_cast<std::uint32_t>(mStateSize);
+    header->mSlotSize = mSlotSize;
+    mSaved = nullptr;
+    mGeneration = 0;
+}
+
+}
@@ -0,0 +1,154 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_CHECKPOINT_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_CHECKPOINT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace ReadyTraderGo {
+
+constexpr std::uint32_t CHECKPOINT_MAGIC = 0x54504b43; // "CKPT" in little-endian order
+constexpr std::uint32_t CHECKPOINT_VERSION = 1;
+constexpr std::size_t CHECKPOINT_ALIGNMENT = 64;
+
+// A checkpoint file starts with this header, padded to the alignment, and is
+// followed by two slots. The state version and size are those given by the
+// owner of the state, so that a file written for a different layout of it is
+// never read back.
+struct CheckpointHeader
+{
+    std::uint32_t mMagic;
+    std::uint32_t mVersion;
+    std::uint32_t mStateVersion;
+    std::uint32_t mStateSize;
+    std::uint64_t mSlotSize;
+};
+
+// Each slot starts with this header, padded to the alignment, and holds one
+// copy of the state. A save stores its generation in mBegin, copies the
+// state and then stores the generation in mEnd (with release semantics), so
+// a slot whose two generations differ was being written when the process
+// stopped.
+struct CheckpointSlotHeader
+{
+    std::atomic<std::uint64_t> mBegin;
+    std::atomic<std::uint64_t> mEnd;
+};
+
+static_assert(sizeof(CheckpointHeader) <= CHECKPOINT_ALIGNMENT, "checkpoint header must fit its alignment");
+static_assert(sizeof(CheckpointSlotHeader) <= CHECKPOINT_ALIGNMENT, "checkpoint slot header must fit its alignment");
+
+// A memory-mapped file holding the latest copy of some state, so that a
+// process can carry on where it, or its predecessor, left off.
+//
+// Save() is intended to be called from the trading thread: it copies the
+// state into the slot not holding the latest copy and makes no system calls,
+// the pages being touched when the file is opened. Because saves alternate
+// between the slots, the latest complete copy survives the process stopping
+// part way through a save. Nothing is flushed to disk, so the state outlives
+// the process but not the machine.
+class CheckpointFile
+{
+public:
+    // Opens the file, creating it if it does not exist. A file written for
+    // another version or size of the state is started afresh.
+    CheckpointFile(const std::string& filename, std::uint32_t stateVersion, std::size_t stateSize);
+
+    CheckpointFile(const CheckpointFile&) = delete;
+    void operator=(const CheckpointFile&) = delete;
+
+    const std::string& GetFilename() const { return mFilename; }
+    std::uint64_t GetSaveCount() const { return mGeneration; }
+
+    // The latest complete copy of the state found when the file was opened,
+    // or null if there was none.
+    const void* GetSaved() const { return mSaved; }
+
+    void Save(const void* state);
+
+private:
+    unsigned char* GetAddress() const { return static_cast<unsigned char*>(mRegion.get_address()); }
+    CheckpointSlotHeader* GetSlot(std::uint64_t generation) const
+    {
+        return reinterpret_cast<CheckpointSlotHeader*>(GetAddress() + CHECKPOINT_ALIGNMENT
+                                                       + (generation & 1) * mSlotSize);
+    }
+    bool Open(std::size_t fileSize);
+    void Create(std::size_t fileSize);
+
+    std::string mFilename;
+    std::uint32_t mStateVersion;
+    std::size_t mStateSize;
+    std::size_t mSlotSize;
+    boost::interprocess::file_mapping mFile;
+    boost::interprocess::mapped_region mRegion;
+    const void* mSaved = nullptr;
+    std::uint64_t mGeneration = 0;
+};
+
+inline void CheckpointFile::Save(const void* state)
+{
+    const std::uint64_t generation = ++mGeneration;
+    CheckpointSlotHeader* slot = GetSlot(generation);
+    slot->mBegin.store(generation, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(reinterpret_cast<unsigned char*>(slot) + CHECKPOINT_ALIGNMENT, state, mStateSize);
+    slot->mEnd.store(generation, std::memory_order_release);
+}
+
+// A checkpoint of a trivially copyable type. The version should be changed
+// whenever the meaning of the type's members changes.
+template<typename T>
+class Checkpoint
+{
+    static_assert(std::is_trivially_copyable_v<T>, "checkpointed state must be trivially copyable");
+
+public:
+    Checkpoint(const std::string& filename, std::uint32_t version) : mFile(filename, version, sizeof(T)) {}
+
+    CheckpointFile& GetFile() { return mFile; }
+
+    // Copies the saved state into the given one, returning false (and
+    // leaving it untouched) if there was none.
+    bool Restore(T& state) const
+    {
+        if (mFile.GetSaved() == nullptr)
+        {
+            return false;
+        }
+        std::memcpy(&state, mFile.GetSaved(), sizeof(T));
+        return true;
+    }
+
+    void Save(const T& state) { mFile.Save(&state); }
+
+private:
+    CheckpointFile mFile;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_CHECKPOINT_H
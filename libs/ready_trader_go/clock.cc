@@ -0,0 +1,51 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <chrono>
+
+#include "clock.h"
+
+namespace ReadyTraderGo {
+
+constexpr auto CLOCK_CALIBRATION_PERIOD = std::chrono::milliseconds(10);
+
+TscClock::Calibration TscClock::Calibrate()
+{
+    const std::uint64_t startTsc = ReadTimestampCounter();
+    const std::uint64_t startRealtime = ReadRealtimeNanoseconds();
+    const auto end = std::chrono::steady_clock::now() + CLOCK_CALIBRATION_PERIOD;
+    while (std::chrono::steady_clock::now() < end)
+    {
+    }
+    const std::uint64_t endTsc = ReadTimestampCounter();
+    const std::uint64_t endRealtime = ReadRealtimeNanoseconds();
+
+    double nanosecondsPerTick = 1.0;
+    if (endTsc > startTsc)
+    {
+        nanosecondsPerTick = double(endRealtime - startRealtime) / double(endTsc - startTsc);
+    }
+    return {endTsc, endRealtime, nanosecondsPerTick};
+}
+
+const IClock& GetSystemClock()
+{
+    static const TscClock clock;
+    return clock;
+}
+
+}
@@ -0,0 +1,143 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_CLOCK_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_CLOCK_H
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#endif
+
+namespace ReadyTraderGo {
+
+constexpr std::uint64_t NANOSECONDS_PER_SECOND = 1000000000;
+
+// Return the raw time stamp counter (or a monotonic nanosecond count on
+// platforms without one).
+inline std::uint64_t ReadTimestampCounter()
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Return nanoseconds since the epoch according to CLOCK_REALTIME.
+inline std::uint64_t ReadRealtimeNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// A source of "now" for the trading thread, in nanoseconds since the epoch.
+// Strategy code that asks its clock for the time, rather than the operating
+// system, can be run in simulated time.
+class IClock
+{
+public:
+    virtual ~IClock() = default;
+
+    virtual std::uint64_t Now() const = 0;
+};
+
+// The production clock: the time stamp counter, calibrated against
+// CLOCK_REALTIME when the clock is constructed. Calibration spins for the
+// calibration period and is never repeated, so the clock can be shared
+// between threads.
+class TscClock : public IClock
+{
+public:
+    TscClock() : TscClock(Calibrate()) {}
+
+    std::uint64_t Now() const override
+    {
+        // Another core's counter may read a little behind the base.
+        const auto ticks = static_cast<std::int64_t>(ReadTimestampCounter() - mBaseTsc);
+        const auto nanoseconds = static_cast<std::int64_t>(double(ticks) * mNanosecondsPerTick);
+        return mBaseRealtime + static_cast<std::uint64_t>(nanoseconds);
+    }
+
+    double GetNanosecondsPerTick() const { return mNanosecondsPerTick; }
+
+private:
+    struct Calibration
+    {
+        std::uint64_t mBaseTsc;
+        std::uint64_t mBaseRealtime;
+        double mNanosecondsPerTick;
+    };
+
+    // Measure the counter's frequency and anchor it to the realtime clock.
+    static Calibration Calibrate();
+
+    explicit TscClock(const Calibration& calibration)
+        : mBaseTsc(calibration.mBaseTsc),
+          mBaseRealtime(calibration.mBaseRealtime),
+          mNanosecondsPerTick(calibration.mNanosecondsPerTick) {}
+
+    const std::uint64_t mBaseTsc;
+    const std::uint64_t mBaseRealtime;
+    const double mNanosecondsPerTick;
+};
+
+// A clock that only moves when told to, for simulation.
+class VirtualClock : public IClock
+{
+public:
+    explicit VirtualClock(std::uint64_t now = 0) : mNow(now) {}
+
+    std::uint64_t Now() const override { return mNow; }
+
+    void Advance(std::uint64_t nanoseconds) { mNow += nanoseconds; }
+    void SetTime(std::uint64_t now) { mNow = now; }
+
+private:
+    std::uint64_t mNow;
+};
+
+// A clock driven by the time stamps of recorded events, for replay. Time
+// never goes backwards, even if the recorded time stamps do.
+class ReplayClock : public IClock
+{
+public:
+    std::uint64_t Now() const override { return mNow; }
+
+    void OnEvent(std::uint64_t timestamp)
+    {
+        if (timestamp > mNow)
+        {
+            mNow = timestamp;
+        }
+    }
+
+private:
+    std::uint64_t mNow = 0;
+};
+
+// Return the process-wide production clock.
+const IClock& GetSystemClock();
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_CLOCK_H
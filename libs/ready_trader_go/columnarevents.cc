@@ -0,0 +1,460 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "columnarevents.h"
+#include "error.h"
+#include "types.h"
+
+namespace interprocess = boost::interprocess;
+
+namespace ReadyTraderGo {
+
+constexpr std::array<std::string_view, EVENT_OPERATION_COUNT> EVENT_OPERATION_NAMES = {
+    "Amend",
+    "Cancel",
+    "Insert",
+    "Hedge",
+    "Trade"
+};
+
+static std::uint64_t alignOffset(std::uint64_t offset)
+{
+    return (offset + COLUMNAR_EVENTS_ALIGNMENT - 1) & ~(COLUMNAR_EVENTS_ALIGNMENT - 1);
+}
+
+// Return the size of a dictionary: a count, count + 1 offsets and the
+// concatenated strings.
+template<typename Container>
+static std::uint64_t dictionarySize(const Container& names)
+{
+    std::uint64_t size = sizeof(std::uint32_t) * (names.size() + 2);
+    for (auto& name : names)
+    {
+        size += name.size();
+    }
+    return size;
+}
+
+template<typename Container>
+static void writeDictionary(std::ostream& out, const Container& names)
+{
+    std::vector<std::uint32_t> table;
+    table.push_back(static_cast<std::uint32_t>(names.size()));
+    std::uint32_t offset = 0;
+    table.push_back(offset);
+    for (auto& name : names)
+    {
+        offset += static_cast<std::uint32_t>(name.size());
+        table.push_back(offset);
+    }
+    out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(std::uint32_t));
+    for (auto& name : names)
+    {
+        out.write(name.data(), name.size());
+    }
+}
+
+template<typename T>
+static void writeColumn(std::ostream& out, std::uint64_t offset, const std::vector<T>& column)
+{
+    out.seekp(offset);
+    out.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T));
+}
+
+void ColumnarEventsBuilder::Append(const EventRow& row)
+{
+    if (!mTimes.empty() && row.mTime < mTimes.back())
+    {
+        throw ReadyTraderGoError("events must be in time order");
+    }
+
+    std::uint16_t competitor = 0;
+    if (!row.mCompetitor.empty())
+    {
+        std::string name{row.mCompetitor};
+        auto it = mCompetitorCodes.find(name);
+        if (it == mCompetitorCodes.end())
+        {
+            if (mCompetitorNames.size() > std::numeric_limits<std::uint16_t>::max())
+            {
+                throw ReadyTraderGoError("too many distinct competitors");
+            }
+            it = mCompetitorCodes.emplace(name, static_cast<std::uint16_t>(mCompetitorNames.size())).first;
+            mCompetitorNames.push_back(name);
+        }
+        competitor = it->second;
+    }
+
+    mTimes.push_back(row.mTime);
+    mCompetitors.push_back(competitor);
+    mOperations.push_back(row.mOperation);
+    mOrderIds.push_back(row.mOrderId);
+    mInstruments.push_back(row.mInstrument);
+    mSides.push_back(row.mSide);
+    mVolumes.push_back(row.mVolume);
+    mPrices.push_back(row.mPrice);
+    mLifespans.push_back(row.mLifespan);
+    mFees.push_back(row.mFee);
+}
+
+void ColumnarEventsBuilder::Write(const std::string& filename) const
+{
+    const std::uint64_t rowCount = mTimes.size();
+
+    ColumnarEventsHeader header{};
+    header.mMagic = COLUMNAR_EVENTS_MAGIC;
+    header.mVersion = COLUMNAR_EVENTS_VERSION;
+    header.mSource = mSource;
+    header.mRowCount = rowCount;
+
+    const std::array<std::size_t, EventColumn::COLUMN_COUNT> widths = {
+        sizeof(std::int64_t),
+        sizeof(std::uint16_t),
+        sizeof(EventOperation),
+        sizeof(std::uint64_t),
+        sizeof(std::uint8_t),
+        sizeof(std::uint8_t),
+        sizeof(std::int32_t),
+        sizeof(std::uint32_t),
+        sizeof(std::uint8_t),
+        sizeof(std::int32_t)
+    };
+
+    std::uint64_t offset = alignOffset(sizeof(ColumnarEventsHeader));
+    for (std::size_t c = 0; c < EventColumn::COLUMN_COUNT; ++c)
+    {
+        header.mColumnOffsets[c] = offset;
+        offset = alignOffset(offset + widths[c] * rowCount);
+    }
+
+    // The time index holds, for each interval, the first row at or after
+    // the start of that interval.
+    std::vector<std::uint64_t> index;
+    header.mIndexInterval = COLUMNAR_EVENTS_INDEX_INTERVAL;
+    if (rowCount != 0)
+    {
+        auto floorDiv = [](std::int64_t a, std::int64_t b) { return a / b - ((a % b != 0) && (a < 0)); };
+        header.mIndexStart = floorDiv(mTimes.front(), COLUMNAR_EVENTS_INDEX_INTERVAL) * COLUMNAR_EVENTS_INDEX_INTERVAL;
+        const std::uint64_t count = (mTimes.back() - header.mIndexStart) / COLUMNAR_EVENTS_INDEX_INTERVAL + 1;
+        index.reserve(count);
+        std::uint64_t row = 0;
+        for (std::uint64_t b = 0; b < count; ++b)
+        {
+            const std::int64_t start = header.mIndexStart + static_cast<std::int64_t>(b) * COLUMNAR_EVENTS_INDEX_INTERVAL;
+            while (row < rowCount && mTimes[row] < start)
+            {
+                ++row;
+            }
+            index.push_back(row);
+        }
+    }
+    header.mIndexOffset = offset;
+    header.mIndexCount = index.size();
+    offset = alignOffset(offset + index.size() * sizeof(std::uint64_t));
+
+    header.mCompetitorDictionaryOffset = offset;
+    offset = alignOffset(offset + dictionarySize(mCompetitorNames));
+    header.mOperationDictionaryOffset = offset;
+    offset = alignOffset(offset + dictionarySize(EVENT_OPERATION_NAMES));
+    header.mFileSize = offset;
+
+    std::ofstream out{filename, std::ios_base::binary | std::ios_base::trunc};
+    if (!out)
+    {
+        throw ReadyTraderGoError("failed to create '" + filename + "': " + std::strerror(errno));
+    }
+
+    // Size the file first so that every padding byte is zero.
+    out.seekp(header.mFileSize - 1);
+    out.put('\0');
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeColumn(out, header.mColumnOffsets[EventColumn::TIME], mTimes);
+    writeColumn(out, header.mColumnOffsets[EventColumn::COMPETITOR], mCompetitors);
+    writeColumn(out, header.mColumnOffsets[EventColumn::OPERATION], mOperations);
+    writeColumn(out, header.mColumnOffsets[EventColumn::ORDER_ID], mOrderIds);
+    writeColumn(out, header.mColumnOffsets[EventColumn::INSTRUMENT], mInstruments);
+    writeColumn(out, header.mColumnOffsets[EventColumn::SIDE], mSides);
+    writeColumn(out, header.mColumnOffsets[EventColumn::VOLUME], mVolumes);
+    writeColumn(out, header.mColumnOffsets[EventColumn::PRICE], mPrices);
+    writeColumn(out, header.mColumnOffsets[EventColumn::LIFESPAN], mLifespans);
+    writeColumn(out, header.mColumnOffsets[EventColumn::FEE], mFees);
+    writeColumn(out, header.mIndexOffset, index);
+    out.seekp(header.mCompetitorDictionaryOffset);
+    writeDictionary(out, mCompetitorNames);
+    out.seekp(header.mOperationDictionaryOffset);
+    writeDictionary(out, EVENT_OPERATION_NAMES);
+
+    if (!out.flush())
+    {
+        throw ReadyTraderGoError("failed to write '" + filename + "'");
+    }
+}
+
+// Split a CSV line (which never contains quoted fields) into its fields.
+template<std::size_t N>
+static bool splitCsvLine(std::string_view line, std::array<std::string_view, N>& fields)
+{
+    std::size_t field = 0;
+    std::size_t start = 0;
+    for (;;)
+    {
+        auto comma = line.find(',', start);
+        if (field == N)
+        {
+            return false;
+        }
+        if (comma == std::string_view::npos)
+        {
+            fields[field++] = line.substr(start);
+            return field == N;
+        }
+        fields[field++] = line.substr(start, comma - start);
+        start = comma + 1;
+    }
+}
+
+static double parseNumber(std::string_view field, std::size_t lineNumber)
+{
+    if (field.empty())
+    {
+        return 0.0;
+    }
+    char buffer[64];
+    if (field.size() >= sizeof(buffer))
+    {
+        throw ReadyTraderGoError("field too long at line " + std::to_string(lineNumber));
+    }
+    std::memcpy(buffer, field.data(), field.size());
+    buffer[field.size()] = '\0';
+    char* end = nullptr;
+    double value = std::strtod(buffer, &end);
+    if (end != buffer + field.size())
+    {
+        throw ReadyTraderGoError("invalid number '" + std::string(field) + "' at line " + std::to_string(lineNumber));
+    }
+    return value;
+}
+
+static EventOperation parseOperation(std::string_view field, std::size_t lineNumber)
+{
+    for (std::size_t i = 0; i < EVENT_OPERATION_COUNT; ++i)
+    {
+        if (field == EVENT_OPERATION_NAMES[i])
+        {
+            return static_cast<EventOperation>(i);
+        }
+    }
+    throw ReadyTraderGoError("invalid operation '" + std::string(field) + "' at line " + std::to_string(lineNumber));
+}
+
+static std::uint8_t parseSide(std::string_view field, std::size_t lineNumber)
+{
+    if (field.empty())
+        return COLUMNAR_NONE;
+    if (field == "A" || field == "ASK" || field == "SELL")
+        return static_cast<std::uint8_t>(Side::SELL);
+    if (field == "B" || field == "BID" || field == "BUY")
+        return static_cast<std::uint8_t>(Side::BUY);
+    throw ReadyTraderGoError("invalid side '" + std::string(field) + "' at line " + std::to_string(lineNumber));
+}
+
+static std::uint8_t parseLifespan(std::string_view field, std::size_t lineNumber)
+{
+    if (field.empty())
+        return COLUMNAR_NONE;
+    if (field == "F" || field == "FAK" || field == "FILL_AND_KILL")
+        return static_cast<std::uint8_t>(Lifespan::FILL_AND_KILL);
+    if (field == "G" || field == "GFD" || field == "GOOD_FOR_DAY")
+        return static_cast<std::uint8_t>(Lifespan::GOOD_FOR_DAY);
+    throw ReadyTraderGoError("invalid lifespan '" + std::string(field) + "' at line " + std::to_string(lineNumber));
+}
+
+static std::uint8_t parseInstrument(std::string_view field, std::size_t lineNumber)
+{
+    if (field.empty())
+        return COLUMNAR_NONE;
+    if (field == "0")
+        return static_cast<std::uint8_t>(Instrument::FUTURE);
+    if (field == "1")
+        return static_cast<std::uint8_t>(Instrument::ETF);
+    throw ReadyTraderGoError("invalid instrument '" + std::string(field) + "' at line " + std::to_string(lineNumber));
+}
+
+static std::int64_t parseTime(std::string_view field, std::size_t lineNumber)
+{
+    return std::llround(parseNumber(field, lineNumber) * 1e6);
+}
+
+ColumnarEventsBuilder parseEventsCsv(std::istream& in)
+{
+    std::string line;
+    if (!std::getline(in, line))
+    {
+        throw ReadyTraderGoError("events file is empty");
+    }
+    if (!line.empty() && line.back() == '\r')
+    {
+        line.pop_back();
+    }
+
+    EventSource source;
+    if (line.rfind("Time,Competitor,", 0) == 0)
+    {
+        source = EventSource::MATCH_EVENTS;
+    }
+    else if (line.rfind("Time,Instrument,", 0) == 0)
+    {
+        source = EventSource::MARKET_DATA;
+    }
+    else
+    {
+        throw ReadyTraderGoError("unrecognised events file header: '" + line + "'");
+    }
+
+    ColumnarEventsBuilder builder{source};
+    std::size_t lineNumber = 1;
+    std::array<std::string_view, 10> matchFields;
+    std::array<std::string_view, 8> marketFields;
+
+    while (std::getline(in, line))
+    {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        if (line.empty())
+        {
+            continue;
+        }
+
+        EventRow row;
+        if (source == EventSource::MATCH_EVENTS)
+        {
+            if (!splitCsvLine(line, matchFields))
+            {
+                throw ReadyTraderGoError("wrong number of fields at line " + std::to_string(lineNumber));
+            }
+            row.mTime = parseTime(matchFields[0], lineNumber);
+            row.mCompetitor = matchFields[1];
+            row.mOperation = parseOperation(matchFields[2], lineNumber);
+            row.mOrderId = static_cast<std::uint64_t>(parseNumber(matchFields[3], lineNumber));
+            row.mInstrument = parseInstrument(matchFields[4], lineNumber);
+            row.mSide = parseSide(matchFields[5], lineNumber);
+            row.mVolume = static_cast<std::int32_t>(parseNumber(matchFields[6], lineNumber));
+            row.mPrice = static_cast<std::uint32_t>(std::llround(parseNumber(matchFields[7], lineNumber)));
+            row.mLifespan = parseLifespan(matchFields[8], lineNumber);
+            if (!matchFields[9].empty())
+            {
+                row.mFee = static_cast<std::int32_t>(std::llround(parseNumber(matchFields[9], lineNumber)));
+            }
+        }
+        else
+        {
+            if (!splitCsvLine(line, marketFields))
+            {
+                throw ReadyTraderGoError("wrong number of fields at line " + std::to_string(lineNumber));
+            }
+            // Market data prices are in dollars and are truncated to cents,
+            // exactly as the exchange does.
+            row.mTime = parseTime(marketFields[0], lineNumber);
+            row.mInstrument = parseInstrument(marketFields[1], lineNumber);
+            row.mOperation = parseOperation(marketFields[2], lineNumber);
+            row.mOrderId = static_cast<std::uint64_t>(parseNumber(marketFields[3], lineNumber));
+            row.mSide = parseSide(marketFields[4], lineNumber);
+            row.mVolume = static_cast<std::int32_t>(parseNumber(marketFields[5], lineNumber));
+            row.mPrice = static_cast<std::uint32_t>(parseNumber(marketFields[6], lineNumber) * 100.0);
+            row.mLifespan = parseLifespan(marketFields[7], lineNumber);
+        }
+        builder.Append(row);
+    }
+
+    return builder;
+}
+
+ColumnarEvents::ColumnarEvents(const std::string& filename)
+{
+    mFile = interprocess::file_mapping{filename.c_str(), interprocess::read_only};
+    mRegion = interprocess::mapped_region{mFile, interprocess::read_only};
+    mBase = static_cast<const unsigned char*>(mRegion.get_address());
+    mHeader = reinterpret_cast<const ColumnarEventsHeader*>(mBase);
+
+    if (mRegion.get_size() < sizeof(ColumnarEventsHeader) || mHeader->mMagic != COLUMNAR_EVENTS_MAGIC)
+    {
+        throw ReadyTraderGoError("'" + filename + "' is not a columnar events file");
+    }
+    if (mHeader->mVersion != COLUMNAR_EVENTS_VERSION)
+    {
+        throw ReadyTraderGoError("columnar events file '" + filename + "' has unsupported version "
+                                 + std::to_string(mHeader->mVersion));
+    }
+    if (mHeader->mFileSize != mRegion.get_size())
+    {
+        throw ReadyTraderGoError("columnar events file '" + filename + "' is truncated");
+    }
+}
+
+std::string_view ColumnarEvents::DictionaryEntry(std::uint64_t offset, std::size_t code) const
+{
+    const std::uint32_t* table = Dictionary(offset);
+    const std::uint32_t count = table[0];
+    if (code >= count)
+    {
+        return {};
+    }
+    const char* strings = reinterpret_cast<const char*>(table + count + 2);
+    return {strings + table[code + 1], table[code + 2] - table[code + 1]};
+}
+
+std::size_t ColumnarEvents::FindFirstRow(std::int64_t time) const
+{
+    const std::size_t rowCount = GetRowCount();
+    if (rowCount == 0 || time <= mHeader->mIndexStart)
+    {
+        return 0;
+    }
+
+    const std::uint64_t bucket = (time - mHeader->mIndexStart) / mHeader->mIndexInterval;
+    if (bucket >= mHeader->mIndexCount)
+    {
+        return rowCount;
+    }
+
+    const auto* index = reinterpret_cast<const std::uint64_t*>(mBase + mHeader->mIndexOffset);
+    const std::size_t first = index[bucket];
+    const std::size_t last = (bucket + 1 < mHeader->mIndexCount) ? index[bucket + 1] : rowCount;
+    const std::int64_t* times = GetTimes();
+    return std::lower_bound(times + first, times + last, time) - times;
+}
+
+}
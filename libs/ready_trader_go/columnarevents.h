@@ -0,0 +1,205 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_COLUMNAREVENTS_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_COLUMNAREVENTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace ReadyTraderGo {
+
+constexpr std::uint32_t COLUMNAR_EVENTS_MAGIC = 0x43475452; // "RTGC" in little-endian order
+constexpr std::uint32_t COLUMNAR_EVENTS_VERSION = 1;
+constexpr std::size_t COLUMNAR_EVENTS_ALIGNMENT = 64;
+constexpr std::int64_t COLUMNAR_EVENTS_INDEX_INTERVAL = 1000000; // one second in microseconds
+
+// Marker for an empty instrument, side or lifespan.
+constexpr std::uint8_t COLUMNAR_NONE = 0xff;
+// Marker for an empty fee.
+constexpr std::int32_t COLUMNAR_NO_FEE = std::numeric_limits<std::int32_t>::min();
+
+// Which of the exchange's CSV formats the events came from.
+enum class EventSource : std::uint32_t
+{
+    // Time,Instrument,Operation,OrderId,Side,Volume,Price,Lifespan
+    MARKET_DATA,
+    // Time,Competitor,Operation,OrderId,Instrument,Side,Volume,Price,Lifespan,Fee
+    MATCH_EVENTS
+};
+
+// Values match MatchEventOperation (and MarketEventOperation) in the exchange.
+enum class EventOperation : std::uint8_t
+{
+    AMEND,
+    CANCEL,
+    INSERT,
+    HEDGE,
+    TRADE
+};
+
+constexpr std::size_t EVENT_OPERATION_COUNT = 5;
+
+enum EventColumn : std::size_t
+{
+    TIME,
+    COMPETITOR,
+    OPERATION,
+    ORDER_ID,
+    INSTRUMENT,
+    SIDE,
+    VOLUME,
+    PRICE,
+    LIFESPAN,
+    FEE,
+    COLUMN_COUNT
+};
+
+struct ColumnarEventsHeader
+{
+    std::uint32_t mMagic;
+    std::uint32_t mVersion;
+    EventSource mSource;
+    std::uint32_t mReserved;
+    std::uint64_t mRowCount;
+    std::uint64_t mColumnOffsets[EventColumn::COLUMN_COUNT];
+    std::int64_t mIndexInterval;
+    std::int64_t mIndexStart;
+    std::uint64_t mIndexOffset;
+    std::uint64_t mIndexCount;
+    std::uint64_t mCompetitorDictionaryOffset;
+    std::uint64_t mOperationDictionaryOffset;
+    std::uint64_t mFileSize;
+};
+
+// A single event, used when building a columnar file. Times are in
+// microseconds and prices in cents.
+struct EventRow
+{
+    std::int64_t mTime = 0;
+    std::string_view mCompetitor;
+    EventOperation mOperation = EventOperation::INSERT;
+    std::uint64_t mOrderId = 0;
+    std::uint8_t mInstrument = COLUMNAR_NONE;
+    std::uint8_t mSide = COLUMNAR_NONE;
+    std::int32_t mVolume = 0;
+    std::uint32_t mPrice = 0;
+    std::uint8_t mLifespan = COLUMNAR_NONE;
+    std::int32_t mFee = COLUMNAR_NO_FEE;
+};
+
+// Accumulates events column by column and writes them out as a columnar
+// events file.
+class ColumnarEventsBuilder
+{
+public:
+    explicit ColumnarEventsBuilder(EventSource source) : mSource(source) {}
+
+    void Append(const EventRow& row);
+    std::size_t GetRowCount() const { return mTimes.size(); }
+    void Write(const std::string& filename) const;
+
+private:
+    EventSource mSource;
+    std::vector<std::int64_t> mTimes;
+    std::vector<std::uint16_t> mCompetitors;
+    std::vector<EventOperation> mOperations;
+    std::vector<std::uint64_t> mOrderIds;
+    std::vector<std::uint8_t> mInstruments;
+    std::vector<std::uint8_t> mSides;
+    std::vector<std::int32_t> mVolumes;
+    std::vector<std::uint32_t> mPrices;
+    std::vector<std::uint8_t> mLifespans;
+    std::vector<std::int32_t> mFees;
+    std::vector<std::string> mCompetitorNames{""};
+    std::unordered_map<std::string, std::uint16_t> mCompetitorCodes{{"", 0}};
+};
+
+// Parse a market data or match events CSV file (the format is determined
+// from the header row) into a builder.
+ColumnarEventsBuilder parseEventsCsv(std::istream& in);
+
+// A read-only, memory-mapped columnar events file. Opening a file only
+// validates its header: every column is used in place.
+class ColumnarEvents
+{
+public:
+    explicit ColumnarEvents(const std::string& filename);
+
+    ColumnarEvents(const ColumnarEvents&) = delete;
+    void operator=(const ColumnarEvents&) = delete;
+
+    EventSource GetSource() const { return mHeader->mSource; }
+    std::size_t GetRowCount() const { return mHeader->mRowCount; }
+
+    const std::int64_t* GetTimes() const { return Column<std::int64_t>(EventColumn::TIME); }
+    const std::uint16_t* GetCompetitors() const { return Column<std::uint16_t>(EventColumn::COMPETITOR); }
+    const EventOperation* GetOperations() const { return Column<EventOperation>(EventColumn::OPERATION); }
+    const std::uint64_t* GetOrderIds() const { return Column<std::uint64_t>(EventColumn::ORDER_ID); }
+    const std::uint8_t* GetInstruments() const { return Column<std::uint8_t>(EventColumn::INSTRUMENT); }
+    const std::uint8_t* GetSides() const { return Column<std::uint8_t>(EventColumn::SIDE); }
+    const std::int32_t* GetVolumes() const { return Column<std::int32_t>(EventColumn::VOLUME); }
+    const std::uint32_t* GetPrices() const { return Column<std::uint32_t>(EventColumn::PRICE); }
+    const std::uint8_t* GetLifespans() const { return Column<std::uint8_t>(EventColumn::LIFESPAN); }
+    const std::int32_t* GetFees() const { return Column<std::int32_t>(EventColumn::FEE); }
+
+    std::size_t GetCompetitorCount() const { return Dictionary(mHeader->mCompetitorDictionaryOffset)[0]; }
+    std::string_view GetCompetitorName(std::uint16_t code) const
+    {
+        return DictionaryEntry(mHeader->mCompetitorDictionaryOffset, code);
+    }
+    std::string_view GetOperationName(EventOperation operation) const
+    {
+        return DictionaryEntry(mHeader->mOperationDictionaryOffset, static_cast<std::size_t>(operation));
+    }
+
+    // Return the index of the first event at or after the given time (in
+    // microseconds), or the row count if there is none.
+    std::size_t FindFirstRow(std::int64_t time) const;
+
+private:
+    template<typename T>
+    const T* Column(EventColumn column) const
+    {
+        return reinterpret_cast<const T*>(mBase + mHeader->mColumnOffsets[column]);
+    }
+
+    const std::uint32_t* Dictionary(std::uint64_t offset) const
+    {
+        return reinterpret_cast<const std::uint32_t*>(mBase + offset);
+    }
+
+    std::string_view DictionaryEntry(std::uint64_t offset, std::size_t code) const;
+
+    boost::interprocess::file_mapping mFile;
+    boost::interprocess::mapped_region mRegion;
+    const unsigned char* mBase = nullptr;
+    const ColumnarEventsHeader* mHeader = nullptr;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_COLUMNAREVENTS_H
@@ -18,10 +18,15 @@
 #ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_CONFIG_H
 #define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_CONFIG_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 #include <boost/property_tree/ptree.hpp>
 
+#include "journal.h"
+#include "trace.h"
+
 namespace ReadyTraderGo {
 
 struct Config
@@ -30,22 +35,67 @@ struct Config
     {
         mExecHost = tree.get<std::string>("Execution.Host");
         mExecPort = tree.get<unsigned short>("Execution.Port");
+        mExecTransport = tree.get<std::string>("Execution.Transport", "asio");
+        mExecSqPoll = tree.get<bool>("Execution.SqPoll", false);
+        mExecBusyPoll = tree.get<bool>("Execution.BusyPoll", false);
+        mExecTimestamping = tree.get<bool>("Execution.Timestamping", true);
+        mExecReconnect = tree.get<bool>("Execution.Reconnect", false);
+        mExecReconnectAttempts = tree.get<unsigned>("Execution.ReconnectAttempts", 50);
+        mExecReconnectInterval = tree.get<double>("Execution.ReconnectInterval", 0.1);
+        mExecConnectTimeout = tree.get<double>("Execution.ConnectTimeout", 1.0);
+        mExecReconcileTimeout = tree.get<double>("Execution.ReconcileTimeout", 1.0);
 
         mInfoType = tree.get<std::string>("Information.Type");
         mInfoName = tree.get<std::string>("Information.Name");
 
         mTeamName = tree.get<std::string>("TeamName");
         mSecret = tree.get<std::string>("Secret");
+
+        mJournalName = tree.get<std::string>("Journal.Name", "");
+        mJournalSegmentSize = tree.get<std::size_t>("Journal.SegmentSize", JOURNAL_DEFAULT_SEGMENT_SIZE);
+
+        mCheckpointFile = tree.get<std::string>("Checkpoint.File", "");
+
+        mMetricsFile = tree.get<std::string>("Profile.MetricsFile", "");
+
+        mAllocationWarmupMessages = tree.get<std::uint64_t>("Allocation.WarmupMessages", 0);
+        mAllocationPolicy = tree.get<std::string>("Allocation.Policy", "report");
+
+        mTraceFile = tree.get<std::string>("Trace.File", "");
+        mTraceSeconds = tree.get<double>("Trace.Seconds", TRACE_DEFAULT_SECONDS);
     }
 
     std::string mExecHost;
     unsigned short mExecPort;
+    std::string mExecTransport;
+    bool mExecSqPoll;
+    bool mExecBusyPoll;
+    bool mExecTimestamping;
+    bool mExecReconnect;
+    unsigned mExecReconnectAttempts;
+    // In seconds.
+    double mExecReconnectInterval;
+    double mExecConnectTimeout;
+    double mExecReconcileTimeout;
 
     std::string mInfoType;
     std::string mInfoName;
 
     std::string mTeamName;
     std::string mSecret;
+
+    std::string mJournalName;
+    std::size_t mJournalSegmentSize;
+
+    std::string mCheckpointFile;
+
+    std::string mMetricsFile;
+
+    std::uint64_t mAllocationWarmupMessages;
+    std::string mAllocationPolicy;
+
+    std::string mTraceFile;
+    double mTraceSeconds;
 };
 
 }
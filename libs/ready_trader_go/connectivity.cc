@@ -15,7 +15,10 @@
 //     You should have received a copy of the GNU Affero General Public
 //     License along with Ready Trader Go.  If not, see
 //     <https://www.gnu.org/licenses/>.
+#include <cerrno>
+#include <csignal>
 #include <cstddef>
+#include <cstring>
 #include <iomanip>
 #include <memory>
 #include <string>
@@ -31,9 +34,21 @@
 #include <boost/interprocess/mapped_region.hpp>
 #include <boost/system/error_code.hpp>
 
+#ifdef __linux__
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#endif
+
+#include "clock.h"
 #include "connectivity.h"
 #include "error.h"
+#include "handlermemory.h"
 #include "logging.h"
+#include "protocol.h"
+#include "trace.h"
+#include "types.h"
 
 namespace error = boost::asio::error;
 namespace interprocess = boost::interprocess;
@@ -44,6 +59,20 @@ RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_CON, "CON")
 
 namespace ReadyTraderGo {
 
+// The receive loop re-posts itself for every frame, so its handler lives in
+// fixed storage rather than being allocated each time.
+static HandlerMemory gReceiveMemory;
+#ifdef __linux__
+static HandlerMemory gCompletionMemory;
+static HandlerMemory gFlushMemory;
+
+// Provided buffers belong to this group, and each operation's user data
+// says which kind of operation completed.
+constexpr unsigned short IO_URING_BUFFER_GROUP = 0;
+constexpr std::uint64_t IO_URING_RECEIVE = 1;
+constexpr std::uint64_t IO_URING_WRITE = 2;
+#endif
+
 // Theoretical maximum size of an (IPv4) UDP packet (actual maximum is lower).
 constexpr std::size_t READ_SIZE = 65535;
 
@@ -67,12 +96,66 @@ Connection::~Connection()
 
 void Connection::AsyncRead()
 {
+#ifdef __linux__
+    // Reading with recvmsg, rather than letting Asio read, also collects the
+    // time stamps the kernel attaches to the data.
+    mSocket.async_wait(tcp::socket::wait_read, [this](auto& error) { ReadableHandler(error); });
+#else
     auto buf = mInBuffer.prepare(READ_SIZE);
     mSocket.async_read_some(
         buf,
         [this](auto& error, auto size) { ReadSomeHandler(error, size); });
+#endif
+}
+
+#ifdef __linux__
+static std::uint64_t timespecNanoseconds(const timespec& time)
+{
+    return std::uint64_t(time.tv_sec) * 1000000000ULL + std::uint64_t(time.tv_nsec);
 }
 
+void Connection::ReadableHandler(const boost::system::error_code& error)
+{
+    if (error)
+    {
+        ReadSomeHandler(error, 0);
+        return;
+    }
+
+    auto buf = mInBuffer.prepare(READ_SIZE);
+    iovec vector{buf.data(), buf.size()};
+    alignas(cmsghdr) unsigned char control[CMSG_SPACE(sizeof(scm_timestamping))];
+    msghdr message{};
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    const ssize_t size = recvmsg(mSocket.native_handle(), &message, MSG_DONTWAIT);
+    if (size <= 0)
+    {
+        ReadSomeHandler(size == 0 ? boost::system::error_code(error::eof)
+                                  : boost::system::error_code(errno, boost::system::system_category()), 0);
+        return;
+    }
+
+    mReceiveTimestamps.mHardware = mReceiveTimestamps.mSoftware = 0;
+    for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header))
+    {
+        if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_TIMESTAMPING)
+        {
+            // ts[0] is the software time stamp and ts[2] the raw hardware one.
+            scm_timestamping timestamps;
+            std::memcpy(&timestamps, CMSG_DATA(header), sizeof(timestamps));
+            mReceiveTimestamps.mSoftware = timespecNanoseconds(timestamps.ts[0]);
+            mReceiveTimestamps.mHardware = timespecNanoseconds(timestamps.ts[2]);
+        }
+    }
+
+    ReadSomeHandler(error, size);
+}
+#endif
+
 void Connection::ReadSomeHandler(const boost::system::error_code& error, std::size_t size)
 {
     if (error)
@@ -97,13 +180,15 @@ void Connection::ReadSomeHandler(const boost::system::error_code& error, std::si
         return;
     }
 
+    mReceiveTimestamps.mRead = ReadRealtimeNanoseconds();
+    RTG_TRACE_SPAN("exec read");
     RLOG(LG_CON, LogLevel::LL_DEBUG) << std::quoted(mName, '\'') << " received " << size
                                      << " bytes";
     mInBuffer.commit(size);
 
     auto* const begin = (unsigned char const*) mInBuffer.data().data();
     auto* upto = begin;
-    auto available = size;
+    auto available = mInBuffer.size();
 
     while (available >= MESSAGE_HEADER_SIZE)
     {
@@ -115,6 +200,10 @@ void Connection::ReadSomeHandler(const boost::system::error_code& error, std::si
         RLOG(LG_CON, LogLevel::LL_DEBUG) << std::quoted(mName, '\'')
                                          << " received message with type=" << static_cast<int>(messageType)
                                          << " and size=" << messageLength;
+        if (mJournal)
+        {
+            mJournal->Record(JournalDirection::EXEC_IN, upto, messageLength);
+        }
         OnMessageReceipt(messageType, upto + MESSAGE_HEADER_SIZE, messageLength - MESSAGE_HEADER_SIZE);
 
         upto += messageLength;
@@ -153,12 +242,17 @@ void Connection::Send(SendMode mode)
 
 void Connection::SendMessage(unsigned char messageType, const ISerialisable& serialisable, SendMode mode)
 {
+    RTG_TRACE_SPAN("exec send");
     const std::size_t size = MESSAGE_HEADER_SIZE + serialisable.Size();
     auto buf = mOutBuffer.prepare(size);
     auto* data = static_cast<unsigned char*>(buf.data());
     *(uint16_t*)data = boost::endian::native_to_big((uint16_t)size);
     data[MESSAGE_TYPE_OFFSET] = messageType;
     serialisable.Serialise(data + MESSAGE_HEADER_SIZE);
+    if (mJournal)
+    {
+        mJournal->Record(JournalDirection::EXEC_OUT, data, size);
+    }
     mOutBuffer.commit(size);
     if (!mIsSending)
     {
@@ -168,12 +262,21 @@ void Connection::SendMessage(unsigned char messageType, const ISerialisable& ser
 
 void Connection::WriteSomeHandler(const boost::system::error_code& error, std::size_t size)
 {
+    RTG_TRACE_SPAN("exec write complete");
     if (error)
     {
         if (error != error::interrupted && error != error::would_block && error != error::try_again)
         {
             RLOG(LG_CON, LogLevel::LL_ERROR) << std::quoted(mName, '\'') << " send failed: "
                                              << error.message();
+            if (mDisconnectOnSendError)
+            {
+                // What was waiting to go will never arrive.
+                mOutBuffer.consume(mOutBuffer.size());
+                mIsSending = false;
+                OnDisconnect();
+                return;
+            }
             throw ReadyTraderGoError("send failed: " + error.message());
         }
         RLOG(LG_CON, LogLevel::LL_DEBUG) << std::quoted(mName, '\'') << " send interrupted: "
@@ -197,6 +300,368 @@ void Connection::WriteSomeHandler(const boost::system::error_code& error, std::s
     }
 }
 
+#ifdef __linux__
+IoUringConnection::IoUringConnection(boost::asio::io_context& context,
+                                     tcp::socket&& socket,
+                                     std::unique_ptr<IoUring>&& ring,
+                                     bool busyPoll)
+    : mContext(context),
+      mSocket(context),
+      mRing(std::move(ring)),
+      mBufferRingMemory(IO_URING_RECEIVE_BUFFER_COUNT * sizeof(io_uring_buf)),
+      mReceiveBuffers(IO_URING_RECEIVE_BUFFER_COUNT * IO_URING_RECEIVE_BUFFER_SIZE),
+      mSendBuffer(IO_URING_SEND_BUFFER_SIZE),
+      mBufferRing(reinterpret_cast<io_uring_buf_ring*>(mBufferRingMemory.Data())),
+      mBufferRingEntries(reinterpret_cast<io_uring_buf*>(mBufferRingMemory.Data())),
+      mEventDescriptor(context),
+      mAlive(std::make_shared<bool>(true)),
+      mBusyPoll(busyPoll)
+{
+    // Nothing here takes the socket until setup has succeeded, so should the
+    // kernel lack something the caller can still use it some other way.
+    SetName('\'' + std::to_string(socket.local_endpoint().port()) + '\'');
+
+    // A partial message never exceeds the largest message plus one buffer.
+    mPartial.reserve(65536 + IO_URING_RECEIVE_BUFFER_SIZE);
+
+    iovec sendBuffer{mSendBuffer.Data(), mSendBuffer.Size()};
+    mRing->RegisterBuffers(&sendBuffer, 1);
+
+    for (unsigned short i = 0; i < IO_URING_RECEIVE_BUFFER_COUNT; ++i)
+    {
+        io_uring_buf& buffer = mBufferRingEntries[i];
+        buffer.addr = reinterpret_cast<std::uint64_t>(mReceiveBuffers.Data() + i * IO_URING_RECEIVE_BUFFER_SIZE);
+        buffer.len = IO_URING_RECEIVE_BUFFER_SIZE;
+        buffer.bid = i;
+    }
+    mBufferRingTail = IO_URING_RECEIVE_BUFFER_COUNT;
+    __atomic_store_n(&mBufferRing->tail, mBufferRingTail, __ATOMIC_RELEASE);
+    mRing->RegisterBufferRing(mBufferRing, IO_URING_RECEIVE_BUFFER_COUNT, IO_URING_BUFFER_GROUP);
+
+    if (!mBusyPoll)
+    {
+        const int eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (eventFd < 0)
+            throw ReadyTraderGoError(std::string("failed to create eventfd: ") + std::strerror(errno));
+        mEventDescriptor.assign(eventFd);
+        mRing->RegisterEventFd(eventFd);
+    }
+
+    mSocket = std::move(socket);
+    // The kernel waits for the socket itself, so it need not be non-blocking
+    // (and io_uring hands EAGAIN straight back for non-blocking files).
+    mSocket.non_blocking(false);
+    // Unlike Asio's sends, a write cannot ask not to raise SIGPIPE, which
+    // would end the process should the exchange reset the connection.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    if (mBusyPoll)
+    {
+        PollCompletions();
+    }
+    else
+    {
+        WaitForCompletions();
+    }
+}
+
+IoUringConnection::~IoUringConnection()
+{
+    RLOG(LG_CON, LogLevel::LL_INFO) << std::quoted(mName, '\'') << " closing";
+    mAlive.reset();
+    // Closing the ring cancels any outstanding operations on the socket.
+    mRing.reset();
+    if (mSocket.is_open())
+    {
+        mSocket.close();
+    }
+}
+
+void IoUringConnection::AsyncRead()
+{
+    ArmReceive();
+}
+
+void IoUringConnection::ArmReceive()
+{
+    io_uring_sqe* sqe = mRing->GetSqe();
+    if (!sqe)
+        throw ReadyTraderGoError("io_uring submission queue is full");
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = mSocket.native_handle();
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = IO_URING_BUFFER_GROUP;
+    sqe->ioprio = mIsMultishot ? IORING_RECV_MULTISHOT : 0;
+    sqe->user_data = IO_URING_RECEIVE;
+    mRing->Submit();
+}
+
+void IoUringConnection::WaitForCompletions()
+{
+    std::weak_ptr<bool> alive = mAlive;
+    mEventDescriptor.async_wait(
+        boost::asio::posix::stream_descriptor::wait_read,
+        bindHandlerMemory(gCompletionMemory, [this, alive](const boost::system::error_code& error) {
+            if (error || alive.expired())
+            {
+                return;
+            }
+            eventfd_t count;
+            eventfd_read(mEventDescriptor.native_handle(), &count);
+            ProcessCompletions();
+            WaitForCompletions();
+        }));
+}
+
+void IoUringConnection::PollCompletions()
+{
+    std::weak_ptr<bool> alive = mAlive;
+    boost::asio::post(mContext, bindHandlerMemory(gCompletionMemory, [this, alive]() {
+        if (alive.expired())
+        {
+            return;
+        }
+        ProcessCompletions();
+        PollCompletions();
+    }));
+}
+
+void IoUringConnection::ProcessCompletions()
+{
+    mRing->DrainCompletions([this](const io_uring_cqe& cqe) {
+        if (cqe.user_data == IO_URING_RECEIVE)
+        {
+            ReceiveHandler(cqe);
+        }
+        else if (cqe.user_data == IO_URING_WRITE)
+        {
+            WriteHandler(cqe);
+        }
+    });
+}
+
+void IoUringConnection::ReceiveHandler(const io_uring_cqe& cqe)
+{
+    if (mIsClosed)
+    {
+        return;
+    }
+
+    const bool isArmed = (cqe.flags & IORING_CQE_F_MORE) != 0;
+    if (cqe.res <= 0)
+    {
+        if (cqe.res == 0)
+        {
+            RLOG(LG_CON, LogLevel::LL_INFO) << std::quoted(mName, '\'') << " remote disconnect";
+        }
+        else if (cqe.res == -EINVAL && mIsMultishot)
+        {
+            RLOG(LG_CON, LogLevel::LL_INFO) << std::quoted(mName, '\'')
+                                            << " multishot receive is not supported, using single receives";
+            mIsMultishot = false;
+            ArmReceive();
+            return;
+        }
+        else if (cqe.res == -EINTR || cqe.res == -EAGAIN || cqe.res == -ENOBUFS)
+        {
+            RLOG(LG_CON, LogLevel::LL_DEBUG) << std::quoted(mName, '\'') << " read interrupted: "
+                                             << std::strerror(-cqe.res);
+            if (!isArmed)
+            {
+                ArmReceive();
+            }
+            return;
+        }
+        else
+        {
+            RLOG(LG_CON, LogLevel::LL_ERROR) << std::quoted(mName, '\'') << " read error: "
+                                             << std::strerror(-cqe.res);
+        }
+        mIsClosed = true;
+        OnDisconnect();
+        return;
+    }
+
+    // Multishot receives carry no control messages, so there are no kernel
+    // time stamps to go with this one.
+    mReceiveTimestamps.mRead = ReadRealtimeNanoseconds();
+    RTG_TRACE_SPAN("exec read");
+    RLOG(LG_CON, LogLevel::LL_DEBUG) << std::quoted(mName, '\'') << " received " << cqe.res << " bytes";
+
+    const auto bufferId = static_cast<unsigned short>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+    unsigned char* buffer = mReceiveBuffers.Data() + bufferId * IO_URING_RECEIVE_BUFFER_SIZE;
+    Receive(buffer, cqe.res);
+
+    // Hand the buffer back to the kernel.
+    io_uring_buf& entry = mBufferRingEntries[mBufferRingTail & (IO_URING_RECEIVE_BUFFER_COUNT - 1)];
+    entry.addr = reinterpret_cast<std::uint64_t>(buffer);
+    entry.len = IO_URING_RECEIVE_BUFFER_SIZE;
+    entry.bid = bufferId;
+    __atomic_store_n(&mBufferRing->tail, ++mBufferRingTail, __ATOMIC_RELEASE);
+
+    if (!isArmed && !mIsClosed)
+    {
+        ArmReceive();
+    }
+}
+
+void IoUringConnection::Receive(unsigned char const* data, std::size_t size)
+{
+    if (mPartial.empty())
+    {
+        const std::size_t consumed = ParseMessages(data, size);
+        mPartial.assign(data + consumed, data + size);
+    }
+    else
+    {
+        mPartial.insert(mPartial.end(), data, data + size);
+        const std::size_t consumed = ParseMessages(mPartial.data(), mPartial.size());
+        mPartial.erase(mPartial.begin(), mPartial.begin() + consumed);
+    }
+}
+
+std::size_t IoUringConnection::ParseMessages(unsigned char const* data, std::size_t size)
+{
+    auto* upto = data;
+    auto available = size;
+
+    while (available >= MESSAGE_HEADER_SIZE)
+    {
+        const std::size_t messageLength = boost::endian::big_to_native(*(uint16_t*)upto);
+        if (messageLength < MESSAGE_HEADER_SIZE)
+            throw ReadyTraderGoError("received a message with invalid length " + std::to_string(messageLength));
+        if (available < messageLength)
+            break;
+
+        const unsigned char messageType = upto[MESSAGE_TYPE_OFFSET];
+        RLOG(LG_CON, LogLevel::LL_DEBUG) << std::quoted(mName, '\'')
+                                         << " received message with type=" << static_cast<int>(messageType)
+                                         << " and size=" << messageLength;
+        if (mJournal)
+        {
+            mJournal->Record(JournalDirection::EXEC_IN, upto, messageLength);
+        }
+        OnMessageReceipt(messageType, upto + MESSAGE_HEADER_SIZE, messageLength - MESSAGE_HEADER_SIZE);
+
+        upto += messageLength;
+        available -= messageLength;
+    }
+
+    return upto - data;
+}
+
+void IoUringConnection::StartWrite()
+{
+    io_uring_sqe* sqe = mRing->GetSqe();
+    if (!sqe)
+        throw ReadyTraderGoError("io_uring submission queue is full");
+    sqe->opcode = IORING_OP_WRITE_FIXED;
+    sqe->fd = mSocket.native_handle();
+    sqe->addr = reinterpret_cast<std::uint64_t>(mSendBuffer.Data() + mSendHead);
+    sqe->len = static_cast<std::uint32_t>(mSendTail - mSendHead);
+    sqe->off = static_cast<std::uint64_t>(-1);
+    sqe->buf_index = 0;
+    sqe->user_data = IO_URING_WRITE;
+    mIsWriting = true;
+    mRing->Submit();
+}
+
+void IoUringConnection::Send(SendMode mode)
+{
+    if (mode == SendMode::ASAP)
+    {
+        StartWrite();
+    }
+    else if (!mIsSendPosted)
+    {
+        std::weak_ptr<bool> alive = mAlive;
+        boost::asio::post(mContext, bindHandlerMemory(gFlushMemory, [this, alive] {
+            if (alive.expired())
+            {
+                return;
+            }
+            mIsSendPosted = false;
+            if (!mIsWriting && mSendHead != mSendTail)
+            {
+                StartWrite();
+            }
+        }));
+        mIsSendPosted = true;
+    }
+}
+
+void IoUringConnection::SendMessage(unsigned char messageType, const ISerialisable& serialisable, SendMode mode)
+{
+    RTG_TRACE_SPAN("exec send");
+    const std::size_t size = MESSAGE_HEADER_SIZE + serialisable.Size();
+    if (mSendTail + size > mSendBuffer.Size())
+    {
+        // Data being written cannot move, so only compact between writes.
+        if (!mIsWriting && mSendHead != 0)
+        {
+            std::memmove(mSendBuffer.Data(), mSendBuffer.Data() + mSendHead, mSendTail - mSendHead);
+            mSendTail -= mSendHead;
+            mSendHead = 0;
+        }
+        if (mSendTail + size > mSendBuffer.Size())
+            throw ReadyTraderGoError("send buffer overflow: the exchange is not reading");
+    }
+
+    unsigned char* data = mSendBuffer.Data() + mSendTail;
+    *(uint16_t*)data = boost::endian::native_to_big((uint16_t)size);
+    data[MESSAGE_TYPE_OFFSET] = messageType;
+    serialisable.Serialise(data + MESSAGE_HEADER_SIZE);
+    if (mJournal)
+    {
+        mJournal->Record(JournalDirection::EXEC_OUT, data, size);
+    }
+    mSendTail += size;
+    if (!mIsWriting)
+    {
+        Send(mode);
+    }
+}
+
+void IoUringConnection::WriteHandler(const io_uring_cqe& cqe)
+{
+    RTG_TRACE_SPAN("exec write complete");
+    mIsWriting = false;
+    if (cqe.res < 0)
+    {
+        if (cqe.res != -EINTR && cqe.res != -EAGAIN)
+        {
+            RLOG(LG_CON, LogLevel::LL_ERROR) << std::quoted(mName, '\'') << " send failed: "
+                                             << std::strerror(-cqe.res);
+            if (mDisconnectOnSendError)
+            {
+                // What was waiting to go will never arrive.
+                mSendHead = mSendTail = 0;
+                mIsClosed = true;
+                OnDisconnect();
+                return;
+            }
+            throw ReadyTraderGoError(std::string("send failed: ") + std::strerror(-cqe.res));
+        }
+        RLOG(LG_CON, LogLevel::LL_DEBUG) << std::quoted(mName, '\'') << " send interrupted: "
+                                         << std::strerror(-cqe.res);
+    }
+    else
+    {
+        RLOG(LG_CON, LogLevel::LL_DEBUG) << std::quoted(mName, '\'') << " sent " << cqe.res << " bytes";
+        mSendHead += cqe.res;
+        if (mSendHead == mSendTail)
+        {
+            mSendHead = mSendTail = 0;
+        }
+    }
+
+    if (mSendHead != mSendTail)
+    {
+        StartWrite();
+    }
+}
+#endif
+
 Subscription::Subscription(boost::asio::io_context& context, interprocess::file_mapping& file, interprocess::mapped_region& region)
     : mContext(context), mFile(std::move(file)), mRegion(std::move(region))
 {
@@ -205,7 +670,9 @@ Subscription::Subscription(boost::asio::io_context& context, interprocess::file_
 
 Subscription::~Subscription()
 {
-    RLOG(LG_CON, LogLevel::LL_INFO) << std::quoted(mName, '\'') << " closing";
+    RLOG(LG_CON, LogLevel::LL_INFO) << std::quoted(mName, '\'') << " closing after " << mCounters.mFrames
+                                    << " frames (" << mCounters.mMalformed << " malformed, " << mCounters.mOverruns
+                                    << " overruns, " << mCounters.mMissedMessages << " messages missed)";
 }
 
 void Subscription::AsyncReceive()
@@ -224,15 +691,36 @@ void Subscription::AsyncReceive(unsigned long pos, std::weak_ptr<ISubscription>
 
     unsigned char* addr = ((unsigned char*)mRegion.get_address()) + pos;
 
-    if (addr[0] != 0)
+    // Acquire pairs with the publisher's release of the flag, so the frame
+    // it guards is complete.
+    if (__atomic_load_n(addr, __ATOMIC_ACQUIRE) != 0)
     {
+        RTG_TRACE_SPAN("info frame");
         const uint32_t* payload_size_ptr = (uint32_t*)(addr + FRAME_PAYLOAD_SIZE_OFFSET);
         const std::size_t payloadSize = boost::endian::big_to_native(*payload_size_ptr);
-        ReceiveFromHandler(addr + FRAME_HEADER_SIZE, payloadSize);
+        if (payloadSize > FRAME_SIZE - FRAME_HEADER_SIZE)
+        {
+            // A torn or corrupt frame header: the payload cannot be read,
+            // let alone journalled, beyond the end of the frame.
+            ++mCounters.mFrames;
+            ++mCounters.mMalformed;
+            RLOG(LG_CON, LogLevel::LL_ERROR) << std::quoted(mName, '\'') << " malformed frame with payload size="
+                                             << payloadSize;
+        }
+        else
+        {
+            if (mJournal)
+            {
+                mJournal->Record(JournalDirection::INFO_IN, addr + FRAME_HEADER_SIZE, payloadSize);
+            }
+            ReceiveFromHandler(addr + FRAME_HEADER_SIZE, payloadSize);
+        }
         pos = (pos + FRAME_SIZE) & (SUBSCRIPTION_TRANSPORT_BUFFER_SIZE - 1);
     }
 
-    mContext.post([this, pos, weak_this](){ AsyncReceive(pos, weak_this); });
+    boost::asio::post(mContext, bindHandlerMemory(gReceiveMemory, [this, pos, weak_this]() {
+        AsyncReceive(pos, weak_this);
+    }));
 }
 
 void Subscription::ReceiveFromHandler(unsigned char const* data, std::size_t size)
@@ -243,20 +731,54 @@ void Subscription::ReceiveFromHandler(unsigned char const* data, std::size_t siz
     const std::size_t messageLength = boost::endian::big_to_native(*(uint16_t*)data);
     const unsigned char messageType = data[MESSAGE_TYPE_OFFSET];
 
-    if (size != messageLength)
+    ++mCounters.mFrames;
+    if (size != messageLength || size < MESSAGE_HEADER_SIZE)
     {
+        ++mCounters.mMalformed;
         RLOG(LG_CON, LogLevel::LL_ERROR) << std::quoted(mName, '\'')
                                          << " malformed message with type=" << static_cast<int>(messageType)
                                          << " and size=" << messageLength;
         return;
     }
 
+    if (messageType == MessageType::ORDER_BOOK_UPDATE || messageType == MessageType::TRADE_TICKS)
+    {
+        CheckSequence(messageType, data, size);
+    }
+
     RLOG(LG_CON, LogLevel::LL_DEBUG) << std::quoted(mName, '\'')
                                      << " received message with type=" << static_cast<int>(messageType)
                                      << " and size=" << messageLength;
     OnMessageReceipt(messageType, data + MESSAGE_HEADER_SIZE, messageLength - MESSAGE_HEADER_SIZE);
 }
 
+void Subscription::CheckSequence(unsigned char messageType, unsigned char const* data, std::size_t size)
+{
+    // Only the instrument and sequence number that follow the header are
+    // needed, and they lie in the same place in both kinds of message.
+    if (size < MESSAGE_HEADER_SIZE)
+        return;
+    const MessageView<OrderBookMessage> book(data + MESSAGE_HEADER_SIZE, size - MESSAGE_HEADER_SIZE);
+    if (!book.Has<&OrderBookMessage::mSequenceNumber>())
+        return;
+    const std::size_t instrument = static_cast<std::size_t>(book.Get<&OrderBookMessage::mInstrument>());
+    if (instrument > static_cast<std::size_t>(Instrument::ETF))
+        return;
+
+    const unsigned long sequenceNumber = book.Get<&OrderBookMessage::mSequenceNumber>();
+    const bool isTradeTicks = messageType == MessageType::TRADE_TICKS;
+    unsigned long& last = mLastSequenceNumbers[isTradeTicks][instrument];
+    if (last != 0 && sequenceNumber > last + 1)
+    {
+        ++mCounters.mOverruns;
+        mCounters.mMissedMessages += sequenceNumber - last - 1;
+        RLOG(LG_CON, LogLevel::LL_WARNING) << std::quoted(mName, '\'') << " missed " << sequenceNumber - last - 1
+                                           << (isTradeTicks ? " trade ticks" : " order book updates") << " for "
+                                           << Instrument(instrument);
+    }
+    last = sequenceNumber;
+}
+
 ConnectionFactory::ConnectionFactory(boost::asio::io_context& context,
                                      std::string host,
                                      unsigned short port)
@@ -284,28 +806,192 @@ static std::basic_ostream<C, T>& operator<<(std::basic_ostream<C, T>& strm, cons
     return strm;
 }
 
+void ConnectionFactory::ConfigureSocket(tcp::socket& sock)
+{
+    boost::system::error_code error;
+
+    // It's not the end of the world if this fails, so any error is ignored.
+    sock.set_option(tcp::no_delay(true), error);
+
+#ifdef __linux__
+    if (mReceiveTimestamping)
+    {
+        const int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE
+                          | SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+        if (setsockopt(sock.native_handle(), SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) != 0)
+        {
+            RLOG(LG_CON, LogLevel::LL_WARNING) << "failed to enable receive time stamps: " << std::strerror(errno);
+        }
+    }
+#endif
+}
+
+void ConnectionFactory::OpenSpareSocket()
+{
+    boost::system::error_code error;
+    // The last one may have been moved from.
+    mSpareSocket = tcp::socket(mContext);
+    mSpareSocket.open(mEndpoints[0].protocol(), error);
+    if (error)
+    {
+        RLOG(LG_CON, LogLevel::LL_WARNING) << "failed to open a spare socket: " << error.message();
+        return;
+    }
+    ConfigureSocket(mSpareSocket);
+}
+
+void ConnectionFactory::SetSpareSocket(bool spare)
+{
+    mKeepSpareSocket = spare;
+    if (spare && !mSpareSocket.is_open())
+    {
+        OpenSpareSocket();
+    }
+}
+
 std::unique_ptr<IConnection> ConnectionFactory::Create()
 {
     boost::system::error_code error;
     tcp::socket sock(mContext);
 
     RLOG(LG_CON, LogLevel::LL_INFO) << "connecting to: " << mEndpoints[0];
-    boost::asio::connect(sock, mEndpoints, error);
+    bool isConnected = false;
+    if (mSpareSocket.is_open())
+    {
+        // Already open and configured, so it only has to be connected. Should
+        // the first endpoint refuse, the others are tried as usual.
+        sock = std::move(mSpareSocket);
+        sock.connect(mEndpoints[0], error);
+        isConnected = !error;
+    }
+    if (!isConnected)
+    {
+        boost::asio::connect(sock, mEndpoints, error);
+        if (error)
+        {
+            RLOG(LG_CON, LogLevel::LL_ERROR) << "connect failed: " << error.message();
+            throw ReadyTraderGoError("connect to '" + mHost + ":" + std::to_string(mPort)
+                                          + "' failed: " + error.message());
+        }
+        ConfigureSocket(sock);
+    }
 
-    if (error)
+    return MakeConnection(std::move(sock));
+}
+
+void ConnectionFactory::AsyncCreate(std::chrono::nanoseconds timeout, CreateHandler handler)
+{
+    if (mCreateHandler)
+        throw ReadyTraderGoError("a connection is already being made");
+
+    mCreateHandler = std::move(handler);
+    mIsConnectTimedOut = false;
+    mConnectTimer.expires_after(timeout);
+    mConnectTimer.async_wait([this](const boost::system::error_code& error) {
+        if (!error && mCreateHandler)
+        {
+            // The connect in progress then fails.
+            mIsConnectTimedOut = true;
+            boost::system::error_code ignored;
+            mConnectingSocket.close(ignored);
+        }
+    });
+
+    RLOG(LG_CON, LogLevel::LL_INFO) << "connecting to: " << mEndpoints[0];
+    if (!mSpareSocket.is_open())
+    {
+        AsyncConnectEndpoints();
+        return;
+    }
+
+    // As in Create, the spare is tried first.
+    mConnectingSocket = std::move(mSpareSocket);
+    mConnectingSocket.async_connect(mEndpoints[0], [this](const boost::system::error_code& error) {
+        if (error && !mIsConnectTimedOut)
+        {
+            AsyncConnectEndpoints();
+            return;
+        }
+        FinishAsyncCreate(error);
+    });
+}
+
+void ConnectionFactory::AsyncConnectEndpoints()
+{
+    // The last one may have been moved from.
+    mConnectingSocket = tcp::socket(mContext);
+    boost::asio::async_connect(mConnectingSocket, mEndpoints,
+                               [this](const boost::system::error_code& error, const tcp::endpoint&) {
+        if (!error && !mIsConnectTimedOut)
+        {
+            ConfigureSocket(mConnectingSocket);
+        }
+        FinishAsyncCreate(error);
+    });
+}
+
+void ConnectionFactory::FinishAsyncCreate(const boost::system::error_code& error)
+{
+    mConnectTimer.cancel();
+    CreateHandler handler = std::move(mCreateHandler);
+    mCreateHandler = nullptr;
+
+    if (error || mIsConnectTimedOut)
     {
-        RLOG(LG_CON, LogLevel::LL_ERROR) << "connect failed: " << error.message();
-        throw ReadyTraderGoError("connect to '" + mHost + ":" + std::to_string(mPort)
-                                      + "' failed: " + error.message());
+        const std::string reason = mIsConnectTimedOut ? std::string("timed out") : error.message();
+        RLOG(LG_CON, LogLevel::LL_ERROR) << "connect failed: " << reason;
+        boost::system::error_code ignored;
+        mConnectingSocket.close(ignored);
+        if (mKeepSpareSocket && !mSpareSocket.is_open())
+        {
+            OpenSpareSocket();
+        }
+        handler(nullptr, "connect to '" + mHost + ":" + std::to_string(mPort) + "' failed: " + reason);
+        return;
     }
 
+    handler(MakeConnection(std::move(mConnectingSocket)), std::string());
+}
+
+std::unique_ptr<IConnection> ConnectionFactory::MakeConnection(tcp::socket&& sock)
+{
     RLOG(LG_CON, LogLevel::LL_INFO) << "connected successfully to: " << sock.remote_endpoint();
     sock.non_blocking(true);
 
-    // It's not the end of the world if this fails, so any error is ignored.
-    sock.set_option(tcp::no_delay(true), error);
+    if (mKeepSpareSocket)
+    {
+        OpenSpareSocket();
+    }
+
+#ifdef __linux__
+    if (mUseIoUring)
+    {
+        try
+        {
+            // The socket is only moved from if the connection is created.
+            auto connection = std::make_unique<IoUringConnection>(mContext, std::move(sock),
+                                                                  std::make_unique<IoUring>(mIoUringOptions),
+                                                                  mIoUringBusyPoll);
+            connection->SetJournal(mJournal);
+            RLOG(LG_CON, LogLevel::LL_INFO) << "using io_uring" << (mIoUringOptions.mSqPoll ? " with SQPOLL" : "")
+                                            << (mIoUringBusyPoll ? " and busy polling" : "");
+            return connection;
+        }
+        catch (const ReadyTraderGoError& e)
+        {
+            RLOG(LG_CON, LogLevel::LL_WARNING) << "io_uring is unavailable, using Asio instead: " << e.what();
+        }
+    }
+#else
+    if (mUseIoUring)
+    {
+        RLOG(LG_CON, LogLevel::LL_WARNING) << "io_uring is only available on Linux, using Asio instead";
+    }
+#endif
 
-    return std::make_unique<Connection>(mContext, std::move(sock));
+    auto connection = std::make_unique<Connection>(mContext, std::move(sock));
+    connection->SetJournal(mJournal);
+    return connection;
 }
 
 SubscriptionFactory::SubscriptionFactory(boost::asio::io_context& context,
@@ -319,7 +1005,9 @@ std::shared_ptr<ISubscription> SubscriptionFactory::Create()
 {
     interprocess::file_mapping file{mName.c_str(), interprocess::read_only};
     interprocess::mapped_region region{file, interprocess::read_only};
-    return std::make_shared<Subscription>(mContext, file, region);
+    auto subscription = std::make_shared<Subscription>(mContext, file, region);
+    subscription->SetJournal(mJournal);
+    return subscription;
 }
 
 }
\ No newline at end of file
@@ -18,19 +18,26 @@
 #ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_CONNECTIVITY_H
 #define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_CONNECTIVITY_H
 
+#include <array>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/asio/streambuf.hpp>
 #include <boost/interprocess/file_mapping.hpp>
 #include <boost/interprocess/mapped_region.hpp>
 #include <boost/system/error_code.hpp>
 
 #include "connectivitytypes.h"
+#include "iouring.h"
+#include "journal.h"
 
 namespace interprocess = boost::interprocess;
 using boost::asio::ip::tcp;
@@ -60,10 +67,16 @@ public:
     void AsyncRead() override;
     void SendMessage(unsigned char messageType, const ISerialisable& serialisable, SendMode mode) override;
 
+    // Record every message sent and received in the given journal.
+    void SetJournal(Journal* journal) { mJournal = journal; }
+
 private:
     void Send();
     void Send(SendMode mode);
 
+#ifdef __linux__
+    void ReadableHandler(const boost::system::error_code& error);
+#endif
     void ReadSomeHandler(const boost::system::error_code& error, std::size_t size);
     void WriteSomeHandler(const boost::system::error_code& error, std::size_t size);
 
@@ -72,9 +85,88 @@ private:
     boost::asio::streambuf mOutBuffer;
     bool mIsSending = false;
     bool mIsSendPosted = false;
+    Journal* mJournal = nullptr;
     tcp::socket mSocket;
 };
 
+#ifdef __linux__
+// Size and number of the provided buffers into which the kernel receives.
+constexpr std::size_t IO_URING_RECEIVE_BUFFER_SIZE = 4096;
+constexpr unsigned IO_URING_RECEIVE_BUFFER_COUNT = 16;
+// Size of the registered buffer messages are serialised into before sending.
+constexpr std::size_t IO_URING_SEND_BUFFER_SIZE = 65536;
+
+// An execution connection whose socket I/O goes through io_uring rather than
+// Asio's reactor: a single multishot receive keeps data arriving in provided
+// buffers without re-arming, and sends are fixed-buffer writes from a
+// registered buffer. Completions are picked up either when the ring signals
+// an eventfd watched by the io_context or, with busy polling, by re-posting a
+// handler that checks the completion queue every time round the event loop.
+class IoUringConnection : public IConnection
+{
+public:
+    IoUringConnection(boost::asio::io_context& context,
+                      tcp::socket&& socket,
+                      std::unique_ptr<IoUring>&& ring,
+                      bool busyPoll);
+    ~IoUringConnection() override;
+    void AsyncRead() override;
+    void SendMessage(unsigned char messageType, const ISerialisable& serialisable, SendMode mode) override;
+
+    // Record every message sent and received in the given journal.
+    void SetJournal(Journal* journal) { mJournal = journal; }
+
+    // Number of io_uring_enter calls made so far, for benchmarking.
+    std::uint64_t GetEnterCount() const { return mRing->GetEnterCount(); }
+
+private:
+    void ArmReceive();
+    void StartWrite();
+    void Send(SendMode mode);
+    void WaitForCompletions();
+    void PollCompletions();
+    void ProcessCompletions();
+    void ReceiveHandler(const io_uring_cqe& cqe);
+    void WriteHandler(const io_uring_cqe& cqe);
+    void Receive(unsigned char const* data, std::size_t size);
+    std::size_t ParseMessages(unsigned char const* data, std::size_t size);
+
+    boost::asio::io_context& mContext;
+    tcp::socket mSocket;
+    std::unique_ptr<IoUring> mRing;
+    MappedBuffer mBufferRingMemory;
+    MappedBuffer mReceiveBuffers;
+    MappedBuffer mSendBuffer;
+    io_uring_buf_ring* mBufferRing;
+    // The ring's entries start at its first byte (the tail overlays the first
+    // entry), but in C++ the header's flexible array member does not.
+    io_uring_buf* mBufferRingEntries;
+    unsigned short mBufferRingTail = 0;
+    std::vector<unsigned char> mPartial;
+    std::size_t mSendHead = 0;
+    std::size_t mSendTail = 0;
+    boost::asio::posix::stream_descriptor mEventDescriptor;
+    std::shared_ptr<bool> mAlive;
+    bool mBusyPoll;
+    bool mIsClosed = false;
+    bool mIsMultishot = true;
+    bool mIsWriting = false;
+    bool mIsSendPosted = false;
+    Journal* mJournal = nullptr;
+};
+#endif
+
+struct SubscriptionCounters
+{
+    std::uint64_t mFrames = 0;
+    std::uint64_t mMalformed = 0;
+    // Order book updates and trade ticks for an instrument are each numbered
+    // consecutively, so a jump means the publisher lapped the reader and
+    // frames were overwritten before they were read.
+    std::uint64_t mOverruns = 0;
+    std::uint64_t mMissedMessages = 0;
+};
+
 class Subscription : public ISubscription
 {
 public:
@@ -84,13 +176,24 @@ public:
     ~Subscription() override;
     void AsyncReceive() override;
 
+    // Record every frame received in the given journal.
+    void SetJournal(Journal* journal) { mJournal = journal; }
+
+    // Only to be read on the thread running the subscription, or once it has stopped.
+    const SubscriptionCounters& GetCounters() const { return mCounters; }
+
 private:
     void AsyncReceive(unsigned long, std::weak_ptr<ISubscription>);
     void ReceiveFromHandler(unsigned char const*, std::size_t size);
+    void CheckSequence(unsigned char messageType, unsigned char const* data, std::size_t size);
 
     boost::asio::io_context& mContext;
     interprocess::file_mapping mFile;
     interprocess::mapped_region mRegion;
+    Journal* mJournal = nullptr;
+    SubscriptionCounters mCounters;
+    // Indexed by whether the message is trade ticks, then by instrument.
+    std::array<std::array<unsigned long, 2>, 2> mLastSequenceNumbers{};
 };
 
 class ConnectionFactory : public IConnectionFactory
@@ -101,12 +204,54 @@ public:
                       unsigned short port);
 
     std::unique_ptr<IConnection> Create() override;
+    void AsyncCreate(std::chrono::nanoseconds timeout, CreateHandler handler) override;
+
+    void SetJournal(Journal* journal) { mJournal = journal; }
+
+    // Have the kernel (and, where the NIC is set up for it, the hardware)
+    // time stamp received data, see IConnection::GetReceiveTimestamps. On by
+    // default; only Linux is supported.
+    void SetReceiveTimestamping(bool timestamping) { mReceiveTimestamping = timestamping; }
+
+    // Keep a socket open and configured for the next connection, so that
+    // reconnecting only has to connect it. The host is only resolved once,
+    // when the factory is made, whether or not this is set.
+    void SetSpareSocket(bool spare);
+
+    // Create io_uring connections rather than Asio ones. Should io_uring be
+    // unavailable when a connection is created, an Asio one is used instead.
+    void SetIoUring(const IoUringOptions& options, bool busyPoll)
+    {
+        mUseIoUring = true;
+        mIoUringOptions = options;
+        mIoUringBusyPoll = busyPoll;
+    }
 
 private:
+    void ConfigureSocket(tcp::socket& sock);
+    void OpenSpareSocket();
+    void AsyncConnectEndpoints();
+    void FinishAsyncCreate(const boost::system::error_code& error);
+    std::unique_ptr<IConnection> MakeConnection(tcp::socket&& sock);
+
     boost::asio::io_context& mContext;
+    Journal* mJournal = nullptr;
+    bool mReceiveTimestamping = true;
+    bool mUseIoUring = false;
+    IoUringOptions mIoUringOptions;
+    bool mIoUringBusyPoll = false;
     std::vector<tcp::endpoint> mEndpoints;
     std::string mHost;
     unsigned short mPort;
+    bool mKeepSpareSocket = false;
+    tcp::socket mSpareSocket{mContext};
+
+    // The socket being connected by AsyncCreate, and the handler waiting
+    // for it.
+    tcp::socket mConnectingSocket{mContext};
+    CreateHandler mCreateHandler;
+    boost::asio::steady_timer mConnectTimer{mContext};
+    bool mIsConnectTimedOut = false;
 };
 
 class SubscriptionFactory : public ISubscriptionFactory
@@ -118,8 +263,11 @@ public:
 
     std::shared_ptr<ISubscription> Create() override;
 
+    void SetJournal(Journal* journal) { mJournal = journal; }
+
 private:
     boost::asio::io_context& mContext;
+    Journal* mJournal = nullptr;
     std::string mType;
     std::string mName;
 };
@@ -18,9 +18,12 @@
 #ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_CONNECTIVITYTYPES_H
 #define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_CONNECTIVITYTYPES_H
 
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
 #include <utility>
 
 namespace ReadyTraderGo {
@@ -38,6 +41,17 @@ struct ISerialisable
     virtual void Serialise(unsigned char*) const = 0;
 };
 
+// When the data holding a received message arrived, in nanoseconds since
+// the epoch (CLOCK_REALTIME), or zero where it is not known. Hardware time
+// stamps come from the NIC's clock, so are only comparable with the others
+// if that clock is kept in step with the system's.
+struct ReceiveTimestamps
+{
+    std::uint64_t mHardware = 0;
+    std::uint64_t mSoftware = 0;
+    std::uint64_t mRead = 0;
+};
+
 struct IConnection
 {
     virtual ~IConnection() = default;
@@ -53,12 +67,32 @@ struct IConnection
     const std::string& GetName() const { return mName; }
     void SetName(std::string name) { mName = std::move(name); }
 
+    // Time stamps of the message currently being received.
+    const ReceiveTimestamps& GetReceiveTimestamps() const { return mReceiveTimestamps; }
+
+    // The exchange requires every new order's client order id to be larger
+    // than the last one sent on the connection, so ids are handed out here.
+    virtual unsigned long NextClientOrderId() { return ++mLastClientOrderId; }
+    unsigned long GetLastClientOrderId() const { return mLastClientOrderId; }
+    // A connection that replaces a lost one carries on from its ids.
+    void SetLastClientOrderId(unsigned long clientOrderId) { mLastClientOrderId = clientOrderId; }
+
+    // Rather than throw when a send fails, report the connection lost, as
+    // when a read fails. For owners that connect again.
+    void SetDisconnectOnSendError(bool disconnect) { mDisconnectOnSendError = disconnect; }
+
     std::function<void()> Disconnected;
     std::function<void(IConnection*, unsigned char, unsigned char const*, std::size_t)> MessageReceived;
 
 protected:
     void OnDisconnect()
     {
+        // A connection is lost once, however many reads and sends then fail.
+        if (mIsDisconnected)
+        {
+            return;
+        }
+        mIsDisconnected = true;
         if (Disconnected)
         {
             Disconnected();
@@ -74,6 +108,10 @@ protected:
     }
 
     std::string mName;
+    ReceiveTimestamps mReceiveTimestamps;
+    unsigned long mLastClientOrderId = 0;
+    bool mDisconnectOnSendError = false;
+    bool mIsDisconnected = false;
 };
 
 struct ISubscription: public std::enable_shared_from_this<ISubscription>
@@ -100,8 +138,15 @@ protected:
 
 struct IConnectionFactory
 {
+    // Given the new connection, or null and why there is none.
+    using CreateHandler = std::function<void(std::unique_ptr<IConnection>, const std::string&)>;
+
     virtual ~IConnectionFactory() = default;
     virtual std::unique_ptr<IConnection> Create() = 0;
+    // As Create, but without blocking: the handler is called from the
+    // context once connected, or once connecting has failed or taken longer
+    // than the timeout. One connection is made at a time.
+    virtual void AsyncCreate(std::chrono::nanoseconds timeout, CreateHandler handler) = 0;
 };
 
 struct ISubscriptionFactory
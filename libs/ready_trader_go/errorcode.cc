@@ -0,0 +1,198 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <cctype>
+
+#include "errorcode.h"
+
+namespace ReadyTraderGo {
+
+struct KnownError
+{
+    std::string_view mText;
+    ErrorCode mCode;
+};
+
+// Errors about a value are listed without it (see ClassifyError).
+static constexpr KnownError KNOWN_ERRORS[] = {
+    {"out-of-order client_order_id in amend message", ErrorCode::OUT_OF_ORDER_AMEND},
+    {"amend operation would increase order volume", ErrorCode::AMEND_INCREASES_VOLUME},
+    {"out-of-order client_order_id in cancel message", ErrorCode::OUT_OF_ORDER_CANCEL},
+    {"duplicate or out-of-order client_order_id", ErrorCode::DUPLICATE_ORDER_ID},
+    {"is not a valid side", ErrorCode::INVALID_SIDE},
+    {"is not a valid price", ErrorCode::INVALID_PRICE},
+    {"is not a valid volume", ErrorCode::INVALID_VOLUME},
+    {"is not a valid lifespan", ErrorCode::INVALID_LIFESPAN},
+    {"is not a valid message type", ErrorCode::INVALID_MESSAGE_TYPE},
+    {"price is not a multiple of tick size", ErrorCode::PRICE_NOT_ON_TICK},
+    {"order rejected: market not yet open", ErrorCode::MARKET_NOT_OPEN},
+    {"order rejected: cannot determine future price", ErrorCode::NO_FUTURE_PRICE},
+    {"order rejected: active order count limit breached", ErrorCode::ACTIVE_ORDER_COUNT_LIMIT},
+    {"order rejected: active order volume limit breached", ErrorCode::ACTIVE_VOLUME_LIMIT},
+    {"order rejected: in cross with an existing order", ErrorCode::IN_CROSS},
+    {"ETF position limit breached", ErrorCode::ETF_POSITION_LIMIT},
+    {"future position limit breached", ErrorCode::FUTURE_POSITION_LIMIT},
+    {"held unhedged lots for longer than the time limit", ErrorCode::UNHEDGED_LOTS_TIME_LIMIT},
+    {"message frequency limit breached", ErrorCode::MESSAGE_FREQUENCY_LIMIT},
+    {"already logged in", ErrorCode::ALREADY_LOGGED_IN},
+    {"not logged in", ErrorCode::NOT_LOGGED_IN},
+    {"order gateway queue is full", ErrorCode::GATEWAY_QUEUE_FULL},
+    {"execution connection is down", ErrorCode::NOT_CONNECTED},
+};
+
+static constexpr std::size_t KNOWN_ERROR_COUNT = sizeof(KNOWN_ERRORS) / sizeof(KNOWN_ERRORS[0]);
+static_assert(KNOWN_ERROR_COUNT == ERROR_CODE_COUNT - 1, "every error code but UNKNOWN needs its text");
+
+static constexpr std::size_t SLOT_BITS = 6;
+static constexpr std::size_t SLOT_COUNT = std::size_t(1) << SLOT_BITS;
+
+static constexpr std::size_t getShortestKnownError()
+{
+    std::size_t shortest = KNOWN_ERRORS[0].mText.size();
+    for (const KnownError& known: KNOWN_ERRORS)
+        shortest = (known.mText.size() < shortest) ? known.mText.size() : shortest;
+    return shortest;
+}
+
+static constexpr std::size_t getLongestKnownError()
+{
+    std::size_t longest = 0;
+    for (const KnownError& known: KNOWN_ERRORS)
+        longest = (known.mText.size() > longest) ? known.mText.size() : longest;
+    return longest;
+}
+
+static constexpr std::size_t SHORTEST_KNOWN_ERROR = getShortestKnownError();
+static constexpr std::size_t LONGEST_KNOWN_ERROR = getLongestKnownError();
+static_assert(SHORTEST_KNOWN_ERROR >= 8, "the hash reads the first and last eight characters");
+
+// Little endian, whatever the host; the compiler makes this a single load
+// where it can.
+static constexpr std::uint64_t loadWord(const char* p)
+{
+    std::uint64_t word = 0;
+    for (std::size_t i = 0; i < 8; ++i)
+        word |= std::uint64_t(static_cast<unsigned char>(p[i])) << (8 * i);
+    return word;
+}
+
+// The text's first and last eight characters and its length tell every
+// known error apart; the seed is a multiplier that spreads them over the
+// slots without collisions.
+static constexpr std::size_t getSlot(std::string_view text, std::uint64_t seed)
+{
+    const std::uint64_t key = loadWord(text.data())
+                              ^ (loadWord(text.data() + text.size() - 8) * 0x9e3779b97f4a7c15ull)
+                              ^ text.size();
+    return static_cast<std::size_t>((key * seed) >> (64 - SLOT_BITS));
+}
+
+static constexpr bool isPerfect(std::uint64_t seed)
+{
+    std::uint64_t used = 0;
+    for (const KnownError& known: KNOWN_ERRORS)
+    {
+        const std::uint64_t bit = std::uint64_t(1) << getSlot(known.mText, seed);
+        if (used & bit)
+            return false;
+        used |= bit;
+    }
+    return true;
+}
+
+// The first of a fixed sequence of odd multipliers that gives no collisions.
+static constexpr std::uint64_t findSeed()
+{
+    std::uint64_t state = 0;
+    for (int attempt = 0; attempt < 10000; ++attempt)
+    {
+        // SplitMix64
+        std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        z = (z ^ (z >> 31)) | 1;
+        if (isPerfect(z))
+            return z;
+    }
+    return 0;
+}
+
+static constexpr std::uint64_t SEED = findSeed();
+static_assert(SEED != 0, "no collision-free seed for the known errors");
+
+// One more than the index of the known error in each slot, or zero.
+static constexpr std::array<unsigned char, SLOT_COUNT> makeSlots()
+{
+    std::array<unsigned char, SLOT_COUNT> slots{};
+    for (std::size_t i = 0; i < KNOWN_ERROR_COUNT; ++i)
+        slots[getSlot(KNOWN_ERRORS[i].mText, SEED)] = static_cast<unsigned char>(i + 1);
+    return slots;
+}
+
+static constexpr std::array<unsigned char, SLOT_COUNT> SLOTS = makeSlots();
+
+ErrorCode ClassifyError(std::string_view text)
+{
+    // Skip the value an error about a value begins with (the exchange has
+    // been known to send it unformatted, as "%d").
+    if (!text.empty() && (std::isdigit(static_cast<unsigned char>(text[0])) || text[0] == '-' || text[0] == '%'))
+    {
+        const std::size_t space = text.find(' ');
+        text = (space != std::string_view::npos) ? text.substr(space + 1) : std::string_view();
+    }
+
+    if (text.size() < SHORTEST_KNOWN_ERROR || text.size() > LONGEST_KNOWN_ERROR)
+        return ErrorCode::UNKNOWN;
+
+    const unsigned char slot = SLOTS[getSlot(text, SEED)];
+    if (slot != 0 && KNOWN_ERRORS[slot - 1].mText == text)
+        return KNOWN_ERRORS[slot - 1].mCode;
+    return ErrorCode::UNKNOWN;
+}
+
+const char* GetErrorCodeName(ErrorCode code)
+{
+    static const char* const NAMES[] = {"unknown", "out_of_order_amend", "amend_increases_volume",
+                                        "out_of_order_cancel", "duplicate_order_id", "invalid_side", "invalid_price",
+                                        "invalid_volume", "invalid_lifespan", "invalid_message_type",
+                                        "price_not_on_tick", "market_not_open", "no_future_price",
+                                        "active_order_count_limit", "active_volume_limit", "in_cross",
+                                        "etf_position_limit", "future_position_limit", "unhedged_lots_time_limit",
+                                        "message_frequency_limit", "already_logged_in", "not_logged_in",
+                                        "gateway_queue_full", "not_connected"};
+    static_assert(sizeof(NAMES) / sizeof(NAMES[0]) == ERROR_CODE_COUNT, "every error code needs a name");
+    return NAMES[static_cast<std::size_t>(code)];
+}
+
+void WriteErrorCounts(std::ostream& out, const ErrorCounts& counts)
+{
+    const char* separator = "";
+    for (std::size_t i = 0; i < ERROR_CODE_COUNT; ++i)
+    {
+        if (counts[i] != 0)
+        {
+            out << separator << static_cast<ErrorCode>(i) << '=' << counts[i];
+            separator = " ";
+        }
+    }
+    if (*separator == '\0')
+    {
+        out << "none";
+    }
+}
+
+}
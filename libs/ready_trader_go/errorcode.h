@@ -0,0 +1,87 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ERRORCODE_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ERRORCODE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+namespace ReadyTraderGo {
+
+// The errors the exchange (and the order gateway and autotrader) report in error messages,
+// so that handlers can act on them without comparing text.
+enum class ErrorCode : unsigned char
+{
+    // Text that matches none of the known errors.
+    UNKNOWN,
+    OUT_OF_ORDER_AMEND,
+    AMEND_INCREASES_VOLUME,
+    OUT_OF_ORDER_CANCEL,
+    DUPLICATE_ORDER_ID,
+    INVALID_SIDE,
+    INVALID_PRICE,
+    INVALID_VOLUME,
+    INVALID_LIFESPAN,
+    INVALID_MESSAGE_TYPE,
+    PRICE_NOT_ON_TICK,
+    MARKET_NOT_OPEN,
+    NO_FUTURE_PRICE,
+    ACTIVE_ORDER_COUNT_LIMIT,
+    ACTIVE_VOLUME_LIMIT,
+    IN_CROSS,
+    // The limit breaches below are followed by the exchange closing the
+    // connection.
+    ETF_POSITION_LIMIT,
+    FUTURE_POSITION_LIMIT,
+    UNHEDGED_LOTS_TIME_LIMIT,
+    MESSAGE_FREQUENCY_LIMIT,
+    ALREADY_LOGGED_IN,
+    NOT_LOGGED_IN,
+    // The order gateway's queue had no room for an order.
+    GATEWAY_QUEUE_FULL,
+    // An order was sent, or lost, while reconnecting to the exchange.
+    NOT_CONNECTED
+};
+
+constexpr std::size_t ERROR_CODE_COUNT = static_cast<std::size_t>(ErrorCode::NOT_CONNECTED) + 1;
+
+// Error messages received, by code.
+using ErrorCounts = std::array<std::uint64_t, ERROR_CODE_COUNT>;
+
+// The code of an error message's text. Errors about a value ("3 is not a
+// valid side") are recognised whatever the value.
+ErrorCode ClassifyError(std::string_view text);
+
+const char* GetErrorCodeName(ErrorCode code);
+
+// Writes "name=count" for each code received, separated by spaces, or
+// "none".
+void WriteErrorCounts(std::ostream& out, const ErrorCounts& counts);
+
+template<typename C, typename T>
+std::basic_ostream<C, T>& operator<<(std::basic_ostream<C, T>& strm, ErrorCode code)
+{
+    return strm << GetErrorCodeName(code);
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ERRORCODE_H
@@ -0,0 +1,134 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_HANDLERMEMORY_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_HANDLERMEMORY_H
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ReadyTraderGo {
+
+constexpr std::size_t HANDLER_MEMORY_SIZE = 256;
+
+// Storage for one outstanding Asio handler at a time. A handler that is
+// re-posted from its own invocation (Asio releases a handler's memory before
+// invoking it) therefore never allocates. Should the storage be in use or
+// too small, allocation falls back to operator new.
+//
+// The storage must outlive every handler bound to it, so it is best given
+// static storage duration.
+class HandlerMemory
+{
+public:
+    HandlerMemory() = default;
+    HandlerMemory(const HandlerMemory&) = delete;
+    void operator=(const HandlerMemory&) = delete;
+
+    void* Allocate(std::size_t size)
+    {
+        if (size <= sizeof(mStorage) && !mInUse.exchange(true, std::memory_order_acquire))
+        {
+            return &mStorage;
+        }
+        return ::operator new(size);
+    }
+
+    void Deallocate(void* pointer)
+    {
+        if (pointer == &mStorage)
+        {
+            mInUse.store(false, std::memory_order_release);
+        }
+        else
+        {
+            ::operator delete(pointer);
+        }
+    }
+
+private:
+    std::aligned_storage_t<HANDLER_MEMORY_SIZE> mStorage;
+    std::atomic<bool> mInUse{false};
+};
+
+// The allocator Asio uses, via the handler's allocator_type, for a handler
+// bound to some HandlerMemory.
+template<typename T>
+class HandlerAllocator
+{
+public:
+    using value_type = T;
+
+    explicit HandlerAllocator(HandlerMemory& memory) : mMemory(&memory) {}
+
+    template<typename U>
+    HandlerAllocator(const HandlerAllocator<U>& other) noexcept : mMemory(other.mMemory) {}
+
+    T* allocate(std::size_t n) const
+    {
+        return static_cast<T*>(mMemory->Allocate(sizeof(T) * n));
+    }
+
+    void deallocate(T* pointer, std::size_t) const
+    {
+        mMemory->Deallocate(pointer);
+    }
+
+    bool operator==(const HandlerAllocator& other) const noexcept { return mMemory == other.mMemory; }
+    bool operator!=(const HandlerAllocator& other) const noexcept { return mMemory != other.mMemory; }
+
+private:
+    template<typename>
+    friend class HandlerAllocator;
+
+    HandlerMemory* mMemory;
+};
+
+template<typename Handler>
+class MemoryBoundHandler
+{
+public:
+    using allocator_type = HandlerAllocator<Handler>;
+
+    MemoryBoundHandler(HandlerMemory& memory, Handler handler) : mMemory(memory), mHandler(std::move(handler)) {}
+
+    allocator_type get_allocator() const noexcept { return allocator_type(mMemory); }
+
+    template<typename... Args>
+    void operator()(Args&&... args)
+    {
+        mHandler(std::forward<Args>(args)...);
+    }
+
+private:
+    HandlerMemory& mMemory;
+    Handler mHandler;
+};
+
+// Wrap a handler so that Asio allocates its operation from the given memory.
+template<typename Handler>
+MemoryBoundHandler<std::decay_t<Handler>> bindHandlerMemory(HandlerMemory& memory, Handler&& handler)
+{
+    return MemoryBoundHandler<std::decay_t<Handler>>(memory, std::forward<Handler>(handler));
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_HANDLERMEMORY_H
@@ -0,0 +1,461 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "handlerprofiler.h"
+
+namespace ReadyTraderGo {
+
+const char* handlerName(Handler handler)
+{
+    switch (handler)
+    {
+    case Handler::ERROR_MESSAGE:
+        return "ErrorMessage";
+    case Handler::HEDGE_FILLED:
+        return "HedgeFilled";
+    case Handler::ORDER_BOOK:
+        return "OrderBook";
+    case Handler::ORDER_FILLED:
+        return "OrderFilled";
+    case Handler::ORDER_STATUS:
+        return "OrderStatus";
+    case Handler::TRADE_TICKS:
+        return "TradeTicks";
+    }
+    return "Unknown";
+}
+
+const char* perfCounterName(PerfCounter counter)
+{
+    switch (counter)
+    {
+    case PerfCounter::CYCLES:
+        return "cycles";
+    case PerfCounter::INSTRUCTIONS:
+        return "instructions";
+    case PerfCounter::CACHE_MISSES:
+        return "cache_misses";
+    case PerfCounter::BRANCH_MISSES:
+        return "branch_misses";
+    default:
+        return "unknown";
+    }
+}
+
+const char* receiveLatencyName(ReceiveLatency latency)
+{
+    switch (latency)
+    {
+    case ReceiveLatency::WIRE_TO_KERNEL:
+        return "wire_to_kernel";
+    case ReceiveLatency::KERNEL_TO_READ:
+        return "kernel_to_read";
+    case ReceiveLatency::READ_TO_HANDLER:
+        return "read_to_handler";
+    default:
+        return "unknown";
+    }
+}
+
+static const char* metricName(std::size_t metric)
+{
+    return (metric == ProfileMetric::NANOSECONDS) ? "nanoseconds" : perfCounterName(PerfCounter(metric - 1));
+}
+
+#ifdef __linux__
+
+static const std::array<std::uint64_t, PerfCounter::PERF_COUNTER_COUNT> PERF_EVENT_CONFIGS = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+static std::string readParanoidLevel()
+{
+    std::ifstream in{"/proc/sys/kernel/perf_event_paranoid"};
+    std::string level;
+    return (in >> level) ? level : "unknown";
+}
+
+PerfCounterGroup::PerfCounterGroup()
+{
+    mFds.fill(-1);
+
+    for (std::size_t i = 0; i < PerfCounter::PERF_COUNTER_COUNT; ++i)
+    {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_EVENT_CONFIGS[i];
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.disabled = (i == 0) ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        const int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, (i == 0) ? -1 : mFds[0], 0));
+        if (fd == -1)
+        {
+            mStatus = std::string("perf_event_open failed for ") + perfCounterName(PerfCounter(i)) + ": "
+                      + std::strerror(errno) + " (perf_event_paranoid=" + readParanoidLevel() + ")";
+            Close();
+            return;
+        }
+        mFds[i] = fd;
+
+        void* page = mmap(nullptr, sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED, fd, 0);
+        mPages[i] = (page == MAP_FAILED) ? nullptr : page;
+    }
+
+    mUsesRdpmc = true;
+    for (auto* page : mPages)
+    {
+        mUsesRdpmc = mUsesRdpmc && page && static_cast<const perf_event_mmap_page*>(page)->cap_user_rdpmc;
+    }
+#if !(defined(__x86_64__) || defined(__i386__))
+    mUsesRdpmc = false;
+#endif
+
+    ioctl(mFds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    mStatus = mUsesRdpmc ? "counting with rdpmc" : "counting with read()";
+}
+
+PerfCounterGroup::~PerfCounterGroup()
+{
+    Close();
+}
+
+void PerfCounterGroup::Close()
+{
+    for (std::size_t i = 0; i < PerfCounter::PERF_COUNTER_COUNT; ++i)
+    {
+        if (mPages[i])
+        {
+            munmap(mPages[i], sysconf(_SC_PAGESIZE));
+            mPages[i] = nullptr;
+        }
+    }
+    // Followers first, then the group leader.
+    for (std::size_t i = PerfCounter::PERF_COUNTER_COUNT; i-- > 0;)
+    {
+        if (mFds[i] != -1)
+        {
+            close(mFds[i]);
+            mFds[i] = -1;
+        }
+    }
+    mUsesRdpmc = false;
+}
+
+void PerfCounterGroup::Read(PerfCounterValues& values) const
+{
+    if (!IsOpen())
+    {
+        values.fill(0);
+        return;
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    if (mUsesRdpmc)
+    {
+        // The sequence lock protocol described in linux/perf_event.h.
+        for (std::size_t i = 0; i < PerfCounter::PERF_COUNTER_COUNT; ++i)
+        {
+            auto* page = static_cast<volatile perf_event_mmap_page*>(mPages[i]);
+            std::uint32_t sequence;
+            std::uint64_t count;
+            do
+            {
+                sequence = page->lock;
+                std::atomic_signal_fence(std::memory_order_acquire);
+                const std::uint32_t index = page->index;
+                count = page->offset;
+                if (index != 0)
+                {
+                    const std::uint16_t width = page->pmc_width;
+                    std::uint64_t pmc = __rdpmc(static_cast<int>(index - 1));
+                    pmc <<= 64 - width;
+                    count += static_cast<std::uint64_t>(static_cast<std::int64_t>(pmc) >> (64 - width));
+                }
+                std::atomic_signal_fence(std::memory_order_acquire);
+            } while (page->lock != sequence);
+            values[i] = count;
+        }
+        return;
+    }
+#endif
+
+    // With PERF_FORMAT_GROUP, the leader reports the whole group at once.
+    std::array<std::uint64_t, PerfCounter::PERF_COUNTER_COUNT + 1> buffer{};
+    if (read(mFds[0], buffer.data(), sizeof(buffer)) == static_cast<ssize_t>(sizeof(buffer)))
+    {
+        std::copy(buffer.begin() + 1, buffer.end(), values.begin());
+    }
+    else
+    {
+        values.fill(0);
+    }
+}
+
+#else
+
+PerfCounterGroup::PerfCounterGroup() : mStatus("hardware counters are only supported on Linux")
+{
+    mFds.fill(-1);
+}
+
+PerfCounterGroup::~PerfCounterGroup() = default;
+
+void PerfCounterGroup::Close()
+{
+}
+
+void PerfCounterGroup::Read(PerfCounterValues& values) const
+{
+    values.fill(0);
+}
+
+#endif
+
+std::size_t LogHistogram::BucketOf(std::uint64_t value)
+{
+    if (value < (std::uint64_t(1) << SUB_BUCKET_BITS))
+    {
+        return static_cast<std::size_t>(value);
+    }
+    std::size_t msb = 63;
+    while ((value >> msb) == 0)
+    {
+        --msb;
+    }
+    const std::size_t shift = msb - SUB_BUCKET_BITS;
+    const std::size_t subBucket = static_cast<std::size_t>(value >> shift) & ((1u << SUB_BUCKET_BITS) - 1);
+    return ((shift + 1) << SUB_BUCKET_BITS) + subBucket;
+}
+
+std::uint64_t LogHistogram::UpperBoundOf(std::size_t bucket)
+{
+    if (bucket < (std::size_t(1) << SUB_BUCKET_BITS))
+    {
+        return bucket;
+    }
+    const std::size_t shift = (bucket >> SUB_BUCKET_BITS) - 1;
+    const std::uint64_t subBucket = bucket & ((1u << SUB_BUCKET_BITS) - 1);
+    const std::uint64_t lower = ((std::uint64_t(1) << SUB_BUCKET_BITS) | subBucket) << shift;
+    return lower + ((std::uint64_t(1) << shift) - 1);
+}
+
+void LogHistogram::Record(std::uint64_t value)
+{
+    ++mBuckets[BucketOf(value)];
+    ++mCount;
+    if (value > mMax)
+    {
+        mMax = value;
+    }
+}
+
+std::uint64_t LogHistogram::GetPercentile(double percentile) const
+{
+    if (mCount == 0)
+    {
+        return 0;
+    }
+
+    const auto target = static_cast<std::uint64_t>(percentile / 100.0 * double(mCount - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket)
+    {
+        seen += mBuckets[bucket];
+        if (seen >= target)
+        {
+            return std::min(UpperBoundOf(bucket), mMax);
+        }
+    }
+    return mMax;
+}
+
+constexpr int PROFILER_CALIBRATION_ROUNDS = 256;
+
+HandlerProfiler::HandlerProfiler()
+{
+    mOverhead.fill(~std::uint64_t(0));
+    for (int i = 0; i < PROFILER_CALIBRATION_ROUNDS; ++i)
+    {
+        PerfCounterValues start;
+        PerfCounterValues end;
+        mCounters.Read(start);
+        const std::uint64_t startTsc = ReadTimestampCounter();
+        const std::uint64_t endTsc = ReadTimestampCounter();
+        mCounters.Read(end);
+
+        const auto nanoseconds = static_cast<std::uint64_t>(double(endTsc - startTsc) * mNanosecondsPerTick);
+        mOverhead[ProfileMetric::NANOSECONDS] = std::min(mOverhead[ProfileMetric::NANOSECONDS], nanoseconds);
+        for (std::size_t c = 0; c < PerfCounter::PERF_COUNTER_COUNT; ++c)
+        {
+            mOverhead[c + 1] = std::min(mOverhead[c + 1], end[c] - start[c]);
+        }
+    }
+}
+
+void HandlerProfiler::Record(Handler handler,
+                             std::uint64_t ticks,
+                             const PerfCounterValues& start,
+                             const PerfCounterValues& end)
+{
+    HandlerProfile& profile = mProfiles[static_cast<std::size_t>(handler)];
+    ++profile.mCount;
+
+    std::array<std::uint64_t, ProfileMetric::PROFILE_METRIC_COUNT> values;
+    values[ProfileMetric::NANOSECONDS] = static_cast<std::uint64_t>(double(ticks) * mNanosecondsPerTick);
+    for (std::size_t i = 0; i < PerfCounter::PERF_COUNTER_COUNT; ++i)
+    {
+        values[i + 1] = end[i] - start[i];
+    }
+
+    const std::size_t metricCount = mCounters.IsOpen() ? std::size_t(ProfileMetric::PROFILE_METRIC_COUNT) : 1;
+    for (std::size_t m = 0; m < metricCount; ++m)
+    {
+        values[m] -= std::min(values[m], mOverhead[m]);
+        profile.mTotals[m] += values[m];
+        profile.mDistributions[m].Record(values[m]);
+    }
+}
+
+void HandlerProfiler::RecordReceive(Handler handler, const ReceiveTimestamps& timestamps)
+{
+    if (timestamps.mRead == 0)
+    {
+        return;
+    }
+
+    auto& latencies = mProfiles[static_cast<std::size_t>(handler)].mReceiveLatencies;
+    const std::uint64_t now = ReadRealtimeNanoseconds();
+    if (now >= timestamps.mRead)
+    {
+        latencies[ReceiveLatency::READ_TO_HANDLER].Record(now - timestamps.mRead);
+    }
+    if (timestamps.mSoftware != 0 && timestamps.mRead >= timestamps.mSoftware)
+    {
+        latencies[ReceiveLatency::KERNEL_TO_READ].Record(timestamps.mRead - timestamps.mSoftware);
+    }
+    if (timestamps.mHardware != 0 && timestamps.mSoftware >= timestamps.mHardware)
+    {
+        latencies[ReceiveLatency::WIRE_TO_KERNEL].Record(timestamps.mSoftware - timestamps.mHardware);
+    }
+}
+
+void HandlerProfiler::WriteReport(std::ostream& out) const
+{
+    out << "handler profile (" << mCounters.GetStatus() << ")\n";
+
+    const std::size_t metricCount = mCounters.IsOpen() ? std::size_t(ProfileMetric::PROFILE_METRIC_COUNT) : 1;
+    for (std::size_t h = 0; h < HANDLER_COUNT; ++h)
+    {
+        const HandlerProfile& profile = mProfiles[h];
+        if (profile.mCount == 0)
+        {
+            continue;
+        }
+
+        out << "  " << std::left << std::setw(13) << handlerName(Handler(h)) << std::right
+            << " calls=" << profile.mCount;
+        for (std::size_t m = 0; m < metricCount; ++m)
+        {
+            const LogHistogram& distribution = profile.mDistributions[m];
+            out << ' ' << metricName(m) << "(mean/p50/p99/max)=" << profile.mTotals[m] / profile.mCount << '/'
+                << distribution.GetPercentile(50.0) << '/' << distribution.GetPercentile(99.0) << '/'
+                << distribution.GetMax();
+        }
+        for (std::size_t l = 0; l < ReceiveLatency::RECEIVE_LATENCY_COUNT; ++l)
+        {
+            const LogHistogram& latency = profile.mReceiveLatencies[l];
+            if (latency.GetCount() != 0)
+            {
+                out << ' ' << receiveLatencyName(ReceiveLatency(l)) << "(p50/p99/max)="
+                    << latency.GetPercentile(50.0) << '/' << latency.GetPercentile(99.0) << '/' << latency.GetMax();
+            }
+        }
+        if (mCounters.IsOpen() && profile.mTotals[ProfileMetric::METRIC_CYCLES] != 0)
+        {
+            out << " ipc=" << std::fixed << std::setprecision(2)
+                << double(profile.mTotals[ProfileMetric::METRIC_INSTRUCTIONS])
+                   / double(profile.mTotals[ProfileMetric::METRIC_CYCLES])
+                << std::defaultfloat;
+        }
+        out << '\n';
+    }
+}
+
+void HandlerProfiler::WriteMetrics(std::ostream& out) const
+{
+    const std::size_t metricCount = mCounters.IsOpen() ? std::size_t(ProfileMetric::PROFILE_METRIC_COUNT) : 1;
+
+    out << "{\"counters\":\"" << mCounters.GetStatus() << "\",\"handlers\":{";
+    bool firstHandler = true;
+    for (std::size_t h = 0; h < HANDLER_COUNT; ++h)
+    {
+        const HandlerProfile& profile = mProfiles[h];
+        if (profile.mCount == 0)
+        {
+            continue;
+        }
+
+        out << (firstHandler ? "" : ",") << '"' << handlerName(Handler(h)) << "\":{\"calls\":" << profile.mCount;
+        firstHandler = false;
+        for (std::size_t m = 0; m < metricCount; ++m)
+        {
+            const LogHistogram& distribution = profile.mDistributions[m];
+            out << ",\"" << metricName(m) << "\":{\"total\":" << profile.mTotals[m]
+                << ",\"p50\":" << distribution.GetPercentile(50.0)
+                << ",\"p90\":" << distribution.GetPercentile(90.0)
+                << ",\"p99\":" << distribution.GetPercentile(99.0)
+                << ",\"max\":" << distribution.GetMax() << '}';
+        }
+        for (std::size_t l = 0; l < ReceiveLatency::RECEIVE_LATENCY_COUNT; ++l)
+        {
+            const LogHistogram& latency = profile.mReceiveLatencies[l];
+            if (latency.GetCount() != 0)
+            {
+                out << ",\"" << receiveLatencyName(ReceiveLatency(l)) << "\":{\"count\":" << latency.GetCount()
+                    << ",\"p50\":" << latency.GetPercentile(50.0)
+                    << ",\"p90\":" << latency.GetPercentile(90.0)
+                    << ",\"p99\":" << latency.GetPercentile(99.0)
+                    << ",\"max\":" << latency.GetMax() << '}';
+            }
+        }
+        out << '}';
+    }
+    out << "}}\n";
+}
+
+}
@@ -0,0 +1,238 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_HANDLERPROFILER_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_HANDLERPROFILER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "clock.h"
+#include "connectivitytypes.h"
+
+namespace ReadyTraderGo {
+
+// Whether BaseAutoTrader was built with its callbacks instrumented (see the
+// RTG_PERF_COUNTERS CMake option). Without it a profiler can still be
+// created, but nothing ever records into it.
+#ifdef RTG_PERF_COUNTERS
+constexpr bool HANDLER_PROFILING_ENABLED = true;
+#else
+constexpr bool HANDLER_PROFILING_ENABLED = false;
+#endif
+
+enum class Handler : std::size_t
+{
+    ERROR_MESSAGE,
+    HEDGE_FILLED,
+    ORDER_BOOK,
+    ORDER_FILLED,
+    ORDER_STATUS,
+    TRADE_TICKS
+};
+
+constexpr std::size_t HANDLER_COUNT = 6;
+
+const char* handlerName(Handler handler);
+
+enum PerfCounter : std::size_t
+{
+    CYCLES,
+    INSTRUCTIONS,
+    CACHE_MISSES,
+    BRANCH_MISSES,
+    PERF_COUNTER_COUNT
+};
+
+const char* perfCounterName(PerfCounter counter);
+
+using PerfCounterValues = std::array<std::uint64_t, PerfCounter::PERF_COUNTER_COUNT>;
+
+// A group of hardware counters (cycles, instructions, cache misses and branch
+// misses) for the calling thread, counting user space only.
+//
+// Counters are read with rdpmc where the kernel allows it, and otherwise with
+// a read() of the whole group. If the counters cannot be opened at all (e.g.
+// perf_event_paranoid forbids it, or there is no PMU) the group is closed and
+// Read() returns zeros.
+class PerfCounterGroup
+{
+public:
+    PerfCounterGroup();
+    ~PerfCounterGroup();
+
+    PerfCounterGroup(const PerfCounterGroup&) = delete;
+    void operator=(const PerfCounterGroup&) = delete;
+
+    bool IsOpen() const { return mFds[0] != -1; }
+    bool UsesRdpmc() const { return mUsesRdpmc; }
+    const std::string& GetStatus() const { return mStatus; }
+
+    void Read(PerfCounterValues& values) const;
+
+private:
+    void Close();
+
+    std::array<int, PerfCounter::PERF_COUNTER_COUNT> mFds;
+    std::array<void*, PerfCounter::PERF_COUNTER_COUNT> mPages{};
+    bool mUsesRdpmc = false;
+    std::string mStatus;
+};
+
+// A histogram with eight buckets per power of two, good to within 12.5%
+// over the whole range of a 64-bit value.
+class LogHistogram
+{
+public:
+    static constexpr std::size_t SUB_BUCKET_BITS = 3;
+    static constexpr std::size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+    void Record(std::uint64_t value);
+
+    std::uint64_t GetCount() const { return mCount; }
+    std::uint64_t GetMax() const { return mMax; }
+
+    // Return an upper bound of the given percentile (0 to 100).
+    std::uint64_t GetPercentile(double percentile) const;
+
+private:
+    static std::size_t BucketOf(std::uint64_t value);
+    static std::uint64_t UpperBoundOf(std::size_t bucket);
+
+    std::array<std::uint64_t, BUCKET_COUNT> mBuckets{};
+    std::uint64_t mCount = 0;
+    std::uint64_t mMax = 0;
+};
+
+enum ProfileMetric : std::size_t
+{
+    NANOSECONDS,
+    METRIC_CYCLES,
+    METRIC_INSTRUCTIONS,
+    METRIC_CACHE_MISSES,
+    METRIC_BRANCH_MISSES,
+    PROFILE_METRIC_COUNT
+};
+
+// Where an execution message spent its time before reaching its handler:
+// between the NIC and the kernel time stamping it, between the kernel and
+// the connection reading it, and between the read and the handler call.
+enum ReceiveLatency : std::size_t
+{
+    WIRE_TO_KERNEL,
+    KERNEL_TO_READ,
+    READ_TO_HANDLER,
+    RECEIVE_LATENCY_COUNT
+};
+
+const char* receiveLatencyName(ReceiveLatency latency);
+
+struct HandlerProfile
+{
+    std::uint64_t mCount = 0;
+    std::array<std::uint64_t, ProfileMetric::PROFILE_METRIC_COUNT> mTotals{};
+    std::array<LogHistogram, ProfileMetric::PROFILE_METRIC_COUNT> mDistributions;
+    // In nanoseconds, for handlers of execution messages only.
+    std::array<LogHistogram, ReceiveLatency::RECEIVE_LATENCY_COUNT> mReceiveLatencies;
+};
+
+// Accumulates wall time and hardware counters for each auto-trader callback.
+// A profiler belongs to the trading thread: its counters count that thread,
+// so it must be created on the trading thread.
+class HandlerProfiler
+{
+public:
+    HandlerProfiler();
+
+    HandlerProfiler(const HandlerProfiler&) = delete;
+    void operator=(const HandlerProfiler&) = delete;
+
+    const PerfCounterGroup& GetCounters() const { return mCounters; }
+    const HandlerProfile& GetProfile(Handler handler) const { return mProfiles[static_cast<std::size_t>(handler)]; }
+
+    // Record how long the message about to be handled took to get here.
+    // Latencies whose time stamps are missing are skipped.
+    void RecordReceive(Handler handler, const ReceiveTimestamps& timestamps);
+
+    // Human readable summary, one line per handler that was called.
+    void WriteReport(std::ostream& out) const;
+    // Machine readable summary, as a JSON object.
+    void WriteMetrics(std::ostream& out) const;
+
+    // Measures the enclosing callback.
+    class Scope
+    {
+    public:
+        Scope(HandlerProfiler* profiler, Handler handler) : mProfiler(profiler), mHandler(handler)
+        {
+            if (mProfiler)
+            {
+                mProfiler->mCounters.Read(mStartCounters);
+                mStartTsc = ReadTimestampCounter();
+            }
+        }
+
+        ~Scope()
+        {
+            if (mProfiler)
+            {
+                const std::uint64_t endTsc = ReadTimestampCounter();
+                PerfCounterValues endCounters;
+                mProfiler->mCounters.Read(endCounters);
+                mProfiler->Record(mHandler, endTsc - mStartTsc, mStartCounters, endCounters);
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        void operator=(const Scope&) = delete;
+
+    private:
+        HandlerProfiler* mProfiler;
+        Handler mHandler;
+        std::uint64_t mStartTsc = 0;
+        PerfCounterValues mStartCounters{};
+    };
+
+private:
+    void Record(Handler handler, std::uint64_t ticks, const PerfCounterValues& start, const PerfCounterValues& end);
+
+    PerfCounterGroup mCounters;
+    // The cost of measuring an empty callback, which is taken off every
+    // measurement.
+    std::array<std::uint64_t, ProfileMetric::PROFILE_METRIC_COUNT> mOverhead{};
+    double mNanosecondsPerTick = static_cast<const TscClock&>(GetSystemClock()).GetNanosecondsPerTick();
+    std::array<HandlerProfile, HANDLER_COUNT> mProfiles;
+};
+
+}
+
+// Profile the rest of the enclosing block as a call of the given handler.
+#ifdef RTG_PERF_COUNTERS
+#define RTG_PROFILE_HANDLER(profiler, handler) \
+    ::ReadyTraderGo::HandlerProfiler::Scope rtgHandlerProfileScope{(profiler), (handler)}
+// Record the receive latencies of the message about to be handled.
+#define RTG_PROFILE_RECEIVE(profiler, handler, timestamps) \
+    if (profiler) (profiler)->RecordReceive((handler), (timestamps))
+#else
+#define RTG_PROFILE_HANDLER(profiler, handler)
+#define RTG_PROFILE_RECEIVE(profiler, handler, timestamps)
+#endif
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_HANDLERPROFILER_H
@@ -0,0 +1,176 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <cmath>
+
+#include "error.h"
+#include "hedgeratio.h"
+
+namespace ReadyTraderGo {
+
+RecursiveLeastSquares::RecursiveLeastSquares(double forgettingFactor, double initialCovariance)
+    : mForgettingFactor(forgettingFactor), mInitialCovariance(initialCovariance), mP00(initialCovariance),
+      mP11(initialCovariance)
+{
+    if (forgettingFactor <= 0.0 || forgettingFactor > 1.0)
+        throw ReadyTraderGoError("forgetting factor must be greater than zero and at most one");
+}
+
+void RecursiveLeastSquares::Reset()
+{
+    mLevel = 0.0;
+    mSlope = 1.0;
+    mP00 = mP11 = mInitialCovariance;
+    mP01 = 0.0;
+    mSquaredErrors = mWeight = 0.0;
+    mEstimate = HedgeRatioEstimate{};
+}
+
+HedgeRatioState RecursiveLeastSquares::GetState() const
+{
+    return HedgeRatioState{mOrigin, mLevel, mSlope, mP00, mP01, mP11, mSquaredErrors, mWeight, mEstimate};
+}
+
+void RecursiveLeastSquares::SetState(const HedgeRatioState& state)
+{
+    mOrigin = state.mOrigin;
+    mLevel = state.mLevel;
+    mSlope = state.mSlope;
+    mP00 = state.mP00;
+    mP01 = state.mP01;
+    mP11 = state.mP11;
+    mSquaredErrors = state.mSquaredErrors;
+    mWeight = state.mWeight;
+    mEstimate = state.mEstimate;
+}
+
+const HedgeRatioEstimate& RecursiveLeastSquares::Update(double future, double etf)
+{
+    if (mEstimate.mCount == 0)
+    {
+        mOrigin = future;
+        mLevel = etf;
+    }
+
+    const double x = future - mOrigin;
+    const double residual = etf - (mLevel + mSlope * x);
+
+    // Gain k = P h / (lambda + h' P h), for h = (1, x).
+    const double ph0 = mP00 + mP01 * x;
+    const double ph1 = mP01 + mP11 * x;
+    const double denominator = mForgettingFactor + ph0 + x * ph1;
+    const double k0 = ph0 / denominator;
+    const double k1 = ph1 / denominator;
+
+    mLevel += k0 * residual;
+    mSlope += k1 * residual;
+
+    const double inverseLambda = 1.0 / mForgettingFactor;
+    mP00 = (mP00 - k0 * ph0) * inverseLambda;
+    mP01 = (mP01 - k0 * ph1) * inverseLambda;
+    mP11 = (mP11 - k1 * ph1) * inverseLambda;
+
+    // The product of the residuals before and after the update is exactly
+    // the growth of the (discounted) sum of squared residuals of the fit.
+    const double posterior = etf - (mLevel + mSlope * x);
+    const double previousVariance = mEstimate.mResidualVariance;
+    mSquaredErrors = mForgettingFactor * mSquaredErrors + residual * posterior;
+    mWeight = mForgettingFactor * mWeight + 1.0;
+
+    ++mEstimate.mCount;
+    mEstimate.mHedgeRatio = mSlope;
+    mEstimate.mIntercept = mLevel - mSlope * mOrigin;
+    mEstimate.mResidual = residual;
+    mEstimate.mResidualVariance = mWeight > 2.0 ? std::max(mSquaredErrors, 0.0) / (mWeight - 2.0) : 0.0;
+    mEstimate.mZScore = previousVariance > 0.0 ? residual / std::sqrt(previousVariance) : 0.0;
+    return mEstimate;
+}
+
+KalmanHedgeRatio::KalmanHedgeRatio(double interceptNoise, double ratioNoise, double observationNoise)
+    : mInterceptNoise(interceptNoise), mRatioNoise(ratioNoise), mObservationNoise(observationNoise)
+{
+    if (interceptNoise < 0.0 || ratioNoise < 0.0 || observationNoise <= 0.0)
+        throw ReadyTraderGoError("Kalman filter process noises must not be negative and observation noise must "
+                                 "be positive");
+}
+
+void KalmanHedgeRatio::Reset()
+{
+    mLevel = 0.0;
+    mSlope = 1.0;
+    mP00 = mP01 = mP11 = 0.0;
+    mEstimate = HedgeRatioEstimate{};
+}
+
+HedgeRatioState KalmanHedgeRatio::GetState() const
+{
+    return HedgeRatioState{mOrigin, mLevel, mSlope, mP00, mP01, mP11, 0.0, 0.0, mEstimate};
+}
+
+void KalmanHedgeRatio::SetState(const HedgeRatioState& state)
+{
+    mOrigin = state.mOrigin;
+    mLevel = state.mLevel;
+    mSlope = state.mSlope;
+    mP00 = state.mP00;
+    mP01 = state.mP01;
+    mP11 = state.mP11;
+    mEstimate = state.mEstimate;
+}
+
+const HedgeRatioEstimate& KalmanHedgeRatio::Update(double future, double etf)
+{
+    if (mEstimate.mCount == 0)
+    {
+        // Start from the pair itself with a hedge ratio of one, as unsure of
+        // the intercept as of a single observation and of the ratio to
+        // within about one.
+        mOrigin = future;
+        mLevel = etf;
+        mP00 = mObservationNoise;
+        mP11 = 1.0;
+    }
+
+    // Predict: the state is unchanged but less certain.
+    mP00 += mInterceptNoise;
+    mP11 += mRatioNoise;
+
+    const double x = future - mOrigin;
+    const double residual = etf - (mLevel + mSlope * x);
+    const double ph0 = mP00 + mP01 * x;
+    const double ph1 = mP01 + mP11 * x;
+    const double innovationVariance = ph0 + x * ph1 + mObservationNoise;
+    const double k0 = ph0 / innovationVariance;
+    const double k1 = ph1 / innovationVariance;
+
+    mLevel += k0 * residual;
+    mSlope += k1 * residual;
+    mP00 -= k0 * ph0;
+    mP01 -= k0 * ph1;
+    mP11 -= k1 * ph1;
+
+    ++mEstimate.mCount;
+    mEstimate.mHedgeRatio = mSlope;
+    mEstimate.mIntercept = mLevel - mSlope * mOrigin;
+    mEstimate.mResidual = residual;
+    mEstimate.mResidualVariance = innovationVariance;
+    mEstimate.mZScore = residual / std::sqrt(innovationVariance);
+    return mEstimate;
+}
+
+}
@@ -0,0 +1,134 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_HEDGERATIO_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_HEDGERATIO_H
+
+#include <cstdint>
+
+namespace ReadyTraderGo {
+
+// The ETF's price regressed on the future's:
+//     etf = intercept + hedgeRatio * future + residual
+struct HedgeRatioEstimate
+{
+    double mHedgeRatio = 1.0;
+    double mIntercept = 0.0;
+    // Of the latest pair, against the estimate from before it was seen.
+    double mResidual = 0.0;
+    double mResidualVariance = 0.0;
+    // The residual in standard deviations, or zero while the variance is
+    // still unknown.
+    double mZScore = 0.0;
+    std::uint64_t mCount = 0;
+};
+
+// Everything an estimator learns from the pairs, so that it can be saved
+// and later restored in place of seeing them again. Terms an estimator does
+// not have are left at zero.
+struct HedgeRatioState
+{
+    double mOrigin = 0.0;
+    double mLevel = 0.0;
+    double mSlope = 1.0;
+    double mP00 = 0.0;
+    double mP01 = 0.0;
+    double mP11 = 0.0;
+    double mSquaredErrors = 0.0;
+    double mWeight = 0.0;
+    HedgeRatioEstimate mEstimate;
+};
+
+// Least squares fitted incrementally: each pair is an O(1) update of a
+// two-parameter state, with no window to rescan. With a forgetting factor of
+// one every pair counts equally and the fit matches ordinary least squares;
+// below one, older pairs are discounted geometrically (a factor of 0.999
+// halves a pair's weight after about 693 more).
+//
+// Future prices are measured from the first one seen, which keeps the
+// covariance well conditioned; the reported intercept is converted back.
+class RecursiveLeastSquares
+{
+public:
+    explicit RecursiveLeastSquares(double forgettingFactor = 0.999, double initialCovariance = 1e6);
+
+    const HedgeRatioEstimate& GetEstimate() const { return mEstimate; }
+
+    const HedgeRatioEstimate& Update(double future, double etf);
+    void Reset();
+
+    HedgeRatioState GetState() const;
+    void SetState(const HedgeRatioState& state);
+
+private:
+    const double mForgettingFactor;
+    const double mInitialCovariance;
+
+    double mOrigin = 0.0;
+    double mLevel = 0.0;
+    double mSlope = 1.0;
+    // The symmetric covariance matrix [[mP00, mP01], [mP01, mP11]].
+    double mP00;
+    double mP01 = 0.0;
+    double mP11;
+    // Discounted sum of squared residuals and of weights.
+    double mSquaredErrors = 0.0;
+    double mWeight = 0.0;
+
+    HedgeRatioEstimate mEstimate;
+};
+
+// A Kalman filter whose state is the intercept and hedge ratio, each taken
+// to follow a random walk. Rather than forgetting old pairs at a fixed rate,
+// the estimate moves as fast as the process noises allow relative to the
+// observation noise. The residual variance is that of the filter's
+// prediction, so it also reflects how uncertain the state is.
+class KalmanHedgeRatio
+{
+public:
+    // Variances (in cents squared, or squared ratio) added per pair to the
+    // intercept and hedge ratio, and of the noise on each observed ETF price.
+    explicit KalmanHedgeRatio(double interceptNoise = 1.0,
+                              double ratioNoise = 1e-9,
+                              double observationNoise = 1e4);
+
+    const HedgeRatioEstimate& GetEstimate() const { return mEstimate; }
+
+    const HedgeRatioEstimate& Update(double future, double etf);
+    void Reset();
+
+    HedgeRatioState GetState() const;
+    void SetState(const HedgeRatioState& state);
+
+private:
+    const double mInterceptNoise;
+    const double mRatioNoise;
+    const double mObservationNoise;
+
+    double mOrigin = 0.0;
+    double mLevel = 0.0;
+    double mSlope = 1.0;
+    double mP00 = 0.0;
+    double mP01 = 0.0;
+    double mP11 = 0.0;
+
+    HedgeRatioEstimate mEstimate;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_HEDGERATIO_H
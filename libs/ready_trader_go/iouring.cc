@@ -0,0 +1,219 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifdef __linux__
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "error.h"
+#include "iouring.h"
+
+namespace ReadyTraderGo {
+
+static std::string systemError(const char* what, int error)
+{
+    return std::string(what) + ": " + std::strerror(error);
+}
+
+IoUring::IoUring(const IoUringOptions& options)
+{
+    io_uring_params params{};
+    if (options.mSqPoll)
+    {
+        params.flags |= IORING_SETUP_SQPOLL;
+        params.sq_thread_idle = options.mSqPollIdleMilliseconds;
+    }
+
+    mFd = static_cast<int>(syscall(__NR_io_uring_setup, options.mEntries, &params));
+    if (mFd < 0)
+        throw ReadyTraderGoError(systemError("io_uring_setup failed", errno));
+    mSqPoll = options.mSqPoll;
+
+    mSqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    mCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap)
+    {
+        mSqRingSize = mCqRingSize = std::max(mSqRingSize, mCqRingSize);
+    }
+
+    mSqRing = mmap(nullptr, mSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mFd, IORING_OFF_SQ_RING);
+    if (mSqRing == MAP_FAILED)
+    {
+        const int error = errno;
+        mSqRing = nullptr;
+        close(mFd);
+        throw ReadyTraderGoError(systemError("failed to map io_uring submission queue", error));
+    }
+
+    if (singleMap)
+    {
+        mCqRing = mSqRing;
+    }
+    else
+    {
+        mCqRing = mmap(nullptr, mCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mFd,
+                       IORING_OFF_CQ_RING);
+        if (mCqRing == MAP_FAILED)
+        {
+            const int error = errno;
+            mCqRing = nullptr;
+            munmap(mSqRing, mSqRingSize);
+            close(mFd);
+            throw ReadyTraderGoError(systemError("failed to map io_uring completion queue", error));
+        }
+    }
+
+    mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mFd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        const int error = errno;
+        if (mCqRing != mSqRing)
+            munmap(mCqRing, mCqRingSize);
+        munmap(mSqRing, mSqRingSize);
+        close(mFd);
+        throw ReadyTraderGoError(systemError("failed to map io_uring submission entries", error));
+    }
+    mSqes = static_cast<io_uring_sqe*>(sqes);
+
+    auto* sq = static_cast<unsigned char*>(mSqRing);
+    mSqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    mSqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    mSqFlags = reinterpret_cast<unsigned*>(sq + params.sq_off.flags);
+    mSqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    mSqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    mSqEntries = params.sq_entries;
+    mSqLocalTail = mSqSubmitted = *mSqTail;
+
+    auto* cq = static_cast<unsigned char*>(mCqRing);
+    mCqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    mCqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    mCqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    mCqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+}
+
+IoUring::~IoUring()
+{
+    munmap(mSqes, mSqesSize);
+    if (mCqRing != mSqRing)
+        munmap(mCqRing, mCqRingSize);
+    munmap(mSqRing, mSqRingSize);
+    close(mFd);
+}
+
+io_uring_sqe* IoUring::GetSqe()
+{
+    const unsigned head = __atomic_load_n(mSqHead, __ATOMIC_ACQUIRE);
+    if (mSqLocalTail - head >= mSqEntries)
+        return nullptr;
+    const unsigned index = mSqLocalTail++ & mSqMask;
+    io_uring_sqe* sqe = &mSqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    mSqArray[index] = index;
+    return sqe;
+}
+
+void IoUring::Submit()
+{
+    const unsigned toSubmit = mSqLocalTail - mSqSubmitted;
+    if (toSubmit == 0)
+        return;
+    __atomic_store_n(mSqTail, mSqLocalTail, __ATOMIC_RELEASE);
+    mSqSubmitted = mSqLocalTail;
+
+    if (mSqPoll)
+    {
+        // The tail store must be visible before the flag is read, otherwise a
+        // thread going to sleep could miss the new entries.
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if ((__atomic_load_n(mSqFlags, __ATOMIC_RELAXED) & IORING_SQ_NEED_WAKEUP) != 0)
+            Enter(0, 0, IORING_ENTER_SQ_WAKEUP);
+        return;
+    }
+
+    Enter(toSubmit, 0, 0);
+}
+
+void IoUring::WaitForCompletion()
+{
+    Enter(0, 1, IORING_ENTER_GETEVENTS);
+}
+
+int IoUring::Enter(unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    int result;
+    do
+    {
+        ++mEnterCount;
+        result = static_cast<int>(syscall(__NR_io_uring_enter, mFd, toSubmit, minComplete, flags, nullptr, 0));
+    }
+    while (result < 0 && errno == EINTR);
+
+    if (result < 0)
+        throw ReadyTraderGoError(systemError("io_uring_enter failed", errno));
+    return result;
+}
+
+void IoUring::Register(unsigned opcode, const void* argument, unsigned count, const char* what)
+{
+    if (syscall(__NR_io_uring_register, mFd, opcode, argument, count) < 0)
+        throw ReadyTraderGoError(systemError(what, errno));
+}
+
+void IoUring::RegisterBuffers(const iovec* buffers, unsigned count)
+{
+    Register(IORING_REGISTER_BUFFERS, buffers, count, "failed to register io_uring buffers");
+}
+
+void IoUring::RegisterEventFd(int eventFd)
+{
+    Register(IORING_REGISTER_EVENTFD, &eventFd, 1, "failed to register io_uring eventfd");
+}
+
+MappedBuffer::MappedBuffer(std::size_t size) : mSize(size)
+{
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (data == MAP_FAILED)
+        throw ReadyTraderGoError(systemError("failed to map buffer memory", errno));
+    mData = static_cast<unsigned char*>(data);
+}
+
+MappedBuffer::~MappedBuffer()
+{
+    munmap(mData, mSize);
+}
+
+void IoUring::RegisterBufferRing(io_uring_buf_ring* ring, unsigned entries, unsigned short group)
+{
+    io_uring_buf_reg registration{};
+    registration.ring_addr = reinterpret_cast<std::uint64_t>(ring);
+    registration.ring_entries = entries;
+    registration.bgid = group;
+    Register(IORING_REGISTER_PBUF_RING, &registration, 1, "failed to register io_uring buffer ring");
+}
+
+}
+
+#endif
@@ -0,0 +1,156 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_IOURING_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_IOURING_H
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+#endif
+
+namespace ReadyTraderGo {
+
+#ifdef __linux__
+constexpr bool IO_URING_SUPPORTED = true;
+#else
+constexpr bool IO_URING_SUPPORTED = false;
+#endif
+
+struct IoUringOptions
+{
+    unsigned mEntries = 64;
+    // Have a kernel thread poll the submission queue, so that submitting
+    // needs no system call while the thread is awake.
+    bool mSqPoll = false;
+    unsigned mSqPollIdleMilliseconds = 1000;
+};
+
+#ifdef __linux__
+// A minimal io_uring instance driven with raw system calls (no liburing).
+// Submission and completion queues are shared with the kernel through
+// mmap'd rings; only the owning thread may use an instance.
+//
+// The constructor throws a ReadyTraderGoError if the kernel does not support
+// io_uring (or forbids it), so callers can fall back to something else.
+class IoUring
+{
+public:
+    explicit IoUring(const IoUringOptions& options = {});
+    ~IoUring();
+
+    IoUring(const IoUring&) = delete;
+    void operator=(const IoUring&) = delete;
+
+    bool IsSqPoll() const { return mSqPoll; }
+
+    // Return a cleared submission queue entry, or nullptr if the queue is
+    // full. Entries become visible to the kernel when Submit is called.
+    io_uring_sqe* GetSqe();
+
+    // Publish queued entries and, unless a polling kernel thread is awake to
+    // pick them up, enter the kernel to submit them.
+    void Submit();
+
+    // Block until at least one completion is available.
+    void WaitForCompletion();
+
+    // Call function(const io_uring_cqe&) for every available completion.
+    template<typename F>
+    unsigned DrainCompletions(F&& function);
+
+    void RegisterBuffers(const iovec* buffers, unsigned count);
+    void RegisterEventFd(int eventFd);
+    // Register a ring of provided buffers in the given group. The ring
+    // memory (entries * sizeof(io_uring_buf), page aligned) stays owned by
+    // the caller.
+    void RegisterBufferRing(io_uring_buf_ring* ring, unsigned entries, unsigned short group);
+
+    // Number of io_uring_enter calls made, for benchmarking.
+    std::uint64_t GetEnterCount() const { return mEnterCount; }
+
+private:
+    int Enter(unsigned toSubmit, unsigned minComplete, unsigned flags);
+    void Register(unsigned opcode, const void* argument, unsigned count, const char* what);
+
+    int mFd = -1;
+    bool mSqPoll = false;
+    std::uint64_t mEnterCount = 0;
+
+    void* mSqRing = nullptr;
+    std::size_t mSqRingSize = 0;
+    void* mCqRing = nullptr;
+    std::size_t mCqRingSize = 0;
+    io_uring_sqe* mSqes = nullptr;
+    std::size_t mSqesSize = 0;
+
+    unsigned* mSqHead = nullptr;
+    unsigned* mSqTail = nullptr;
+    unsigned* mSqFlags = nullptr;
+    unsigned* mSqArray = nullptr;
+    unsigned mSqMask = 0;
+    unsigned mSqEntries = 0;
+    unsigned mSqLocalTail = 0;
+    unsigned mSqSubmitted = 0;
+
+    unsigned* mCqHead = nullptr;
+    unsigned* mCqTail = nullptr;
+    io_uring_cqe* mCqes = nullptr;
+    unsigned mCqMask = 0;
+};
+
+// Page aligned, zero filled memory mapped for the lifetime of the object,
+// suitable for buffer rings and registered buffers.
+class MappedBuffer
+{
+public:
+    explicit MappedBuffer(std::size_t size);
+    ~MappedBuffer();
+
+    MappedBuffer(const MappedBuffer&) = delete;
+    void operator=(const MappedBuffer&) = delete;
+
+    unsigned char* Data() const { return mData; }
+    std::size_t Size() const { return mSize; }
+
+private:
+    unsigned char* mData;
+    std::size_t mSize;
+};
+
+template<typename F>
+unsigned IoUring::DrainCompletions(F&& function)
+{
+    unsigned head = *mCqHead;
+    const unsigned tail = __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE);
+    const unsigned count = tail - head;
+    for (; head != tail; ++head)
+    {
+        function(static_cast<const io_uring_cqe&>(mCqes[head & mCqMask]));
+    }
+    __atomic_store_n(mCqHead, head, __ATOMIC_RELEASE);
+    return count;
+}
+
+#endif
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_IOURING_H
@@ -0,0 +1,294 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <system_error>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "error.h"
+#include "journal.h"
+#include "logging.h"
+
+namespace interprocess = boost::interprocess;
+
+RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_JNL, "JRNL")
+
+namespace ReadyTraderGo {
+
+constexpr std::size_t JOURNAL_PAGE_SIZE = 4096;
+
+std::string JournalSegmentFilename(const std::string& baseName, std::uint64_t segmentNumber)
+{
+    std::ostringstream filename;
+    filename << baseName << '.' << std::setw(6) << std::setfill('0') << segmentNumber << ".jnl";
+    return filename.str();
+}
+
+JournalSegment::JournalSegment(const std::string& baseName, std::uint64_t segmentNumber, std::size_t capacity)
+    : mSegmentNumber(segmentNumber)
+{
+    std::string filename = JournalSegmentFilename(baseName, segmentNumber);
+    {
+        std::ofstream stream{filename, std::ios_base::binary | std::ios_base::trunc};
+        if (!stream)
+        {
+            throw ReadyTraderGoError("failed to create journal segment '" + filename + "': "
+                                     + std::strerror(errno));
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::resize_file(filename, capacity, error);
+    if (error)
+    {
+        throw ReadyTraderGoError("failed to size journal segment '" + filename + "': " + error.message());
+    }
+
+    mFile = interprocess::file_mapping{filename.c_str(), interprocess::read_write};
+    mRegion = interprocess::mapped_region{mFile, interprocess::read_write};
+
+    // Touch every page now so that the writer never takes a page fault.
+    auto* address = GetAddress();
+    for (std::size_t offset = 0; offset < capacity; offset += JOURNAL_PAGE_SIZE)
+    {
+        address[offset] = 0;
+    }
+
+    auto* header = GetHeader();
+    header->mMagic = JOURNAL_MAGIC;
+    header->mVersion = JOURNAL_VERSION;
+    header->mSegmentNumber = segmentNumber;
+    header->mCapacity = capacity;
+    header->mCalibrationTsc = ReadTimestampCounter();
+    header->mCalibrationRealtime = ReadRealtimeNanoseconds();
+    header->mSealed.store(0, std::memory_order_relaxed);
+    header->mEnd.store(sizeof(JournalSegmentHeader), std::memory_order_release);
+}
+
+JournalSegment::JournalSegment(const std::string& baseName, std::uint64_t segmentNumber)
+    : mSegmentNumber(segmentNumber)
+{
+    std::string filename = JournalSegmentFilename(baseName, segmentNumber);
+    mFile = interprocess::file_mapping{filename.c_str(), interprocess::read_only};
+    mRegion = interprocess::mapped_region{mFile, interprocess::read_only};
+
+    if (GetSize() < sizeof(JournalSegmentHeader))
+    {
+        throw ReadyTraderGoError("'" + filename + "' is not a journal segment");
+    }
+    if (!IsReady())
+    {
+        return;
+    }
+
+    auto* header = GetHeader();
+    if (header->mMagic != JOURNAL_MAGIC)
+    {
+        throw ReadyTraderGoError("'" + filename + "' is not a journal segment");
+    }
+    if (header->mVersion != JOURNAL_VERSION)
+    {
+        throw ReadyTraderGoError("journal segment '" + filename + "' has unsupported version "
+                                 + std::to_string(header->mVersion));
+    }
+}
+
+Journal::Journal(std::string baseName, std::size_t segmentSize)
+    : mBaseName(std::move(baseName)), mSegmentSize(segmentSize)
+{
+    if (mSegmentSize < JOURNAL_PAGE_SIZE)
+    {
+        throw ReadyTraderGoError("journal segment size must be at least "
+                                 + std::to_string(JOURNAL_PAGE_SIZE) + " bytes");
+    }
+
+    // Any journal previously written with the same name is replaced.
+    std::error_code error;
+    for (std::uint64_t n = 0; std::filesystem::remove(JournalSegmentFilename(mBaseName, n), error); ++n)
+    {
+    }
+
+    mActive = std::make_unique<JournalSegment>(mBaseName, mNextSegmentNumber++, mSegmentSize);
+    mActiveHeader = mActive->GetHeader();
+    mActiveBase = mActive->GetAddress();
+    mActiveEnd = sizeof(JournalSegmentHeader);
+    mActiveCapacity = mActive->GetSize();
+
+    RLOG(LG_JNL, LogLevel::LL_INFO) << "journal " << std::quoted(mBaseName, '\'') << " opened with "
+                                    << mSegmentSize << " byte segments";
+
+    mThread = std::thread([this] { BackgroundWorker(); });
+}
+
+Journal::~Journal()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mCondition.notify_one();
+    mThread.join();
+
+    mActiveHeader->mSealed.store(1, std::memory_order_release);
+    mActive->Flush();
+
+    if (mSpare)
+    {
+        // An unused spare would only confuse readers.
+        auto filename = JournalSegmentFilename(mBaseName, mSpare->GetSegmentNumber());
+        mSpare.reset();
+        std::error_code error;
+        std::filesystem::remove(filename, error);
+    }
+
+    RLOG(LG_JNL, LogLevel::LL_INFO) << "journal " << std::quoted(mBaseName, '\'') << " closed after "
+                                    << mRecordCount << " records in " << mActive->GetSegmentNumber() + 1
+                                    << " segments (" << mSynchronousRollCount << " synchronous rolls)";
+}
+
+void Journal::BackgroundWorker()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (!mStopping)
+    {
+        while (!mRetired.empty())
+        {
+            auto retired = std::move(mRetired.back());
+            mRetired.pop_back();
+            lock.unlock();
+            retired->Flush();
+            retired.reset();
+            lock.lock();
+        }
+
+        if (!mSpare && !mCreatingSpare)
+        {
+            mCreatingSpare = true;
+            auto segmentNumber = mNextSegmentNumber++;
+            lock.unlock();
+            auto spare = std::make_unique<JournalSegment>(mBaseName, segmentNumber, mSegmentSize);
+            lock.lock();
+            mSpare = std::move(spare);
+            mCreatingSpare = false;
+            mCondition.notify_all();
+            continue;
+        }
+
+        mCondition.wait(lock);
+    }
+}
+
+void Journal::Roll()
+{
+    mActiveHeader->mSealed.store(1, std::memory_order_release);
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (!mSpare)
+    {
+        // The background thread has fallen behind (or is still creating the
+        // spare), so the trading thread has to wait for the next segment.
+        ++mSynchronousRollCount;
+        if (mCreatingSpare)
+        {
+            mCondition.wait(lock, [this] { return !mCreatingSpare; });
+        }
+        else
+        {
+            mSpare = std::make_unique<JournalSegment>(mBaseName, mNextSegmentNumber++, mSegmentSize);
+        }
+    }
+
+    mRetired.push_back(std::move(mActive));
+    mActive = std::move(mSpare);
+    mActiveHeader = mActive->GetHeader();
+    mActiveBase = mActive->GetAddress();
+    mActiveEnd = sizeof(JournalSegmentHeader);
+    mActiveCapacity = mActive->GetSize();
+
+    lock.unlock();
+    mCondition.notify_all();
+}
+
+JournalReader::JournalReader(std::string baseName) : mBaseName(std::move(baseName))
+{
+    if (!OpenSegment(0))
+    {
+        throw ReadyTraderGoError("journal '" + mBaseName + "' does not exist");
+    }
+}
+
+bool JournalReader::OpenSegment(std::uint64_t segmentNumber)
+{
+    std::error_code error;
+    const std::uintmax_t size = std::filesystem::file_size(JournalSegmentFilename(mBaseName, segmentNumber), error);
+    if (error || size < sizeof(JournalSegmentHeader))
+    {
+        return false;
+    }
+
+    auto segment = std::make_unique<JournalSegment>(mBaseName, segmentNumber);
+    if (!segment->IsReady())
+    {
+        return false;
+    }
+    mSegment = std::move(segment);
+    mPosition = sizeof(JournalSegmentHeader);
+    return true;
+}
+
+bool JournalReader::Next(JournalRecord& record)
+{
+    for (;;)
+    {
+        // The seal is read before the end so that records added just before
+        // the segment was sealed are not skipped.
+        const JournalSegmentHeader* segmentHeader = mSegment->GetHeader();
+        const bool isSealed = segmentHeader->mSealed.load(std::memory_order_acquire) != 0;
+        const std::size_t end = segmentHeader->mEnd.load(std::memory_order_acquire);
+        if (mPosition < end)
+        {
+            auto* header = reinterpret_cast<JournalRecordHeader const*>(mSegment->GetAddress() + mPosition);
+            record.mDirection = header->mDirection;
+            record.mTsc = header->mTsc;
+            record.mRealtime = header->mRealtime;
+            record.mData = reinterpret_cast<unsigned char const*>(header + 1);
+            record.mSize = header->mSize;
+            mPosition += (sizeof(JournalRecordHeader) + header->mSize + JOURNAL_RECORD_ALIGNMENT - 1)
+                         & ~(JOURNAL_RECORD_ALIGNMENT - 1);
+            return true;
+        }
+
+        // The writer preallocates the next segment long before it moves on
+        // to it, so only a sealed segment has been finished with.
+        if (!isSealed || !OpenSegment(mSegment->GetSegmentNumber() + 1))
+        {
+            return false;
+        }
+    }
+}
+
+}
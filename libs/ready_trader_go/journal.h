@@ -0,0 +1,236 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_JOURNAL_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_JOURNAL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "clock.h"
+#include "error.h"
+
+namespace ReadyTraderGo {
+
+constexpr std::uint32_t JOURNAL_MAGIC = 0x4c4e524a; // "JRNL" in little-endian order
+constexpr std::uint32_t JOURNAL_VERSION = 1;
+constexpr std::size_t JOURNAL_DEFAULT_SEGMENT_SIZE = 64 * 1024 * 1024;
+constexpr std::size_t JOURNAL_RECORD_ALIGNMENT = 8;
+
+enum class JournalDirection : unsigned char
+{
+    INFO_IN,
+    EXEC_IN,
+    EXEC_OUT
+};
+
+// Every segment starts with this header. The writer advances mEnd (with
+// release semantics) after each record so that a reader can safely follow a
+// live segment.
+struct JournalSegmentHeader
+{
+    std::uint32_t mMagic;
+    std::uint32_t mVersion;
+    std::uint64_t mSegmentNumber;
+    std::uint64_t mCapacity;
+    std::uint64_t mCalibrationTsc;
+    std::uint64_t mCalibrationRealtime;
+    std::atomic<std::uint64_t> mEnd;
+    std::atomic<std::uint32_t> mSealed;
+    std::uint32_t mReserved;
+};
+
+// Each record holds an entire protocol message (including the three byte
+// message header) as it appeared on the wire.
+struct JournalRecordHeader
+{
+    std::uint32_t mSize;
+    JournalDirection mDirection;
+    unsigned char mReserved[3];
+    std::uint64_t mTsc;
+    std::uint64_t mRealtime;
+};
+
+static_assert(sizeof(JournalRecordHeader) == 24, "journal record header must be 24 bytes");
+static_assert(sizeof(JournalSegmentHeader) % JOURNAL_RECORD_ALIGNMENT == 0,
+              "journal segment header must preserve record alignment");
+
+std::string JournalSegmentFilename(const std::string& baseName, std::uint64_t segmentNumber);
+
+class JournalSegment
+{
+public:
+    // Create (and preallocate) a new segment file for writing.
+    JournalSegment(const std::string& baseName, std::uint64_t segmentNumber, std::size_t capacity);
+
+    // Open an existing segment file for reading. The writer may still be
+    // creating it, in which case it is not yet ready.
+    JournalSegment(const std::string& baseName, std::uint64_t segmentNumber);
+
+    JournalSegment(const JournalSegment&) = delete;
+    void operator=(const JournalSegment&) = delete;
+
+    unsigned char* GetAddress() const { return static_cast<unsigned char*>(mRegion.get_address()); }
+    JournalSegmentHeader* GetHeader() const { return reinterpret_cast<JournalSegmentHeader*>(GetAddress()); }
+    std::size_t GetSize() const { return mRegion.get_size(); }
+    std::uint64_t GetSegmentNumber() const { return mSegmentNumber; }
+    // The header is complete once the end of the records has been set.
+    bool IsReady() const { return GetHeader()->mEnd.load(std::memory_order_acquire) != 0; }
+    void Flush() { mRegion.flush(0, 0, true); }
+
+private:
+    std::uint64_t mSegmentNumber;
+    boost::interprocess::file_mapping mFile;
+    boost::interprocess::mapped_region mRegion;
+};
+
+// An append-only, memory-mapped binary journal of raw protocol messages.
+//
+// Record() is intended to be called from the trading thread: it copies the
+// message into the active segment and never blocks on I/O. A background
+// thread preallocates the next segment and retires (flushes and unmaps) full
+// ones.
+class Journal
+{
+public:
+    explicit Journal(std::string baseName, std::size_t segmentSize = JOURNAL_DEFAULT_SEGMENT_SIZE);
+    ~Journal();
+
+    Journal(const Journal&) = delete;
+    void operator=(const Journal&) = delete;
+
+    const std::string& GetBaseName() const { return mBaseName; }
+    std::uint64_t GetRecordCount() const { return mRecordCount; }
+    std::uint64_t GetSynchronousRollCount() const { return mSynchronousRollCount; }
+
+    void Record(JournalDirection direction, unsigned char const* data, std::size_t size);
+
+private:
+    void BackgroundWorker();
+    void Roll();
+
+    std::string mBaseName;
+    std::size_t mSegmentSize;
+
+    std::unique_ptr<JournalSegment> mActive;
+    JournalSegmentHeader* mActiveHeader = nullptr;
+    unsigned char* mActiveBase = nullptr;
+    std::size_t mActiveEnd = 0;
+    std::size_t mActiveCapacity = 0;
+    std::uint64_t mNextSegmentNumber = 0;
+    std::uint64_t mRecordCount = 0;
+    std::uint64_t mSynchronousRollCount = 0;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::unique_ptr<JournalSegment> mSpare;
+    std::vector<std::unique_ptr<JournalSegment>> mRetired;
+    bool mCreatingSpare = false;
+    bool mStopping = false;
+    std::thread mThread;
+};
+
+inline void Journal::Record(JournalDirection direction, unsigned char const* data, std::size_t size)
+{
+    const std::size_t recordSize = (sizeof(JournalRecordHeader) + size + JOURNAL_RECORD_ALIGNMENT - 1)
+                                   & ~(JOURNAL_RECORD_ALIGNMENT - 1);
+    if (mActiveEnd + recordSize > mActiveCapacity)
+    {
+        // Rolling would not help a record too large for an empty segment.
+        if (recordSize > mActiveCapacity - sizeof(JournalSegmentHeader))
+        {
+            throw ReadyTraderGoError("journal record of " + std::to_string(size)
+                                     + " bytes does not fit in a segment");
+        }
+        Roll();
+    }
+
+    auto* header = reinterpret_cast<JournalRecordHeader*>(mActiveBase + mActiveEnd);
+    header->mSize = static_cast<std::uint32_t>(size);
+    header->mDirection = direction;
+    header->mTsc = ReadTimestampCounter();
+    header->mRealtime = ReadRealtimeNanoseconds();
+    std::memcpy(header + 1, data, size);
+
+    mActiveEnd += recordSize;
+    mActiveHeader->mEnd.store(mActiveEnd, std::memory_order_release);
+    ++mRecordCount;
+}
+
+struct JournalRecord
+{
+    JournalDirection mDirection;
+    std::uint64_t mTsc;
+    std::uint64_t mRealtime;
+    unsigned char const* mData;
+    std::size_t mSize;
+};
+
+// Sequential reader over all segments of a journal.
+class JournalReader
+{
+public:
+    explicit JournalReader(std::string baseName);
+
+    // Advance to the next record, returning false at the end of the journal.
+    // The record's data remains valid until the following call to Next().
+    // When following a journal that is still being written, false means the
+    // reader has caught up with the writer and Next() may be called again
+    // later.
+    bool Next(JournalRecord& record);
+
+private:
+    bool OpenSegment(std::uint64_t segmentNumber);
+
+    std::string mBaseName;
+    std::unique_ptr<JournalSegment> mSegment;
+    std::size_t mPosition = 0;
+};
+
+template<typename C, typename T>
+std::basic_ostream<C, T>& operator<<(std::basic_ostream<C, T>& strm, JournalDirection direction)
+{
+    switch (direction)
+    {
+    case JournalDirection::INFO_IN:
+        strm << "INFO<";
+        break;
+    case JournalDirection::EXEC_IN:
+        strm << "EXEC<";
+        break;
+    case JournalDirection::EXEC_OUT:
+        strm << "EXEC>";
+        break;
+    }
+    return strm;
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_JOURNAL_H
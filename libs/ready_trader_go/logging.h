@@ -57,7 +57,13 @@ std::basic_ostream<C, T>& operator<<(std::basic_ostream<C, T>& strm, LogLevel lv
         boost::log::sources::severity_channel_logger<ReadyTraderGo::LogLevel>,\
         (boost::log::keywords::channel = (channelName)));
 
-#define RLOG(loggerName, logLevel) BOOST_LOG_SEV(loggerName::get(), (logLevel))
+// Boost.Log builds a record's attribute values (allocating as it does so)
+// before any sink filter sees it, so records below this level are discarded
+// up front instead. Disabled log statements then cost a single comparison.
+inline LogLevel gLogLevelThreshold = LogLevel::LL_DEBUG;
+
+#define RLOG(loggerName, logLevel)\
+    if ((logLevel) < ReadyTraderGo::gLogLevelThreshold) {} else BOOST_LOG_SEV(loggerName::get(), (logLevel))
 }
 
 #endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_LOGGING_H
@@ -0,0 +1,274 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_MESSAGELAYOUT_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_MESSAGELAYOUT_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include <boost/endian/conversion.hpp>
+
+#include "connectivitytypes.h"
+#include "price.h"
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+enum MessageFieldSize : std::size_t
+{
+    BYTE = 1,
+    LONG = 4,
+    STRING = 50
+};
+
+// How a field's type travels on the wire: its size in bytes and how it is
+// read and written. Everything is big-endian and nothing is aligned. Read
+// decodes into an existing value, so a string reuses its capacity; Get
+// returns the field without copying where it can (a string is viewed in
+// place).
+template<typename T, typename = void>
+struct WireFormat;
+
+inline std::uint32_t loadBigEndian32(unsigned char const* data)
+{
+    std::uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return boost::endian::big_to_native(value);
+}
+
+inline void storeBigEndian32(unsigned char* buf, std::uint32_t value)
+{
+    value = boost::endian::native_to_big(value);
+    std::memcpy(buf, &value, sizeof(value));
+}
+
+template<>
+struct WireFormat<unsigned long>
+{
+    static constexpr std::size_t SIZE = MessageFieldSize::LONG;
+    static unsigned long Get(unsigned char const* data) { return loadBigEndian32(data); }
+    static void Read(unsigned char const* data, unsigned long& value) { value = Get(data); }
+    static void Write(unsigned char* buf, unsigned long value) { storeBigEndian32(buf, std::uint32_t(value)); }
+};
+
+template<>
+struct WireFormat<signed long>
+{
+    static constexpr std::size_t SIZE = MessageFieldSize::LONG;
+    static signed long Get(unsigned char const* data) { return std::int32_t(loadBigEndian32(data)); }
+    static void Read(unsigned char const* data, signed long& value) { value = Get(data); }
+    static void Write(unsigned char* buf, signed long value) { storeBigEndian32(buf, std::uint32_t(value)); }
+};
+
+template<>
+struct WireFormat<Price>
+{
+    static constexpr std::size_t SIZE = MessageFieldSize::LONG;
+    static Price Get(unsigned char const* data) { return Price(loadBigEndian32(data)); }
+    static void Read(unsigned char const* data, Price& value) { value = Get(data); }
+    static void Write(unsigned char* buf, Price value) { storeBigEndian32(buf, std::uint32_t(value.Cents())); }
+};
+
+template<>
+struct WireFormat<Volume>
+{
+    static constexpr std::size_t SIZE = MessageFieldSize::LONG;
+    static Volume Get(unsigned char const* data) { return Volume(loadBigEndian32(data)); }
+    static void Read(unsigned char const* data, Volume& value) { value = Get(data); }
+    static void Write(unsigned char* buf, Volume value) { storeBigEndian32(buf, std::uint32_t(value.Lots())); }
+};
+
+// Instrument, Lifespan and Side are each a single byte.
+template<typename T>
+struct WireFormat<T, std::enable_if_t<std::is_enum_v<T> && sizeof(T) == MessageFieldSize::BYTE>>
+{
+    static constexpr std::size_t SIZE = MessageFieldSize::BYTE;
+    static T Get(unsigned char const* data) { return T(*data); }
+    static void Read(unsigned char const* data, T& value) { value = Get(data); }
+    static void Write(unsigned char* buf, T value) { *buf = static_cast<unsigned char>(value); }
+};
+
+// Fixed length and padded with zeros; a string of exactly the maximum length
+// has no terminator and a longer one is truncated.
+template<>
+struct WireFormat<std::string>
+{
+    static constexpr std::size_t SIZE = MessageFieldSize::STRING;
+    static std::string_view Get(unsigned char const* data)
+    {
+        auto end = static_cast<unsigned char const*>(std::memchr(data, 0, SIZE));
+        return std::string_view(reinterpret_cast<char const*>(data), (end != nullptr) ? end - data : SIZE);
+    }
+    static void Read(unsigned char const* data, std::string& value) { value.assign(Get(data)); }
+    static void Write(unsigned char* buf, const std::string& value)
+    {
+        const std::size_t length = std::min(value.size(), SIZE);
+        std::memcpy(buf, value.data(), length);
+        std::memset(buf + length, 0, SIZE - length);
+    }
+};
+
+// Consecutive elements, such as a side of an order book.
+template<typename T, std::size_t N>
+struct WireFormat<std::array<T, N>>
+{
+    static constexpr std::size_t SIZE = WireFormat<T>::SIZE * N;
+    static std::array<T, N> Get(unsigned char const* data)
+    {
+        std::array<T, N> value;
+        Read(data, value);
+        return value;
+    }
+    static void Read(unsigned char const* data, std::array<T, N>& value)
+    {
+        for (std::size_t i = 0; i < N; ++i)
+            WireFormat<T>::Read(data + i * WireFormat<T>::SIZE, value[i]);
+    }
+    static void Write(unsigned char* buf, const std::array<T, N>& value)
+    {
+        for (std::size_t i = 0; i < N; ++i)
+            WireFormat<T>::Write(buf + i * WireFormat<T>::SIZE, value[i]);
+    }
+};
+
+template<typename C, typename T>
+T memberType(T C::*);
+
+// A data member of a message, written in the order its field is listed.
+template<auto Member>
+struct Field
+{
+    using Type = decltype(memberType(Member));
+    using Format = WireFormat<Type>;
+    static constexpr auto MEMBER = Member;
+    static constexpr std::size_t SIZE = Format::SIZE;
+};
+
+// A message's fields, in wire order. The offset of every field and the size
+// of the whole message are worked out at compile time, so each field is
+// read or written at a constant offset with no pointer to advance.
+template<typename... Fields>
+struct MessageLayout
+{
+    static constexpr std::size_t FIELD_COUNT = sizeof...(Fields);
+    static constexpr std::size_t SIZE = (Fields::SIZE + ...);
+    static constexpr std::array<std::size_t, FIELD_COUNT> OFFSETS = [] {
+        std::array<std::size_t, FIELD_COUNT> offsets{};
+        const std::array<std::size_t, FIELD_COUNT> sizes = {Fields::SIZE...};
+        for (std::size_t i = 1; i < FIELD_COUNT; ++i)
+            offsets[i] = offsets[i - 1] + sizes[i - 1];
+        return offsets;
+    }();
+
+    template<auto Member>
+    static constexpr bool HAS_FIELD = (std::is_same_v<Field<Member>, Fields> || ...);
+
+    template<auto Member>
+    static constexpr std::size_t OffsetOf()
+    {
+        static_assert(HAS_FIELD<Member>, "the member is not one of the message's fields");
+        constexpr std::array<bool, FIELD_COUNT> matches = {std::is_same_v<Field<Member>, Fields>...};
+        std::size_t i = 0;
+        while (!matches[i])
+            ++i;
+        return OFFSETS[i];
+    }
+
+    template<typename M>
+    static void Encode(const M& message, unsigned char* buf)
+    {
+        Encode(message, buf, std::index_sequence_for<Fields...>());
+    }
+
+    template<typename M>
+    static void Decode(unsigned char const* data, M& message)
+    {
+        Decode(data, message, std::index_sequence_for<Fields...>());
+    }
+
+private:
+    template<typename M, std::size_t... I>
+    static void Encode(const M& message, unsigned char* buf, std::index_sequence<I...>)
+    {
+        (Fields::Format::Write(buf + OFFSETS[I], message.*Fields::MEMBER), ...);
+    }
+
+    template<typename M, std::size_t... I>
+    static void Decode(unsigned char const* data, M& message, std::index_sequence<I...>)
+    {
+        (Fields::Format::Read(data + OFFSETS[I], message.*Fields::MEMBER), ...);
+    }
+};
+
+// The serialisation of a message whose struct names its MessageLayout as
+// Layout. The data given to Deserialise must hold at least Layout::SIZE
+// bytes.
+template<typename M>
+struct WireMessage : ISerialisable
+{
+    std::size_t Size() const noexcept override { return M::Layout::SIZE; }
+
+    void Deserialise(unsigned char const* data, std::size_t) override
+    {
+        M::Layout::Decode(data, static_cast<M&>(*this));
+    }
+
+    void Serialise(unsigned char* buf) const override
+    {
+        M::Layout::Encode(static_cast<const M&>(*this), buf);
+    }
+};
+
+// Reads single fields of a received message where they lie, for code that
+// routes or filters messages without decoding them. A field may be read only
+// if the data is long enough to hold it.
+template<typename M>
+class MessageView
+{
+public:
+    MessageView(unsigned char const* data, std::size_t size) : mData(data), mSize(size) {}
+
+    bool IsComplete() const { return mSize >= M::Layout::SIZE; }
+
+    template<auto Member>
+    bool Has() const
+    {
+        return mSize >= M::Layout::template OffsetOf<Member>() + Field<Member>::SIZE;
+    }
+
+    template<auto Member>
+    auto Get() const
+    {
+        return Field<Member>::Format::Get(mData + M::Layout::template OffsetOf<Member>());
+    }
+
+private:
+    unsigned char const* mData;
+    std::size_t mSize;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_MESSAGELAYOUT_H
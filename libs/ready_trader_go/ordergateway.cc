@@ -0,0 +1,397 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include <boost/asio/post.hpp>
+
+#include "error.h"
+#include "errorcode.h"
+#include "logging.h"
+#include "ordergateway.h"
+
+RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_GWY, "GATEWAY")
+
+namespace ReadyTraderGo {
+
+// The pass of a strategy with a weight of one advances by this much each
+// time it is served.
+constexpr std::uint64_t GATEWAY_STRIDE = std::uint64_t(1) << 20;
+
+OrderGateway::OrderGateway(boost::asio::io_context& context,
+                           std::size_t messageLimit,
+                           std::chrono::nanoseconds interval,
+                           std::size_t activeOrderLimit)
+    : mContext(context), mInterval(interval),
+      mSendTimes(messageLimit, std::chrono::steady_clock::time_point::min()), mDrainTimer(context)
+{
+    if (messageLimit == 0)
+        throw ReadyTraderGoError("order gateway message limit must be positive");
+    mOwners.reserve(MAXIMUM_OWNERS);
+
+    // Room for every order the exchange allows to be live, with plenty to
+    // spare for those sent but not yet answered. Each rename spends up to a
+    // table's worth of sequence numbers, so it should be no bigger.
+    std::size_t capacity = 1;
+    while (capacity < 8 * activeOrderLimit)
+    {
+        capacity <<= 1;
+    }
+    mRenamed.resize(capacity);
+}
+
+OrderGateway::~OrderGateway()
+{
+    if (mConnection)
+    {
+        mConnection->Disconnected = nullptr;
+        mConnection->MessageReceived = nullptr;
+    }
+}
+
+std::unique_ptr<GatewayConnection> OrderGateway::Register(std::string name, unsigned weight)
+{
+    if (mOwners.size() == MAXIMUM_OWNERS)
+        throw ReadyTraderGoError("too many strategies for the order gateway");
+
+    if (weight == 0)
+        throw ReadyTraderGoError("order gateway weight must be positive");
+
+    const auto owner = static_cast<unsigned>(mOwners.size());
+    Owner& o = mOwners.emplace_back();
+    o.mName = std::move(name);
+    o.mWeight = weight;
+    o.mStride = GATEWAY_STRIDE / weight;
+    auto connection = std::make_unique<GatewayConnection>(*this, owner);
+    o.mConnection = connection.get();
+    return connection;
+}
+
+void OrderGateway::SetConnection(std::unique_ptr<IConnection>&& connection)
+{
+    mConnection = std::move(connection);
+    mConnection->SetName("Exec");
+    mConnection->Disconnected = [this] { DisconnectHandler(); };
+    mConnection->MessageReceived = [this](IConnection*, unsigned char t, unsigned char const* d, std::size_t s) {
+        MessageHandler(t, d, s);
+    };
+    mConnection->AsyncRead();
+}
+
+bool OrderGateway::HasRoom(std::chrono::steady_clock::time_point now) const
+{
+    // The slot about to be reused holds the oldest send in the window.
+    return mSendTimes[mSendIndex] + mInterval <= now;
+}
+
+unsigned long OrderGateway::NextClientOrderId(unsigned owner)
+{
+    // Skip the slots of renamed orders, so that an order needing a fresh id
+    // finds its own slot free.
+    const std::size_t mask = mRenamed.size() - 1;
+    for (std::size_t i = 0; i != mask && mRenamed[(mSequence + 1) & mask].mFreshId != 0; ++i)
+    {
+        ++mSequence;
+    }
+    return (++mSequence << OWNER_BITS) | owner;
+}
+
+void OrderGateway::Rename(unsigned owner, unsigned long& clientOrderId, bool isNewOrder)
+{
+    if (!isNewOrder)
+    {
+        const RenamedOrder& slot = GetRenamedSlot(clientOrderId);
+        if (slot.mClientOrderId == clientOrderId)
+        {
+            clientOrderId = slot.mFreshId;
+        }
+        else if (!mRenamedOverflow.empty())
+        {
+            auto it = std::find_if(mRenamedOverflow.begin(), mRenamedOverflow.end(),
+                                   [clientOrderId](const auto& r) { return r.mClientOrderId == clientOrderId; });
+            if (it != mRenamedOverflow.end())
+            {
+                clientOrderId = it->mFreshId;
+            }
+        }
+        return;
+    }
+
+    if (clientOrderId <= mLastOrderId)
+    {
+        RenamedOrder& slot = GetRenamedSlot(clientOrderId);
+        if (slot.mFreshId == 0)
+        {
+            // The first sequence number after the last that shares the slot.
+            const std::size_t mask = mRenamed.size() - 1;
+            mSequence += 1 + (((clientOrderId >> OWNER_BITS) - (mSequence + 1)) & mask);
+            slot = {clientOrderId, (mSequence << OWNER_BITS) | owner};
+            clientOrderId = slot.mFreshId;
+        }
+        else
+        {
+            // Only if a table's worth of ids were handed out while this
+            // order waited, or the table is full.
+            RLOG(LG_GWY, LogLevel::LL_WARNING) << "slot for order " << clientOrderId << " of '"
+                                               << mOwners[owner].mName << "' is taken by order "
+                                               << slot.mClientOrderId;
+            const unsigned long fresh = NextClientOrderId(owner);
+            mRenamedOverflow.push_back({clientOrderId, fresh});
+            clientOrderId = fresh;
+        }
+    }
+    mLastOrderId = clientOrderId;
+}
+
+void OrderGateway::Transmit(unsigned owner, unsigned char messageType, QueuedMessage& message, SendMode mode)
+{
+    std::visit([this, owner](auto& m) {
+        using T = std::decay_t<decltype(m)>;
+        Rename(owner, m.mClientOrderId, std::is_same_v<T, HedgeMessage> || std::is_same_v<T, InsertMessage>);
+    }, message);
+
+    mSendTimes[mSendIndex] = std::chrono::steady_clock::now();
+    mSendIndex = (mSendIndex + 1 == mSendTimes.size()) ? 0 : mSendIndex + 1;
+    std::visit([this, messageType, mode](const auto& m) { mConnection->SendMessage(messageType, m, mode); },
+               message);
+}
+
+void OrderGateway::Send(unsigned owner, unsigned char messageType, const ISerialisable& serialisable, SendMode mode)
+{
+    if (messageType == MessageType::LOGIN)
+    {
+        if (!mLoggedIn)
+        {
+            mLoggedIn = true;
+            mConnection->SendMessage(messageType, serialisable, mode);
+        }
+        return;
+    }
+
+    // The auto-trader always sends the message type's own structure.
+    QueuedMessage message;
+    unsigned long clientOrderId;
+    switch (messageType)
+    {
+    case MessageType::AMEND_ORDER:
+        clientOrderId = message.emplace<AmendMessage>(static_cast<const AmendMessage&>(serialisable)).mClientOrderId;
+        break;
+    case MessageType::CANCEL_ORDER:
+        clientOrderId = message.emplace<CancelMessage>(static_cast<const CancelMessage&>(serialisable)).mClientOrderId;
+        break;
+    case MessageType::HEDGE_ORDER:
+        clientOrderId = message.emplace<HedgeMessage>(static_cast<const HedgeMessage&>(serialisable)).mClientOrderId;
+        break;
+    case MessageType::INSERT_ORDER:
+        clientOrderId = message.emplace<InsertMessage>(static_cast<const InsertMessage&>(serialisable)).mClientOrderId;
+        break;
+    default:
+        throw ReadyTraderGoError("order gateway cannot send message of type "
+                                 + std::to_string(static_cast<int>(messageType)));
+    }
+
+    Owner& o = mOwners[owner];
+    if (o.mQueueSize == 0 && mBackloggedCount == 0 && HasRoom(std::chrono::steady_clock::now()))
+    {
+        ++o.mSentCount;
+        Transmit(owner, messageType, message, mode);
+        return;
+    }
+
+    if (o.mQueueSize == QUEUE_CAPACITY)
+    {
+        ++o.mRejectedCount;
+        RLOG(LG_GWY, LogLevel::LL_WARNING) << "queue for '" << o.mName << "' is full, rejecting order "
+                                           << clientOrderId;
+        boost::asio::post(mContext, [this, owner, clientOrderId] {
+            if (GatewayConnection* connection = mOwners[owner].mConnection)
+            {
+                ErrorMessage error{clientOrderId, "order gateway queue is full"};
+                unsigned char data[ErrorMessage::Layout::SIZE];
+                error.Serialise(data);
+                connection->Deliver(MessageType::ERROR_MESSAGE, data, error.Size(), ReceiveTimestamps{});
+            }
+        });
+        return;
+    }
+
+    if (o.mQueueSize == 0)
+    {
+        // A strategy that had nothing to send banks no credit for it.
+        ++mBackloggedCount;
+        o.mPass = std::max(o.mPass, mGlobalPass);
+    }
+    o.mQueue[(o.mQueueHead + o.mQueueSize++) % QUEUE_CAPACITY] = {messageType, std::move(message)};
+    o.mMaximumQueueSize = std::max(o.mMaximumQueueSize, o.mQueueSize);
+    ++o.mDelayedCount;
+    ArmDrainTimer();
+}
+
+void OrderGateway::Drain()
+{
+    const auto now = std::chrono::steady_clock::now();
+    while (mBackloggedCount != 0 && HasRoom(now))
+    {
+        Owner* next = nullptr;
+        for (Owner& o : mOwners)
+        {
+            if (o.mQueueSize != 0 && (!next || o.mPass < next->mPass))
+            {
+                next = &o;
+            }
+        }
+
+        auto& [messageType, message] = next->mQueue[next->mQueueHead];
+        Transmit(static_cast<unsigned>(next - mOwners.data()), messageType, message, SendMode::ASAP);
+        next->mQueueHead = (next->mQueueHead + 1) % QUEUE_CAPACITY;
+        ++next->mSentCount;
+        mGlobalPass = next->mPass;
+        next->mPass += next->mStride;
+        if (--next->mQueueSize == 0)
+        {
+            --mBackloggedCount;
+        }
+    }
+    ArmDrainTimer();
+}
+
+void OrderGateway::ArmDrainTimer()
+{
+    if (mDrainTimerArmed || mBackloggedCount == 0)
+    {
+        return;
+    }
+
+    mDrainTimerArmed = true;
+    mDrainTimer.expires_at(mSendTimes[mSendIndex] + mInterval);
+    mDrainTimer.async_wait(bindHandlerMemory(mDrainTimerMemory, [this](const boost::system::error_code& error) {
+        mDrainTimerArmed = false;
+        if (!error)
+        {
+            Drain();
+        }
+    }));
+}
+
+void OrderGateway::MessageHandler(unsigned char messageType, unsigned char const* data, std::size_t size)
+{
+    // Every execution message starts with the client order id.
+    if (size < MessageFieldSize::LONG)
+    {
+        RLOG(LG_GWY, LogLevel::LL_ERROR) << "received execution message too short to route: type="
+                                         << static_cast<int>(messageType) << " size=" << size;
+        return;
+    }
+
+    const unsigned long clientOrderId = loadBigEndian32(data);
+    const ReceiveTimestamps& timestamps = mConnection->GetReceiveTimestamps();
+    if (clientOrderId == 0)
+    {
+        // Not about any order, so everyone should hear about it.
+        for (Owner& o : mOwners)
+        {
+            if (o.mConnection)
+            {
+                o.mConnection->Deliver(messageType, data, size, timestamps);
+            }
+        }
+        return;
+    }
+
+    const unsigned owner = GetOwner(clientOrderId);
+    if (owner >= mOwners.size() || !mOwners[owner].mConnection)
+    {
+        return;
+    }
+
+    RenamedOrder* renamed = &GetRenamedSlot(clientOrderId);
+    auto overflow = mRenamedOverflow.end();
+    if (renamed->mFreshId != clientOrderId)
+    {
+        overflow = std::find_if(mRenamedOverflow.begin(), mRenamedOverflow.end(),
+                                [clientOrderId](const auto& r) { return r.mFreshId == clientOrderId; });
+        if (overflow == mRenamedOverflow.end())
+        {
+            mOwners[owner].mConnection->Deliver(messageType, data, size, timestamps);
+            return;
+        }
+        renamed = &*overflow;
+    }
+
+    // Give the strategy back the id it chose.
+    // Of the execution messages, the error message is the longest.
+    unsigned char buffer[ErrorMessage::Layout::SIZE];
+    if (size > sizeof(buffer))
+    {
+        RLOG(LG_GWY, LogLevel::LL_ERROR) << "received execution message too long to translate: type="
+                                         << static_cast<int>(messageType) << " size=" << size;
+        return;
+    }
+    std::memcpy(buffer, data, size);
+    storeBigEndian32(buffer, static_cast<std::uint32_t>(renamed->mClientOrderId));
+
+    const MessageView<OrderStatusMessage> status(data, size);
+    const MessageView<ErrorMessage> error(data, size);
+    const bool isFinished = (messageType == MessageType::HEDGE_FILLED)
+        || (messageType == MessageType::ORDER_STATUS && status.Has<&OrderStatusMessage::mRemainingVolume>()
+            && !status.Get<&OrderStatusMessage::mRemainingVolume>())
+        // A refused amend leaves the order as it was; any other error about
+        // an order, a refused insert or hedge included, means the exchange
+        // no longer has it.
+        || (messageType == MessageType::ERROR_MESSAGE && error.Has<&ErrorMessage::mMessage>()
+            && ClassifyError(error.Get<&ErrorMessage::mMessage>()) != ErrorCode::AMEND_INCREASES_VOLUME);
+    if (isFinished)
+    {
+        if (overflow != mRenamedOverflow.end())
+        {
+            mRenamedOverflow.erase(overflow);
+        }
+        else
+        {
+            *renamed = RenamedOrder{};
+        }
+    }
+    mOwners[owner].mConnection->Deliver(messageType, buffer, size, timestamps);
+}
+
+void OrderGateway::DisconnectHandler()
+{
+    for (Owner& o : mOwners)
+    {
+        if (o.mConnection)
+        {
+            o.mConnection->OnDisconnect();
+        }
+    }
+}
+
+void OrderGateway::WriteReport(std::ostream& out) const
+{
+    out << "  order gateway: orders=" << mSequence << " renamed_capacity=" << mRenamed.size() << '\n';
+    for (const Owner& o : mOwners)
+    {
+        out << "    '" << o.mName << "' weight=" << o.mWeight << " sent=" << o.mSentCount
+            << " delayed=" << o.mDelayedCount << " rejected=" << o.mRejectedCount
+            << " max_queue=" << o.mMaximumQueueSize << '\n';
+    }
+}
+
+}
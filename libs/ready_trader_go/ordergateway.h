@@ -0,0 +1,204 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ORDERGATEWAY_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ORDERGATEWAY_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include "connectivitytypes.h"
+#include "handlermemory.h"
+#include "protocol.h"
+
+namespace ReadyTraderGo {
+
+class GatewayConnection;
+
+// Shares one execution connection, and so one login, between several
+// strategies.
+//
+// Every client order id carries its owner in its low OWNER_BITS bits, above
+// which is a sequence number shared by all strategies. The exchange insists
+// that each new order's id be larger than the last, so the owner cannot go in
+// the high bits; in the low bits it still lets each response be routed by
+// masking its id rather than looking it up. Strategies must therefore take
+// their ids from their connection (see BaseAutoTrader::NextClientOrderId).
+// Ids are taken when an order is made, but waiting messages from different
+// strategies may go out in a different order, so an insert or hedge that
+// would reach the exchange with an id no larger than the last is sent under
+// a fresh one. The gateway translates between the two for the rest of the
+// order's life through a table indexed by sequence number, modulo its size.
+// The fresh id is chosen to fall in the same slot as the strategy's id, so
+// one lookup serves both directions, and ids are not handed out for slots in
+// use. The table is sized from the active order count limit so that live
+// orders fill only a small part of it; should an order's slot nonetheless be
+// taken, it is kept in a list on the side rather than one being forgotten.
+//
+// The exchange's message frequency limit is shared too. While there is room
+// in the limit's window messages go straight out; once it is full they wait
+// in a queue per strategy and, as room appears, each strategy is served in
+// proportion to its weight (by stride scheduling). A strategy's own messages
+// are never reordered.
+class OrderGateway
+{
+public:
+    static constexpr unsigned OWNER_BITS = 3;
+    static constexpr std::size_t MAXIMUM_OWNERS = std::size_t(1) << OWNER_BITS;
+    static constexpr std::size_t QUEUE_CAPACITY = 64;
+
+    static unsigned GetOwner(unsigned long clientOrderId) { return clientOrderId & (MAXIMUM_OWNERS - 1); }
+
+    // The limit is the number of messages allowed in any interval of the
+    // given length. The active order limit is the exchange's limit on the
+    // number of orders live at once.
+    OrderGateway(boost::asio::io_context& context,
+                 std::size_t messageLimit = 50,
+                 std::chrono::nanoseconds interval = std::chrono::seconds(1),
+                 std::size_t activeOrderLimit = 10);
+    ~OrderGateway();
+
+    OrderGateway(const OrderGateway&) = delete;
+    void operator=(const OrderGateway&) = delete;
+
+    // A connection for a strategy to use in place of the real one.
+    std::unique_ptr<GatewayConnection> Register(std::string name, unsigned weight = 1);
+
+    // The gateway sends the first login it is given by any strategy and
+    // drops the rest.
+    void SetConnection(std::unique_ptr<IConnection>&& connection);
+
+    std::size_t GetRenamedCapacity() const { return mRenamed.size(); }
+
+    void WriteReport(std::ostream& out) const;
+
+private:
+    friend class GatewayConnection;
+
+    using QueuedMessage = std::variant<AmendMessage, CancelMessage, HedgeMessage, InsertMessage>;
+
+    struct Owner
+    {
+        std::string mName;
+        GatewayConnection* mConnection = nullptr;
+        unsigned mWeight = 1;
+        std::uint64_t mStride = 0;
+        std::uint64_t mPass = 0;
+
+        std::array<std::pair<unsigned char, QueuedMessage>, QUEUE_CAPACITY> mQueue;
+        std::size_t mQueueHead = 0;
+        std::size_t mQueueSize = 0;
+
+        std::uint64_t mSentCount = 0;
+        std::uint64_t mDelayedCount = 0;
+        std::uint64_t mRejectedCount = 0;
+        std::size_t mMaximumQueueSize = 0;
+    };
+
+    // An order sent under a fresh id; a free slot has a fresh id of zero.
+    struct RenamedOrder
+    {
+        unsigned long mClientOrderId = 0;
+        unsigned long mFreshId = 0;
+    };
+
+    RenamedOrder& GetRenamedSlot(unsigned long clientOrderId)
+    {
+        return mRenamed[(clientOrderId >> OWNER_BITS) & (mRenamed.size() - 1)];
+    }
+    unsigned long NextClientOrderId(unsigned owner);
+    void Send(unsigned owner, unsigned char messageType, const ISerialisable& serialisable, SendMode mode);
+    void Unregister(unsigned owner) { mOwners[owner].mConnection = nullptr; }
+
+    bool HasRoom(std::chrono::steady_clock::time_point now) const;
+    void Transmit(unsigned owner, unsigned char messageType, QueuedMessage& message, SendMode mode);
+    void Rename(unsigned owner, unsigned long& clientOrderId, bool isNewOrder);
+    void Drain();
+    void ArmDrainTimer();
+    void MessageHandler(unsigned char messageType, unsigned char const* data, std::size_t size);
+    void DisconnectHandler();
+
+    boost::asio::io_context& mContext;
+    std::unique_ptr<IConnection> mConnection;
+    bool mLoggedIn = false;
+    unsigned long mSequence = 0;
+    // The id of the last insert or hedge sent to the exchange.
+    unsigned long mLastOrderId = 0;
+
+    // Renamed orders by sequence number modulo the (power of two) size, and
+    // the few that found their slot taken.
+    std::vector<RenamedOrder> mRenamed;
+    std::vector<RenamedOrder> mRenamedOverflow;
+
+    std::vector<Owner> mOwners;
+    std::size_t mBackloggedCount = 0;
+    std::uint64_t mGlobalPass = 0;
+
+    // When each of the last messageLimit messages was sent, as a ring.
+    const std::chrono::nanoseconds mInterval;
+    std::vector<std::chrono::steady_clock::time_point> mSendTimes;
+    std::size_t mSendIndex = 0;
+
+    HandlerMemory mDrainTimerMemory;
+    boost::asio::steady_timer mDrainTimer;
+    bool mDrainTimerArmed = false;
+};
+
+// A strategy's view of an OrderGateway. Responses to its orders, and errors
+// not about any order, arrive as if it had the connection to itself.
+class GatewayConnection : public IConnection
+{
+public:
+    GatewayConnection(OrderGateway& gateway, unsigned owner) : mGateway(gateway), mOwner(owner) {}
+    ~GatewayConnection() override { mGateway.Unregister(mOwner); }
+
+    void AsyncRead() override {}
+    void SendMessage(unsigned char messageType, const ISerialisable& serialisable, SendMode mode) override
+    {
+        mGateway.Send(mOwner, messageType, serialisable, mode);
+    }
+    unsigned long NextClientOrderId() override { return mGateway.NextClientOrderId(mOwner); }
+
+private:
+    friend class OrderGateway;
+
+    void Deliver(unsigned char messageType,
+                 unsigned char const* data,
+                 std::size_t size,
+                 const ReceiveTimestamps& timestamps)
+    {
+        mReceiveTimestamps = timestamps;
+        OnMessageReceipt(messageType, data, size);
+    }
+
+    OrderGateway& mGateway;
+    const unsigned mOwner;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_ORDERGATEWAY_H
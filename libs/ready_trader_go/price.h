@@ -0,0 +1,216 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_PRICE_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_PRICE_H
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+constexpr unsigned long TICK_SIZE_IN_CENTS = 100;
+
+// Prices, volumes and ids each travel in four bytes on the wire.
+constexpr unsigned long MAXIMUM_WIRE_VALUE = std::numeric_limits<std::uint32_t>::max();
+
+// A signed number of ticks.
+class Ticks
+{
+public:
+    constexpr Ticks() = default;
+    constexpr explicit Ticks(signed long count) : mCount(count) {}
+
+    constexpr signed long Count() const { return mCount; }
+
+    constexpr Ticks operator-() const { return Ticks(-mCount); }
+    constexpr bool operator==(Ticks other) const { return mCount == other.mCount; }
+    constexpr bool operator!=(Ticks other) const { return mCount != other.mCount; }
+    constexpr bool operator<(Ticks other) const { return mCount < other.mCount; }
+    constexpr bool operator>(Ticks other) const { return mCount > other.mCount; }
+
+private:
+    signed long mCount = 0;
+};
+
+// A price in cents. Zero is no price, as at an empty order book level.
+class Price
+{
+public:
+    constexpr Price() = default;
+    constexpr explicit Price(unsigned long cents) : mCents(cents) {}
+
+    constexpr unsigned long Cents() const { return mCents; }
+    constexpr explicit operator bool() const { return mCents != 0; }
+
+    constexpr Price RoundDownToTick() const { return Price(mCents - mCents % TICK_SIZE_IN_CENTS); }
+    constexpr Price RoundUpToTick() const
+    {
+        return (mCents % TICK_SIZE_IN_CENTS == 0) ? *this : Price(RoundDownToTick().mCents + TICK_SIZE_IN_CENTS);
+    }
+
+    // Moves by whole ticks, stopping at the lowest and highest prices at
+    // which an order on the tick grid may be placed. The price should be on
+    // the grid.
+    constexpr Price operator+(Ticks ticks) const;
+    constexpr Price operator-(Ticks ticks) const { return *this + -ticks; }
+
+    // Whole ticks from the other price to this one; both should be on the
+    // grid.
+    constexpr Ticks operator-(Price other) const
+    {
+        return Ticks((static_cast<signed long>(mCents) - static_cast<signed long>(other.mCents))
+                     / static_cast<signed long>(TICK_SIZE_IN_CENTS));
+    }
+
+    constexpr bool operator==(Price other) const { return mCents == other.mCents; }
+    constexpr bool operator!=(Price other) const { return mCents != other.mCents; }
+    constexpr bool operator<(Price other) const { return mCents < other.mCents; }
+    constexpr bool operator<=(Price other) const { return mCents <= other.mCents; }
+    constexpr bool operator>(Price other) const { return mCents > other.mCents; }
+    constexpr bool operator>=(Price other) const { return mCents >= other.mCents; }
+
+private:
+    unsigned long mCents = 0;
+};
+
+// The lowest and highest prices on the tick grid the exchange accepts.
+constexpr Price MINIMUM_BID_TICK = Price(MINIMUM_BID).RoundUpToTick();
+constexpr Price MAXIMUM_ASK_TICK = Price(MAXIMUM_ASK).RoundDownToTick();
+
+constexpr Price Price::operator+(Ticks ticks) const
+{
+    // In ticks, the bounds are small enough that no sum can overflow.
+    const signed long lowest = MINIMUM_BID_TICK.mCents / TICK_SIZE_IN_CENTS;
+    const signed long highest = MAXIMUM_ASK_TICK.mCents / TICK_SIZE_IN_CENTS;
+    const signed long count = static_cast<signed long>(mCents / TICK_SIZE_IN_CENTS) + ticks.Count();
+    const signed long clamped = (count < lowest) ? lowest : (count > highest) ? highest : count;
+    return Price(static_cast<unsigned long>(clamped) * TICK_SIZE_IN_CENTS);
+}
+
+// A number of lots. Arithmetic saturates at zero and at the largest volume
+// the wire can carry.
+class Volume
+{
+public:
+    constexpr Volume() = default;
+    constexpr explicit Volume(unsigned long lots) : mLots(lots) {}
+
+    constexpr unsigned long Lots() const { return mLots; }
+    constexpr explicit operator bool() const { return mLots != 0; }
+
+    constexpr Volume operator+(Volume other) const
+    {
+        return Volume((mLots > MAXIMUM_WIRE_VALUE - other.mLots) ? MAXIMUM_WIRE_VALUE : mLots + other.mLots);
+    }
+    constexpr Volume operator-(Volume other) const { return Volume((mLots > other.mLots) ? mLots - other.mLots : 0); }
+    constexpr Volume& operator+=(Volume other) { return *this = *this + other; }
+    constexpr Volume& operator-=(Volume other) { return *this = *this - other; }
+
+    constexpr bool operator==(Volume other) const { return mLots == other.mLots; }
+    constexpr bool operator!=(Volume other) const { return mLots != other.mLots; }
+    constexpr bool operator<(Volume other) const { return mLots < other.mLots; }
+    constexpr bool operator<=(Volume other) const { return mLots <= other.mLots; }
+    constexpr bool operator>(Volume other) const { return mLots > other.mLots; }
+    constexpr bool operator>=(Volume other) const { return mLots >= other.mLots; }
+
+private:
+    unsigned long mLots = 0;
+};
+
+// Cents times lots, which cannot overflow (see below), though a sum of such
+// products at the extremes could.
+constexpr std::uint64_t operator*(Price price, Volume volume)
+{
+    return std::uint64_t(price.Cents()) * volume.Lots();
+}
+
+// The mid of two prices in whole cents, rounded down.
+class MidPrice
+{
+public:
+    constexpr MidPrice() = default;
+    constexpr explicit MidPrice(Price price) : mCents(price.Cents()) {}
+    constexpr MidPrice(Price bid, Price ask) : mCents((bid.Cents() + ask.Cents()) / 2) {}
+
+    constexpr unsigned long Cents() const { return mCents; }
+    constexpr double ToDouble() const { return static_cast<double>(mCents); }
+    constexpr explicit operator bool() const { return mCents != 0; }
+
+    // In cents.
+    constexpr signed long operator-(MidPrice other) const
+    {
+        return static_cast<signed long>(mCents) - static_cast<signed long>(other.mCents);
+    }
+
+    constexpr bool operator==(MidPrice other) const { return mCents == other.mCents; }
+    constexpr bool operator!=(MidPrice other) const { return mCents != other.mCents; }
+    constexpr bool operator<(MidPrice other) const { return mCents < other.mCents; }
+    constexpr bool operator>(MidPrice other) const { return mCents > other.mCents; }
+
+private:
+    unsigned long mCents = 0;
+};
+
+using PriceLevels = std::array<Price, TOP_LEVEL_COUNT>;
+using VolumeLevels = std::array<Volume, TOP_LEVEL_COUNT>;
+
+// Overflow at the limits, checked once here rather than at each use.
+static_assert(MAXIMUM_ASK <= MAXIMUM_WIRE_VALUE, "prices must fit on the wire");
+static_assert(2 * MAXIMUM_ASK <= std::numeric_limits<unsigned long>::max(), "the sum of two prices must fit");
+static_assert(MAXIMUM_ASK <= std::uint64_t(std::numeric_limits<signed long>::max()), "tick differences must fit");
+static_assert(std::uint64_t(MAXIMUM_ASK) <= std::numeric_limits<std::uint64_t>::max() / MAXIMUM_WIRE_VALUE,
+              "a price times a volume must fit");
+static_assert(MINIMUM_BID_TICK.Cents() == TICK_SIZE_IN_CENTS);
+static_assert(MAXIMUM_ASK_TICK <= Price(MAXIMUM_ASK) && MAXIMUM_ASK_TICK + Ticks(1) == MAXIMUM_ASK_TICK);
+static_assert(MINIMUM_BID_TICK - Ticks(1) == MINIMUM_BID_TICK && Price() + Ticks(1) == MINIMUM_BID_TICK);
+static_assert(Price(12300) + Ticks(2) == Price(12500) && Price(12500) - Price(12300) == Ticks(2));
+static_assert(Volume(MAXIMUM_WIRE_VALUE) + Volume(1) == Volume(MAXIMUM_WIRE_VALUE) && Volume(1) - Volume(2) == Volume());
+static_assert(MidPrice(Price(MAXIMUM_ASK), Price(MAXIMUM_ASK)).Cents() == MAXIMUM_ASK);
+static_assert(MidPrice(Price(10100), Price(10200)).Cents() == 10150 && MidPrice(Price(101), Price(102)).Cents() == 101);
+
+template<typename C, typename T>
+std::basic_ostream<C, T>& operator<<(std::basic_ostream<C, T>& strm, Price price)
+{
+    return strm << price.Cents();
+}
+
+template<typename C, typename T>
+std::basic_ostream<C, T>& operator<<(std::basic_ostream<C, T>& strm, Volume volume)
+{
+    return strm << volume.Lots();
+}
+
+template<typename C, typename T>
+std::basic_ostream<C, T>& operator<<(std::basic_ostream<C, T>& strm, Ticks ticks)
+{
+    return strm << ticks.Count();
+}
+
+template<typename C, typename T>
+std::basic_ostream<C, T>& operator<<(std::basic_ostream<C, T>& strm, MidPrice mid)
+{
+    return strm << mid.Cents();
+}
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_PRICE_H
@@ -15,303 +15,102 @@
 //     You should have received a copy of the GNU Affero General Public
 //     License along with Ready Trader Go.  If not, see
 //     <https://www.gnu.org/licenses/>.
-#include <cstring>
+#include <iomanip>
+#include <ostream>
 #include <string>
 
-#include <boost/endian/conversion.hpp>
-
 #include "protocol.h"
 
 namespace ReadyTraderGo {
 
-static std::string readFixedLengthString(unsigned char const* data, std::size_t maxSize)
-{
-    auto loc = (decltype(data)) std::memchr(data, 0, maxSize);
-    auto len = (loc != nullptr) ? loc - data : maxSize;
-    return std::string((char const*) data, len);
-}
-
-static void writeFixedLengthString(const std::string& message, unsigned char* buf, std::size_t maxSize)
+template<class T>
+static void printLevels(std::ostream& out, const char* name, const std::array<T, TOP_LEVEL_COUNT>& values)
 {
-    auto len = message.length();
-    std::memcpy(buf, message.c_str(), len);
-    if (len < maxSize)
+    out << ' ' << name << '=';
+    for (std::size_t i = 0; i < TOP_LEVEL_COUNT; ++i)
     {
-        std::memset(buf + len, 0, maxSize - len);
+        out << (i ? "," : "") << values[i];
     }
 }
 
-void AmendMessage::Deserialise(unsigned char const* data, std::size_t)
-{
-    mClientOrderId = boost::endian::big_to_native(*(uint32_t*)data);
-    data += MessageFieldSize::LONG;
-    mNewVolume = boost::endian::big_to_native(*(uint32_t*)data);
-}
-
-void AmendMessage::Serialise(unsigned char* buf) const
-{
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mClientOrderId);
-    buf += MessageFieldSize::LONG;
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mNewVolume);
-}
-
-void CancelMessage::Deserialise(unsigned char const* data, std::size_t)
-{
-    mClientOrderId = boost::endian::big_to_native(*(uint32_t*)data);
-}
-
-void CancelMessage::Serialise(unsigned char* buf) const
-{
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mClientOrderId);
-}
-
-void ErrorMessage::Deserialise(unsigned char const* data, std::size_t)
-{
-    mClientOrderId = boost::endian::big_to_native(*(uint32_t*)data);
-    data += MessageFieldSize::LONG;
-    mMessage = readFixedLengthString(data, MessageFieldSize::STRING);
-}
-
-void ErrorMessage::Serialise(unsigned char* buf) const
-{
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mClientOrderId);
-    buf += MessageFieldSize::LONG;
-    writeFixedLengthString(mMessage, buf, MessageFieldSize::STRING);
-}
-
-void HedgeMessage::Deserialise(unsigned char const* data, std::size_t)
-{
-    mClientOrderId = boost::endian::big_to_native(*(uint32_t*)data);
-    data += MessageFieldSize::LONG;
-    mSide = Side(*data);
-    data += MessageFieldSize::BYTE;
-    mPrice = boost::endian::big_to_native(*(uint32_t*)data);
-    data += MessageFieldSize::LONG;
-    mVolume = boost::endian::big_to_native(*(uint32_t*)data);
-}
-
-void HedgeMessage::Serialise(unsigned char* buf) const
-{
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mClientOrderId);
-    buf += MessageFieldSize::LONG;
-    *buf = static_cast<unsigned char>(mSide);
-    buf += MessageFieldSize::BYTE;
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mPrice);
-    buf += MessageFieldSize::LONG;
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mVolume);
-}
-
-void HedgeFilledMessage::Deserialise(unsigned char const* data, std::size_t)
-{
-    mClientOrderId = boost::endian::big_to_native(*(uint32_t*)data);
-    data += MessageFieldSize::LONG;
-    mPrice = boost::endian::big_to_native(*(uint32_t*)data);
-    data += MessageFieldSize::LONG;
-    mVolume = boost::endian::big_to_native(*(uint32_t*)data);
-}
-
-void HedgeFilledMessage::Serialise(unsigned char* buf) const
-{
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mClientOrderId);
-    buf += MessageFieldSize::LONG;
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mPrice);
-    buf += MessageFieldSize::LONG;
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mVolume);
-}
-
-void InsertMessage::Deserialise(unsigned char const* data, std::size_t)
-{
-    mClientOrderId = boost::endian::big_to_native(*(uint32_t*)data);
-    data += MessageFieldSize::LONG;
-    mSide = Side(*data);
-    data += MessageFieldSize::BYTE;
-    mPrice = boost::endian::big_to_native(*(uint32_t*)data);
-    data += MessageFieldSize::LONG;
-    mVolume = boost::endian::big_to_native(*(uint32_t*)data);
-    data += MessageFieldSize::LONG;
-    mLifespan = Lifespan(*data);
-}
-
-void InsertMessage::Serialise(unsigned char* buf) const
-{
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mClientOrderId);
-    buf += MessageFieldSize::LONG;
-    *buf = static_cast<unsigned char>(mSide);
-    buf += MessageFieldSize::BYTE;
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mPrice);
-    buf += MessageFieldSize::LONG;
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mVolume);
-    buf += MessageFieldSize::LONG;
-    *buf = static_cast<unsigned char>(mLifespan);
-}
-
-void LoginMessage::Deserialise(unsigned char const* data, std::size_t)
-{
-    mName = readFixedLengthString(data, MessageFieldSize::STRING);
-    data += MessageFieldSize::STRING;
-    mSecret = readFixedLengthString(data, MessageFieldSize::STRING);
-}
-
-void LoginMessage::Serialise(unsigned char* buf) const
+template<class T>
+static void printLevelsMessage(std::ostream& out, const T& message)
 {
-    writeFixedLengthString(mName, buf, MessageFieldSize::STRING);
-    buf += MessageFieldSize::STRING;
-    writeFixedLengthString(mSecret, buf, MessageFieldSize::STRING);
+    out << " instrument=" << message.mInstrument << " sequence=" << message.mSequenceNumber;
+    printLevels(out, "askPrices", message.mAskPrices);
+    printLevels(out, "askVolumes", message.mAskVolumes);
+    printLevels(out, "bidPrices", message.mBidPrices);
+    printLevels(out, "bidVolumes", message.mBidVolumes);
 }
 
-void OrderBookMessage::Deserialise(unsigned char const* data, std::size_t)
+void printMessage(std::ostream& out, unsigned char messageType, unsigned char const* data, std::size_t size)
 {
-    mInstrument = Instrument(*data);
-    data += MessageFieldSize::BYTE;
-    mSequenceNumber = boost::endian::big_to_native(*(uint32_t*)data);
-    data += MessageFieldSize::LONG;
-
-    for (auto& p : mAskPrices)
-    {
-        p = boost::endian::big_to_native(*(uint32_t*)data);
-        data += MessageFieldSize::LONG;
-    }
-    for (auto& v : mAskVolumes)
-    {
-        v = boost::endian::big_to_native(*(uint32_t*)data);
-        data += MessageFieldSize::LONG;
-    }
-    for (auto& p : mBidPrices)
+    switch (messageType)
     {
-        p = boost::endian::big_to_native(*(uint32_t*)data);
-        data += MessageFieldSize::LONG;
-    }
-    for (auto& v : mBidVolumes)
-    {
-        v = boost::endian::big_to_native(*(uint32_t*)data);
-        data += MessageFieldSize::LONG;
-    }
-}
-
-void OrderBookMessage::Serialise(unsigned char* buf) const
-{
-    *buf = static_cast<unsigned char>(mInstrument);
-    buf += MessageFieldSize::BYTE;
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mSequenceNumber);
-    buf += MessageFieldSize::LONG;
-
-    for (auto p : mAskPrices)
-    {
-        *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)p);
-        buf += MessageFieldSize::LONG;
-    }
-    for (auto v : mAskVolumes)
-    {
-        *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)v);
-        buf += MessageFieldSize::LONG;
-    }
-    for (auto p : mBidPrices)
-    {
-        *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)p);
-        buf += MessageFieldSize::LONG;
-    }
-    for (auto v : mBidVolumes)
-    {
-        *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)v);
-        buf += MessageFieldSize::LONG;
-    }
-}
-
-void OrderFilledMessage::Deserialise(unsigned char const* data, std::size_t)
-{
-    mClientOrderId = boost::endian::big_to_native(*(uint32_t*)data);
-    data += MessageFieldSize::LONG;
-    mPrice = boost::endian::big_to_native(*(uint32_t*)data);
-    data += MessageFieldSize::LONG;
-    mVolume = boost::endian::big_to_native(*(uint32_t*)data);
-}
-
-void OrderFilledMessage::Serialise(unsigned char* buf) const
-{
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mClientOrderId);
-    buf += MessageFieldSize::LONG;
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mPrice);
-    buf += MessageFieldSize::LONG;
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mVolume);
-}
-
-void OrderStatusMessage::Deserialise(unsigned char const* data, std::size_t)
-{
-    mClientOrderId = boost::endian::big_to_native(*(uint32_t*)data);
-    data += MessageFieldSize::LONG;
-    mFillVolume = boost::endian::big_to_native(*(uint32_t*)data);
-    data += MessageFieldSize::LONG;
-    mRemainingVolume = boost::endian::big_to_native(*(uint32_t*)data);
-    data += MessageFieldSize::LONG;
-    mFees = boost::endian::big_to_native(*(int32_t*)data);
-}
-
-void OrderStatusMessage::Serialise(unsigned char* buf) const
-{
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mClientOrderId);
-    buf += MessageFieldSize::LONG;
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mFillVolume);
-    buf += MessageFieldSize::LONG;
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mRemainingVolume);
-    buf += MessageFieldSize::LONG;
-    *(int32_t*)buf = boost::endian::native_to_big((int32_t)mFees);
-}
-
-void TradeTicksMessage::Deserialise(unsigned char const* data, std::size_t)
-{
-    mInstrument = Instrument(*data);
-    data += MessageFieldSize::BYTE;
-    mSequenceNumber = boost::endian::big_to_native(*(uint32_t*)data);
-    data += MessageFieldSize::LONG;
-
-    for (auto& p : mAskPrices)
+    case MessageType::AMEND_ORDER:
     {
-        p = boost::endian::big_to_native(*(uint32_t*)data);
-        data += MessageFieldSize::LONG;
+        auto amend = makeMessage<AmendMessage>(data, size);
+        out << "AMEND_ORDER clientOrderId=" << amend.mClientOrderId << " newVolume=" << amend.mNewVolume;
+        break;
     }
-    for (auto& v : mAskVolumes)
+    case MessageType::CANCEL_ORDER:
+        out << "CANCEL_ORDER clientOrderId=" << makeMessage<CancelMessage>(data, size).mClientOrderId;
+        break;
+    case MessageType::ERROR_MESSAGE:
     {
-        v = boost::endian::big_to_native(*(uint32_t*)data);
-        data += MessageFieldSize::LONG;
+        auto error = makeMessage<ErrorMessage>(data, size);
+        out << "ERROR clientOrderId=" << error.mClientOrderId << " message=" << std::quoted(error.mMessage, '\'');
+        break;
     }
-    for (auto& p : mBidPrices)
+    case MessageType::HEDGE_FILLED:
     {
-        p = boost::endian::big_to_native(*(uint32_t*)data);
-        data += MessageFieldSize::LONG;
+        auto filled = makeMessage<HedgeFilledMessage>(data, size);
+        out << "HEDGE_FILLED clientOrderId=" << filled.mClientOrderId << " price=" << filled.mPrice
+            << " volume=" << filled.mVolume;
+        break;
     }
-    for (auto& v : mBidVolumes)
+    case MessageType::HEDGE_ORDER:
     {
-        v = boost::endian::big_to_native(*(uint32_t*)data);
-        data += MessageFieldSize::LONG;
+        auto hedge = makeMessage<HedgeMessage>(data, size);
+        out << "HEDGE_ORDER clientOrderId=" << hedge.mClientOrderId << " side=" << hedge.mSide
+            << " price=" << hedge.mPrice << " volume=" << hedge.mVolume;
+        break;
     }
-}
-
-void TradeTicksMessage::Serialise(unsigned char* buf) const
-{
-    *buf = static_cast<unsigned char>(mInstrument);
-    buf += MessageFieldSize::BYTE;
-    *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)mSequenceNumber);
-    buf += MessageFieldSize::LONG;
-
-    for (auto p : mAskPrices)
+    case MessageType::INSERT_ORDER:
     {
-        *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)p);
-        buf += MessageFieldSize::LONG;
+        auto insert = makeMessage<InsertMessage>(data, size);
+        out << "INSERT_ORDER clientOrderId=" << insert.mClientOrderId << " side=" << insert.mSide
+            << " price=" << insert.mPrice << " volume=" << insert.mVolume << " lifespan=" << insert.mLifespan;
+        break;
     }
-    for (auto v : mAskVolumes)
+    case MessageType::LOGIN:
+        out << "LOGIN name=" << std::quoted(makeMessage<LoginMessage>(data, size).mName, '\'');
+        break;
+    case MessageType::ORDER_BOOK_UPDATE:
+        out << "ORDER_BOOK_UPDATE";
+        printLevelsMessage(out, makeMessage<OrderBookMessage>(data, size));
+        break;
+    case MessageType::ORDER_FILLED:
     {
-        *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)v);
-        buf += MessageFieldSize::LONG;
+        auto filled = makeMessage<OrderFilledMessage>(data, size);
+        out << "ORDER_FILLED clientOrderId=" << filled.mClientOrderId << " price=" << filled.mPrice
+            << " volume=" << filled.mVolume;
+        break;
     }
-    for (auto p : mBidPrices)
+    case MessageType::ORDER_STATUS:
     {
-        *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)p);
-        buf += MessageFieldSize::LONG;
+        auto status = makeMessage<OrderStatusMessage>(data, size);
+        out << "ORDER_STATUS clientOrderId=" << status.mClientOrderId << " fillVolume=" << status.mFillVolume
+            << " remainingVolume=" << status.mRemainingVolume << " fees=" << status.mFees;
+        break;
     }
-    for (auto v : mBidVolumes)
-    {
-        *(uint32_t*)buf = boost::endian::native_to_big((uint32_t)v);
-        buf += MessageFieldSize::LONG;
+    case MessageType::TRADE_TICKS:
+        out << "TRADE_TICKS";
+        printLevelsMessage(out, makeMessage<TradeTicksMessage>(data, size));
+        break;
+    default:
+        out << "UNKNOWN type=" << static_cast<int>(messageType);
+        break;
     }
 }
 
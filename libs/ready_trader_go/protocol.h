@@ -20,11 +20,14 @@
 
 #include <array>
 #include <cstddef>
+#include <ostream>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "connectivitytypes.h"
+#include "messagelayout.h"
+#include "price.h"
 #include "types.h"
 
 namespace ReadyTraderGo {
@@ -44,109 +47,89 @@ enum MessageType : unsigned char
     TRADE_TICKS = 11
 };
 
-enum MessageFieldSize : std::size_t
-{
-    BYTE = 1,
-    LONG = 4,
-    STRING = 50
-};
-
-struct AmendMessage : ISerialisable
+struct AmendMessage : WireMessage<AmendMessage>
 {
     AmendMessage() = default;
-    AmendMessage(unsigned long clientOrderId, unsigned long newVolume)
+    AmendMessage(unsigned long clientOrderId, Volume newVolume)
         : mClientOrderId(clientOrderId), mNewVolume(newVolume) {}
 
-    std::size_t Size() const noexcept override { return MessageFieldSize::LONG * 2; }
-
-    void Deserialise(unsigned char const* data, std::size_t size) override;
-    void Serialise(unsigned char* buf) const override;
-
     unsigned long mClientOrderId = 0;
-    unsigned long mNewVolume = 0;
+    Volume mNewVolume;
+
+    using Layout = MessageLayout<Field<&AmendMessage::mClientOrderId>, Field<&AmendMessage::mNewVolume>>;
 };
 
-struct CancelMessage : ISerialisable
+struct CancelMessage : WireMessage<CancelMessage>
 {
     CancelMessage() = default;
     explicit CancelMessage(unsigned long clientOrderId) : mClientOrderId(clientOrderId) {}
 
-    std::size_t Size() const noexcept override { return MessageFieldSize::LONG; }
-
-    void Deserialise(unsigned char const* data, std::size_t size) override;
-    void Serialise(unsigned char* buf) const override;
-
     unsigned long mClientOrderId = 0;
+
+    using Layout = MessageLayout<Field<&CancelMessage::mClientOrderId>>;
 };
 
-struct ErrorMessage : ISerialisable
+struct ErrorMessage : WireMessage<ErrorMessage>
 {
     ErrorMessage() = default;
     ErrorMessage(unsigned long clientOrderId, std::string message)
         : mClientOrderId(clientOrderId), mMessage(std::move(message)) {}
 
-    std::size_t Size() const noexcept override
-    {
-        return MessageFieldSize::LONG + MessageFieldSize::STRING;
-    }
-
-    void Deserialise(unsigned char const* data, std::size_t size) override;
-    void Serialise(unsigned char* buf) const override;
-
     unsigned long mClientOrderId = 0;
     std::string mMessage;
+
+    using Layout = MessageLayout<Field<&ErrorMessage::mClientOrderId>, Field<&ErrorMessage::mMessage>>;
 };
 
-struct HedgeMessage : ISerialisable
+struct HedgeMessage : WireMessage<HedgeMessage>
 {
     HedgeMessage() = default;
     HedgeMessage(unsigned long clientOrderId,
                   Side side,
-                  unsigned long price,
-                  unsigned long volume)
+                  Price price,
+                  Volume volume)
         : mClientOrderId(clientOrderId),
           mSide(side),
           mPrice(price),
           mVolume(volume) {}
 
-    std::size_t Size() const noexcept override { return MessageFieldSize::LONG * 3 + MessageFieldSize::BYTE; }
-
-    void Deserialise(unsigned char const* data, std::size_t size) override;
-    void Serialise(unsigned char* buf) const override;
-
     unsigned long mClientOrderId = 0;
     Side mSide = Side::SELL;
-    unsigned long mPrice = 0;
-    unsigned long mVolume = 0;
+    Price mPrice;
+    Volume mVolume;
+
+    using Layout = MessageLayout<Field<&HedgeMessage::mClientOrderId>,
+                                 Field<&HedgeMessage::mSide>,
+                                 Field<&HedgeMessage::mPrice>,
+                                 Field<&HedgeMessage::mVolume>>;
 };
 
-struct HedgeFilledMessage : ISerialisable
+struct HedgeFilledMessage : WireMessage<HedgeFilledMessage>
 {
     HedgeFilledMessage() = default;
     HedgeFilledMessage(unsigned long clientOrderId,
-                       unsigned long price,
-                       unsigned long volume)
+                       Price price,
+                       Volume volume)
         : mClientOrderId(clientOrderId),
           mPrice(price),
           mVolume(volume) {}
 
-    std::size_t Size() const noexcept override { return MessageFieldSize::LONG * 3; }
-
-    void Deserialise(unsigned char const* data, std::size_t size) override;
-    void Serialise(unsigned char* buf) const override;
-
     unsigned long mClientOrderId = 0;
-    unsigned long mPrice = 0;
-    unsigned long mVolume = 0;
+    Price mPrice;
+    Volume mVolume;
+
+    using Layout = MessageLayout<Field<&HedgeFilledMessage::mClientOrderId>,
+                                 Field<&HedgeFilledMessage::mPrice>,
+                                 Field<&HedgeFilledMessage::mVolume>>;
 };
 
-struct InsertMessage : ISerialisable
+struct InsertMessage : WireMessage<InsertMessage>
 {
     InsertMessage() = default;
     InsertMessage(unsigned long clientOrderId,
                   Side side,
-                  unsigned long price,
-                  unsigned long volume,
+                  Price price,
+                  Volume volume,
                   Lifespan lifespan)
         : mClientOrderId(clientOrderId),
           mSide(side),
@@ -154,45 +137,40 @@ struct InsertMessage : ISerialisable
           mVolume(volume),
           mLifespan(lifespan) {}
 
-    std::size_t Size() const noexcept override { return MessageFieldSize::LONG * 3 + MessageFieldSize::BYTE * 2; }
-
-    void Deserialise(unsigned char const* data, std::size_t size) override;
-    void Serialise(unsigned char* buf) const override;
-
     unsigned long mClientOrderId = 0;
     Side mSide = Side::SELL;
-    unsigned long mPrice = 0;
-    unsigned long mVolume = 0;
+    Price mPrice;
+    Volume mVolume;
     Lifespan mLifespan = Lifespan::FILL_AND_KILL;
+
+    using Layout = MessageLayout<Field<&InsertMessage::mClientOrderId>,
+                                 Field<&InsertMessage::mSide>,
+                                 Field<&InsertMessage::mPrice>,
+                                 Field<&InsertMessage::mVolume>,
+                                 Field<&InsertMessage::mLifespan>>;
 };
 
-struct LoginMessage : ISerialisable
+struct LoginMessage : WireMessage<LoginMessage>
 {
     LoginMessage() = default;
     LoginMessage(std::string name, std::string secret)
         : mName(std::move(name)), mSecret(std::move(secret)) {}
 
-    std::size_t Size() const noexcept override
-    {
-        return MessageFieldSize::STRING * 2;
-    }
-
-    void Deserialise(unsigned char const* data, std::size_t size) override;
-    void Serialise(unsigned char* buf) const override;
-
     std::string mName;
     std::string mSecret;
+
+    using Layout = MessageLayout<Field<&LoginMessage::mName>, Field<&LoginMessage::mSecret>>;
 };
 
-struct OrderBookMessage : ISerialisable
+struct OrderBookMessage : WireMessage<OrderBookMessage>
 {
     OrderBookMessage() = default;
     OrderBookMessage(Instrument instrument,
                      unsigned long sequenceNumber,
-                     const std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
-                     const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
-                     const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
-                     const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes)
+                     const PriceLevels& askPrices,
+                     const VolumeLevels& askVolumes,
+                     const PriceLevels& bidPrices,
+                     const VolumeLevels& bidVolumes)
         : mInstrument(instrument),
           mSequenceNumber(sequenceNumber),
           mAskPrices(askPrices),
@@ -200,76 +178,72 @@ struct OrderBookMessage : ISerialisable
           mBidPrices(bidPrices),
           mBidVolumes(bidVolumes) {}
 
-    std::size_t Size() const noexcept override
-    {
-        return MessageFieldSize::BYTE
-            + MessageFieldSize::LONG
-            + MessageFieldSize::LONG * TOP_LEVEL_COUNT * 4;
-    }
-
-    void Deserialise(unsigned char const* data, std::size_t size) override;
-    void Serialise(unsigned char* buf) const override;
-
     Instrument mInstrument = Instrument::FUTURE;
     unsigned long mSequenceNumber = 0;
-    std::array<unsigned long, TOP_LEVEL_COUNT> mAskPrices = {};
-    std::array<unsigned long, TOP_LEVEL_COUNT> mAskVolumes = {};
-    std::array<unsigned long, TOP_LEVEL_COUNT> mBidPrices = {};
-    std::array<unsigned long, TOP_LEVEL_COUNT> mBidVolumes = {};
+    PriceLevels mAskPrices = {};
+    VolumeLevels mAskVolumes = {};
+    PriceLevels mBidPrices = {};
+    VolumeLevels mBidVolumes = {};
+
+    using Layout = MessageLayout<Field<&OrderBookMessage::mInstrument>,
+                                 Field<&OrderBookMessage::mSequenceNumber>,
+                                 Field<&OrderBookMessage::mAskPrices>,
+                                 Field<&OrderBookMessage::mAskVolumes>,
+                                 Field<&OrderBookMessage::mBidPrices>,
+                                 Field<&OrderBookMessage::mBidVolumes>>;
 };
 
-struct OrderFilledMessage : ISerialisable
+struct OrderFilledMessage : WireMessage<OrderFilledMessage>
 {
     OrderFilledMessage() = default;
     OrderFilledMessage(unsigned long clientOrderId,
-                       unsigned long price,
-                       unsigned long volume)
+                       Price price,
+                       Volume volume)
         : mClientOrderId(clientOrderId),
           mPrice(price),
           mVolume(volume) {}
 
-    std::size_t Size() const noexcept override { return MessageFieldSize::LONG * 3; }
-
-    void Deserialise(unsigned char const* data, std::size_t size) override;
-    void Serialise(unsigned char* buf) const override;
-
     unsigned long mClientOrderId = 0;
-    unsigned long mPrice = 0;
-    unsigned long mVolume = 0;
+    Price mPrice;
+    Volume mVolume;
+
+    using Layout = MessageLayout<Field<&OrderFilledMessage::mClientOrderId>,
+                                 Field<&OrderFilledMessage::mPrice>,
+                                 Field<&OrderFilledMessage::mVolume>>;
 };
 
-struct OrderStatusMessage : ISerialisable
+struct OrderStatusMessage : WireMessage<OrderStatusMessage>
 {
     OrderStatusMessage() = default;
     OrderStatusMessage(unsigned long clientOrderId,
-                       unsigned long fillVolume,
-                       unsigned long remainingVolume,
+                       Volume fillVolume,
+                       Volume remainingVolume,
                        signed long fees)
         : mClientOrderId(clientOrderId),
           mFillVolume(fillVolume),
           mRemainingVolume(remainingVolume),
           mFees(fees) {}
 
-    std::size_t Size() const noexcept override { return MessageFieldSize::LONG * 4; }
-
-    void Deserialise(unsigned char const* data, std::size_t size) override;
-    void Serialise(unsigned char* buf) const override;
-
     unsigned long mClientOrderId = 0;
-    unsigned long mFillVolume = 0;
-    unsigned long mRemainingVolume = 0;
+    Volume mFillVolume;
+    Volume mRemainingVolume;
     signed long mFees = 0;
+
+    using Layout = MessageLayout<Field<&OrderStatusMessage::mClientOrderId>,
+                                 Field<&OrderStatusMessage::mFillVolume>,
+                                 Field<&OrderStatusMessage::mRemainingVolume>,
+                                 Field<&OrderStatusMessage::mFees>>;
 };
 
-struct TradeTicksMessage : ISerialisable
+struct TradeTicksMessage : WireMessage<TradeTicksMessage>
 {
     TradeTicksMessage() = default;
     TradeTicksMessage(Instrument instrument,
                       unsigned long sequenceNumber,
-                      const std::array<unsigned long, TOP_LEVEL_COUNT> &askPrices,
-                      const std::array<unsigned long, TOP_LEVEL_COUNT> &askVolumes,
-                      const std::array<unsigned long, TOP_LEVEL_COUNT> &bidPrices,
-                      const std::array<unsigned long, TOP_LEVEL_COUNT> &bidVolumes)
+                      const PriceLevels& askPrices,
+                      const VolumeLevels& askVolumes,
+                      const PriceLevels& bidPrices,
+                      const VolumeLevels& bidVolumes)
             : mInstrument(instrument),
               mSequenceNumber(sequenceNumber),
               mAskPrices(askPrices),
@@ -277,24 +251,40 @@ struct TradeTicksMessage : ISerialisable
               mBidPrices(bidPrices),
               mBidVolumes(bidVolumes) {}
 
-    std::size_t Size() const noexcept override
-    {
-        return MessageFieldSize::BYTE
-               + MessageFieldSize::LONG
-               + MessageFieldSize::LONG * TOP_LEVEL_COUNT * 4;
-    }
-
-    void Deserialise(unsigned char const* data, std::size_t size) override;
-    void Serialise(unsigned char* buf) const override;
-
     Instrument mInstrument = Instrument::FUTURE;
     unsigned long mSequenceNumber = 0;
-    std::array<unsigned long, TOP_LEVEL_COUNT> mAskPrices = {};
-    std::array<unsigned long, TOP_LEVEL_COUNT> mAskVolumes = {};
-    std::array<unsigned long, TOP_LEVEL_COUNT> mBidPrices = {};
-    std::array<unsigned long, TOP_LEVEL_COUNT> mBidVolumes = {};
+    PriceLevels mAskPrices = {};
+    VolumeLevels mAskVolumes = {};
+    PriceLevels mBidPrices = {};
+    VolumeLevels mBidVolumes = {};
+
+    using Layout = MessageLayout<Field<&TradeTicksMessage::mInstrument>,
+                                 Field<&TradeTicksMessage::mSequenceNumber>,
+                                 Field<&TradeTicksMessage::mAskPrices>,
+                                 Field<&TradeTicksMessage::mAskVolumes>,
+                                 Field<&TradeTicksMessage::mBidPrices>,
+                                 Field<&TradeTicksMessage::mBidVolumes>>;
 };
 
+// The sizes of the messages the exchange sends and expects.
+static_assert(AmendMessage::Layout::SIZE == 8);
+static_assert(CancelMessage::Layout::SIZE == 4);
+static_assert(ErrorMessage::Layout::SIZE == 54);
+static_assert(HedgeMessage::Layout::SIZE == 13);
+static_assert(HedgeFilledMessage::Layout::SIZE == 12);
+static_assert(InsertMessage::Layout::SIZE == 14);
+static_assert(LoginMessage::Layout::SIZE == 100);
+static_assert(OrderBookMessage::Layout::SIZE == 85);
+static_assert(OrderFilledMessage::Layout::SIZE == 12);
+static_assert(OrderStatusMessage::Layout::SIZE == 16);
+static_assert(TradeTicksMessage::Layout::SIZE == 85);
+
+// Every execution message starts with the client order id, and both kinds
+// of information message with the instrument and sequence number.
+static_assert(OrderStatusMessage::Layout::OffsetOf<&OrderStatusMessage::mClientOrderId>() == 0);
+static_assert(OrderBookMessage::Layout::OffsetOf<&OrderBookMessage::mSequenceNumber>()
+              == TradeTicksMessage::Layout::OffsetOf<&TradeTicksMessage::mSequenceNumber>());
+
 template<class T>
 T makeMessage(unsigned char const* data, std::size_t size)
 {
@@ -303,6 +293,9 @@ T makeMessage(unsigned char const* data, std::size_t size)
     return message;
 }
 
+// Write a human readable description of a message (excluding its header).
+void printMessage(std::ostream& out, unsigned char messageType, unsigned char const* data, std::size_t size);
+
 }
 
 #endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_PROTOCOL_H
@@ -0,0 +1,255 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <cmath>
+
+#include "queueposition.h"
+
+namespace ReadyTraderGo {
+
+// True if a resting order at the first price would trade before one at the
+// second.
+static bool isBetter(Side side, Price price, Price other)
+{
+    return (side == Side::BUY) ? price > other : price < other;
+}
+
+QueuePositionEstimator::QueuePositionEstimator(double horizon, double smoothing, std::size_t capacity)
+    : mHorizon(horizon), mSmoothing(smoothing)
+{
+    mOrders.reserve(capacity);
+}
+
+QueuePosition* QueuePositionEstimator::FindOrder(unsigned long clientOrderId)
+{
+    auto it = std::find_if(mOrders.begin(), mOrders.end(),
+                           [clientOrderId](const QueuePosition& o) { return o.mClientOrderId == clientOrderId; });
+    return (it != mOrders.end()) ? &*it : nullptr;
+}
+
+const QueuePosition* QueuePositionEstimator::Find(unsigned long clientOrderId) const
+{
+    return const_cast<QueuePositionEstimator*>(this)->FindOrder(clientOrderId);
+}
+
+Volume QueuePositionEstimator::GetOwnVolume(Side side, Price price) const
+{
+    Volume volume;
+    for (const QueuePosition& o: mOrders)
+    {
+        if (o.mSide == side && o.mPrice == price)
+        {
+            volume += o.mRemainingVolume;
+        }
+    }
+    return volume;
+}
+
+void QueuePositionEstimator::Locate(QueuePosition& order, const BookSide& book, bool isNewOrder)
+{
+    Volume better;
+    bool found = false;
+    bool isInsideBook = false;
+    Volume visible;
+
+    std::size_t i = 0;
+    for (; i < TOP_LEVEL_COUNT && book.mPrices[i]; ++i)
+    {
+        Price price = book.mPrices[i];
+        Volume others = book.mVolumes[i] - GetOwnVolume(order.mSide, price);
+        if (isBetter(order.mSide, price, order.mPrice))
+        {
+            better += others;
+            continue;
+        }
+        found = (price == order.mPrice);
+        isInsideBook = true;
+        if (found)
+        {
+            visible = others;
+        }
+        break;
+    }
+    // Fewer levels than could be shown means the book ends before the price.
+    isInsideBook = isInsideBook || i < TOP_LEVEL_COUNT;
+
+    if (found)
+    {
+        if (isNewOrder)
+        {
+            order.mQueueAhead = static_cast<double>(visible.Lots());
+        }
+        else
+        {
+            // Traded volume has already been taken from the front of the
+            // queue; whatever else has gone was cancelled from anywhere in it.
+            Volume remaining = order.mVisibleVolume - order.mTradedSinceBook;
+            Volume cancelled = remaining - visible;
+            if (cancelled)
+            {
+                order.mQueueAhead -= order.mQueueAhead * static_cast<double>(cancelled.Lots())
+                                     / static_cast<double>(remaining.Lots());
+            }
+        }
+        order.mQueueAhead = std::min(order.mQueueAhead, static_cast<double>(visible.Lots()));
+        order.mVisibleVolume = visible;
+    }
+    else if (isInsideBook)
+    {
+        // The price is shown (or would be) but nobody else is there.
+        order.mQueueAhead = 0.0;
+        order.mVisibleVolume = Volume();
+    }
+    // Otherwise the order is deeper than the levels shown and its place in
+    // the queue cannot be seen; the volume shown is only a lower bound on
+    // the volume at better prices.
+
+    order.mVolumeAtBetterPrices = better;
+    order.mTradedSinceBook = Volume();
+}
+
+void QueuePositionEstimator::OnInsert(unsigned long clientOrderId, Side side, Price price,
+                                      Volume volume)
+{
+    QueuePosition order;
+    order.mClientOrderId = clientOrderId;
+    order.mSide = side;
+    order.mPrice = price;
+    mOrders.push_back(order);
+    // The last order book was published before the exchange saw this order,
+    // so none of the volume in it is the order's own.
+    Locate(mOrders.back(), GetBookSide(side), true);
+    mOrders.back().mRemainingVolume = volume;
+}
+
+void QueuePositionEstimator::OnAmend(unsigned long clientOrderId, Volume remainingVolume)
+{
+    if (QueuePosition* order = FindOrder(clientOrderId))
+    {
+        order->mRemainingVolume = std::min(order->mRemainingVolume, remainingVolume);
+    }
+}
+
+void QueuePositionEstimator::OnFill(unsigned long clientOrderId, Volume volume)
+{
+    QueuePosition* order = FindOrder(clientOrderId);
+    if (order == nullptr)
+    {
+        return;
+    }
+
+    // Nothing can be ahead of an order that is trading.
+    order->mQueueAhead = 0.0;
+    order->mVolumeAtBetterPrices = Volume();
+    order->mRemainingVolume -= volume;
+    if (!order->mRemainingVolume)
+    {
+        OnRemove(clientOrderId);
+    }
+}
+
+void QueuePositionEstimator::OnRemove(unsigned long clientOrderId)
+{
+    if (QueuePosition* order = FindOrder(clientOrderId))
+    {
+        *order = mOrders.back();
+        mOrders.pop_back();
+    }
+}
+
+void QueuePositionEstimator::OnOrderBook(const PriceLevels& askPrices,
+                                         const VolumeLevels& askVolumes,
+                                         const PriceLevels& bidPrices,
+                                         const VolumeLevels& bidVolumes)
+{
+    BookSide& asks = GetBookSide(Side::SELL);
+    BookSide& bids = GetBookSide(Side::BUY);
+    asks.mPrices = askPrices;
+    asks.mVolumes = askVolumes;
+    bids.mPrices = bidPrices;
+    bids.mVolumes = bidVolumes;
+
+    for (BookSide& book: mBookSides)
+    {
+        book.mTradeRate += mSmoothing * (static_cast<double>(book.mTradedSinceBook.Lots()) - book.mTradeRate);
+        book.mTradedSinceBook = Volume();
+    }
+
+    for (QueuePosition& order: mOrders)
+    {
+        Locate(order, GetBookSide(order.mSide), false);
+    }
+}
+
+void QueuePositionEstimator::OnTradeTicks(const PriceLevels& askPrices,
+                                          const VolumeLevels& askVolumes,
+                                          const PriceLevels& bidPrices,
+                                          const VolumeLevels& bidVolumes)
+{
+    // Ask ticks are buyers trading with resting sell orders and bid ticks
+    // sellers trading with resting buy orders.
+    for (std::size_t i = 0; i < TOP_LEVEL_COUNT; ++i)
+    {
+        GetBookSide(Side::SELL).mTradedSinceBook += askVolumes[i];
+        GetBookSide(Side::BUY).mTradedSinceBook += bidVolumes[i];
+    }
+
+    for (QueuePosition& order: mOrders)
+    {
+        const auto& prices = (order.mSide == Side::BUY) ? bidPrices : askPrices;
+        const auto& volumes = (order.mSide == Side::BUY) ? bidVolumes : askVolumes;
+        for (std::size_t i = 0; i < TOP_LEVEL_COUNT && prices[i]; ++i)
+        {
+            if (prices[i] == order.mPrice)
+            {
+                order.mQueueAhead = std::max(0.0, order.mQueueAhead - static_cast<double>(volumes[i].Lots()));
+                order.mTradedSinceBook += volumes[i];
+            }
+            else if (isBetter(order.mSide, prices[i], order.mPrice))
+            {
+                order.mVolumeAtBetterPrices -= volumes[i];
+            }
+            else
+            {
+                // Trading went through the order's price, so the whole queue
+                // at that price has gone.
+                order.mQueueAhead = 0.0;
+                order.mVolumeAtBetterPrices = Volume();
+            }
+        }
+    }
+}
+
+double QueuePositionEstimator::GetFillProbability(unsigned long clientOrderId) const
+{
+    const QueuePosition* order = Find(clientOrderId);
+    if (order == nullptr)
+    {
+        return 0.0;
+    }
+
+    double expected = GetBookSide(order->mSide).mTradeRate * mHorizon;
+    if (expected <= 0.0)
+    {
+        return 0.0;
+    }
+    double ahead = static_cast<double>(order->mVolumeAtBetterPrices.Lots()) + order->mQueueAhead;
+    return std::exp(-ahead / expected);
+}
+
+}
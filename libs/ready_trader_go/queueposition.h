@@ -0,0 +1,114 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_QUEUEPOSITION_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_QUEUEPOSITION_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "price.h"
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+struct QueuePosition
+{
+    unsigned long mClientOrderId = 0;
+    Side mSide = Side::BUY;
+    Price mPrice;
+    Volume mRemainingVolume;
+    // Other traders' volume that must trade before this order: at better
+    // prices, and ahead of it in the queue at its own price.
+    Volume mVolumeAtBetterPrices;
+    double mQueueAhead = 0.0;
+    // Other traders' volume at the order's price in the last order book, and
+    // how much has traded at that price since.
+    Volume mVisibleVolume;
+    Volume mTradedSinceBook;
+};
+
+// Infers where each of our resting orders in one instrument sits in its
+// price level's queue. Nothing about the queue is published, so:
+//  - an order joins behind all the volume shown at its price when inserted;
+//  - volume traded at its price (from trade ticks) comes off the front, so
+//    all of it is taken from the volume ahead;
+//  - any other fall in the volume shown at its price is cancellation, which
+//    is assumed to be spread evenly through the queue and so is taken from
+//    the volume ahead in proportion;
+//  - growth is new orders, which join behind.
+// Each order book or trade ticks message is an O(orders * levels) update.
+//
+// The fill probability is the chance that, over the given horizon, more
+// volume trades on the order's side than is ahead of it, taking the volume
+// traded per order book update (smoothed) as exponentially distributed.
+class QueuePositionEstimator
+{
+public:
+    // The horizon is in order book updates; the smoothing is the weight of
+    // the latest update in the average traded volume.
+    explicit QueuePositionEstimator(double horizon = 4.0, double smoothing = 0.1, std::size_t capacity = 16);
+
+    // Call when an order is sent, before the exchange has seen it.
+    void OnInsert(unsigned long clientOrderId, Side side, Price price, Volume volume);
+    // An amendment that reduces an order's volume keeps its place.
+    void OnAmend(unsigned long clientOrderId, Volume remainingVolume);
+    void OnFill(unsigned long clientOrderId, Volume volume);
+    void OnRemove(unsigned long clientOrderId);
+
+    void OnOrderBook(const PriceLevels& askPrices,
+                     const VolumeLevels& askVolumes,
+                     const PriceLevels& bidPrices,
+                     const VolumeLevels& bidVolumes);
+    void OnTradeTicks(const PriceLevels& askPrices,
+                      const VolumeLevels& askVolumes,
+                      const PriceLevels& bidPrices,
+                      const VolumeLevels& bidVolumes);
+
+    // Returns nullptr for an order that is not being tracked.
+    const QueuePosition* Find(unsigned long clientOrderId) const;
+    // Zero for an order that is not being tracked.
+    double GetFillProbability(unsigned long clientOrderId) const;
+
+private:
+    struct BookSide
+    {
+        PriceLevels mPrices{};
+        VolumeLevels mVolumes{};
+        // Smoothed volume traded on this side per order book update.
+        double mTradeRate = 0.0;
+        Volume mTradedSinceBook;
+    };
+
+    QueuePosition* FindOrder(unsigned long clientOrderId);
+    BookSide& GetBookSide(Side side) { return mBookSides[static_cast<std::size_t>(side)]; }
+    const BookSide& GetBookSide(Side side) const { return mBookSides[static_cast<std::size_t>(side)]; }
+    // Our own volume resting at the price.
+    Volume GetOwnVolume(Side side, Price price) const;
+    void Locate(QueuePosition& order, const BookSide& book, bool isNewOrder);
+
+    const double mHorizon;
+    const double mSmoothing;
+    // Indexed by Side, so the sell (ask) side comes first.
+    std::array<BookSide, 2> mBookSides;
+    std::vector<QueuePosition> mOrders;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_QUEUEPOSITION_H
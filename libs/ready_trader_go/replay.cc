@@ -0,0 +1,191 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <boost/endian/conversion.hpp>
+
+#include "connectivity.h"
+#include "logging.h"
+#include "protocol.h"
+#include "replay.h"
+
+RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_RPL, "REPLAY")
+
+namespace ReadyTraderGo {
+
+void ReplayConnection::SendMessage(unsigned char messageType, const ISerialisable& serialisable, SendMode)
+{
+    const std::size_t size = MESSAGE_HEADER_SIZE + serialisable.Size();
+    const std::size_t offset = mSent.size();
+    mSent.resize(offset + size);
+    auto* data = mSent.data() + offset;
+    *(uint16_t*)data = boost::endian::native_to_big((uint16_t)size);
+    data[MESSAGE_TYPE_OFFSET] = messageType;
+    serialisable.Serialise(data + MESSAGE_HEADER_SIZE);
+    mSentOffsets.push_back(offset);
+}
+
+std::size_t ReplayConnection::GetSentSize(std::size_t index) const
+{
+    const std::size_t end = (index + 1 < mSentOffsets.size()) ? mSentOffsets[index + 1] : mSent.size();
+    return end - mSentOffsets[index];
+}
+
+JournalReplayer::JournalReplayer(BaseAutoTrader& autoTrader,
+                                 std::string journalName,
+                                 ReplayPacing pacing,
+                                 std::size_t mismatchLimit)
+    : mAutoTrader(autoTrader),
+      mJournalName(std::move(journalName)),
+      mPacing(pacing),
+      mMismatchLimit(mismatchLimit)
+{
+    mAutoTrader.SetClock(mClock);
+
+    auto connection = std::make_unique<ReplayConnection>();
+    mConnection = connection.get();
+    mAutoTrader.SetExecutionConnection(std::move(connection));
+
+    // Credentials differ between sessions, so logins are not compared.
+    mFirstCaptured = mNextCaptured = mConnection->GetSentCount();
+
+    mSubscription = std::make_shared<ReplaySubscription>();
+    mAutoTrader.SetInformationSubscription(std::shared_ptr<ISubscription>(mSubscription));
+}
+
+void JournalReplayer::Compare(ReplayResult& result, const JournalRecord& record)
+{
+    const std::size_t index = result.mExpectedCount++;
+    ReplayMismatch mismatch{index, record.mRealtime, {record.mData, record.mData + record.mSize}, {}};
+
+    if (mNextCaptured < mConnection->GetSentCount())
+    {
+        auto* actual = mConnection->GetSentMessage(mNextCaptured);
+        auto actualSize = mConnection->GetSentSize(mNextCaptured);
+        ++mNextCaptured;
+        if (actualSize == record.mSize && std::memcmp(actual, record.mData, actualSize) == 0)
+        {
+            return;
+        }
+        mismatch.mActual.assign(actual, actual + actualSize);
+    }
+
+    ++result.mMismatchCount;
+    if (result.mMismatches.size() < mMismatchLimit)
+    {
+        result.mMismatches.push_back(std::move(mismatch));
+    }
+}
+
+ReplayResult JournalReplayer::Run()
+{
+    JournalReader reader{mJournalName};
+    JournalRecord record{};
+    ReplayResult result;
+
+    std::uint64_t firstTime = 0;
+    const auto wallStart = std::chrono::steady_clock::now();
+
+    RLOG(LG_RPL, LogLevel::LL_INFO) << "replaying journal '" << mJournalName << "'";
+
+    while (reader.Next(record))
+    {
+        if (result.mRecordCount++ == 0)
+        {
+            firstTime = record.mRealtime;
+        }
+        mCurrentTime = record.mRealtime;
+        mClock.OnEvent(record.mRealtime);
+
+        if (mPacing == ReplayPacing::ORIGINAL)
+        {
+            std::this_thread::sleep_until(wallStart + std::chrono::nanoseconds(record.mRealtime - firstTime));
+        }
+
+        std::size_t length = 0;
+        if (record.mSize >= MESSAGE_HEADER_SIZE)
+        {
+            length = boost::endian::big_to_native(*(uint16_t const*)record.mData);
+        }
+        if (length < MESSAGE_HEADER_SIZE || length != record.mSize)
+        {
+            // The live subscription drops malformed frames, so the replay does too.
+            ++result.mMalformedCount;
+            continue;
+        }
+
+        const unsigned char messageType = record.mData[MESSAGE_TYPE_OFFSET];
+        unsigned char const* body = record.mData + MESSAGE_HEADER_SIZE;
+        const std::size_t bodySize = record.mSize - MESSAGE_HEADER_SIZE;
+
+        switch (record.mDirection)
+        {
+        case JournalDirection::INFO_IN:
+        {
+            auto start = std::chrono::steady_clock::now();
+            mSubscription->Deliver(messageType, body, bodySize);
+            result.mHandlerNanoseconds += (std::chrono::steady_clock::now() - start).count();
+            ++result.mInformationCount;
+            break;
+        }
+        case JournalDirection::EXEC_IN:
+        {
+            auto start = std::chrono::steady_clock::now();
+            mConnection->Deliver(messageType, body, bodySize);
+            result.mHandlerNanoseconds += (std::chrono::steady_clock::now() - start).count();
+            ++result.mExecutionCount;
+            break;
+        }
+        case JournalDirection::EXEC_OUT:
+            if (messageType != MessageType::LOGIN)
+            {
+                Compare(result, record);
+            }
+            break;
+        }
+    }
+
+    // Anything sent beyond the end of the recording is unexpected.
+    while (mNextCaptured < mConnection->GetSentCount())
+    {
+        auto* actual = mConnection->GetSentMessage(mNextCaptured);
+        ReplayMismatch mismatch{mNextCaptured - mFirstCaptured, mCurrentTime, {},
+                                {actual, actual + mConnection->GetSentSize(mNextCaptured)}};
+        ++mNextCaptured;
+        ++result.mMismatchCount;
+        if (result.mMismatches.size() < mMismatchLimit)
+        {
+            result.mMismatches.push_back(std::move(mismatch));
+        }
+    }
+
+    result.mCapturedCount = mConnection->GetSentCount() - mFirstCaptured;
+    result.mSessionNanoseconds = mCurrentTime - firstTime;
+
+    RLOG(LG_RPL, LogLevel::LL_INFO) << "replayed " << result.mRecordCount << " records with "
+                                    << result.mMismatchCount << " mismatches";
+
+    return result;
+}
+
+}
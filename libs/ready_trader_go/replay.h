@@ -0,0 +1,144 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_REPLAY_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_REPLAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "baseautotrader.h"
+#include "clock.h"
+#include "connectivitytypes.h"
+#include "journal.h"
+
+namespace ReadyTraderGo {
+
+// An in-memory execution connection. Messages sent by the auto-trader are
+// captured (complete with message header) rather than sent anywhere.
+class ReplayConnection : public IConnection
+{
+public:
+    ReplayConnection() { SetName("Replay"); }
+
+    void AsyncRead() override {}
+    void SendMessage(unsigned char messageType, const ISerialisable& serialisable, SendMode mode) override;
+
+    // Deliver a message (excluding its header) to the auto-trader.
+    void Deliver(unsigned char messageType, unsigned char const* data, std::size_t size)
+    {
+        OnMessageReceipt(messageType, data, size);
+    }
+
+    std::size_t GetSentCount() const { return mSentOffsets.size(); }
+    unsigned char const* GetSentMessage(std::size_t index) const { return mSent.data() + mSentOffsets[index]; }
+    std::size_t GetSentSize(std::size_t index) const;
+
+private:
+    std::vector<unsigned char> mSent;
+    std::vector<std::size_t> mSentOffsets;
+};
+
+// An in-memory information subscription.
+class ReplaySubscription : public ISubscription
+{
+public:
+    ReplaySubscription() { SetName("Replay"); }
+
+    void AsyncReceive() override {}
+
+    // Deliver a message (excluding its header) to the auto-trader.
+    void Deliver(unsigned char messageType, unsigned char const* data, std::size_t size)
+    {
+        OnMessageReceipt(messageType, data, size);
+    }
+};
+
+enum class ReplayPacing
+{
+    // Deliver messages with the same spacing as the original session.
+    ORIGINAL,
+    // Deliver messages as fast as the auto-trader can handle them.
+    MAXIMUM
+};
+
+struct ReplayMismatch
+{
+    // Index of the recorded outbound message (or, for unexpected messages,
+    // of the captured one).
+    std::size_t mIndex;
+    std::uint64_t mRealtime;
+    std::vector<unsigned char> mExpected;
+    std::vector<unsigned char> mActual;
+};
+
+struct ReplayResult
+{
+    std::uint64_t mRecordCount = 0;
+    std::uint64_t mInformationCount = 0;
+    std::uint64_t mExecutionCount = 0;
+    std::uint64_t mMalformedCount = 0;
+    std::uint64_t mExpectedCount = 0;
+    std::uint64_t mCapturedCount = 0;
+    std::uint64_t mMismatchCount = 0;
+    std::uint64_t mHandlerNanoseconds = 0;
+    std::uint64_t mSessionNanoseconds = 0;
+    std::vector<ReplayMismatch> mMismatches;
+};
+
+// Feeds a recorded journal back through an auto-trader's message handlers
+// and compares the messages it sends with those in the recording. The
+// auto-trader's clock is replaced by one that follows the recorded time
+// stamps.
+//
+// The replayer installs its own connection and subscription in the
+// auto-trader, so it must be constructed before any other connection is set.
+class JournalReplayer
+{
+public:
+    JournalReplayer(BaseAutoTrader& autoTrader,
+                    std::string journalName,
+                    ReplayPacing pacing = ReplayPacing::MAXIMUM,
+                    std::size_t mismatchLimit = 16);
+
+    // Returns the time of the record currently being replayed, in
+    // nanoseconds since the epoch.
+    std::uint64_t GetCurrentTime() const { return mCurrentTime; }
+
+    ReplayResult Run();
+
+private:
+    void Compare(ReplayResult& result, const JournalRecord& record);
+
+    BaseAutoTrader& mAutoTrader;
+    std::string mJournalName;
+    ReplayPacing mPacing;
+    std::size_t mMismatchLimit;
+    ReplayClock mClock;
+    ReplayConnection* mConnection = nullptr;
+    std::shared_ptr<ReplaySubscription> mSubscription;
+    std::size_t mFirstCaptured = 0;
+    std::size_t mNextCaptured = 0;
+    std::uint64_t mCurrentTime = 0;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_REPLAY_H
@@ -0,0 +1,366 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <string>
+
+#include "error.h"
+#include "scheduler.h"
+
+namespace ReadyTraderGo {
+
+constexpr std::uint64_t SLOT_MASK = SCHEDULER_SLOT_COUNT - 1;
+
+// Index of the lowest set bit (which must exist).
+static inline std::size_t lowestSetBit(std::uint64_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<std::size_t>(__builtin_ctzll(word));
+#else
+    std::size_t result = 0;
+    while ((word & 1) == 0)
+    {
+        word >>= 1;
+        ++result;
+    }
+    return result;
+#endif
+}
+
+TimerScheduler::TimerScheduler(const IClock& clock, std::size_t capacity, std::uint64_t resolution)
+    : mClock(&clock), mResolution(resolution), mCurrentTick(0)
+{
+    if (resolution == 0 || capacity == 0)
+    {
+        throw ReadyTraderGoError("timer scheduler resolution and capacity must be positive");
+    }
+    if (capacity >= NO_INDEX - SENTINEL_COUNT)
+    {
+        throw ReadyTraderGoError("timer scheduler capacity is too large");
+    }
+
+    mTimers.resize(SENTINEL_COUNT + capacity);
+    for (std::uint32_t i = 0; i < SENTINEL_COUNT; ++i)
+    {
+        mTimers[i].mPrev = mTimers[i].mNext = i;
+        mTimers[i].mList = i;
+    }
+    for (std::uint32_t i = SENTINEL_COUNT; i < mTimers.size(); ++i)
+    {
+        mTimers[i].mNext = (i + 1 < mTimers.size()) ? i + 1 : NO_INDEX;
+    }
+    mFreeHead = SENTINEL_COUNT;
+    mCurrentTick = clock.Now() / resolution;
+}
+
+void TimerScheduler::SetClock(const IClock& clock)
+{
+    if (mPendingCount != 0)
+    {
+        throw ReadyTraderGoError("cannot change the clock of a timer scheduler with pending timers");
+    }
+    mClock = &clock;
+    mCurrentTick = clock.Now() / mResolution;
+}
+
+std::uint32_t TimerScheduler::Allocate()
+{
+    if (mFreeHead == NO_INDEX)
+    {
+        throw ReadyTraderGoError("timer scheduler is full (capacity " + std::to_string(GetCapacity()) + ")");
+    }
+    const std::uint32_t index = mFreeHead;
+    mFreeHead = mTimers[index].mNext;
+    ++mPendingCount;
+    return index;
+}
+
+void TimerScheduler::Free(std::uint32_t index)
+{
+    Timer& timer = mTimers[index];
+    ++timer.mGeneration;
+    timer.mList = NO_INDEX;
+    timer.mNext = mFreeHead;
+    mFreeHead = index;
+    --mPendingCount;
+}
+
+void TimerScheduler::Link(std::uint32_t index, std::uint32_t list)
+{
+    Timer& timer = mTimers[index];
+    Timer& head = mTimers[list];
+    timer.mList = list;
+    timer.mNext = list;
+    timer.mPrev = head.mPrev;
+    mTimers[head.mPrev].mNext = index;
+    head.mPrev = index;
+
+    if (list < WHEEL_SLOT_COUNT)
+    {
+        auto& word = mOccupied[list / SCHEDULER_SLOT_COUNT][(list % SCHEDULER_SLOT_COUNT) / 64];
+        word |= std::uint64_t(1) << (list % 64);
+    }
+}
+
+void TimerScheduler::Unlink(std::uint32_t index)
+{
+    Timer& timer = mTimers[index];
+    mTimers[timer.mPrev].mNext = timer.mNext;
+    mTimers[timer.mNext].mPrev = timer.mPrev;
+
+    const std::uint32_t list = timer.mList;
+    if (list < WHEEL_SLOT_COUNT && mTimers[list].mNext == list)
+    {
+        auto& word = mOccupied[list / SCHEDULER_SLOT_COUNT][(list % SCHEDULER_SLOT_COUNT) / 64];
+        word &= ~(std::uint64_t(1) << (list % 64));
+    }
+}
+
+void TimerScheduler::Place(std::uint32_t index)
+{
+    // A deadline in the past goes in the current slot, to fire at the next poll.
+    const std::uint64_t tick = std::max(mTimers[index].mDeadline / mResolution, mCurrentTick);
+    const std::uint64_t delta = tick - mCurrentTick;
+
+    std::size_t level = 0;
+    while (level + 1 < SCHEDULER_LEVEL_COUNT && delta >= (std::uint64_t(1) << (SCHEDULER_SLOT_BITS * (level + 1))))
+    {
+        ++level;
+    }
+
+    // Anything beyond the top level waits in its furthest slot and is placed
+    // again when that slot cascades.
+    const std::uint64_t horizon = std::uint64_t(1) << (SCHEDULER_SLOT_BITS * SCHEDULER_LEVEL_COUNT);
+    const std::uint64_t placedTick = (delta < horizon) ? tick : mCurrentTick + horizon - 1;
+
+    const std::size_t slot = (placedTick >> (SCHEDULER_SLOT_BITS * level)) & SLOT_MASK;
+    Link(index, static_cast<std::uint32_t>(level * SCHEDULER_SLOT_COUNT + slot));
+}
+
+TimerId TimerScheduler::ScheduleAt(std::uint64_t deadline, TimerCallback callback)
+{
+    const std::uint32_t index = Allocate();
+    Timer& timer = mTimers[index];
+    timer.mDeadline = deadline;
+    timer.mInterval = 0;
+    timer.mCallback = callback;
+    Place(index);
+    return MakeId(index);
+}
+
+TimerId TimerScheduler::ScheduleEvery(std::uint64_t interval, TimerCallback callback)
+{
+    if (interval == 0)
+    {
+        throw ReadyTraderGoError("timer interval must be positive");
+    }
+
+    const std::uint32_t index = Allocate();
+    Timer& timer = mTimers[index];
+    timer.mDeadline = mClock->Now() + interval;
+    timer.mInterval = interval;
+    timer.mCallback = callback;
+    Place(index);
+    return MakeId(index);
+}
+
+bool TimerScheduler::Cancel(TimerId id)
+{
+    const auto index = static_cast<std::uint32_t>(id);
+    if (index < SENTINEL_COUNT || index >= mTimers.size())
+    {
+        return false;
+    }
+
+    Timer& timer = mTimers[index];
+    if (timer.mGeneration != static_cast<std::uint32_t>(id >> 32) || timer.mList == NO_INDEX)
+    {
+        return false;
+    }
+
+    Unlink(index);
+    Free(index);
+    return true;
+}
+
+std::uint32_t TimerScheduler::FindSlot(std::size_t level, std::size_t start) const
+{
+    // Search every slot once, starting from (and wrapping around to) start.
+    const SlotBitmap& bitmap = mOccupied[level];
+    std::size_t position = start & SLOT_MASK;
+    std::size_t remaining = SCHEDULER_SLOT_COUNT;
+    while (remaining != 0)
+    {
+        const std::size_t offset = position % 64;
+        const std::size_t count = std::min<std::size_t>(64 - offset, remaining);
+        std::uint64_t word = bitmap[position / 64] >> offset;
+        if (count < 64)
+        {
+            word &= (std::uint64_t(1) << count) - 1;
+        }
+        if (word != 0)
+        {
+            return static_cast<std::uint32_t>((position + lowestSetBit(word)) & SLOT_MASK);
+        }
+        position = (position + count) & SLOT_MASK;
+        remaining -= count;
+    }
+    return NO_INDEX;
+}
+
+std::uint64_t TimerScheduler::GetNextDeadline() const
+{
+    std::uint64_t result = NO_TIMER_DEADLINE;
+    for (std::size_t level = 0; level < SCHEDULER_LEVEL_COUNT; ++level)
+    {
+        // The first level's current slot holds the current tick. On every
+        // other level the current slot holds the furthest timers, so the
+        // search starts just after it. Timers beyond the top level's reach
+        // are out of order there, so every one of its slots is searched.
+        const std::size_t current = (mCurrentTick >> (SCHEDULER_SLOT_BITS * level)) & SLOT_MASK;
+        const bool top = level + 1 == SCHEDULER_LEVEL_COUNT;
+        const std::size_t first = (level == 0) ? current : current + 1;
+        std::size_t offset = 0;
+        while (offset < SCHEDULER_SLOT_COUNT)
+        {
+            const std::uint32_t slot = FindSlot(level, first + offset);
+            const std::size_t distance = (slot - first) & SLOT_MASK;
+            if (slot == NO_INDEX || distance < offset)
+            {
+                break;
+            }
+
+            const auto list = static_cast<std::uint32_t>(level * SCHEDULER_SLOT_COUNT + slot);
+            for (std::uint32_t i = mTimers[list].mNext; i != list; i = mTimers[i].mNext)
+            {
+                result = std::min(result, mTimers[i].mDeadline);
+            }
+            if (!top)
+            {
+                break;
+            }
+            offset = distance + 1;
+        }
+    }
+    return result;
+}
+
+void TimerScheduler::Cascade(std::size_t level)
+{
+    const std::size_t slot = (mCurrentTick >> (SCHEDULER_SLOT_BITS * level)) & SLOT_MASK;
+    const auto list = static_cast<std::uint32_t>(level * SCHEDULER_SLOT_COUNT + slot);
+    while (mTimers[list].mNext != list)
+    {
+        const std::uint32_t index = mTimers[list].mNext;
+        Unlink(index);
+        Place(index);
+    }
+}
+
+std::size_t TimerScheduler::Expire(std::uint32_t list, std::uint64_t now)
+{
+    for (std::uint32_t i = mTimers[list].mNext; i != list;)
+    {
+        const std::uint32_t next = mTimers[i].mNext;
+        if (mTimers[i].mDeadline <= now)
+        {
+            Unlink(i);
+            Link(i, FIRING_LIST);
+        }
+        i = next;
+    }
+
+    // Callbacks may schedule or cancel timers (including ones waiting here
+    // to fire), so each timer leaves the firing list before it is run.
+    std::size_t fired = 0;
+    while (mTimers[FIRING_LIST].mNext != FIRING_LIST)
+    {
+        const std::uint32_t index = mTimers[FIRING_LIST].mNext;
+        Timer& timer = mTimers[index];
+        TimerCallback callback = timer.mCallback;
+        Unlink(index);
+        if (timer.mInterval != 0)
+        {
+            timer.mDeadline += timer.mInterval;
+            if (timer.mDeadline <= now)
+            {
+                timer.mDeadline = now + timer.mInterval;
+            }
+            Place(index);
+        }
+        else
+        {
+            Free(index);
+        }
+        callback();
+        ++fired;
+    }
+    return fired;
+}
+
+std::size_t TimerScheduler::Poll()
+{
+    const std::uint64_t now = mClock->Now();
+    const std::uint64_t nowTick = now / mResolution;
+    std::size_t fired = 0;
+
+    while (mCurrentTick < nowTick)
+    {
+        if (mPendingCount == 0)
+        {
+            mCurrentTick = nowTick;
+            return fired;
+        }
+
+        // Every timer in the current slot is due, but callbacks may add more.
+        std::size_t count;
+        while ((count = Expire(static_cast<std::uint32_t>(mCurrentTick & SLOT_MASK), now)) != 0)
+        {
+            fired += count;
+        }
+
+        // Jump over stretches of the wheel with nothing in them, stopping at
+        // the boundary of the lowest occupied level so that it can cascade.
+        std::size_t level = 0;
+        while (level + 1 < SCHEDULER_LEVEL_COUNT
+               && std::all_of(mOccupied[level].begin(), mOccupied[level].end(), [](auto w) { return w == 0; }))
+        {
+            ++level;
+        }
+        const std::size_t shift = SCHEDULER_SLOT_BITS * level;
+        const std::uint64_t next = (level == 0) ? mCurrentTick + 1 : ((mCurrentTick >> shift) + 1) << shift;
+        mCurrentTick = std::min(next, nowTick);
+
+        for (std::size_t l = 1; l < SCHEDULER_LEVEL_COUNT; ++l)
+        {
+            if ((mCurrentTick & ((std::uint64_t(1) << (SCHEDULER_SLOT_BITS * l)) - 1)) != 0)
+            {
+                break;
+            }
+            Cascade(l);
+        }
+    }
+
+    std::size_t count;
+    while ((count = Expire(static_cast<std::uint32_t>(mCurrentTick & SLOT_MASK), now)) != 0)
+    {
+        fired += count;
+    }
+    return fired;
+}
+
+}
@@ -0,0 +1,175 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_SCHEDULER_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_SCHEDULER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "clock.h"
+
+namespace ReadyTraderGo {
+
+// Identifies a scheduled timer. Handles are never reused: once a timer has
+// fired or been cancelled, its handle no longer refers to anything.
+using TimerId = std::uint64_t;
+
+constexpr TimerId NO_TIMER = 0;
+constexpr std::uint64_t NO_TIMER_DEADLINE = std::numeric_limits<std::uint64_t>::max();
+
+constexpr std::uint64_t SCHEDULER_DEFAULT_RESOLUTION = 1000000; // one millisecond in nanoseconds
+constexpr std::size_t SCHEDULER_DEFAULT_CAPACITY = 1024;
+constexpr std::size_t SCHEDULER_LEVEL_COUNT = 4;
+constexpr std::size_t SCHEDULER_SLOT_BITS = 8;
+constexpr std::size_t SCHEDULER_SLOT_COUNT = std::size_t(1) << SCHEDULER_SLOT_BITS;
+
+// A callback stored inside the timer itself, so that scheduling never
+// allocates. Captures must be trivially copyable (pointers, references and
+// numbers) and fit in CAPACITY bytes, which is checked at compile time.
+class TimerCallback
+{
+public:
+    static constexpr std::size_t CAPACITY = 32;
+
+    TimerCallback() = default;
+
+    template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, TimerCallback>>>
+    TimerCallback(F&& function)
+    {
+        using Function = std::decay_t<F>;
+        static_assert(sizeof(Function) <= CAPACITY, "timer callback captures too much");
+        static_assert(alignof(Function) <= alignof(std::max_align_t), "timer callback is over-aligned");
+        static_assert(std::is_trivially_copyable_v<Function>, "timer callback must be trivially copyable");
+        ::new (static_cast<void*>(mStorage)) Function(std::forward<F>(function));
+        mInvoke = [](void* storage) { (*std::launder(static_cast<Function*>(storage)))(); };
+    }
+
+    explicit operator bool() const { return mInvoke != nullptr; }
+    void operator()() { mInvoke(mStorage); }
+
+private:
+    alignas(std::max_align_t) unsigned char mStorage[CAPACITY];
+    void (*mInvoke)(void*) = nullptr;
+};
+
+// A hierarchical timer wheel that runs callbacks once its clock reaches
+// their deadlines. Scheduling and cancelling are O(1) and, because timers
+// come from a pool sized at construction, never allocate.
+//
+// The scheduler never looks at the operating system's clock, so the same
+// timers work in production, in simulation and in replay: whoever drives
+// the clock calls Poll() to fire whatever has come due. Deadlines are in
+// nanoseconds since the epoch (i.e. in the clock's units). Timers due at the
+// same poll fire in order of their wheel tick.
+//
+// There are four levels of 256 slots. The first level covers 256 ticks of
+// the resolution; each level above covers 256 times the one below, and its
+// timers are cascaded down as the wheel turns.
+class TimerScheduler
+{
+public:
+    explicit TimerScheduler(const IClock& clock,
+                            std::size_t capacity = SCHEDULER_DEFAULT_CAPACITY,
+                            std::uint64_t resolution = SCHEDULER_DEFAULT_RESOLUTION);
+
+    TimerScheduler(const TimerScheduler&) = delete;
+    void operator=(const TimerScheduler&) = delete;
+
+    const IClock& GetClock() const { return *mClock; }
+    std::size_t GetCapacity() const { return mTimers.size() - SENTINEL_COUNT; }
+    std::size_t GetPendingCount() const { return mPendingCount; }
+    std::uint64_t GetResolution() const { return mResolution; }
+
+    // Replace the clock. Only allowed while no timers are pending.
+    void SetClock(const IClock& clock);
+
+    // Schedule a one-off timer. Throws if the scheduler is full.
+    TimerId ScheduleAt(std::uint64_t deadline, TimerCallback callback);
+    TimerId ScheduleAfter(std::uint64_t delay, TimerCallback callback)
+    {
+        return ScheduleAt(mClock->Now() + delay, callback);
+    }
+
+    // Schedule a timer that fires every interval, starting one interval from
+    // now, until cancelled. Intervals missed by a late poll are skipped.
+    TimerId ScheduleEvery(std::uint64_t interval, TimerCallback callback);
+
+    // Returns false if the timer has already fired or been cancelled.
+    bool Cancel(TimerId id);
+
+    // Return the earliest pending deadline, or NO_TIMER_DEADLINE.
+    std::uint64_t GetNextDeadline() const;
+
+    // Fire every timer whose deadline is at or before the clock's current
+    // time and return the number fired.
+    std::size_t Poll();
+
+private:
+    static constexpr std::uint32_t WHEEL_SLOT_COUNT = SCHEDULER_LEVEL_COUNT * SCHEDULER_SLOT_COUNT;
+    static constexpr std::uint32_t FIRING_LIST = WHEEL_SLOT_COUNT;
+    static constexpr std::uint32_t SENTINEL_COUNT = WHEEL_SLOT_COUNT + 1;
+    static constexpr std::uint32_t NO_INDEX = std::numeric_limits<std::uint32_t>::max();
+
+    // Timers live in doubly-linked lists threaded through the pool by index.
+    // The first SENTINEL_COUNT entries are the list heads: one per wheel slot
+    // and one for timers that are about to fire.
+    struct Timer
+    {
+        std::uint64_t mDeadline = 0;
+        std::uint64_t mInterval = 0;
+        std::uint32_t mPrev = NO_INDEX;
+        std::uint32_t mNext = NO_INDEX;
+        std::uint32_t mGeneration = 1;
+        std::uint32_t mList = NO_INDEX;
+        TimerCallback mCallback;
+    };
+
+    using SlotBitmap = std::array<std::uint64_t, SCHEDULER_SLOT_COUNT / 64>;
+
+    std::uint32_t Allocate();
+    std::size_t Expire(std::uint32_t list, std::uint64_t now);
+    void Cascade(std::size_t level);
+    std::uint32_t FindSlot(std::size_t level, std::size_t start) const;
+    void Free(std::uint32_t index);
+    void Link(std::uint32_t index, std::uint32_t list);
+    void Place(std::uint32_t index);
+    void Unlink(std::uint32_t index);
+
+    TimerId MakeId(std::uint32_t index) const
+    {
+        return (TimerId(mTimers[index].mGeneration) << 32) | index;
+    }
+
+    const IClock* mClock;
+    std::uint64_t mResolution;
+    std::vector<Timer> mTimers;
+    std::array<SlotBitmap, SCHEDULER_LEVEL_COUNT> mOccupied{};
+    std::uint32_t mFreeHead = NO_INDEX;
+    std::size_t mPendingCount = 0;
+    std::uint64_t mCurrentTick;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_SCHEDULER_H
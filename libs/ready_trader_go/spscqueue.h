@@ -0,0 +1,99 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_SPSCQUEUE_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "error.h"
+
+namespace ReadyTraderGo {
+
+// A bounded queue with exactly one producing and one consuming thread. The
+// producer and consumer each keep a copy of the other's index and only read
+// the shared one when that copy says the queue is full or empty, so in the
+// steady state neither touches the other's cache line.
+template<typename T>
+class SpscQueue
+{
+public:
+    static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+    // The capacity must be a power of two.
+    explicit SpscQueue(std::size_t capacity) : mSlots(capacity), mMask(capacity - 1)
+    {
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+            throw ReadyTraderGoError("queue capacity must be a power of two");
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    void operator=(const SpscQueue&) = delete;
+
+    std::size_t GetCapacity() const { return mSlots.size(); }
+
+    // Producer only. Returns false, leaving the queue unchanged, if it is full.
+    bool TryPush(const T& value)
+    {
+        const std::size_t tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mCachedHead == mSlots.size())
+        {
+            mCachedHead = mHead.load(std::memory_order_acquire);
+            if (tail - mCachedHead == mSlots.size())
+                return false;
+        }
+        mSlots[tail & mMask] = value;
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Returns the oldest element, which stays valid until
+    // Pop is called, or nullptr if the queue is empty.
+    T* Front()
+    {
+        const std::size_t head = mHead.load(std::memory_order_relaxed);
+        if (head == mCachedTail)
+        {
+            mCachedTail = mTail.load(std::memory_order_acquire);
+            if (head == mCachedTail)
+                return nullptr;
+        }
+        return &mSlots[head & mMask];
+    }
+
+    // Consumer only. Must follow a call to Front that returned an element.
+    void Pop()
+    {
+        mHead.store(mHead.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+private:
+    std::vector<T> mSlots;
+    const std::size_t mMask;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> mHead{0};
+    std::size_t mCachedTail = 0;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> mTail{0};
+    std::size_t mCachedHead = 0;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_SPSCQUEUE_H
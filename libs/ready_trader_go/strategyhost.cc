@@ -0,0 +1,404 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <sstream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/post.hpp>
+
+#include "allocationtracker.h"
+#include "error.h"
+#include "logging.h"
+#include "strategyhost.h"
+#include "trace.h"
+
+RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_HST, "HOST")
+
+namespace ReadyTraderGo {
+
+ShadowConnection::ShadowConnection(boost::asio::io_context& context) : mContext(context)
+{
+    SetName("Shadow");
+    mRestingOrders.reserve(64);
+}
+
+template<typename M>
+void ShadowConnection::Respond(unsigned char messageType, const M& message)
+{
+    boost::asio::post(mContext, [this, messageType, message] {
+        unsigned char data[M::Layout::SIZE];
+        message.Serialise(data);
+        OnMessageReceipt(messageType, data, message.Size());
+    });
+}
+
+void ShadowConnection::SendMessage(unsigned char messageType, const ISerialisable& serialisable, SendMode)
+{
+    // The auto-trader always sends the message type's own structure.
+    switch (messageType)
+    {
+    case MessageType::INSERT_ORDER:
+    {
+        const auto& insert = static_cast<const InsertMessage&>(serialisable);
+        ++mCounts.mInserts;
+        Volume remaining;
+        if (insert.mLifespan == Lifespan::GOOD_FOR_DAY)
+        {
+            remaining = insert.mVolume;
+            mRestingOrders.emplace_back(insert.mClientOrderId, remaining);
+        }
+        Respond(MessageType::ORDER_STATUS, OrderStatusMessage{insert.mClientOrderId, Volume(), remaining, 0});
+        break;
+    }
+    case MessageType::AMEND_ORDER:
+    {
+        const auto& amend = static_cast<const AmendMessage&>(serialisable);
+        ++mCounts.mAmends;
+        auto order = std::find_if(mRestingOrders.begin(), mRestingOrders.end(),
+                                  [&amend](const auto& o) { return o.first == amend.mClientOrderId; });
+        if (order != mRestingOrders.end() && amend.mNewVolume < order->second)
+        {
+            order->second = amend.mNewVolume;
+            if (!amend.mNewVolume)
+            {
+                *order = mRestingOrders.back();
+                mRestingOrders.pop_back();
+            }
+            Respond(MessageType::ORDER_STATUS, OrderStatusMessage{amend.mClientOrderId, Volume(), amend.mNewVolume, 0});
+        }
+        break;
+    }
+    case MessageType::CANCEL_ORDER:
+    {
+        const auto& cancel = static_cast<const CancelMessage&>(serialisable);
+        ++mCounts.mCancels;
+        auto order = std::find_if(mRestingOrders.begin(), mRestingOrders.end(),
+                                  [&cancel](const auto& o) { return o.first == cancel.mClientOrderId; });
+        if (order != mRestingOrders.end())
+        {
+            *order = mRestingOrders.back();
+            mRestingOrders.pop_back();
+            Respond(MessageType::ORDER_STATUS, OrderStatusMessage{cancel.mClientOrderId, Volume(), Volume(), 0});
+        }
+        break;
+    }
+    case MessageType::HEDGE_ORDER:
+    {
+        const auto& hedge = static_cast<const HedgeMessage&>(serialisable);
+        ++mCounts.mHedges;
+        Respond(MessageType::HEDGE_FILLED, HedgeFilledMessage{hedge.mClientOrderId, hedge.mPrice, hedge.mVolume});
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+StrategyHost::~StrategyHost()
+{
+    Stop();
+    if (mStrategies.empty())
+    {
+        return;
+    }
+
+    std::ostringstream report;
+    WriteReport(report);
+    std::string text = report.str();
+    if (!text.empty() && text.back() == '\n')
+    {
+        text.pop_back();
+    }
+    RLOG(LG_HST, LogLevel::LL_INFO) << text;
+}
+
+void StrategyHost::AddStrategy(const StrategyOptions& options, const StrategyFactory& create)
+{
+    if (mStarted)
+        throw ReadyTraderGoError("strategies must be added before the host is started");
+
+    if (options.mMode == StrategyMode::LIVE && mLive.size() == OrderGateway::MAXIMUM_OWNERS)
+        throw ReadyTraderGoError("too many live strategies");
+
+    if (options.mMode == StrategyMode::LIVE && options.mCore >= 0)
+        throw ReadyTraderGoError("live strategies must run on the host's thread");
+
+    auto strategy = std::make_unique<Strategy>();
+    strategy->mOptions = options;
+    if (options.mCore >= 0)
+    {
+        strategy->mContext = std::make_unique<boost::asio::io_context>(1);
+        strategy->mQueue = std::make_unique<SpscQueue<HostedMessage>>(options.mQueueCapacity);
+    }
+
+    strategy->mTrader = create(strategy->mContext ? *strategy->mContext : mContext);
+    if (!strategy->mTrader)
+        throw ReadyTraderGoError("strategy factory returned no strategy");
+
+    if (options.mMode == StrategyMode::LIVE)
+    {
+        mLive.push_back(strategy.get());
+        strategy->mTrader->SetLoginDetails(mTeamName, mSecret);
+    }
+    mStrategies.push_back(std::move(strategy));
+}
+
+void StrategyHost::Deliver(Strategy& strategy, const HostedMessage& message)
+{
+    const std::uint64_t start = ReadTimestampCounter();
+    if (const auto* book = std::get_if<OrderBookMessage>(&message))
+    {
+        strategy.mTrader->DeliverOrderBook(*book);
+    }
+    else
+    {
+        strategy.mTrader->DeliverTradeTicks(std::get<TradeTicksMessage>(message));
+    }
+    const auto nanoseconds = static_cast<std::uint64_t>(double(ReadTimestampCounter() - start) * mNanosecondsPerTick);
+    strategy.mHandlerNanoseconds.Record(nanoseconds);
+    strategy.mHandlerTotalNanoseconds += nanoseconds;
+}
+
+void StrategyHost::MessageHandler(ISubscription*,
+                                  unsigned char messageType,
+                                  unsigned char const* data,
+                                  std::size_t size)
+{
+    RTG_TRACE_SPAN("host dispatch");
+    const std::uint64_t start = ReadTimestampCounter();
+    switch (messageType)
+    {
+    case MessageType::ORDER_BOOK_UPDATE:
+        mMessage.emplace<OrderBookMessage>().Deserialise(data, size);
+        break;
+    case MessageType::TRADE_TICKS:
+        mMessage.emplace<TradeTicksMessage>().Deserialise(data, size);
+        break;
+    default:
+    {
+        RLOG(LG_HST, LogLevel::LL_ERROR) << "received information message with unexpected type: "
+                                         << static_cast<int>(messageType);
+        throw ReadyTraderGoError("received information message with unexpected type");
+    }
+    }
+    mDecodeNanoseconds.Record(
+        static_cast<std::uint64_t>(double(ReadTimestampCounter() - start) * mNanosecondsPerTick));
+
+    // Strategies on their own threads get their copies first, so that they
+    // work in parallel with the ones below; the live strategy is never kept
+    // waiting by a shadow one on this thread.
+    for (auto& strategy : mStrategies)
+    {
+        if (strategy->mQueue && !strategy->mQueue->TryPush(mMessage))
+        {
+            strategy->mDroppedCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    for (Strategy* live : mLive)
+    {
+        Deliver(*live, mMessage);
+    }
+
+    for (auto& strategy : mStrategies)
+    {
+        if (!strategy->mQueue && strategy->mOptions.mMode != StrategyMode::LIVE)
+        {
+            Deliver(*strategy, mMessage);
+        }
+    }
+
+    InformationHandled();
+}
+
+void StrategyHost::SetClock(const IClock& clock)
+{
+    BaseAutoTrader::SetClock(clock);
+    for (auto& strategy : mStrategies)
+    {
+        strategy->mTrader->SetClock(clock);
+    }
+}
+
+void StrategyHost::SetExecutionConnection(std::unique_ptr<IConnection>&& connection)
+{
+    for (auto& strategy : mStrategies)
+    {
+        if (strategy->mOptions.mMode != StrategyMode::LIVE)
+        {
+            boost::asio::io_context& context = strategy->mContext ? *strategy->mContext : mContext;
+            auto shadow = std::make_unique<ShadowConnection>(context);
+            strategy->mShadowConnection = shadow.get();
+            strategy->mTrader->SetExecutionConnection(std::move(shadow));
+        }
+    }
+
+    // Without a live strategy the host logs in itself, so the exchange sees
+    // the team connect, and ignores whatever it is sent.
+    if (mLive.empty())
+    {
+        BaseAutoTrader::SetExecutionConnection(std::move(connection));
+        return;
+    }
+
+    // Callbacks of live strategies are profiled (together) as if there were
+    // no host.
+    if (mLive.size() == 1)
+    {
+        mLive.front()->mTrader->SetHandlerProfiler(mProfiler);
+        mLive.front()->mTrader->SetExecutionConnection(std::move(connection));
+        return;
+    }
+
+    mGateway = std::make_unique<OrderGateway>(mContext, mMessageLimit, mMessageInterval, mActiveOrderLimit);
+    std::vector<std::unique_ptr<GatewayConnection>> connections;
+    for (Strategy* live : mLive)
+    {
+        connections.push_back(mGateway->Register(live->mOptions.mName, live->mOptions.mWeight));
+    }
+    mGateway->SetConnection(std::move(connection));
+    for (std::size_t i = 0; i < mLive.size(); ++i)
+    {
+        mLive[i]->mTrader->SetHandlerProfiler(mProfiler);
+        mLive[i]->mTrader->SetExecutionConnection(std::move(connections[i]));
+    }
+}
+
+void StrategyHost::SetInformationSubscription(std::shared_ptr<ISubscription>&& subscription)
+{
+    mStarted = true;
+    for (auto& strategy : mStrategies)
+    {
+        if (strategy->mQueue)
+        {
+            Strategy& s = *strategy;
+            strategy->mThread = std::thread([this, &s] { StrategyThread(s); });
+        }
+    }
+
+    BaseAutoTrader::SetInformationSubscription(std::move(subscription));
+}
+
+void StrategyHost::SetLoginDetails(std::string teamName, std::string secret)
+{
+    for (Strategy* live : mLive)
+    {
+        live->mTrader->SetLoginDetails(teamName, secret);
+    }
+    BaseAutoTrader::SetLoginDetails(std::move(teamName), std::move(secret));
+}
+
+void StrategyHost::SetReconnectPolicy(IConnectionFactory*, const ReconnectPolicy&)
+{
+    throw ReadyTraderGoError("the strategy host cannot reconnect to the exchange");
+}
+
+void StrategyHost::Stop()
+{
+    mStopping.store(true, std::memory_order_relaxed);
+    for (auto& strategy : mStrategies)
+    {
+        if (strategy->mThread.joinable())
+        {
+            strategy->mThread.join();
+        }
+    }
+}
+
+void StrategyHost::StrategyThread(Strategy& strategy)
+{
+    if (TRACING_ENABLED)
+    {
+        setTraceThreadName(strategy.mOptions.mName);
+    }
+
+#ifdef __linux__
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(strategy.mOptions.mCore, &cpus);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0)
+    {
+        RLOG(LG_HST, LogLevel::LL_WARNING) << "could not pin strategy '" << strategy.mOptions.mName
+                                           << "' to core " << strategy.mOptions.mCore;
+    }
+#endif
+
+    // Spin, but give the core up whenever there is nothing to do in case it
+    // is shared after all.
+    auto work = boost::asio::make_work_guard(*strategy.mContext);
+    while (!mStopping.load(std::memory_order_relaxed))
+    {
+        bool busy = strategy.mContext->poll() != 0;
+        while (HostedMessage* message = strategy.mQueue->Front())
+        {
+            Deliver(strategy, *message);
+            strategy.mQueue->Pop();
+            busy = true;
+        }
+        if (!busy)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void StrategyHost::WriteReport(std::ostream& out) const
+{
+    out << "strategy host: messages=" << mDecodeNanoseconds.GetCount() << " decode_ns(p50/p99/max)="
+        << mDecodeNanoseconds.GetPercentile(50.0) << '/' << mDecodeNanoseconds.GetPercentile(99.0) << '/'
+        << mDecodeNanoseconds.GetMax() << '\n';
+
+    for (const auto& strategy : mStrategies)
+    {
+        const LogHistogram& handler = strategy->mHandlerNanoseconds;
+        out << "  '" << strategy->mOptions.mName << "' "
+            << (strategy->mOptions.mMode == StrategyMode::LIVE ? "live" : "shadow");
+        if (strategy->mOptions.mCore >= 0)
+        {
+            out << " core=" << strategy->mOptions.mCore;
+        }
+        out << " handled=" << handler.GetCount() << " handler_ns(mean/p50/p99/max)="
+            << (handler.GetCount() ? strategy->mHandlerTotalNanoseconds / handler.GetCount() : 0) << '/'
+            << handler.GetPercentile(50.0) << '/' << handler.GetPercentile(99.0) << '/' << handler.GetMax();
+        if (strategy->mQueue)
+        {
+            out << " dropped=" << strategy->mDroppedCount.load(std::memory_order_relaxed);
+        }
+        if (strategy->mShadowConnection)
+        {
+            const ShadowOrderCounts& counts = strategy->mShadowConnection->GetCounts();
+            out << " unsent(insert/amend/cancel/hedge)=" << counts.mInserts << '/' << counts.mAmends << '/'
+                << counts.mCancels << '/' << counts.mHedges;
+        }
+        out << " errors=";
+        WriteErrorCounts(out, strategy->mTrader->GetErrorCounts());
+        out << '\n';
+    }
+
+    if (mGateway)
+    {
+        mGateway->WriteReport(out);
+    }
+}
+
+}
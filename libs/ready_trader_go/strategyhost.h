@@ -0,0 +1,201 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_STRATEGYHOST_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_STRATEGYHOST_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+
+#include "baseautotrader.h"
+#include "clock.h"
+#include "connectivitytypes.h"
+#include "handlerprofiler.h"
+#include "ordergateway.h"
+#include "protocol.h"
+#include "spscqueue.h"
+
+namespace ReadyTraderGo {
+
+enum class StrategyMode
+{
+    // Trades through the execution connection (shared through an
+    // OrderGateway if more than one strategy is live).
+    LIVE,
+    // Never sends anything to the exchange, see ShadowConnection.
+    SHADOW
+};
+
+struct StrategyOptions
+{
+    std::string mName;
+    StrategyMode mMode = StrategyMode::SHADOW;
+    // Run the strategy on its own thread, pinned to this core and fed
+    // through a queue. A negative core runs it on the host's thread. Only
+    // shadow strategies may have their own thread.
+    int mCore = -1;
+    // Share of the message frequency limit when several strategies are live.
+    unsigned mWeight = 1;
+    // Information messages that may wait for a strategy on its own thread
+    // before further ones are dropped (must be a power of two).
+    std::size_t mQueueCapacity = 1024;
+};
+
+// What a shadow strategy would have sent.
+struct ShadowOrderCounts
+{
+    std::uint64_t mInserts = 0;
+    std::uint64_t mAmends = 0;
+    std::uint64_t mCancels = 0;
+    std::uint64_t mHedges = 0;
+};
+
+// An execution connection for a strategy that must not trade. Orders are
+// counted and acknowledged, as the exchange would acknowledge them, but
+// never filled: good-for-day orders rest until amended or cancelled,
+// fill-and-kill orders are cancelled and hedges are filled at their limit
+// price. Responses are posted to the given context rather than delivered
+// from inside SendMessage.
+class ShadowConnection : public IConnection
+{
+public:
+    explicit ShadowConnection(boost::asio::io_context& context);
+
+    void AsyncRead() override {}
+    void SendMessage(unsigned char messageType, const ISerialisable& serialisable, SendMode mode) override;
+
+    const ShadowOrderCounts& GetCounts() const { return mCounts; }
+
+private:
+    template<typename M>
+    void Respond(unsigned char messageType, const M& message);
+
+    boost::asio::io_context& mContext;
+    ShadowOrderCounts mCounts;
+    // Resting orders as (client order id, remaining volume) pairs.
+    std::vector<std::pair<unsigned long, Volume>> mRestingOrders;
+};
+
+// Runs several strategies against one execution connection and one
+// information subscription. Each information frame is decoded once and
+// handed to every strategy. Live strategies trade, sharing the connection
+// through an OrderGateway when there is more than one of them; the others
+// run in shadow mode. The time each strategy spends handling information
+// messages is measured and written to the log when the host is destroyed.
+//
+// The host is itself an auto-trader, so it can be given to an
+// AutoTraderAppHandler in place of a single strategy. Strategies must be
+// added before the host is given its connection and subscription.
+class StrategyHost : public BaseAutoTrader
+{
+public:
+    using StrategyFactory = std::function<std::unique_ptr<BaseAutoTrader>(boost::asio::io_context&)>;
+
+    explicit StrategyHost(boost::asio::io_context& context) : BaseAutoTrader(context) {}
+    ~StrategyHost();
+
+    StrategyHost(const StrategyHost&) = delete;
+    void operator=(const StrategyHost&) = delete;
+
+    // The factory is given the context the strategy must be built with.
+    void AddStrategy(const StrategyOptions& options, const StrategyFactory& create);
+    std::size_t GetStrategyCount() const { return mStrategies.size(); }
+
+    // The exchange's message frequency limit, which live strategies share
+    // when there is more than one of them.
+    void SetMessageFrequencyLimit(std::size_t messageLimit, std::chrono::nanoseconds interval)
+    {
+        mMessageLimit = messageLimit;
+        mMessageInterval = interval;
+    }
+
+    // The exchange's limit on the number of orders live at once.
+    void SetActiveOrderCountLimit(std::size_t activeOrderLimit) { mActiveOrderLimit = activeOrderLimit; }
+
+    // Stop and join the strategies' own threads.
+    void Stop();
+
+    void WriteReport(std::ostream& out) const;
+
+    void SetClock(const IClock& clock) override;
+    void SetExecutionConnection(std::unique_ptr<IConnection>&& connection) override;
+    void SetInformationSubscription(std::shared_ptr<ISubscription>&& subscription) override;
+    void SetLoginDetails(std::string teamName, std::string secret) override;
+    // Not supported: the live strategies, not the host, hold the connection.
+    void SetReconnectPolicy(IConnectionFactory* factory, const ReconnectPolicy& policy) override;
+
+protected:
+    using BaseAutoTrader::MessageHandler;
+    void MessageHandler(ISubscription* subscription,
+                        unsigned char messageType,
+                        unsigned char const* data,
+                        std::size_t size) override;
+
+private:
+    using HostedMessage = std::variant<OrderBookMessage, TradeTicksMessage>;
+
+    struct Strategy
+    {
+        StrategyOptions mOptions;
+        // Only for strategies with their own thread.
+        std::unique_ptr<boost::asio::io_context> mContext;
+        std::unique_ptr<SpscQueue<HostedMessage>> mQueue;
+        std::thread mThread;
+
+        std::unique_ptr<BaseAutoTrader> mTrader;
+        ShadowConnection* mShadowConnection = nullptr;
+
+        LogHistogram mHandlerNanoseconds;
+        std::uint64_t mHandlerTotalNanoseconds = 0;
+        std::atomic<std::uint64_t> mDroppedCount{0};
+    };
+
+    void Deliver(Strategy& strategy, const HostedMessage& message);
+    void StrategyThread(Strategy& strategy);
+
+    // Declared first so that it outlives the strategies' connections to it.
+    std::unique_ptr<OrderGateway> mGateway;
+    std::size_t mMessageLimit = 50;
+    std::chrono::nanoseconds mMessageInterval = std::chrono::seconds(1);
+    std::size_t mActiveOrderLimit = 10;
+
+    std::vector<std::unique_ptr<Strategy>> mStrategies;
+    std::vector<Strategy*> mLive;
+    bool mStarted = false;
+    std::atomic<bool> mStopping{false};
+
+    // Reused so that each frame is decoded without allocating.
+    HostedMessage mMessage;
+    LogHistogram mDecodeNanoseconds;
+    double mNanosecondsPerTick = static_cast<const TscClock&>(GetSystemClock()).GetNanosecondsPerTick();
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_STRATEGYHOST_H
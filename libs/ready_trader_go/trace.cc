@@ -0,0 +1,168 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "error.h"
+#include "trace.h"
+
+namespace ReadyTraderGo {
+
+namespace {
+
+std::mutex gTraceMutex;
+std::vector<std::unique_ptr<TraceRing>> gTraceRings;
+
+void writeEscaped(std::ostream& out, const std::string& text)
+{
+    out << '"';
+    for (char c: text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out << '\\' << c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            out << ' ';
+        }
+        else
+        {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+}
+
+std::vector<TraceRecord> TraceRing::Snapshot(std::uint64_t since) const
+{
+    const std::uint64_t head = mHead.load(std::memory_order_acquire);
+    const std::uint64_t start = (head > TRACE_RING_CAPACITY) ? head - TRACE_RING_CAPACITY : 0;
+
+    std::vector<TraceRecord> records;
+    records.reserve(head - start);
+    for (std::uint64_t i = start; i < head; ++i)
+    {
+        records.push_back(mRecords[i & (TRACE_RING_CAPACITY - 1)]);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    // Anything the writer lapped while the copy was being taken may be torn.
+    const std::uint64_t newHead = mHead.load(std::memory_order_relaxed);
+    const std::uint64_t valid = (newHead > TRACE_RING_CAPACITY) ? newHead - TRACE_RING_CAPACITY : 0;
+    const std::size_t torn = (valid > start) ? std::min<std::uint64_t>(valid - start, records.size()) : 0;
+    records.erase(records.begin(), records.begin() + torn);
+
+    records.erase(std::remove_if(records.begin(), records.end(), [since](const TraceRecord& record) {
+        return (record.mTimestamp & ~TRACE_END_FLAG) < since;
+    }), records.end());
+    return records;
+}
+
+TraceRing& registerTraceRing()
+{
+    std::lock_guard<std::mutex> lock(gTraceMutex);
+    const std::size_t index = gTraceRings.size() + 1;
+    gTraceRings.push_back(std::make_unique<TraceRing>(index, "thread " + std::to_string(index)));
+    tTraceRing = gTraceRings.back().get();
+    return *tTraceRing;
+}
+
+void setTraceThreadName(std::string name)
+{
+    TraceRing& ring = currentTraceRing();
+    std::lock_guard<std::mutex> lock(gTraceMutex);
+    ring.SetThreadName(std::move(name));
+}
+
+void writeChromeTrace(std::ostream& out, double seconds)
+{
+    // Time stamp counter readings are converted to microseconds since the
+    // epoch by anchoring them to the current real time.
+    static const TscClock clock;
+    const double nanosecondsPerTick = clock.GetNanosecondsPerTick();
+    const std::uint64_t nowTsc = ReadTimestampCounter();
+    const std::uint64_t nowRealtime = ReadRealtimeNanoseconds();
+    const auto window = static_cast<std::uint64_t>(seconds * NANOSECONDS_PER_SECOND / nanosecondsPerTick);
+    const std::uint64_t since = (nowTsc > window) ? nowTsc - window : 0;
+    const auto toMicroseconds = [&](std::uint64_t tsc) {
+        const double ago = double(nowTsc - std::min(tsc, nowTsc)) * nanosecondsPerTick;
+        return (double(nowRealtime) - ago) / 1000.0;
+    };
+
+    std::lock_guard<std::mutex> lock(gTraceMutex);
+    const int pid = ::getpid();
+    const char* separator = "\n";
+
+    out << "{\"traceEvents\":[" << std::fixed << std::setprecision(3);
+    for (const auto& ring: gTraceRings)
+    {
+        out << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":"
+            << ring->GetThreadIndex() << ",\"args\":{\"name\":";
+        writeEscaped(out, ring->GetThreadName());
+        out << "}}";
+        separator = ",\n";
+
+        // Spans that began before the window (or before the oldest surviving
+        // record) have no begin record, so their end records are dropped.
+        std::size_t depth = 0;
+        for (const TraceRecord& record: ring->Snapshot(since))
+        {
+            const bool end = (record.mTimestamp & TRACE_END_FLAG) != 0;
+            if (end && depth == 0)
+            {
+                continue;
+            }
+            depth = end ? depth - 1 : depth + 1;
+
+            out << separator << "{\"name\":";
+            writeEscaped(out, record.mName);
+            out << ",\"ph\":\"" << (end ? 'E' : 'B') << "\",\"ts\":"
+                << toMicroseconds(record.mTimestamp & ~TRACE_END_FLAG) << ",\"pid\":" << pid << ",\"tid\":"
+                << ring->GetThreadIndex() << '}';
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+void dumpChromeTrace(const std::string& filename, double seconds)
+{
+    std::ofstream out{filename};
+    if (!out)
+    {
+        throw ReadyTraderGoError("failed to create trace file '" + filename + "': " + std::strerror(errno));
+    }
+    writeChromeTrace(out, seconds);
+    if (!out.flush())
+    {
+        throw ReadyTraderGoError("failed to write trace file '" + filename + "'");
+    }
+}
+
+}
@@ -0,0 +1,143 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_TRACE_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_TRACE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "clock.h"
+
+namespace ReadyTraderGo {
+
+// Whether the RTG_TRACE_SPAN macros were compiled in (see the RTG_TRACING
+// CMake option).
+#ifdef RTG_TRACING
+constexpr bool TRACING_ENABLED = true;
+#else
+constexpr bool TRACING_ENABLED = false;
+#endif
+
+constexpr std::size_t TRACE_RING_CAPACITY = 65536; // records per thread, a power of two
+constexpr double TRACE_DEFAULT_SECONDS = 10.0;
+constexpr std::uint64_t TRACE_END_FLAG = std::uint64_t(1) << 63;
+
+// A span boundary: the time stamp counter (with the top bit set for the end
+// of a span) and the span's name, which must be a string literal.
+struct TraceRecord
+{
+    std::uint64_t mTimestamp;
+    const char* mName;
+};
+
+// The most recent span boundaries recorded by one thread. Only the owning
+// thread writes; a dump may read concurrently and discards anything that was
+// overwritten while it was being copied.
+class TraceRing
+{
+public:
+    TraceRing(std::size_t threadIndex, std::string threadName)
+        : mThreadIndex(threadIndex), mThreadName(std::move(threadName))
+    {
+    }
+
+    TraceRing(const TraceRing&) = delete;
+    void operator=(const TraceRing&) = delete;
+
+    std::size_t GetThreadIndex() const { return mThreadIndex; }
+    const std::string& GetThreadName() const { return mThreadName; }
+    void SetThreadName(std::string name) { mThreadName = std::move(name); }
+
+    void Write(std::uint64_t timestamp, const char* name)
+    {
+        const std::uint64_t head = mHead.load(std::memory_order_relaxed);
+        mRecords[head & (TRACE_RING_CAPACITY - 1)] = {timestamp, name};
+        mHead.store(head + 1, std::memory_order_release);
+    }
+
+    // Copy out the records at or after the given time stamp, oldest first.
+    std::vector<TraceRecord> Snapshot(std::uint64_t since) const;
+
+private:
+    std::array<TraceRecord, TRACE_RING_CAPACITY> mRecords;
+    std::atomic<std::uint64_t> mHead{0};
+    std::size_t mThreadIndex;
+    std::string mThreadName;
+};
+
+// Return the calling thread's ring, creating it on first use.
+TraceRing& registerTraceRing();
+
+inline thread_local TraceRing* tTraceRing = nullptr;
+
+inline TraceRing& currentTraceRing()
+{
+    return tTraceRing ? *tTraceRing : registerTraceRing();
+}
+
+// Name the calling thread in dumped traces.
+void setTraceThreadName(std::string name);
+
+// Records the span from construction to destruction in the calling thread's
+// ring.
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char* name) : mRing(currentTraceRing()), mName(name)
+    {
+        mRing.Write(ReadTimestampCounter(), mName);
+    }
+
+    ~TraceSpan()
+    {
+        mRing.Write(ReadTimestampCounter() | TRACE_END_FLAG, mName);
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    void operator=(const TraceSpan&) = delete;
+
+private:
+    TraceRing& mRing;
+    const char* mName;
+};
+
+// Write the last so many seconds of every thread's spans in the Chrome trace
+// event format (which Perfetto and chrome://tracing both read).
+void writeChromeTrace(std::ostream& out, double seconds);
+
+// As writeChromeTrace, but to a file. Throws if the file cannot be written.
+void dumpChromeTrace(const std::string& filename, double seconds);
+
+}
+
+#ifdef RTG_TRACING
+#define RTG_TRACE_CONCAT_INNER(a, b) a##b
+#define RTG_TRACE_CONCAT(a, b) RTG_TRACE_CONCAT_INNER(a, b)
+// Trace the rest of the enclosing block as a span with the given name, which
+// must be a string literal.
+#define RTG_TRACE_SPAN(name) ::ReadyTraderGo::TraceSpan RTG_TRACE_CONCAT(rtgTraceSpan, __LINE__){name}
+#else
+#define RTG_TRACE_SPAN(name)
+#endif
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_TRACE_H
@@ -0,0 +1,203 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <cmath>
+
+#include "error.h"
+#include "tradeaggregator.h"
+
+namespace ReadyTraderGo {
+
+TradeAggregator::TradeAggregator(const TradeAggregatorParameters& parameters)
+    : mParameters(parameters), mEntries(parameters.mCapacity), mTimeBars(parameters.mBarCapacity),
+      mVolumeBars(parameters.mBarCapacity)
+{
+    if (parameters.mCapacity == 0 || parameters.mBarCapacity == 0)
+        throw ReadyTraderGoError("trade aggregator capacities must be positive");
+
+    if (parameters.mBarInterval == 0 || parameters.mBarVolume == 0)
+        throw ReadyTraderGoError("trade aggregator bar interval and volume must be positive");
+
+    if (!std::is_sorted(parameters.mHorizons.begin(), parameters.mHorizons.end()) || parameters.mHorizons[0] == 0)
+        throw ReadyTraderGoError("trade aggregator horizons must be positive and shortest first");
+}
+
+void TradeAggregator::AddToBar(TradeBar& bar, const Entry& entry, unsigned long high, unsigned long low,
+                               double price)
+{
+    if (bar.mVolume == 0)
+    {
+        bar.mOpen = price;
+        bar.mHigh = high;
+        bar.mLow = low;
+    }
+    bar.mHigh = std::max(bar.mHigh, high);
+    bar.mLow = std::min(bar.mLow, low);
+    bar.mClose = price;
+    bar.mEndTime = entry.mTime;
+    bar.mVolume += entry.mVolume;
+    bar.mBuyVolume += entry.mBuyVolume;
+    bar.mSellVolume += entry.mSellVolume;
+    bar.mTurnover += entry.mTurnover;
+}
+
+void TradeAggregator::OnTradeTicks(std::uint64_t now,
+                                   const PriceLevels& askPrices,
+                                   const VolumeLevels& askVolumes,
+                                   const PriceLevels& bidPrices,
+                                   const VolumeLevels& bidVolumes)
+{
+    Entry entry{now, 0, 0, 0, 0, 0.0};
+    unsigned long high = 0;
+    unsigned long low = MAXIMUM_ASK;
+    for (std::size_t i = 0; i < TOP_LEVEL_COUNT; ++i)
+    {
+        if (askVolumes[i])
+        {
+            entry.mBuyVolume += askVolumes[i].Lots();
+            entry.mTurnover += askPrices[i] * askVolumes[i];
+            high = std::max(high, askPrices[i].Cents());
+            low = std::min(low, askPrices[i].Cents());
+        }
+        if (bidVolumes[i])
+        {
+            entry.mSellVolume += bidVolumes[i].Lots();
+            entry.mTurnover += bidPrices[i] * bidVolumes[i];
+            high = std::max(high, bidPrices[i].Cents());
+            low = std::min(low, bidPrices[i].Cents());
+        }
+    }
+    entry.mVolume = entry.mBuyVolume + entry.mSellVolume;
+
+    if (entry.mVolume == 0)
+    {
+        Advance(now);
+        return;
+    }
+
+    const double price = static_cast<double>(entry.mTurnover) / entry.mVolume;
+    if (mSnapshot.mLastPrice > 0.0)
+    {
+        const double logReturn = std::log(price / mSnapshot.mLastPrice);
+        entry.mSquaredReturn = logReturn * logReturn;
+    }
+
+    // A message in a later interval closes the open time bar before the
+    // windows catch up with it.
+    if (mIsTimeBarOpen && now >= mTimeBar.mStartTime + mParameters.mBarInterval)
+    {
+        mTimeBars.Push(mTimeBar);
+        mIsTimeBarOpen = false;
+    }
+    if (!mIsTimeBarOpen)
+    {
+        mTimeBar = TradeBar{};
+        mTimeBar.mStartTime = now - now % mParameters.mBarInterval;
+        mIsTimeBarOpen = true;
+    }
+    AddToBar(mTimeBar, entry, high, low, price);
+
+    if (mVolumeBar.mVolume == 0)
+    {
+        mVolumeBar.mStartTime = now;
+    }
+    AddToBar(mVolumeBar, entry, high, low, price);
+    if (mVolumeBar.mVolume >= mParameters.mBarVolume)
+    {
+        mVolumeBars.Push(mVolumeBar);
+        mVolumeBar = TradeBar{};
+    }
+
+    if (mNext >= mEntries.size())
+    {
+        // The slot about to be reused holds the oldest message, which must
+        // first leave any window still covering it.
+        const std::uint64_t oldest = mNext - mEntries.size();
+        for (std::size_t w = 0; w < TRADE_HORIZON_COUNT; ++w)
+        {
+            if (mSums[w].mFirst == oldest)
+            {
+                Remove(w);
+            }
+        }
+    }
+    GetEntry(mNext++) = entry;
+    for (WindowSums& sums: mSums)
+    {
+        sums.mVolume += entry.mVolume;
+        sums.mBuyVolume += entry.mBuyVolume;
+        sums.mSellVolume += entry.mSellVolume;
+        sums.mTurnover += entry.mTurnover;
+        sums.mSquaredReturns += entry.mSquaredReturn;
+    }
+
+    mSnapshot.mLastPrice = price;
+    mSnapshot.mTotalVolume += entry.mVolume;
+    mSnapshot.mTotalBuyVolume += entry.mBuyVolume;
+    mSnapshot.mTotalSellVolume += entry.mSellVolume;
+    Advance(now);
+}
+
+void TradeAggregator::Advance(std::uint64_t now)
+{
+    for (std::size_t w = 0; w < TRADE_HORIZON_COUNT; ++w)
+    {
+        while (mSums[w].mFirst != mNext && GetEntry(mSums[w].mFirst).mTime + mParameters.mHorizons[w] <= now)
+        {
+            Remove(w);
+        }
+        Publish(w);
+    }
+
+    if (mIsTimeBarOpen && now >= mTimeBar.mStartTime + mParameters.mBarInterval)
+    {
+        mTimeBars.Push(mTimeBar);
+        mIsTimeBarOpen = false;
+    }
+    mSnapshot.mTime = now;
+}
+
+void TradeAggregator::Remove(std::size_t window)
+{
+    WindowSums& sums = mSums[window];
+    const Entry& entry = GetEntry(sums.mFirst++);
+    sums.mVolume -= entry.mVolume;
+    sums.mBuyVolume -= entry.mBuyVolume;
+    sums.mSellVolume -= entry.mSellVolume;
+    sums.mTurnover -= entry.mTurnover;
+    sums.mSquaredReturns -= entry.mSquaredReturn;
+}
+
+void TradeAggregator::Publish(std::size_t window)
+{
+    WindowSums& sums = mSums[window];
+    TradeWindow& out = mSnapshot.mWindows[window];
+    out.mMessageCount = mNext - sums.mFirst;
+    if (out.mMessageCount == 0)
+    {
+        // Start the next window's sum of squares afresh, free of rounding.
+        sums.mSquaredReturns = 0.0;
+    }
+    out.mVolume = sums.mVolume;
+    out.mBuyVolume = sums.mBuyVolume;
+    out.mSellVolume = sums.mSellVolume;
+    out.mVwap = (sums.mVolume != 0) ? static_cast<double>(sums.mTurnover) / sums.mVolume : 0.0;
+    out.mRealisedVolatility = std::sqrt(std::max(0.0, sums.mSquaredReturns));
+}
+
+}
@@ -0,0 +1,202 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_TRADEAGGREGATOR_H
+#define CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_TRADEAGGREGATOR_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "clock.h"
+#include "price.h"
+#include "types.h"
+
+namespace ReadyTraderGo {
+
+constexpr std::size_t TRADE_HORIZON_COUNT = 3;
+
+struct TradeAggregatorParameters
+{
+    // Lengths, in nanoseconds, of the rolling windows, shortest first.
+    std::array<std::uint64_t, TRADE_HORIZON_COUNT> mHorizons{NANOSECONDS_PER_SECOND,
+                                                             10 * NANOSECONDS_PER_SECOND,
+                                                             60 * NANOSECONDS_PER_SECOND};
+    // Trade ticks messages remembered for the windows. Should the longest
+    // window need more, the oldest messages leave it early.
+    std::size_t mCapacity = 4096;
+    // Nanoseconds covered by each time bar.
+    std::uint64_t mBarInterval = NANOSECONDS_PER_SECOND;
+    // Lots traded before a volume bar closes.
+    unsigned long mBarVolume = 100;
+    // Closed bars remembered of each kind.
+    std::size_t mBarCapacity = 256;
+};
+
+// Trading in one of the rolling windows. Buy volume is that of buyers
+// trading with resting sell orders (ask ticks) and sell volume that of
+// sellers trading with resting buy orders (bid ticks).
+struct TradeWindow
+{
+    unsigned long mVolume = 0;
+    unsigned long mBuyVolume = 0;
+    unsigned long mSellVolume = 0;
+    // Volume weighted average price, or zero if nothing traded.
+    double mVwap = 0.0;
+    // Square root of the sum of squared log returns between the average
+    // prices of successive trade ticks messages.
+    double mRealisedVolatility = 0.0;
+    std::size_t mMessageCount = 0;
+};
+
+struct TradeSnapshot
+{
+    std::uint64_t mTime = 0;
+    // Average price of the latest trade ticks message.
+    double mLastPrice = 0.0;
+    std::uint64_t mTotalVolume = 0;
+    std::uint64_t mTotalBuyVolume = 0;
+    std::uint64_t mTotalSellVolume = 0;
+    std::array<TradeWindow, TRADE_HORIZON_COUNT> mWindows;
+};
+
+struct TradeBar
+{
+    std::uint64_t mStartTime = 0;
+    std::uint64_t mEndTime = 0;
+    // The average prices of the first and last messages.
+    double mOpen = 0.0;
+    unsigned long mHigh = 0;
+    unsigned long mLow = 0;
+    double mClose = 0.0;
+    unsigned long mVolume = 0;
+    unsigned long mBuyVolume = 0;
+    unsigned long mSellVolume = 0;
+    std::uint64_t mTurnover = 0;
+
+    double GetVwap() const { return (mVolume != 0) ? static_cast<double>(mTurnover) / mVolume : 0.0; }
+};
+
+// The most recent bars, newest first, in preallocated storage.
+class TradeBarSeries
+{
+public:
+    explicit TradeBarSeries(std::size_t capacity) : mBars(capacity) {}
+
+    std::size_t GetCapacity() const { return mBars.size(); }
+    std::size_t Size() const { return mSize; }
+    bool Empty() const { return mSize == 0; }
+    // Bars closed since the aggregator was made, including any forgotten.
+    std::uint64_t GetClosedCount() const { return mClosedCount; }
+
+    // Zero is the latest closed bar; the index must be less than Size().
+    const TradeBar& operator[](std::size_t index) const
+    {
+        return mBars[(mNext + mBars.size() - 1 - index) % mBars.size()];
+    }
+
+    void Push(const TradeBar& bar)
+    {
+        mBars[mNext] = bar;
+        mNext = (mNext + 1 == mBars.size()) ? 0 : mNext + 1;
+        mSize = (mSize < mBars.size()) ? mSize + 1 : mSize;
+        ++mClosedCount;
+    }
+
+private:
+    std::vector<TradeBar> mBars;
+    std::size_t mNext = 0;
+    std::size_t mSize = 0;
+    std::uint64_t mClosedCount = 0;
+};
+
+// Aggregates every level of one instrument's trade ticks into rolling
+// windows and bars. Each message is kept once, in a ring; each window keeps
+// running sums and the oldest message it covers, so an update costs
+// O(levels + windows) however many messages the windows hold. Nothing is
+// allocated after construction, and the snapshot and bars are read in place.
+//
+// Time bars are aligned to multiples of their interval and only made for
+// intervals in which something traded. A volume bar closes on the message
+// that takes it to its volume, so may hold a little more.
+class TradeAggregator
+{
+public:
+    explicit TradeAggregator(const TradeAggregatorParameters& parameters = {});
+
+    void OnTradeTicks(std::uint64_t now,
+                      const PriceLevels& askPrices,
+                      const VolumeLevels& askVolumes,
+                      const PriceLevels& bidPrices,
+                      const VolumeLevels& bidVolumes);
+
+    // Lets time pass without trading: messages leave the windows and a time
+    // bar whose interval has ended closes.
+    void Advance(std::uint64_t now);
+
+    const TradeAggregatorParameters& GetParameters() const { return mParameters; }
+    const TradeSnapshot& GetSnapshot() const { return mSnapshot; }
+    const TradeBarSeries& GetTimeBars() const { return mTimeBars; }
+    const TradeBarSeries& GetVolumeBars() const { return mVolumeBars; }
+
+private:
+    struct Entry
+    {
+        std::uint64_t mTime;
+        unsigned long mVolume;
+        unsigned long mBuyVolume;
+        unsigned long mSellVolume;
+        std::uint64_t mTurnover;
+        double mSquaredReturn;
+    };
+
+    struct WindowSums
+    {
+        // Sequence number of the oldest message in the window.
+        std::uint64_t mFirst = 0;
+        std::uint64_t mVolume = 0;
+        std::uint64_t mBuyVolume = 0;
+        std::uint64_t mSellVolume = 0;
+        std::uint64_t mTurnover = 0;
+        double mSquaredReturns = 0.0;
+    };
+
+    Entry& GetEntry(std::uint64_t sequence) { return mEntries[sequence % mEntries.size()]; }
+    void Remove(std::size_t window);
+    void Publish(std::size_t window);
+    static void AddToBar(TradeBar& bar, const Entry& entry, unsigned long high, unsigned long low, double price);
+
+    const TradeAggregatorParameters mParameters;
+
+    std::vector<Entry> mEntries;
+    // Sequence number of the next message.
+    std::uint64_t mNext = 0;
+    std::array<WindowSums, TRADE_HORIZON_COUNT> mSums;
+
+    bool mIsTimeBarOpen = false;
+    TradeBar mTimeBar;
+    TradeBar mVolumeBar;
+    TradeBarSeries mTimeBars;
+    TradeBarSeries mVolumeBars;
+
+    TradeSnapshot mSnapshot;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_READY_TRADER_GO_TRADEAGGREGATOR_H
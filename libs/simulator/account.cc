@@ -0,0 +1,67 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <cmath>
+
+#include "account.h"
+
+namespace ReadyTraderGo {
+
+void CompetitorAccount::Transact(Instrument instrument, Side side, unsigned long price, long volume, long fee)
+{
+    const long value = static_cast<long>(price) * volume;
+    mAccountBalance += (side == Side::SELL) ? value : -value;
+    mAccountBalance -= fee;
+    mTotalFees += fee;
+
+    if (instrument == Instrument::FUTURE)
+    {
+        mFuturePosition += (side == Side::SELL) ? -volume : volume;
+    }
+    else if (side == Side::SELL)
+    {
+        mSellVolume += volume;
+        mEtfPosition -= volume;
+    }
+    else
+    {
+        mBuyVolume += volume;
+        mEtfPosition += volume;
+    }
+}
+
+void CompetitorAccount::Update(double futurePrice, double etfPrice)
+{
+    // Rounding matches the exchange, which uses Python's round().
+    long delta = static_cast<long>(std::nearbyint(mEtfClamp * futurePrice));
+    delta -= delta % static_cast<long>(mTickSize);
+    const double minPrice = futurePrice - delta;
+    const double maxPrice = futurePrice + delta;
+    const double clamped = (etfPrice < minPrice) ? minPrice : (etfPrice > maxPrice) ? maxPrice : etfPrice;
+
+    mProfitOrLoss = mAccountBalance + mFuturePosition * futurePrice + mEtfPosition * clamped;
+    if (mProfitOrLoss > mMaxProfit)
+    {
+        mMaxProfit = mProfitOrLoss;
+    }
+    if (mMaxProfit - mProfitOrLoss > mMaxDrawdown)
+    {
+        mMaxDrawdown = mMaxProfit - mProfitOrLoss;
+    }
+}
+
+}
@@ -0,0 +1,62 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_SIMULATOR_ACCOUNT_H
+#define CPPREADY_TRADER_GO_LIBS_SIMULATOR_ACCOUNT_H
+
+#include <ready_trader_go/types.h>
+
+namespace ReadyTraderGo {
+
+// A competitor's account. Profit or loss values the ETF position at the
+// ETF price clamped to within a band around the future price.
+class CompetitorAccount
+{
+public:
+    CompetitorAccount(unsigned long tickSize, double etfClamp) : mTickSize(tickSize), mEtfClamp(etfClamp) {}
+
+    void Transact(Instrument instrument, Side side, unsigned long price, long volume, long fee);
+    void Update(double futurePrice, double etfPrice);
+
+    long GetAccountBalance() const { return mAccountBalance; }
+    long GetBuyVolume() const { return mBuyVolume; }
+    long GetEtfPosition() const { return mEtfPosition; }
+    long GetFuturePosition() const { return mFuturePosition; }
+    double GetMaxDrawdown() const { return mMaxDrawdown; }
+    double GetMaxProfit() const { return mMaxProfit; }
+    double GetProfitOrLoss() const { return mProfitOrLoss; }
+    long GetSellVolume() const { return mSellVolume; }
+    long GetTotalFees() const { return mTotalFees; }
+
+private:
+    unsigned long mTickSize;
+    double mEtfClamp;
+
+    long mAccountBalance = 0;
+    long mBuyVolume = 0;
+    long mEtfPosition = 0;
+    long mFuturePosition = 0;
+    double mMaxDrawdown = 0.0;
+    double mMaxProfit = 0.0;
+    double mProfitOrLoss = 0.0;
+    long mSellVolume = 0;
+    long mTotalFees = 0;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_SIMULATOR_ACCOUNT_H
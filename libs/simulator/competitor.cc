@@ -0,0 +1,449 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <string>
+#include <utility>
+
+#include <ready_trader_go/logging.h>
+
+#include "competitor.h"
+
+RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_CMP, "COMPETITOR")
+
+namespace ReadyTraderGo {
+
+Competitor::Competitor(IExecutionChannel& channel,
+                       OrderBook& etfBook,
+                       OrderBook& futureBook,
+                       OrderPool& pool,
+                       const SimulatorConfig& config)
+    : mChannel(channel),
+      mEtfBook(etfBook),
+      mFutureBook(futureBook),
+      mPool(pool),
+      mConfig(config),
+      mAccount(config.mTickSize, config.mEtfClamp)
+{
+    mOrders.reserve(config.mActiveOrderCountLimit);
+    mBuyPrices.reserve(config.mActiveOrderCountLimit);
+    mSellPrices.reserve(config.mActiveOrderCountLimit);
+}
+
+void Competitor::ApplyPositionDelta(long now, long delta)
+{
+    const long limit = mConfig.mUnhedgedLotsLimit;
+    const long newRelativePosition = mRelativePosition + delta;
+
+    if (delta > 0)
+    {
+        if (mRelativePosition < -limit && -limit <= newRelativePosition)
+        {
+            mUnhedgedLotsDeadline = NO_DEADLINE;
+        }
+        if (newRelativePosition > limit && limit >= mRelativePosition)
+        {
+            mUnhedgedLotsDeadline = now + mConfig.mUnhedgedLotsTimeLimit;
+        }
+    }
+    else if (delta < 0)
+    {
+        if (mRelativePosition > limit && limit >= newRelativePosition)
+        {
+            mUnhedgedLotsDeadline = NO_DEADLINE;
+        }
+        if (newRelativePosition < -limit && -limit <= mRelativePosition)
+        {
+            mUnhedgedLotsDeadline = now + mConfig.mUnhedgedLotsTimeLimit;
+        }
+    }
+
+    mRelativePosition = newRelativePosition;
+}
+
+Order* Competitor::FindOrder(unsigned long clientOrderId) const
+{
+    for (Order* order : mOrders)
+    {
+        if (order->mClientOrderId == clientOrderId)
+        {
+            return order;
+        }
+    }
+    return nullptr;
+}
+
+void Competitor::RemoveOrder(Order& order)
+{
+    mOrders.erase(std::find(mOrders.begin(), mOrders.end(), &order));
+    mFinishedOrders.push_back(&order);
+}
+
+void Competitor::RemovePrice(Order& order)
+{
+    auto& prices = (order.mSide == Side::BUY) ? mBuyPrices : mSellPrices;
+    prices.erase(std::find(prices.begin(), prices.end(), order.mPrice));
+}
+
+void Competitor::ReleaseFinishedOrders()
+{
+    for (Order* order : mFinishedOrders)
+    {
+        mPool.Release(order);
+    }
+    mFinishedOrders.clear();
+}
+
+void Competitor::HardBreach(long now, unsigned long clientOrderId, std::string message)
+{
+    RLOG(LG_CMP, LogLevel::LL_INFO) << "hard breach at time=" << now << ": " << message;
+    mBreached = true;
+    if (mConnected)
+    {
+        mChannel.SendError(clientOrderId, std::move(message));
+        mChannel.Close();
+    }
+}
+
+void Competitor::OnConnectionLost(long now)
+{
+    mConnected = false;
+    const std::vector<Order*> orders{mOrders};
+    for (Order* order : orders)
+    {
+        mEtfBook.Cancel(now, *order);
+    }
+}
+
+void Competitor::OnTimerTick(long now, unsigned long futurePrice, unsigned long etfPrice)
+{
+    mAccount.Update(futurePrice, etfPrice);
+}
+
+void Competitor::OnUnhedgedLotsExpiry(long now)
+{
+    mUnhedgedLotsDeadline = NO_DEADLINE;
+    HardBreach(now, 0, "held unhedged lots for longer than the time limit");
+}
+
+void Competitor::OnOrderAmended(long now, Order& order, long volumeRemoved)
+{
+    if (mConnected)
+    {
+        mChannel.SendOrderStatus(order.mClientOrderId, order.mVolume - order.mRemainingVolume,
+                                 order.mRemainingVolume, order.mTotalFees);
+    }
+
+    mActiveVolume -= volumeRemoved;
+
+    if (order.mRemainingVolume == 0)
+    {
+        RemovePrice(order);
+        RemoveOrder(order);
+    }
+}
+
+void Competitor::OnOrderCancelled(long now, Order& order, long volumeRemoved)
+{
+    if (mConnected)
+    {
+        mChannel.SendOrderStatus(order.mClientOrderId, order.mVolume - volumeRemoved,
+                                 order.mRemainingVolume, order.mTotalFees);
+    }
+
+    mActiveVolume -= volumeRemoved;
+
+    RemovePrice(order);
+    RemoveOrder(order);
+}
+
+void Competitor::OnOrderPlaced(long now, Order& order)
+{
+    // Only send an order status if the order has not partially filled
+    if (order.mVolume == order.mRemainingVolume && mConnected)
+    {
+        mChannel.SendOrderStatus(order.mClientOrderId, 0, order.mRemainingVolume, order.mTotalFees);
+    }
+}
+
+void Competitor::OnOrderFilled(long now, Order& order, unsigned long price, long volume, long fee)
+{
+    mActiveVolume -= volume;
+
+    if (order.mRemainingVolume == 0)
+    {
+        // Like the exchange, assume the best priced order was the one filled.
+        if (order.mSide == Side::BUY)
+        {
+            mBuyPrices.pop_back();
+        }
+        else
+        {
+            mSellPrices.pop_back();
+        }
+        RemoveOrder(order);
+    }
+
+    ApplyPositionDelta(now, (order.mSide == Side::BUY) ? volume : -volume);
+
+    double lastTraded = mFutureBook.LastTradedPrice();
+    if (lastTraded == 0.0)
+    {
+        lastTraded = std::nearbyint(mFutureBook.MidpointPrice());
+    }
+    mAccount.Transact(Instrument::ETF, order.mSide, price, volume, fee);
+    mAccount.Update(lastTraded, price);
+
+    if (mConnected)
+    {
+        mChannel.SendOrderFilled(order.mClientOrderId, price, volume);
+        mChannel.SendOrderStatus(order.mClientOrderId, order.mVolume - order.mRemainingVolume,
+                                 order.mRemainingVolume, order.mTotalFees);
+    }
+
+    if (std::abs(mAccount.GetEtfPosition()) > mConfig.mPositionLimit)
+    {
+        HardBreach(now, order.mClientOrderId, "ETF position limit breached");
+    }
+}
+
+void Competitor::OnAmendMessage(long now, unsigned long clientOrderId, unsigned long volume)
+{
+    if (static_cast<long>(clientOrderId) > mLastClientOrderId)
+    {
+        mChannel.SendError(clientOrderId, "out-of-order client_order_id in amend message");
+        return;
+    }
+
+    if (Order* order = FindOrder(clientOrderId))
+    {
+        if (static_cast<long>(volume) > order->mVolume)
+        {
+            mChannel.SendError(clientOrderId, "amend operation would increase order volume");
+        }
+        else
+        {
+            mEtfBook.Amend(now, *order, volume);
+        }
+    }
+}
+
+void Competitor::OnCancelMessage(long now, unsigned long clientOrderId)
+{
+    if (static_cast<long>(clientOrderId) > mLastClientOrderId)
+    {
+        mChannel.SendError(clientOrderId, "out-of-order client_order_id in cancel message");
+        return;
+    }
+
+    if (Order* order = FindOrder(clientOrderId))
+    {
+        mEtfBook.Cancel(now, *order);
+    }
+}
+
+void Competitor::OnHedgeMessage(long now,
+                                unsigned long clientOrderId,
+                                Side side,
+                                unsigned long price,
+                                unsigned long volume)
+{
+    if (static_cast<long>(clientOrderId) <= mLastClientOrderId)
+    {
+        mChannel.SendError(clientOrderId, "duplicate or out-of-order client_order_id");
+        return;
+    }
+
+    mLastClientOrderId = clientOrderId;
+
+    if (side != Side::BUY && side != Side::SELL)
+    {
+        mChannel.SendError(clientOrderId, std::to_string(static_cast<int>(side)) + " is not a valid side");
+        return;
+    }
+
+    if (price < MINIMUM_BID || price > MAXIMUM_ASK)
+    {
+        mChannel.SendError(clientOrderId, std::to_string(price) + " is not a valid price");
+        return;
+    }
+
+    if (price % mConfig.mTickSize != 0)
+    {
+        mChannel.SendError(clientOrderId, "price is not a multiple of tick size");
+        return;
+    }
+
+    if (volume < 1)
+    {
+        mChannel.SendError(clientOrderId, std::to_string(volume) + " is not a valid volume");
+        return;
+    }
+
+    if (now == 0)
+    {
+        mChannel.SendError(clientOrderId, "order rejected: market not yet open");
+        return;
+    }
+
+    auto [volumeTraded, averagePrice] = mFutureBook.TryTrade(side, price, volume);
+    if (volumeTraded == 0)
+    {
+        // The trade could have failed because there were no orders on the opposite side
+        const unsigned long best = (side == Side::BUY) ? mFutureBook.BestAsk() : mFutureBook.BestBid();
+        if (best == 0)
+        {
+            const unsigned long lastTraded = mFutureBook.LastTradedPrice();
+            if (lastTraded == 0)
+            {
+                mChannel.SendError(clientOrderId, "order rejected: cannot determine future price");
+                return;
+            }
+            if ((side == Side::SELL && lastTraded >= price) || (side == Side::BUY && lastTraded <= price))
+            {
+                averagePrice = lastTraded;
+            }
+        }
+    }
+
+    if (averagePrice == 0)
+    {
+        if (mConnected)
+        {
+            mChannel.SendHedgeFilled(clientOrderId, 0, 0);
+        }
+        return;
+    }
+
+    const long lots = static_cast<long>(volume);
+    ApplyPositionDelta(now, (side == Side::BUY) ? lots : -lots);
+    mAccount.Transact(Instrument::FUTURE, side, averagePrice, lots, 0);
+
+    const unsigned long futureLast = mFutureBook.LastTradedPrice();
+    const unsigned long etfLast = mEtfBook.LastTradedPrice();
+    mAccount.Update(futureLast ? futureLast : mFutureBook.MidpointPrice(),
+                    etfLast ? etfLast : mEtfBook.MidpointPrice());
+
+    if (mConnected)
+    {
+        mChannel.SendHedgeFilled(clientOrderId, averagePrice, lots);
+    }
+
+    if (std::abs(mAccount.GetFuturePosition()) > mConfig.mPositionLimit)
+    {
+        HardBreach(now, clientOrderId, "future position limit breached");
+    }
+}
+
+void Competitor::OnInsertMessage(long now,
+                                 unsigned long clientOrderId,
+                                 Side side,
+                                 unsigned long price,
+                                 unsigned long volume,
+                                 Lifespan lifespan)
+{
+    if (static_cast<long>(clientOrderId) <= mLastClientOrderId)
+    {
+        mChannel.SendError(clientOrderId, "duplicate or out-of-order client_order_id");
+        return;
+    }
+
+    mLastClientOrderId = clientOrderId;
+
+    if (side != Side::BUY && side != Side::SELL)
+    {
+        mChannel.SendError(clientOrderId, std::to_string(static_cast<int>(side)) + " is not a valid side");
+        return;
+    }
+
+    if (lifespan != Lifespan::FILL_AND_KILL && lifespan != Lifespan::GOOD_FOR_DAY)
+    {
+        mChannel.SendError(clientOrderId, std::to_string(static_cast<int>(lifespan)) + " is not a valid lifespan");
+        return;
+    }
+
+    if (price < MINIMUM_BID || price > MAXIMUM_ASK)
+    {
+        mChannel.SendError(clientOrderId, std::to_string(price) + " is not a valid price");
+        return;
+    }
+
+    if (price % mConfig.mTickSize != 0)
+    {
+        mChannel.SendError(clientOrderId, "price is not a multiple of tick size");
+        return;
+    }
+
+    if (static_cast<long>(mOrders.size()) == mConfig.mActiveOrderCountLimit)
+    {
+        mChannel.SendError(clientOrderId, "order rejected: active order count limit breached");
+        return;
+    }
+
+    if (volume < 1)
+    {
+        // The exchange sends this message without formatting it.
+        mChannel.SendError(clientOrderId, "%d is not a valid volume");
+        return;
+    }
+
+    if (mActiveVolume + static_cast<long>(volume) > mConfig.mActiveVolumeLimit)
+    {
+        mChannel.SendError(clientOrderId, "order rejected: active order volume limit breached");
+        return;
+    }
+
+    if (now == 0)
+    {
+        mChannel.SendError(clientOrderId, "order rejected: market not yet open");
+        return;
+    }
+
+    if ((side == Side::BUY && !mSellPrices.empty() && price >= mSellPrices.back())
+        || (side == Side::SELL && !mBuyPrices.empty() && price <= mBuyPrices.back()))
+    {
+        mChannel.SendError(clientOrderId, "order rejected: in cross with an existing order");
+        return;
+    }
+
+    Order* order = mPool.Allocate();
+    order->mClientOrderId = clientOrderId;
+    order->mInstrument = Instrument::ETF;
+    order->mLifespan = lifespan;
+    order->mSide = side;
+    order->mPrice = price;
+    order->mVolume = order->mRemainingVolume = static_cast<long>(volume);
+    order->mListener = this;
+    mOrders.push_back(order);
+
+    if (side == Side::BUY)
+    {
+        mBuyPrices.insert(std::upper_bound(mBuyPrices.begin(), mBuyPrices.end(), price), price);
+    }
+    else
+    {
+        mSellPrices.insert(std::upper_bound(mSellPrices.begin(), mSellPrices.end(), price, std::greater<>()),
+                           price);
+    }
+
+    mActiveVolume += order->mVolume;
+    mEtfBook.Insert(now, *order);
+}
+
+}
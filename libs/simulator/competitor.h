@@ -0,0 +1,123 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_SIMULATOR_COMPETITOR_H
+#define CPPREADY_TRADER_GO_LIBS_SIMULATOR_COMPETITOR_H
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <ready_trader_go/types.h>
+
+#include "account.h"
+#include "orderbook.h"
+#include "simulatorconfig.h"
+
+namespace ReadyTraderGo {
+
+constexpr long NO_DEADLINE = std::numeric_limits<long>::max();
+
+// The exchange's side of a competitor's execution connection.
+struct IExecutionChannel
+{
+    virtual ~IExecutionChannel() = default;
+    virtual void Close() = 0;
+    virtual void SendError(unsigned long clientOrderId, std::string message) = 0;
+    virtual void SendHedgeFilled(unsigned long clientOrderId, unsigned long averagePrice, long volume) = 0;
+    virtual void SendOrderFilled(unsigned long clientOrderId, unsigned long price, long volume) = 0;
+    virtual void SendOrderStatus(unsigned long clientOrderId, long fillVolume, long remainingVolume, long fees) = 0;
+};
+
+// A competitor in a simulated match. Requests are validated and executed
+// exactly as the exchange simulator's Competitor class does, including
+// its limits and breaches.
+class Competitor : public IOrderListener
+{
+public:
+    Competitor(IExecutionChannel& channel,
+               OrderBook& etfBook,
+               OrderBook& futureBook,
+               OrderPool& pool,
+               const SimulatorConfig& config);
+
+    Competitor(const Competitor&) = delete;
+    void operator=(const Competitor&) = delete;
+
+    const CompetitorAccount& GetAccount() const { return mAccount; }
+    std::size_t GetActiveOrderCount() const { return mOrders.size(); }
+    bool IsBreached() const { return mBreached; }
+    // Time at which unhedged lots will breach, or NO_DEADLINE.
+    long GetUnhedgedLotsDeadline() const { return mUnhedgedLotsDeadline; }
+
+    void HardBreach(long now, unsigned long clientOrderId, std::string message);
+    void OnConnectionLost(long now);
+    void OnTimerTick(long now, unsigned long futurePrice, unsigned long etfPrice);
+    void OnUnhedgedLotsExpiry(long now);
+
+    // Message callbacks
+    void OnAmendMessage(long now, unsigned long clientOrderId, unsigned long volume);
+    void OnCancelMessage(long now, unsigned long clientOrderId);
+    void OnHedgeMessage(long now, unsigned long clientOrderId, Side side, unsigned long price, unsigned long volume);
+    void OnInsertMessage(long now,
+                         unsigned long clientOrderId,
+                         Side side,
+                         unsigned long price,
+                         unsigned long volume,
+                         Lifespan lifespan);
+
+    // Return orders that are no longer active to the pool. Must not be
+    // called while an order book operation is in progress.
+    void ReleaseFinishedOrders();
+
+    // IOrderListener callbacks
+    void OnOrderAmended(long now, Order& order, long volumeRemoved) override;
+    void OnOrderCancelled(long now, Order& order, long volumeRemoved) override;
+    void OnOrderPlaced(long now, Order& order) override;
+    void OnOrderFilled(long now, Order& order, unsigned long price, long volume, long fee) override;
+
+private:
+    void ApplyPositionDelta(long now, long delta);
+    Order* FindOrder(unsigned long clientOrderId) const;
+    void RemoveOrder(Order& order);
+    void RemovePrice(Order& order);
+
+    IExecutionChannel& mChannel;
+    OrderBook& mEtfBook;
+    OrderBook& mFutureBook;
+    OrderPool& mPool;
+    const SimulatorConfig& mConfig;
+    CompetitorAccount mAccount;
+
+    long mActiveVolume = 0;
+    bool mBreached = false;
+    bool mConnected = true;
+    long mLastClientOrderId = -1;
+    long mRelativePosition = 0;
+    long mUnhedgedLotsDeadline = NO_DEADLINE;
+
+    std::vector<Order*> mOrders;
+    std::vector<Order*> mFinishedOrders;
+    // Ascending buy prices and descending sell prices, so that the best of
+    // each is at the back.
+    std::vector<unsigned long> mBuyPrices;
+    std::vector<unsigned long> mSellPrices;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_SIMULATOR_COMPETITOR_H
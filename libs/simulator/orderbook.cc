@@ -0,0 +1,430 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include <ready_trader_go/error.h>
+
+#include "orderbook.h"
+
+namespace ReadyTraderGo {
+
+// Number of levels initially allocated and the most the array may grow to.
+constexpr std::size_t INITIAL_LEVEL_COUNT = 4096;
+constexpr std::size_t MAXIMUM_LEVEL_COUNT = 1 << 22;
+
+static long calculateFee(unsigned long price, long volume, double feeRate)
+{
+    // std::nearbyint rounds halves to even, just like Python's round().
+    return static_cast<long>(std::nearbyint(static_cast<double>(price * volume) * feeRate));
+}
+
+static void recordTick(std::vector<std::pair<unsigned long, unsigned long>>& ticks, unsigned long price, long volume)
+{
+    for (auto& tick : ticks)
+    {
+        if (tick.first == price)
+        {
+            tick.second += volume;
+            return;
+        }
+    }
+    ticks.emplace_back(price, volume);
+}
+
+Order* OrderPool::Allocate()
+{
+    if (!mFree)
+    {
+        mBlocks.emplace_back(new Order[BLOCK_SIZE]);
+        Order* block = mBlocks.back().get();
+        for (std::size_t i = 0; i < BLOCK_SIZE; ++i)
+        {
+            Release(block + i);
+        }
+    }
+
+    Order* order = mFree;
+    mFree = order->mNext;
+    *order = Order{};
+    return order;
+}
+
+OrderBook::OrderBook(Instrument instrument, double makerFee, double takerFee, unsigned long tickSize)
+    : mInstrument(instrument), mMakerFee(makerFee), mTakerFee(takerFee), mTickSize(tickSize)
+{
+    if (mTickSize == 0)
+    {
+        throw ReadyTraderGoError("order book tick size must be positive");
+    }
+}
+
+long OrderBook::PriceToTick(unsigned long price) const
+{
+    if (price % mTickSize != 0)
+    {
+        throw ReadyTraderGoError("price " + std::to_string(price) + " is not a multiple of the tick size");
+    }
+    return static_cast<long>(price / mTickSize);
+}
+
+void OrderBook::EnsureTick(long tick)
+{
+    const long size = static_cast<long>(mLevels.size());
+    if (size == 0)
+    {
+        mFirstTick = std::max(0L, tick - static_cast<long>(INITIAL_LEVEL_COUNT / 2));
+        mLevels.resize(INITIAL_LEVEL_COUNT);
+        return;
+    }
+    if (tick >= mFirstTick && tick < mFirstTick + size)
+    {
+        return;
+    }
+
+    const long low = std::min(mFirstTick, tick);
+    const long high = std::max(mFirstTick + size - 1, tick);
+    const long span = high - low + 1;
+    const long newSize = std::max(size * 2, span + size);
+    if (static_cast<std::size_t>(newSize) > MAXIMUM_LEVEL_COUNT)
+    {
+        throw ReadyTraderGoError("order book price range is too wide");
+    }
+
+    const long newFirstTick = std::max(0L, low - (newSize - span) / 2);
+    std::vector<PriceLevel> levels(newSize);
+    std::copy(mLevels.begin(), mLevels.end(), levels.begin() + (mFirstTick - newFirstTick));
+    mLevels.swap(levels);
+    mFirstTick = newFirstTick;
+}
+
+long OrderBook::NextAsk(long tick) const
+{
+    const long end = mFirstTick + static_cast<long>(mLevels.size());
+    for (tick = std::max(tick, mFirstTick); tick < end; ++tick)
+    {
+        if (Level(tick).mHead)
+        {
+            return tick;
+        }
+    }
+    return -1;
+}
+
+long OrderBook::NextBid(long tick) const
+{
+    for (tick = std::min(tick, mFirstTick + static_cast<long>(mLevels.size()) - 1); tick >= mFirstTick; --tick)
+    {
+        if (Level(tick).mHead)
+        {
+            return tick;
+        }
+    }
+    return -1;
+}
+
+double OrderBook::MidpointPrice() const
+{
+    if (mBestAsk >= 0 && mBestBid >= 0)
+    {
+        return static_cast<double>(TickToPrice(mBestBid) + TickToPrice(mBestAsk)) / 2.0;
+    }
+    return 0.0;
+}
+
+void OrderBook::Amend(long now, Order& order, long newVolume)
+{
+    if (order.mRemainingVolume > 0)
+    {
+        const long fillVolume = order.mVolume - order.mRemainingVolume;
+        const long diff = order.mVolume - ((newVolume < fillVolume) ? fillVolume : newVolume);
+        order.mVolume -= diff;
+        RemoveVolume(order, diff);
+        if (order.mListener)
+        {
+            order.mListener->OnOrderAmended(now, order, diff);
+        }
+    }
+}
+
+void OrderBook::Cancel(long now, Order& order)
+{
+    if (order.mRemainingVolume > 0)
+    {
+        const long remaining = order.mRemainingVolume;
+        RemoveVolume(order, remaining);
+        if (order.mListener)
+        {
+            order.mListener->OnOrderCancelled(now, order, remaining);
+        }
+    }
+}
+
+void OrderBook::Insert(long now, Order& order)
+{
+    const long tick = PriceToTick(order.mPrice);
+
+    if (order.mSide == Side::SELL)
+    {
+        while (order.mRemainingVolume > 0 && mBestBid >= tick)
+        {
+            TradeLevel(now, order, mBestBid);
+        }
+    }
+    else
+    {
+        while (order.mRemainingVolume > 0 && mBestAsk >= 0 && mBestAsk <= tick)
+        {
+            TradeLevel(now, order, mBestAsk);
+        }
+    }
+
+    if (order.mRemainingVolume > 0)
+    {
+        if (order.mLifespan == Lifespan::FILL_AND_KILL)
+        {
+            const long remaining = order.mRemainingVolume;
+            order.mRemainingVolume = 0;
+            if (order.mListener)
+            {
+                order.mListener->OnOrderCancelled(now, order, remaining);
+            }
+        }
+        else
+        {
+            Place(now, order, tick);
+        }
+    }
+}
+
+void OrderBook::Place(long now, Order& order, long tick)
+{
+    EnsureTick(tick);
+    PriceLevel& level = Level(tick);
+
+    if (!level.mHead)
+    {
+        if (order.mSide == Side::SELL)
+        {
+            ++mAskLevelCount;
+            if (mBestAsk < 0 || tick < mBestAsk)
+            {
+                mBestAsk = tick;
+            }
+        }
+        else
+        {
+            ++mBidLevelCount;
+            if (tick > mBestBid)
+            {
+                mBestBid = tick;
+            }
+        }
+    }
+
+    order.mPrev = level.mTail;
+    order.mNext = nullptr;
+    if (level.mTail)
+    {
+        level.mTail->mNext = &order;
+    }
+    else
+    {
+        level.mHead = &order;
+    }
+    level.mTail = &order;
+    level.mTotalVolume += order.mRemainingVolume;
+
+    if (order.mListener)
+    {
+        order.mListener->OnOrderPlaced(now, order);
+    }
+}
+
+void OrderBook::RemoveOrder(Order& order, long tick)
+{
+    PriceLevel& level = Level(tick);
+    (order.mPrev ? order.mPrev->mNext : level.mHead) = order.mNext;
+    (order.mNext ? order.mNext->mPrev : level.mTail) = order.mPrev;
+    order.mPrev = order.mNext = nullptr;
+
+    if (!level.mHead)
+    {
+        if (order.mSide == Side::SELL)
+        {
+            mBestAsk = (--mAskLevelCount == 0) ? -1 : (tick == mBestAsk ? NextAsk(tick + 1) : mBestAsk);
+        }
+        else
+        {
+            mBestBid = (--mBidLevelCount == 0) ? -1 : (tick == mBestBid ? NextBid(tick - 1) : mBestBid);
+        }
+    }
+}
+
+void OrderBook::RemoveVolume(Order& order, long volume)
+{
+    const long tick = PriceToTick(order.mPrice);
+    Level(tick).mTotalVolume -= volume;
+    order.mRemainingVolume -= volume;
+    if (order.mRemainingVolume == 0)
+    {
+        RemoveOrder(order, tick);
+    }
+}
+
+void OrderBook::TradeLevel(long now, Order& order, long tick)
+{
+    PriceLevel& level = Level(tick);
+    const unsigned long price = TickToPrice(tick);
+    long remaining = order.mRemainingVolume;
+
+    // Filled passive orders are unlinked before their listener is told, so
+    // a listener may release them straight away.
+    while (remaining > 0 && level.mHead)
+    {
+        Order& passive = *level.mHead;
+        const long volume = (remaining < passive.mRemainingVolume) ? remaining : passive.mRemainingVolume;
+        const long fee = calculateFee(price, volume, mMakerFee);
+        level.mTotalVolume -= volume;
+        remaining -= volume;
+        passive.mRemainingVolume -= volume;
+        passive.mTotalFees += fee;
+        if (passive.mRemainingVolume == 0)
+        {
+            RemoveOrder(passive, tick);
+        }
+        if (passive.mListener)
+        {
+            passive.mListener->OnOrderFilled(now, passive, price, volume, fee);
+        }
+    }
+
+    const long traded = order.mRemainingVolume - remaining;
+    recordTick((order.mSide == Side::BUY) ? mAskTicks : mBidTicks, price, traded);
+
+    const long fee = calculateFee(price, traded, mTakerFee);
+    order.mRemainingVolume = remaining;
+    order.mTotalFees += fee;
+    if (order.mListener)
+    {
+        order.mListener->OnOrderFilled(now, order, price, traded, fee);
+    }
+
+    mLastTradedPrice = price;
+    if (TradeOccurred)
+    {
+        TradeOccurred(*this);
+    }
+}
+
+void OrderBook::TopLevels(PriceLevels& askPrices,
+                          VolumeLevels& askVolumes,
+                          PriceLevels& bidPrices,
+                          VolumeLevels& bidVolumes) const
+{
+    askPrices.fill(Price());
+    askVolumes.fill(Volume());
+    bidPrices.fill(Price());
+    bidVolumes.fill(Volume());
+
+    long tick = mBestAsk;
+    for (std::size_t i = 0; i < TOP_LEVEL_COUNT && i < mAskLevelCount; ++i, ++tick)
+    {
+        tick = NextAsk(tick);
+        askPrices[i] = Price(TickToPrice(tick));
+        askVolumes[i] = Volume(Level(tick).mTotalVolume);
+    }
+
+    tick = mBestBid;
+    for (std::size_t i = 0; i < TOP_LEVEL_COUNT && i < mBidLevelCount; ++i, --tick)
+    {
+        tick = NextBid(tick);
+        bidPrices[i] = Price(TickToPrice(tick));
+        bidVolumes[i] = Volume(Level(tick).mTotalVolume);
+    }
+}
+
+bool OrderBook::TradeTicks(PriceLevels& askPrices,
+                           VolumeLevels& askVolumes,
+                           PriceLevels& bidPrices,
+                           VolumeLevels& bidVolumes)
+{
+    if (mAskTicks.empty() && mBidTicks.empty())
+    {
+        return false;
+    }
+
+    std::sort(mAskTicks.begin(), mAskTicks.end());
+    std::sort(mBidTicks.begin(), mBidTicks.end(), std::greater<>());
+
+    for (std::size_t i = 0; i < TOP_LEVEL_COUNT; ++i)
+    {
+        askPrices[i] = (i < mAskTicks.size()) ? Price(mAskTicks[i].first) : Price();
+        askVolumes[i] = (i < mAskTicks.size()) ? Volume(mAskTicks[i].second) : Volume();
+        bidPrices[i] = (i < mBidTicks.size()) ? Price(mBidTicks[i].first) : Price();
+        bidVolumes[i] = (i < mBidTicks.size()) ? Volume(mBidTicks[i].second) : Volume();
+    }
+
+    mAskTicks.clear();
+    mBidTicks.clear();
+    return true;
+}
+
+std::pair<long, unsigned long> OrderBook::TryTrade(Side side, unsigned long limitPrice, long volume) const
+{
+    long totalVolume = 0;
+    unsigned long totalValue = 0;
+
+    if (side == Side::SELL)
+    {
+        long tick = mBestBid;
+        for (std::size_t i = 0; i < mBidLevelCount && totalVolume < volume; ++i, --tick)
+        {
+            tick = NextBid(tick);
+            const unsigned long price = TickToPrice(tick);
+            if (price < limitPrice)
+            {
+                break;
+            }
+            const long weight = std::min(volume - totalVolume, Level(tick).mTotalVolume);
+            totalVolume += weight;
+            totalValue += weight * price;
+        }
+    }
+    else
+    {
+        long tick = mBestAsk;
+        for (std::size_t i = 0; i < mAskLevelCount && totalVolume < volume; ++i, ++tick)
+        {
+            tick = NextAsk(tick);
+            const unsigned long price = TickToPrice(tick);
+            if (price > limitPrice)
+            {
+                break;
+            }
+            const long weight = std::min(volume - totalVolume, Level(tick).mTotalVolume);
+            totalVolume += weight;
+            totalValue += weight * price;
+        }
+    }
+
+    return {totalVolume, totalVolume > 0 ? totalValue / totalVolume : 0};
+}
+
+}
@@ -0,0 +1,176 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_SIMULATOR_ORDERBOOK_H
+#define CPPREADY_TRADER_GO_LIBS_SIMULATOR_ORDERBOOK_H
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <ready_trader_go/price.h>
+#include <ready_trader_go/types.h>
+
+namespace ReadyTraderGo {
+
+struct Order;
+
+// Receives notifications about an order's progress. Times are in
+// microseconds since the market opened.
+struct IOrderListener
+{
+    virtual ~IOrderListener() = default;
+    virtual void OnOrderAmended(long now, Order& order, long volumeRemoved) {}
+    virtual void OnOrderCancelled(long now, Order& order, long volumeRemoved) {}
+    virtual void OnOrderPlaced(long now, Order& order) {}
+    virtual void OnOrderFilled(long now, Order& order, unsigned long price, long volume, long fee) {}
+};
+
+// A request to buy or sell at a given price. Resting orders are linked into
+// the queue of their price level.
+struct Order
+{
+    unsigned long mClientOrderId = 0;
+    Instrument mInstrument = Instrument::FUTURE;
+    Lifespan mLifespan = Lifespan::GOOD_FOR_DAY;
+    Side mSide = Side::SELL;
+    unsigned long mPrice = 0;
+    long mVolume = 0;
+    long mRemainingVolume = 0;
+    long mTotalFees = 0;
+    IOrderListener* mListener = nullptr;
+
+    Order* mPrev = nullptr;
+    Order* mNext = nullptr;
+};
+
+// A free list of orders allocated in blocks, so that inserting an order
+// never touches the heap once the pool has grown to the working set.
+class OrderPool
+{
+public:
+    OrderPool() = default;
+    OrderPool(const OrderPool&) = delete;
+    void operator=(const OrderPool&) = delete;
+
+    Order* Allocate();
+    void Release(Order* order)
+    {
+        order->mNext = mFree;
+        mFree = order;
+    }
+
+private:
+    static constexpr std::size_t BLOCK_SIZE = 1024;
+
+    std::vector<std::unique_ptr<Order[]>> mBlocks;
+    Order* mFree = nullptr;
+};
+
+// A collection of orders arranged by the price-time priority principle with
+// the same semantics as the exchange simulator's order book.
+//
+// Price levels are held in a flat array indexed by tick, which grows to
+// cover whatever range of prices is seen. Each level holds an intrusive,
+// first-in-first-out list of its orders.
+class OrderBook
+{
+public:
+    OrderBook(Instrument instrument, double makerFee, double takerFee, unsigned long tickSize);
+
+    OrderBook(const OrderBook&) = delete;
+    void operator=(const OrderBook&) = delete;
+
+    // Decrease the volume of a resting order.
+    void Amend(long now, Order& order, long newVolume);
+    // Cancel a resting order.
+    void Cancel(long now, Order& order);
+    // Match a new order against this book and place or cancel any remainder.
+    void Insert(long now, Order& order);
+
+    // Prices are zero if there is no order on that side.
+    unsigned long BestAsk() const { return mBestAsk >= 0 ? TickToPrice(mBestAsk) : 0; }
+    unsigned long BestBid() const { return mBestBid >= 0 ? TickToPrice(mBestBid) : 0; }
+    Instrument GetInstrument() const { return mInstrument; }
+    // Zero if there have been no trades.
+    unsigned long LastTradedPrice() const { return mLastTradedPrice; }
+    // Zero unless there are orders on both sides.
+    double MidpointPrice() const;
+
+    void TopLevels(PriceLevels& askPrices,
+                   VolumeLevels& askVolumes,
+                   PriceLevels& bidPrices,
+                   VolumeLevels& bidVolumes) const;
+
+    // Populate the arrays with the volume traded at each price since the
+    // last call and return true, or return false if there were no trades.
+    bool TradeTicks(PriceLevels& askPrices,
+                    VolumeLevels& askVolumes,
+                    PriceLevels& bidPrices,
+                    VolumeLevels& bidVolumes);
+
+    // Return the volume that would trade and the average price per lot
+    // without changing the book.
+    std::pair<long, unsigned long> TryTrade(Side side, unsigned long limitPrice, long volume) const;
+
+    // Called after each aggressive fill.
+    std::function<void(OrderBook&)> TradeOccurred;
+
+private:
+    struct PriceLevel
+    {
+        Order* mHead = nullptr;
+        Order* mTail = nullptr;
+        long mTotalVolume = 0;
+    };
+
+    long PriceToTick(unsigned long price) const;
+    unsigned long TickToPrice(long tick) const { return static_cast<unsigned long>(tick) * mTickSize; }
+    PriceLevel& Level(long tick) { return mLevels[tick - mFirstTick]; }
+    const PriceLevel& Level(long tick) const { return mLevels[tick - mFirstTick]; }
+
+    void EnsureTick(long tick);
+    long NextAsk(long tick) const;
+    long NextBid(long tick) const;
+    void Place(long now, Order& order, long tick);
+    void RemoveOrder(Order& order, long tick);
+    void RemoveVolume(Order& order, long volume);
+    void TradeLevel(long now, Order& order, long tick);
+
+    Instrument mInstrument;
+    double mMakerFee;
+    double mTakerFee;
+    unsigned long mTickSize;
+
+    std::vector<PriceLevel> mLevels;
+    long mFirstTick = 0;
+    long mBestAsk = -1;
+    long mBestBid = -1;
+    std::size_t mAskLevelCount = 0;
+    std::size_t mBidLevelCount = 0;
+    unsigned long mLastTradedPrice = 0;
+
+    std::vector<std::pair<unsigned long, unsigned long>> mAskTicks;
+    std::vector<std::pair<unsigned long, unsigned long>> mBidTicks;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_SIMULATOR_ORDERBOOK_H
@@ -0,0 +1,526 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <ready_trader_go/error.h>
+#include <ready_trader_go/logging.h>
+#include <ready_trader_go/protocol.h>
+
+#include "simulator.h"
+
+RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_SIM, "SIMULATOR")
+
+namespace ReadyTraderGo {
+
+// Marks the point in the outbound queue at which the connection closes.
+constexpr unsigned char DISCONNECT_MESSAGE_TYPE = 0;
+
+void SimulatorConnection::SendMessage(unsigned char messageType, const ISerialisable& serialisable, SendMode)
+{
+    SimulatorRequest& request = mRequests.emplace_back();
+    request.mMessageType = messageType;
+    switch (messageType)
+    {
+    case MessageType::AMEND_ORDER:
+    {
+        auto& amend = static_cast<const AmendMessage&>(serialisable);
+        request.mClientOrderId = amend.mClientOrderId;
+        request.mVolume = amend.mNewVolume.Lots();
+        break;
+    }
+    case MessageType::CANCEL_ORDER:
+        request.mClientOrderId = static_cast<const CancelMessage&>(serialisable).mClientOrderId;
+        break;
+    case MessageType::HEDGE_ORDER:
+    {
+        auto& hedge = static_cast<const HedgeMessage&>(serialisable);
+        request.mClientOrderId = hedge.mClientOrderId;
+        request.mSide = hedge.mSide;
+        request.mPrice = hedge.mPrice.Cents();
+        request.mVolume = hedge.mVolume.Lots();
+        break;
+    }
+    case MessageType::INSERT_ORDER:
+    {
+        auto& insert = static_cast<const InsertMessage&>(serialisable);
+        request.mClientOrderId = insert.mClientOrderId;
+        request.mSide = insert.mSide;
+        request.mPrice = insert.mPrice.Cents();
+        request.mVolume = insert.mVolume.Lots();
+        request.mLifespan = insert.mLifespan;
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+Order* Simulator::MarketOrders::Find(Instrument instrument, std::uint64_t orderId)
+{
+    auto& orders = mOrders[static_cast<std::size_t>(instrument)];
+    auto it = orders.find(orderId);
+    return (it != orders.end()) ? it->second : nullptr;
+}
+
+void Simulator::MarketOrders::Finish(Order& order)
+{
+    auto& orders = mOrders[static_cast<std::size_t>(order.mInstrument)];
+    auto it = orders.find(order.mClientOrderId);
+    if (it != orders.end() && it->second == &order)
+    {
+        orders.erase(it);
+        mFinishedOrders.push_back(&order);
+    }
+}
+
+void Simulator::MarketOrders::ReleaseFinishedOrders()
+{
+    for (Order* order : mFinishedOrders)
+    {
+        mPool.Release(order);
+    }
+    mFinishedOrders.clear();
+}
+
+void Simulator::MarketOrders::OnOrderAmended(long, Order& order, long)
+{
+    if (order.mRemainingVolume == 0)
+    {
+        Finish(order);
+    }
+}
+
+void Simulator::MarketOrders::OnOrderCancelled(long, Order& order, long)
+{
+    Finish(order);
+}
+
+void Simulator::MarketOrders::OnOrderPlaced(long, Order& order)
+{
+    mOrders[static_cast<std::size_t>(order.mInstrument)][order.mClientOrderId] = &order;
+}
+
+void Simulator::MarketOrders::OnOrderFilled(long, Order& order, unsigned long, long, long)
+{
+    if (order.mRemainingVolume == 0)
+    {
+        Finish(order);
+    }
+}
+
+Simulator::Simulator(BaseAutoTrader& autoTrader, const ColumnarEvents& events, SimulatorConfig config)
+    : mAutoTrader(autoTrader),
+      mEvents(events),
+      mConfig(config),
+      mFutureBook(Instrument::FUTURE, 0.0, 0.0, mConfig.mTickSize),
+      mEtfBook(Instrument::ETF, mConfig.mMakerFee, mConfig.mTakerFee, mConfig.mTickSize),
+      mMarketOrders(mPool),
+      mCompetitor(*this, mEtfBook, mFutureBook, mPool, mConfig)
+{
+    if (mConfig.mMarketEventInterval <= 0 || mConfig.mTickInterval <= 0)
+    {
+        throw ReadyTraderGoError("simulator timer intervals must be positive");
+    }
+
+    mFutureBook.TradeOccurred = [this](OrderBook& book) { OnTrade(book); };
+    mEtfBook.TradeOccurred = [this](OrderBook& book) { OnTrade(book); };
+    mPendingTradeTicks.reserve(2);
+    mOutbound.reserve(64);
+
+    mAutoTrader.SetClock(mClock);
+
+    auto connection = std::make_unique<SimulatorConnection>();
+    mConnection = connection.get();
+    mConnection->GetRequests().reserve(64);
+    mAutoTrader.SetExecutionConnection(std::move(connection));
+
+    mSubscription = std::make_shared<SimulatorSubscription>();
+    mAutoTrader.SetInformationSubscription(std::shared_ptr<ISubscription>(mSubscription));
+}
+
+void Simulator::Close()
+{
+    if (!mClosing)
+    {
+        mClosing = true;
+        PendingMessage& pending = mOutbound.emplace_back();
+        pending.mInformation = false;
+        pending.mMessageType = DISCONNECT_MESSAGE_TYPE;
+        pending.mSize = 0;
+    }
+}
+
+void Simulator::Enqueue(bool information, unsigned char messageType, const ISerialisable& message)
+{
+    PendingMessage& pending = mOutbound.emplace_back();
+    pending.mInformation = information;
+    pending.mMessageType = messageType;
+    pending.mSize = static_cast<unsigned char>(message.Size());
+    message.Serialise(pending.mData.data());
+}
+
+void Simulator::SendError(unsigned long clientOrderId, std::string message)
+{
+    if (!mClosing)
+    {
+        ++mResult.mErrorCount;
+        Enqueue(false, MessageType::ERROR_MESSAGE, ErrorMessage{clientOrderId, std::move(message)});
+    }
+}
+
+void Simulator::SendHedgeFilled(unsigned long clientOrderId, unsigned long averagePrice, long volume)
+{
+    if (!mClosing)
+    {
+        const long position = std::labs(mCompetitor.GetAccount().GetFuturePosition());
+        mResult.mMaxFuturePosition = std::max(mResult.mMaxFuturePosition, position);
+        Enqueue(false, MessageType::HEDGE_FILLED,
+                HedgeFilledMessage{clientOrderId, Price(averagePrice), Volume(static_cast<unsigned long>(volume))});
+    }
+}
+
+void Simulator::SendOrderFilled(unsigned long clientOrderId, unsigned long price, long volume)
+{
+    if (!mClosing)
+    {
+        ++mResult.mFillCount;
+        mResult.mFillVolume += volume;
+        const long position = std::labs(mCompetitor.GetAccount().GetEtfPosition());
+        mResult.mMaxEtfPosition = std::max(mResult.mMaxEtfPosition, position);
+        Enqueue(false, MessageType::ORDER_FILLED,
+                OrderFilledMessage{clientOrderId, Price(price), Volume(static_cast<unsigned long>(volume))});
+    }
+}
+
+void Simulator::SendOrderStatus(unsigned long clientOrderId, long fillVolume, long remainingVolume, long fees)
+{
+    if (!mClosing)
+    {
+        Enqueue(false, MessageType::ORDER_STATUS,
+                OrderStatusMessage{clientOrderId, Volume(static_cast<unsigned long>(fillVolume)),
+                                   Volume(static_cast<unsigned long>(remainingVolume)), fees});
+    }
+}
+
+bool Simulator::CheckMessageFrequency()
+{
+    // Equivalent to the exchange's FrequencyLimiter, but with exact times.
+    mMessageTimes.push_back(mNow);
+    const long windowStart = mNow - mConfig.mMessageFrequencyInterval;
+    while (mMessageTimes[mMessageTimesHead] <= windowStart)
+    {
+        ++mMessageTimesHead;
+    }
+    if (mMessageTimesHead > 1024)
+    {
+        mMessageTimes.erase(mMessageTimes.begin(), mMessageTimes.begin() + mMessageTimesHead);
+        mMessageTimesHead = 0;
+    }
+    return static_cast<long>(mMessageTimes.size() - mMessageTimesHead) > mConfig.mMessageFrequencyLimit;
+}
+
+void Simulator::HandleRequest(const SimulatorRequest& request)
+{
+    if (mClosing)
+    {
+        return;
+    }
+
+    ++mResult.mMessageCount;
+
+    if (CheckMessageFrequency())
+    {
+        if (mLoggedIn)
+        {
+            mCompetitor.HardBreach(mNow, 0, "message frequency limit breached");
+        }
+        else
+        {
+            Close();
+        }
+        return;
+    }
+
+    if (!mLoggedIn)
+    {
+        if (request.mMessageType == MessageType::LOGIN)
+        {
+            mLoggedIn = true;
+        }
+        else
+        {
+            RLOG(LG_SIM, LogLevel::LL_INFO) << "first message received was not a login";
+            Close();
+        }
+        return;
+    }
+
+    switch (request.mMessageType)
+    {
+    case MessageType::AMEND_ORDER:
+        ++mResult.mAmendCount;
+        mCompetitor.OnAmendMessage(mNow, request.mClientOrderId, request.mVolume);
+        break;
+    case MessageType::CANCEL_ORDER:
+        ++mResult.mCancelCount;
+        mCompetitor.OnCancelMessage(mNow, request.mClientOrderId);
+        break;
+    case MessageType::HEDGE_ORDER:
+        ++mResult.mHedgeCount;
+        mCompetitor.OnHedgeMessage(mNow, request.mClientOrderId, request.mSide, request.mPrice, request.mVolume);
+        break;
+    case MessageType::INSERT_ORDER:
+        ++mResult.mInsertCount;
+        mCompetitor.OnInsertMessage(mNow, request.mClientOrderId, request.mSide, request.mPrice, request.mVolume,
+                                    request.mLifespan);
+        break;
+    default:
+        RLOG(LG_SIM, LogLevel::LL_INFO) << "received invalid message: time=" << mNow
+                                        << " type=" << static_cast<int>(request.mMessageType);
+        Close();
+        break;
+    }
+
+    mCompetitor.ReleaseFinishedOrders();
+    mMarketOrders.ReleaseFinishedOrders();
+    PublishTradeTicks();
+}
+
+void Simulator::OnTrade(OrderBook& book)
+{
+    if (std::find(mPendingTradeTicks.begin(), mPendingTradeTicks.end(), &book) == mPendingTradeTicks.end())
+    {
+        mPendingTradeTicks.push_back(&book);
+    }
+}
+
+void Simulator::ProcessMarketEvents(long now)
+{
+    const std::int64_t* times = mEvents.GetTimes();
+    const std::uint16_t* competitors = mEvents.GetCompetitors();
+    const EventOperation* operations = mEvents.GetOperations();
+    const std::uint64_t* orderIds = mEvents.GetOrderIds();
+    const std::uint8_t* instruments = mEvents.GetInstruments();
+    const std::size_t eventCount = mEvents.GetRowCount();
+
+    for (; mNextEvent < eventCount && times[mNextEvent] < now; ++mNextEvent)
+    {
+        const std::size_t i = mNextEvent;
+        const EventOperation operation = operations[i];
+        if (competitors[i] != 0 || instruments[i] == COLUMNAR_NONE
+            || !(operation == EventOperation::INSERT || operation == EventOperation::CANCEL
+                 || operation == EventOperation::AMEND))
+        {
+            continue;
+        }
+
+        const auto instrument = static_cast<Instrument>(instruments[i]);
+        OrderBook& book = (instrument == Instrument::FUTURE) ? mFutureBook : mEtfBook;
+        const long time = times[i];
+        ++mResult.mMarketEventCount;
+
+        if (operation == EventOperation::INSERT)
+        {
+            const std::uint8_t lifespan = mEvents.GetLifespans()[i];
+            Order* order = mPool.Allocate();
+            order->mClientOrderId = orderIds[i];
+            order->mInstrument = instrument;
+            order->mLifespan = (lifespan == COLUMNAR_NONE) ? Lifespan::GOOD_FOR_DAY : static_cast<Lifespan>(lifespan);
+            order->mSide = static_cast<Side>(mEvents.GetSides()[i]);
+            order->mPrice = mEvents.GetPrices()[i];
+            order->mVolume = order->mRemainingVolume = mEvents.GetVolumes()[i];
+            order->mListener = &mMarketOrders;
+            book.Insert(time, *order);
+            if (order->mRemainingVolume == 0)
+            {
+                // It traded or was killed without ever resting in the book.
+                mPool.Release(order);
+            }
+        }
+        else if (Order* order = mMarketOrders.Find(instrument, orderIds[i]))
+        {
+            const long volume = mEvents.GetVolumes()[i];
+            if (operation == EventOperation::CANCEL)
+            {
+                book.Cancel(time, *order);
+            }
+            else if (volume < 0)
+            {
+                book.Amend(time, *order, order->mVolume + volume);
+            }
+        }
+    }
+
+    mCompetitor.ReleaseFinishedOrders();
+    mMarketOrders.ReleaseFinishedOrders();
+    PublishTradeTicks();
+}
+
+void Simulator::PublishOrderBooks()
+{
+    OrderBookMessage message;
+    for (OrderBook* book : {&mFutureBook, &mEtfBook})
+    {
+        message.mInstrument = book->GetInstrument();
+        message.mSequenceNumber = mTickNumber;
+        book->TopLevels(message.mAskPrices, message.mAskVolumes, message.mBidPrices, message.mBidVolumes);
+        Enqueue(true, MessageType::ORDER_BOOK_UPDATE, message);
+    }
+}
+
+void Simulator::PublishTradeTicks()
+{
+    TradeTicksMessage message;
+    for (OrderBook* book : mPendingTradeTicks)
+    {
+        if (book->TradeTicks(message.mAskPrices, message.mAskVolumes, message.mBidPrices, message.mBidVolumes))
+        {
+            message.mInstrument = book->GetInstrument();
+            message.mSequenceNumber = ++mTradeTicksSequences[static_cast<std::size_t>(book->GetInstrument())];
+            Enqueue(true, MessageType::TRADE_TICKS, message);
+        }
+    }
+    mPendingTradeTicks.clear();
+}
+
+void Simulator::Pump()
+{
+    std::vector<SimulatorRequest>& requests = mConnection->GetRequests();
+    std::size_t nextRequest = 0;
+    std::size_t nextMessage = 0;
+
+    for (;;)
+    {
+        if (nextRequest < requests.size())
+        {
+            const SimulatorRequest request = requests[nextRequest++];
+            HandleRequest(request);
+            continue;
+        }
+        requests.clear();
+        nextRequest = 0;
+
+        if (mClosing && !mConnectionLost)
+        {
+            mConnectionLost = true;
+            mCompetitor.OnConnectionLost(mNow);
+            mCompetitor.ReleaseFinishedOrders();
+            PublishTradeTicks();
+        }
+
+        if (nextMessage < mOutbound.size())
+        {
+            const PendingMessage& message = mOutbound[nextMessage++];
+            if (message.mInformation)
+            {
+                mSubscription->Deliver(message.mMessageType, message.mData.data(), message.mSize);
+            }
+            else if (message.mMessageType == DISCONNECT_MESSAGE_TYPE)
+            {
+                mConnection->Disconnect();
+            }
+            else
+            {
+                mConnection->Deliver(message.mMessageType, message.mData.data(), message.mSize);
+            }
+            continue;
+        }
+        mOutbound.clear();
+        break;
+    }
+}
+
+void Simulator::UpdateResult()
+{
+    const CompetitorAccount& account = mCompetitor.GetAccount();
+    mResult.mMatchTime = mNow;
+    mResult.mEtfPosition = account.GetEtfPosition();
+    mResult.mFuturePosition = account.GetFuturePosition();
+    mResult.mTotalFees = account.GetTotalFees();
+    mResult.mProfitOrLoss = account.GetProfitOrLoss();
+    mResult.mMaxDrawdown = account.GetMaxDrawdown();
+    mResult.mBreached = mCompetitor.IsBreached();
+}
+
+SimulatorResult Simulator::Run()
+{
+    const std::size_t eventCount = mEvents.GetRowCount();
+    long nextMarketEvents = 0;
+    long nextTick = 0;
+    bool done = false;
+
+    RLOG(LG_SIM, LogLevel::LL_INFO) << "simulating " << eventCount << " events";
+
+    // The login is processed before the market opens.
+    Pump();
+
+    while (!done)
+    {
+        const long deadline = mConnectionLost ? NO_DEADLINE : mCompetitor.GetUnhedgedLotsDeadline();
+        const std::uint64_t timerDeadline = mAutoTrader.GetScheduler().GetNextDeadline();
+        const long timer = (timerDeadline == NO_TIMER_DEADLINE)
+                           ? NO_DEADLINE
+                           : std::max(mNow, static_cast<long>((timerDeadline + 999) / 1000));
+        mNow = std::min({nextMarketEvents, nextTick, deadline, timer});
+        mClock.SetTime(static_cast<std::uint64_t>(mNow) * 1000);
+
+        if (timer == mNow)
+        {
+            mAutoTrader.GetScheduler().Poll();
+        }
+
+        if (deadline == mNow)
+        {
+            ProcessMarketEvents(mNow);
+            mCompetitor.OnUnhedgedLotsExpiry(mNow);
+        }
+
+        if (nextMarketEvents == mNow)
+        {
+            ProcessMarketEvents(mNow);
+            nextMarketEvents += mConfig.mMarketEventInterval;
+        }
+
+        if (nextTick == mNow)
+        {
+            mCompetitor.OnTimerTick(mNow, mFutureBook.LastTradedPrice(), mEtfBook.LastTradedPrice());
+            PublishOrderBooks();
+            ++mResult.mTickCount;
+            ++mTickNumber;
+            nextTick += mConfig.mTickInterval;
+            done = mNextEvent == eventCount || mConnectionLost;
+        }
+
+        Pump();
+    }
+
+    // The market closes, disconnecting the auto-trader.
+    Close();
+    Pump();
+
+    UpdateResult();
+    RLOG(LG_SIM, LogLevel::LL_INFO) << "simulation complete at time=" << mNow << " with profit or loss "
+                                    << mResult.mProfitOrLoss;
+    return mResult;
+}
+
+}
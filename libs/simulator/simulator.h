@@ -0,0 +1,220 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_SIMULATOR_SIMULATOR_H
+#define CPPREADY_TRADER_GO_LIBS_SIMULATOR_SIMULATOR_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <ready_trader_go/baseautotrader.h>
+#include <ready_trader_go/clock.h>
+#include <ready_trader_go/columnarevents.h>
+#include <ready_trader_go/connectivitytypes.h>
+#include <ready_trader_go/types.h>
+
+#include "competitor.h"
+#include "orderbook.h"
+#include "simulatorconfig.h"
+
+namespace ReadyTraderGo {
+
+// A request sent by the auto-trader to the simulated exchange.
+struct SimulatorRequest
+{
+    unsigned char mMessageType = 0;
+    unsigned long mClientOrderId = 0;
+    Side mSide = Side::SELL;
+    unsigned long mPrice = 0;
+    unsigned long mVolume = 0;
+    Lifespan mLifespan = Lifespan::FILL_AND_KILL;
+};
+
+// An in-memory execution connection to the simulated exchange. Requests
+// are queued, rather than serialised, until the simulator gets to them.
+class SimulatorConnection : public IConnection
+{
+public:
+    SimulatorConnection() { SetName("Simulator"); }
+
+    void AsyncRead() override {}
+    void SendMessage(unsigned char messageType, const ISerialisable& serialisable, SendMode mode) override;
+
+    void Deliver(unsigned char messageType, unsigned char const* data, std::size_t size)
+    {
+        OnMessageReceipt(messageType, data, size);
+    }
+    void Disconnect() { OnDisconnect(); }
+
+    std::vector<SimulatorRequest>& GetRequests() { return mRequests; }
+
+private:
+    std::vector<SimulatorRequest> mRequests;
+};
+
+// An in-memory information subscription to the simulated exchange.
+class SimulatorSubscription : public ISubscription
+{
+public:
+    SimulatorSubscription() { SetName("Simulator"); }
+
+    void AsyncReceive() override {}
+
+    void Deliver(unsigned char messageType, unsigned char const* data, std::size_t size)
+    {
+        OnMessageReceipt(messageType, data, size);
+    }
+};
+
+struct SimulatorResult
+{
+    std::uint64_t mMarketEventCount = 0;
+    std::uint64_t mTickCount = 0;
+    std::uint64_t mMessageCount = 0;
+    std::uint64_t mInsertCount = 0;
+    std::uint64_t mAmendCount = 0;
+    std::uint64_t mCancelCount = 0;
+    std::uint64_t mHedgeCount = 0;
+    std::uint64_t mErrorCount = 0;
+    std::uint64_t mFillCount = 0;
+    std::uint64_t mFillVolume = 0;
+    long mMatchTime = 0;
+    long mMaxEtfPosition = 0;
+    long mMaxFuturePosition = 0;
+    long mEtfPosition = 0;
+    long mFuturePosition = 0;
+    long mTotalFees = 0;
+    double mProfitOrLoss = 0.0;
+    double mMaxDrawdown = 0.0;
+    bool mBreached = false;
+};
+
+// Runs an auto-trader against an in-process copy of the exchange's matching
+// engine, driven by the market events in a columnar events file (only the
+// market's own orders are replayed from a match events file).
+//
+// Match time is virtual: market events are released every market event
+// interval and order books are published every tick interval, exactly as
+// the exchange's timers do but without any waiting. Requests from the
+// auto-trader are processed at the match time at which they were sent.
+// The auto-trader's clock is replaced by a virtual one that reads the match
+// time (in nanoseconds since the market opened), and the simulator skips
+// ahead to the deadline of each of the auto-trader's timers.
+//
+// The simulator installs its own connection and subscription in the
+// auto-trader, so it must be constructed before any other connection is set.
+class Simulator : private IExecutionChannel
+{
+public:
+    Simulator(BaseAutoTrader& autoTrader, const ColumnarEvents& events, SimulatorConfig config = {});
+
+    Simulator(const Simulator&) = delete;
+    void operator=(const Simulator&) = delete;
+
+    // Match time in microseconds since the market opened.
+    long GetCurrentTime() const { return mNow; }
+
+    SimulatorResult Run();
+
+private:
+    // The market's own orders, placed from market events.
+    class MarketOrders : public IOrderListener
+    {
+    public:
+        explicit MarketOrders(OrderPool& pool) : mPool(pool) {}
+
+        Order* Find(Instrument instrument, std::uint64_t orderId);
+        void ReleaseFinishedOrders();
+
+        void OnOrderAmended(long now, Order& order, long volumeRemoved) override;
+        void OnOrderCancelled(long now, Order& order, long volumeRemoved) override;
+        void OnOrderPlaced(long now, Order& order) override;
+        void OnOrderFilled(long now, Order& order, unsigned long price, long volume, long fee) override;
+
+    private:
+        void Finish(Order& order);
+
+        OrderPool& mPool;
+        std::array<std::unordered_map<std::uint64_t, Order*>, 2> mOrders;
+        std::vector<Order*> mFinishedOrders;
+    };
+
+    struct PendingMessage
+    {
+        static constexpr std::size_t CAPACITY = 96;
+
+        bool mInformation;
+        unsigned char mMessageType;
+        unsigned char mSize;
+        std::array<unsigned char, CAPACITY> mData;
+    };
+
+    // IExecutionChannel
+    void Close() override;
+    void SendError(unsigned long clientOrderId, std::string message) override;
+    void SendHedgeFilled(unsigned long clientOrderId, unsigned long averagePrice, long volume) override;
+    void SendOrderFilled(unsigned long clientOrderId, unsigned long price, long volume) override;
+    void SendOrderStatus(unsigned long clientOrderId, long fillVolume, long remainingVolume, long fees) override;
+
+    bool CheckMessageFrequency();
+    void Enqueue(bool information, unsigned char messageType, const ISerialisable& message);
+    void HandleRequest(const SimulatorRequest& request);
+    void OnTrade(OrderBook& book);
+    void ProcessMarketEvents(long now);
+    void PublishOrderBooks();
+    void PublishTradeTicks();
+    void Pump();
+    void UpdateResult();
+
+    BaseAutoTrader& mAutoTrader;
+    const ColumnarEvents& mEvents;
+    SimulatorConfig mConfig;
+    VirtualClock mClock;
+
+    OrderPool mPool;
+    OrderBook mFutureBook;
+    OrderBook mEtfBook;
+    MarketOrders mMarketOrders;
+    Competitor mCompetitor;
+
+    SimulatorConnection* mConnection = nullptr;
+    std::shared_ptr<SimulatorSubscription> mSubscription;
+
+    long mNow = 0;
+    std::size_t mNextEvent = 0;
+    unsigned long mTickNumber = 1;
+    std::array<unsigned long, 2> mTradeTicksSequences = {1, 1};
+    std::vector<OrderBook*> mPendingTradeTicks;
+
+    bool mLoggedIn = false;
+    bool mClosing = false;
+    bool mConnectionLost = false;
+    std::vector<long> mMessageTimes;
+    std::size_t mMessageTimesHead = 0;
+
+    std::vector<PendingMessage> mOutbound;
+    SimulatorResult mResult;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_SIMULATOR_SIMULATOR_H
@@ -0,0 +1,84 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_SIMULATOR_SIMULATORCONFIG_H
+#define CPPREADY_TRADER_GO_LIBS_SIMULATOR_SIMULATORCONFIG_H
+
+#include <cmath>
+
+#include <boost/property_tree/ptree.hpp>
+
+namespace ReadyTraderGo {
+
+constexpr long MICROSECONDS_PER_SECOND = 1000000;
+
+// Exchange settings for a simulated match. Times are in microseconds of
+// match time and prices are in cents. The defaults are those of the
+// exchange.json shipped with Ready Trader Go.
+struct SimulatorConfig
+{
+    // Read the settings from an exchange configuration (i.e. exchange.json).
+    void readFromPropertyTree(const boost::property_tree::ptree& tree)
+    {
+        auto microseconds = [](double seconds) { return std::lround(seconds * MICROSECONDS_PER_SECOND); };
+
+        const double speed = tree.get<double>("Engine.Speed");
+        mMarketEventInterval = microseconds(tree.get<double>("Engine.MarketEventInterval"));
+        mTickInterval = microseconds(tree.get<double>("Engine.TickInterval"));
+
+        mMakerFee = tree.get<double>("Fees.Maker");
+        mTakerFee = tree.get<double>("Fees.Taker");
+
+        mEtfClamp = tree.get<double>("Instrument.EtfClamp");
+        mTickSize = std::lround(tree.get<double>("Instrument.TickSize") * 100.0);
+
+        mActiveOrderCountLimit = tree.get<long>("Limits.ActiveOrderCountLimit");
+        mActiveVolumeLimit = tree.get<long>("Limits.ActiveVolumeLimit");
+        mMessageFrequencyLimit = tree.get<long>("Limits.MessageFrequencyLimit");
+        mPositionLimit = tree.get<long>("Limits.PositionLimit");
+
+        // The exchange divides the frequency interval by the speed but
+        // measures it in match time, and runs the unhedged lots timer on the
+        // wall clock. Both are converted to match time here.
+        mMessageFrequencyInterval = microseconds(tree.get<double>("Limits.MessageFrequencyInterval") / speed);
+        mUnhedgedLotsTimeLimit = microseconds(UNHEDGED_LOTS_TIME_LIMIT_SECONDS * speed);
+    }
+
+    static constexpr double UNHEDGED_LOTS_TIME_LIMIT_SECONDS = 60.0;
+
+    long mMarketEventInterval = 50000;
+    long mTickInterval = 250000;
+
+    double mMakerFee = -0.0001;
+    double mTakerFee = 0.0002;
+
+    double mEtfClamp = 0.002;
+    unsigned long mTickSize = 100;
+
+    long mActiveOrderCountLimit = 10;
+    long mActiveVolumeLimit = 200;
+    long mMessageFrequencyLimit = 50;
+    long mPositionLimit = 100;
+    long mMessageFrequencyInterval = 100000;
+
+    long mUnhedgedLotsLimit = 10;
+    long mUnhedgedLotsTimeLimit = 600000000;
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_SIMULATOR_SIMULATORCONFIG_H
@@ -0,0 +1,160 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <utility>
+
+#include "workstealingpool.h"
+
+namespace ReadyTraderGo {
+
+WorkStealingPool::WorkStealingPool(std::size_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (std::size_t i = 0; i < threadCount; ++i)
+    {
+        mWorkers.push_back(std::make_unique<Worker>());
+    }
+    for (std::size_t i = 0; i < threadCount; ++i)
+    {
+        mThreads.emplace_back([this, i] { WorkerThread(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mWorkAvailable.notify_all();
+    for (auto& thread : mThreads)
+    {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::Submit(std::function<void()> task)
+{
+    std::size_t index;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        index = mNextWorker++ % mWorkers.size();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mWorkers[index]->mMutex);
+        mWorkers[index]->mTasks.push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        ++mQueuedCount;
+        ++mOutstandingCount;
+    }
+    mWorkAvailable.notify_one();
+}
+
+void WorkStealingPool::Wait()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mAllDone.wait(lock, [this] { return mOutstandingCount == 0; });
+    if (mException)
+    {
+        std::rethrow_exception(std::exchange(mException, nullptr));
+    }
+}
+
+bool WorkStealingPool::TryPop(std::size_t index, std::function<void()>& task)
+{
+    Worker& worker = *mWorkers[index];
+    std::lock_guard<std::mutex> lock(worker.mMutex);
+    if (worker.mTasks.empty())
+    {
+        return false;
+    }
+    task = std::move(worker.mTasks.back());
+    worker.mTasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::TrySteal(std::size_t index, std::function<void()>& task)
+{
+    for (std::size_t i = 1; i < mWorkers.size(); ++i)
+    {
+        Worker& victim = *mWorkers[(index + i) % mWorkers.size()];
+        std::lock_guard<std::mutex> lock(victim.mMutex);
+        if (!victim.mTasks.empty())
+        {
+            task = std::move(victim.mTasks.front());
+            victim.mTasks.pop_front();
+            mStealCount.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::WorkerThread(std::size_t index)
+{
+    std::function<void()> task;
+    for (;;)
+    {
+        if (TryPop(index, task) || TrySteal(index, task))
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                --mQueuedCount;
+            }
+
+            std::exception_ptr exception;
+            try
+            {
+                task();
+            }
+            catch (...)
+            {
+                exception = std::current_exception();
+            }
+            task = nullptr;
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (exception && !mException)
+            {
+                mException = exception;
+            }
+            if (--mOutstandingCount == 0)
+            {
+                mAllDone.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        mWorkAvailable.wait(lock, [this] { return mStopping || mQueuedCount != 0; });
+        if (mStopping && mQueuedCount == 0)
+        {
+            return;
+        }
+    }
+}
+
+}
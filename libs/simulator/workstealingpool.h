@@ -0,0 +1,88 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LIBS_SIMULATOR_WORKSTEALINGPOOL_H
+#define CPPREADY_TRADER_GO_LIBS_SIMULATOR_WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ReadyTraderGo {
+
+// A fixed set of worker threads, each with its own task deque. A worker
+// takes the newest task from its own deque and, when that is empty, steals
+// the oldest task from another worker's.
+//
+// Tasks are expected to be coarse (e.g. a whole backtest), so each deque is
+// protected by a plain mutex that is almost never contended.
+class WorkStealingPool
+{
+public:
+    // A thread count of zero means one thread per hardware thread.
+    explicit WorkStealingPool(std::size_t threadCount = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    void operator=(const WorkStealingPool&) = delete;
+
+    std::size_t GetThreadCount() const { return mThreads.size(); }
+    std::uint64_t GetStealCount() const { return mStealCount.load(std::memory_order_relaxed); }
+
+    void Submit(std::function<void()> task);
+
+    // Block until every submitted task has finished. If any task threw, the
+    // first exception is rethrown here.
+    void Wait();
+
+private:
+    struct Worker
+    {
+        std::mutex mMutex;
+        std::deque<std::function<void()>> mTasks;
+    };
+
+    bool TryPop(std::size_t index, std::function<void()>& task);
+    bool TrySteal(std::size_t index, std::function<void()>& task);
+    void WorkerThread(std::size_t index);
+
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+    std::vector<std::thread> mThreads;
+
+    std::mutex mMutex;
+    std::condition_variable mWorkAvailable;
+    std::condition_variable mAllDone;
+    std::size_t mQueuedCount = 0;
+    std::size_t mOutstandingCount = 0;
+    std::size_t mNextWorker = 0;
+    bool mStopping = false;
+    std::exception_ptr mException;
+
+    std::atomic<std::uint64_t> mStealCount{0};
+};
+
+}
+
+#endif //CPPREADY_TRADER_GO_LIBS_SIMULATOR_WORKSTEALINGPOOL_H
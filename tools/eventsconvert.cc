@@ -0,0 +1,164 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <ready_trader_go/columnarevents.h>
+
+using namespace ReadyTraderGo;
+
+struct ScanTotals
+{
+    std::array<std::uint64_t, EVENT_OPERATION_COUNT> mOperationCounts{};
+    std::int64_t mNotional = 0;
+    std::int64_t mFees = 0;
+};
+
+// A scan touching the columns a backtest typically needs.
+static ScanTotals scan(const ColumnarEvents& events)
+{
+    ScanTotals totals;
+    const auto* operations = events.GetOperations();
+    const auto* volumes = events.GetVolumes();
+    const auto* prices = events.GetPrices();
+    const auto* fees = events.GetFees();
+    const std::size_t rowCount = events.GetRowCount();
+    for (std::size_t i = 0; i < rowCount; ++i)
+    {
+        ++totals.mOperationCounts[static_cast<std::size_t>(operations[i])];
+        totals.mNotional += std::int64_t(volumes[i]) * prices[i];
+        if (fees[i] != COLUMNAR_NO_FEE)
+        {
+            totals.mFees += fees[i];
+        }
+    }
+    return totals;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void benchmark(const std::string& csvName, const std::string& columnarName, int repetitions)
+{
+    double csvSeconds = 0.0;
+    double openSeconds = 0.0;
+    double scanSeconds = 0.0;
+    std::size_t rowCount = 0;
+    ScanTotals totals;
+
+    for (int r = 0; r < repetitions; ++r)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::ifstream csv{csvName};
+        rowCount = parseEventsCsv(csv).GetRowCount();
+        csvSeconds += secondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        ColumnarEvents events{columnarName};
+        openSeconds += secondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        totals = scan(events);
+        scanSeconds += secondsSince(start);
+    }
+
+    csvSeconds /= repetitions;
+    openSeconds /= repetitions;
+    scanSeconds /= repetitions;
+
+    std::cout << "events:              " << rowCount << '\n'
+              << "csv parse seconds:   " << csvSeconds << '\n'
+              << "csv events/sec:      " << rowCount / csvSeconds << '\n'
+              << "mmap open seconds:   " << openSeconds << '\n'
+              << "scan seconds:        " << scanSeconds << '\n'
+              << "scan events/sec:     " << rowCount / scanSeconds << '\n'
+              << "load speed-up:       " << csvSeconds / (openSeconds + scanSeconds) << "x\n"
+              << "notional (cents):    " << totals.mNotional << '\n'
+              << "fees (cents):        " << totals.mFees << '\n';
+}
+
+int main(int argc, char* argv[])
+{
+    int repetitions = 0;
+    std::string inputName;
+    std::string outputName;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc)
+        {
+            repetitions = std::atoi(argv[++i]);
+        }
+        else if (inputName.empty() && argv[i][0] != '-')
+        {
+            inputName = argv[i];
+        }
+        else if (outputName.empty() && argv[i][0] != '-')
+        {
+            outputName = argv[i];
+        }
+        else
+        {
+            outputName.clear();
+            break;
+        }
+    }
+
+    if (outputName.empty() || repetitions < 0)
+    {
+        std::cerr << "usage: " << argv[0] << " [--benchmark REPETITIONS] INPUT_CSV OUTPUT" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        std::ifstream input{inputName};
+        if (!input)
+        {
+            std::cerr << "failed to open '" << inputName << "': " << std::strerror(errno) << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        ColumnarEventsBuilder builder = parseEventsCsv(input);
+        builder.Write(outputName);
+        std::cout << "converted " << builder.GetRowCount() << " events in " << secondsSince(start)
+                  << " seconds" << std::endl;
+
+        if (repetitions != 0)
+        {
+            benchmark(inputName, outputName, repetitions);
+        }
+
+        return EXIT_SUCCESS;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
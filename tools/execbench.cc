@@ -0,0 +1,247 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/log/core.hpp>
+
+#include <ready_trader_go/connectivity.h>
+#include <ready_trader_go/protocol.h>
+#include <ready_trader_go/types.h>
+
+using namespace ReadyTraderGo;
+
+// Drive an exchange (usually stubexchange) with a stream of orders, keeping a
+// fixed number outstanding, and time each from being sent to its final
+// response: the last ORDER_STATUS of an insert or the HEDGE_FILLED of a hedge.
+// With a window of one this is the true round trip; with a large window the
+// rate at which orders complete is the throughput limit.
+class ExecutionBenchmark
+{
+public:
+    ExecutionBenchmark(boost::asio::io_context& context, IConnection& connection, bool hedge, std::size_t orders,
+                       std::size_t warmup, std::size_t window)
+        : mContext(context), mConnection(connection), mHedge(hedge), mWarmup(warmup),
+          mWindow(window), mSendTimes(orders + warmup + 1)
+    {
+        mRoundTrips.reserve(orders);
+        mConnection.Disconnected = [this] { mContext.stop(); };
+        mConnection.MessageReceived = [this](IConnection*, unsigned char messageType, unsigned char const* data,
+                                             std::size_t size) {
+            MessageHandler(messageType, data, size);
+        };
+    }
+
+    void Start(const std::string& name, const std::string& secret)
+    {
+        mConnection.SendMessage(MessageType::LOGIN, LoginMessage{name, secret});
+        mConnection.AsyncRead();
+        while (mNextOrderId <= mWindow && mNextOrderId < mSendTimes.size())
+            SendOrder();
+    }
+
+    std::vector<double>& GetRoundTrips() { return mRoundTrips; }
+    double GetSeconds() const { return std::chrono::duration<double>(mFinish - mStart).count(); }
+    std::size_t GetErrorCount() const { return mErrorCount; }
+
+private:
+    void SendOrder()
+    {
+        const unsigned long id = mNextOrderId++;
+        if (id == mWarmup + 1)
+            mStart = std::chrono::steady_clock::now();
+        mSendTimes[id] = std::chrono::steady_clock::now();
+        if (mHedge)
+            mConnection.SendMessage(MessageType::HEDGE_ORDER, HedgeMessage{id, Side::BUY, Price(10000), Volume(1)});
+        else
+            mConnection.SendMessage(MessageType::INSERT_ORDER,
+                                    InsertMessage{id, Side::BUY, Price(10000), Volume(1), Lifespan::FILL_AND_KILL});
+    }
+
+    void Complete(unsigned long id)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (id == 0 || id >= mNextOrderId)
+            return;
+        if (id > mWarmup)
+            mRoundTrips.push_back(std::chrono::duration<double, std::nano>(now - mSendTimes[id]).count());
+
+        if (++mCompleted == mSendTimes.size() - 1)
+        {
+            mFinish = now;
+            mContext.stop();
+        }
+        else if (mNextOrderId < mSendTimes.size())
+        {
+            SendOrder();
+        }
+    }
+
+    void MessageHandler(unsigned char messageType, unsigned char const* data, std::size_t size)
+    {
+        switch (messageType)
+        {
+        case MessageType::ORDER_STATUS:
+        {
+            auto status = makeMessage<OrderStatusMessage>(data, size);
+            if (!status.mRemainingVolume)
+                Complete(status.mClientOrderId);
+            break;
+        }
+        case MessageType::HEDGE_FILLED:
+            Complete(makeMessage<HedgeFilledMessage>(data, size).mClientOrderId);
+            break;
+        case MessageType::ERROR_MESSAGE:
+        {
+            auto error = makeMessage<ErrorMessage>(data, size);
+            if (mErrorCount++ == 0)
+                std::cerr << "error: " << error.mClientOrderId << ": " << error.mMessage << std::endl;
+            Complete(error.mClientOrderId);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    boost::asio::io_context& mContext;
+    IConnection& mConnection;
+    const bool mHedge;
+    const std::size_t mWarmup;
+    const std::size_t mWindow;
+    std::vector<std::chrono::steady_clock::time_point> mSendTimes;
+    std::vector<double> mRoundTrips;
+    unsigned long mNextOrderId = 1;
+    std::size_t mCompleted = 0;
+    std::size_t mErrorCount = 0;
+    std::chrono::steady_clock::time_point mStart;
+    std::chrono::steady_clock::time_point mFinish;
+};
+
+int main(int argc, char* argv[])
+{
+    std::string host = "127.0.0.1";
+    unsigned short port = 12345;
+    std::string transport = "asio";
+    bool busyPoll = false;
+    bool hedge = false;
+    std::size_t orders = 100000;
+    std::size_t warmup = 1000;
+    std::size_t window = 1;
+    bool usage = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--host") == 0 && i + 1 < argc)
+        {
+            host = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+        {
+            port = static_cast<unsigned short>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--transport") == 0 && i + 1 < argc)
+        {
+            transport = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--busy-poll") == 0)
+        {
+            busyPoll = true;
+        }
+        else if (std::strcmp(argv[i], "--hedge") == 0)
+        {
+            hedge = true;
+        }
+        else if (std::strcmp(argv[i], "--orders") == 0 && i + 1 < argc)
+        {
+            orders = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+        {
+            warmup = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--window") == 0 && i + 1 < argc)
+        {
+            window = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else
+        {
+            usage = true;
+            break;
+        }
+    }
+
+    if (usage || orders == 0 || window == 0 || (transport != "asio" && transport != "io_uring"))
+    {
+        std::cerr << "usage: " << argv[0] << " [--host HOST] [--port PORT] [--transport asio|io_uring]"
+                  << " [--busy-poll] [--hedge] [--orders COUNT] [--warmup COUNT] [--window COUNT]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    boost::log::core::get()->set_logging_enabled(false);
+
+    try
+    {
+        boost::asio::io_context context;
+        ConnectionFactory factory{context, host, port};
+        if (transport == "io_uring")
+            factory.SetIoUring(IoUringOptions{}, busyPoll);
+        std::unique_ptr<IConnection> connection = factory.Create();
+
+        ExecutionBenchmark benchmark{context, *connection, hedge, orders, warmup, window};
+        benchmark.Start("execbench", "secret");
+        context.run();
+
+        std::vector<double>& roundTrips = benchmark.GetRoundTrips();
+        if (roundTrips.size() != orders)
+            throw std::runtime_error("connection closed after " + std::to_string(roundTrips.size()) + " orders");
+
+        std::sort(roundTrips.begin(), roundTrips.end());
+        auto percentile = [&roundTrips](double p) {
+            return roundTrips[std::min(roundTrips.size() - 1, std::size_t(p * double(roundTrips.size())))];
+        };
+
+        std::cout << "orders:                " << orders << (hedge ? " hedges" : " inserts") << '\n'
+                  << "window:                " << window << '\n'
+                  << "errors:                " << benchmark.GetErrorCount() << '\n'
+                  << std::fixed << std::setprecision(0)
+                  << "orders/s:              " << double(orders) / benchmark.GetSeconds() << '\n'
+                  << "min ns:                " << roundTrips.front() << '\n'
+                  << "p50 ns:                " << percentile(0.5) << '\n'
+                  << "p90 ns:                " << percentile(0.9) << '\n'
+                  << "p99 ns:                " << percentile(0.99) << '\n'
+                  << "p99.9 ns:              " << percentile(0.999) << '\n'
+                  << "max ns:                " << roundTrips.back() << '\n';
+        return EXIT_SUCCESS;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,304 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <ready_trader_go/bookfeatures.h>
+
+using namespace ReadyTraderGo;
+
+struct Book
+{
+    PriceLevels mAskPrices{};
+    VolumeLevels mAskVolumes{};
+    PriceLevels mBidPrices{};
+    VolumeLevels mBidVolumes{};
+};
+
+struct Feature
+{
+    BookFeature mFeature;
+    Instrument mInstrument;
+    std::size_t mLevels;
+};
+
+// Every feature the pipeline offers, per-level kinds at each depth first,
+// so that the first few make a realistic mix.
+static std::vector<Feature> allFeatures()
+{
+    std::vector<Feature> features;
+    for (auto instrument : {Instrument::ETF, Instrument::FUTURE})
+    {
+        features.push_back({BookFeature::MID, instrument, 1});
+        features.push_back({BookFeature::SPREAD_TICKS, instrument, 1});
+    }
+    features.push_back({BookFeature::BASIS_TICKS, Instrument::ETF, 1});
+    for (auto kind : {BookFeature::IMBALANCE, BookFeature::DEPTH_WEIGHTED_MID, BookFeature::SLOPE,
+                      BookFeature::ASK_VWAP, BookFeature::BID_VWAP, BookFeature::ASK_DEPTH, BookFeature::BID_DEPTH})
+    {
+        for (std::size_t levels = 1; levels <= TOP_LEVEL_COUNT; ++levels)
+        {
+            for (auto instrument : {Instrument::ETF, Instrument::FUTURE})
+            {
+                features.push_back({kind, instrument, levels});
+            }
+        }
+    }
+    return features;
+}
+
+// Books for both instruments on each tick: a random walk of the mid with a
+// five tick deep book of random volumes, some of which stay unchanged.
+static std::vector<std::array<Book, 2>> makeBooks(std::size_t ticks, double unchanged, unsigned seed)
+{
+    std::mt19937_64 random{seed};
+    std::uniform_real_distribution<double> uniform;
+    std::uniform_int_distribution<unsigned long> volumes{1, 200};
+    std::vector<std::array<Book, 2>> books(ticks);
+    long mid = 100000;
+    for (std::size_t t = 0; t < ticks; ++t)
+    {
+        // Kept well clear of zero, where prices would wrap.
+        mid += (uniform(random) < 0.5 || mid > 200000) && mid > 20000 ? -100 : 100;
+        for (std::size_t i = 0; i < 2; ++i)
+        {
+            Book& book = books[t][i];
+            if (t != 0 && uniform(random) < unchanged)
+            {
+                book = books[t - 1][i];
+                continue;
+            }
+            const long base = mid + ((i == 0) ? 0 : (uniform(random) < 0.5 ? -100 : 100));
+            const std::size_t askLevels = (uniform(random) < 0.05) ? 3 : TOP_LEVEL_COUNT;
+            for (std::size_t l = 0; l < TOP_LEVEL_COUNT; ++l)
+            {
+                if (l < askLevels)
+                {
+                    book.mAskPrices[l] = Price(base + 100 * long(l + 1));
+                    book.mAskVolumes[l] = Volume(volumes(random));
+                }
+                book.mBidPrices[l] = Price(base - 100 * long(l + 1));
+                book.mBidVolumes[l] = Volume(volumes(random));
+            }
+        }
+    }
+    return books;
+}
+
+static double mid(const Book& b)
+{
+    return (b.mAskPrices[0] && b.mBidPrices[0]) ? MidPrice(b.mBidPrices[0], b.mAskPrices[0]).ToDouble() : 0.0;
+}
+
+// The feature written out directly, as a strategy would in its order book
+// handler.
+static double computeScalar(const Feature& f, const std::array<Book, 2>& books)
+{
+    const Book& b = books[static_cast<std::size_t>(f.mInstrument)];
+    double askDepth = 0, bidDepth = 0, askTurnover = 0, bidTurnover = 0;
+    for (std::size_t l = 0; l < f.mLevels; ++l)
+    {
+        askDepth += b.mAskVolumes[l].Lots();
+        bidDepth += b.mBidVolumes[l].Lots();
+        askTurnover += double(b.mAskPrices[l] * b.mAskVolumes[l]);
+        bidTurnover += double(b.mBidPrices[l] * b.mBidVolumes[l]);
+    }
+    const double askVwap = (askDepth > 0) ? askTurnover / askDepth : 0.0;
+    const double bidVwap = (bidDepth > 0) ? bidTurnover / bidDepth : 0.0;
+    const double depth = askDepth + bidDepth;
+    const std::size_t last = f.mLevels - 1;
+
+    switch (f.mFeature)
+    {
+    case BookFeature::MID:
+        return mid(b);
+    case BookFeature::SPREAD_TICKS:
+        if (!b.mAskPrices[0] || !b.mBidPrices[0])
+            return 0.0;
+        return double((b.mAskPrices[0] - b.mBidPrices[0]).Count());
+    case BookFeature::ASK_DEPTH:
+        return askDepth;
+    case BookFeature::BID_DEPTH:
+        return bidDepth;
+    case BookFeature::ASK_VWAP:
+        return askVwap;
+    case BookFeature::BID_VWAP:
+        return bidVwap;
+    case BookFeature::DEPTH_WEIGHTED_MID:
+        return (depth > 0) ? (askVwap * bidDepth + bidVwap * askDepth) / depth : 0.0;
+    case BookFeature::IMBALANCE:
+        return (depth > 0) ? (bidDepth - askDepth) / depth : 0.0;
+    case BookFeature::SLOPE:
+        if (!b.mAskPrices[last] || !b.mBidPrices[last] || depth == 0)
+            return 0.0;
+        return double((b.mAskPrices[last] - b.mBidPrices[last]).Count()) / depth;
+    case BookFeature::BASIS_TICKS:
+    {
+        const double etf = mid(books[static_cast<std::size_t>(Instrument::ETF)]);
+        const double future = mid(books[static_cast<std::size_t>(Instrument::FUTURE)]);
+        return (etf != 0 && future != 0) ? (etf - future) / TICK_SIZE_IN_CENTS : 0.0;
+    }
+    }
+    return 0.0;
+}
+
+static double nanosecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static int benchmark(std::size_t featureCount, std::size_t ticks, double unchanged, unsigned seed)
+{
+    std::vector<Feature> features = allFeatures();
+    if (featureCount > features.size())
+    {
+        std::cerr << "at most " << features.size() << " features are available" << std::endl;
+        return EXIT_FAILURE;
+    }
+    features.resize(featureCount);
+    const auto books = makeBooks(ticks, unchanged, seed);
+
+    BookFeaturePipeline pipeline{TICK_SIZE_IN_CENTS};
+    for (const Feature& f : features)
+    {
+        pipeline.Add(f.mFeature, f.mInstrument, f.mLevels);
+    }
+
+    // Checksums stop the compiler discarding either loop.
+    double pipelineSum = 0.0;
+    double maximumError = 0.0;
+    std::size_t recomputed = 0;
+    std::vector<double> scalar(featureCount);
+
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& tick : books)
+    {
+        for (std::size_t i = 0; i < 2; ++i)
+        {
+            const Book& b = tick[i];
+            pipeline.OnOrderBook(static_cast<Instrument>(i), b.mAskPrices, b.mAskVolumes, b.mBidPrices,
+                                 b.mBidVolumes);
+        }
+        pipeline.Evaluate();
+        pipelineSum += pipeline[featureCount - 1];
+    }
+    const double pipelineNanoseconds = nanosecondsSince(start);
+
+    double scalarSum = 0.0;
+    start = std::chrono::steady_clock::now();
+    for (const auto& tick : books)
+    {
+        for (std::size_t f = 0; f < featureCount; ++f)
+        {
+            scalar[f] = computeScalar(features[f], tick);
+        }
+        scalarSum += scalar[featureCount - 1];
+    }
+    const double scalarNanoseconds = nanosecondsSince(start);
+
+    // Check every value, outside the timed loops.
+    BookFeaturePipeline checked{TICK_SIZE_IN_CENTS};
+    for (const Feature& f : features)
+    {
+        checked.Add(f.mFeature, f.mInstrument, f.mLevels);
+    }
+    for (const auto& tick : books)
+    {
+        for (std::size_t i = 0; i < 2; ++i)
+        {
+            const Book& b = tick[i];
+            checked.OnOrderBook(static_cast<Instrument>(i), b.mAskPrices, b.mAskVolumes, b.mBidPrices,
+                                b.mBidVolumes);
+        }
+        checked.Evaluate();
+        for (std::size_t f = 0; f < featureCount; ++f)
+        {
+            const double expected = computeScalar(features[f], tick);
+            const double error = std::abs(checked[f] - expected) / std::max(1.0, std::abs(expected));
+            maximumError = std::max(maximumError, error);
+            recomputed += checked.IsUpdated(f) ? 1 : 0;
+        }
+    }
+
+    std::cout << "features:            " << featureCount << '\n'
+              << "ticks:               " << ticks << " (books unchanged with probability " << unchanged << ")\n"
+              << "pipeline per tick:   " << pipelineNanoseconds / ticks << " ns\n"
+              << "scalar per tick:     " << scalarNanoseconds / ticks << " ns\n"
+              << "recomputed:          " << 100.0 * recomputed / double(ticks * featureCount) << "% of features\n"
+              << "max relative error:  " << maximumError << '\n'
+              << "checksums:           " << pipelineSum << ' ' << scalarSum << '\n';
+
+    return (maximumError < 1e-9) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t featureCount = 50;
+    std::size_t ticks = 1000000;
+    double unchanged = 0.2;
+    unsigned seed = 42;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--features") == 0 && i + 1 < argc)
+        {
+            featureCount = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--ticks") == 0 && i + 1 < argc)
+        {
+            ticks = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--unchanged") == 0 && i + 1 < argc)
+        {
+            unchanged = std::strtod(argv[++i], nullptr);
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            seed = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else
+        {
+            ticks = 0;
+            break;
+        }
+    }
+
+    if (featureCount == 0 || ticks == 0 || unchanged < 0.0 || unchanged > 1.0)
+    {
+        std::cerr << "usage: " << argv[0] << " [--features COUNT] [--ticks COUNT] [--unchanged PROBABILITY]"
+                  << " [--seed SEED]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        return benchmark(featureCount, ticks, unchanged, seed);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
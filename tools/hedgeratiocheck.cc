@@ -0,0 +1,331 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/endian/conversion.hpp>
+
+#include <ready_trader_go/connectivity.h>
+#include <ready_trader_go/hedgeratio.h>
+#include <ready_trader_go/journal.h>
+#include <ready_trader_go/protocol.h>
+#include <ready_trader_go/types.h>
+
+using namespace ReadyTraderGo;
+
+using PricePair = std::pair<double, double>;
+
+struct OlsFit
+{
+    double mHedgeRatio = 0.0;
+    double mIntercept = 0.0;
+    double mResidualVariance = 0.0;
+};
+
+// Pair the latest mid prices of the future and ETF after every order book
+// update in a journal, once both are known.
+static std::vector<PricePair> readJournalPairs(const std::string& journalName)
+{
+    std::vector<PricePair> pairs;
+    double mids[2] = {0.0, 0.0};
+
+    JournalReader reader{journalName};
+    JournalRecord record{};
+    while (reader.Next(record))
+    {
+        if (record.mDirection != JournalDirection::INFO_IN || record.mSize < MESSAGE_HEADER_SIZE
+            || record.mData[MESSAGE_TYPE_OFFSET] != MessageType::ORDER_BOOK_UPDATE)
+        {
+            continue;
+        }
+
+        auto book = makeMessage<OrderBookMessage>(record.mData + MESSAGE_HEADER_SIZE,
+                                                  record.mSize - MESSAGE_HEADER_SIZE);
+        if (!book.mAskPrices[0] || !book.mBidPrices[0])
+        {
+            continue;
+        }
+
+        mids[static_cast<int>(book.mInstrument)] = MidPrice(book.mBidPrices[0], book.mAskPrices[0]).ToDouble();
+        if (mids[0] != 0.0 && mids[1] != 0.0)
+        {
+            pairs.emplace_back(mids[static_cast<int>(Instrument::FUTURE)], mids[static_cast<int>(Instrument::ETF)]);
+        }
+    }
+    return pairs;
+}
+
+// A random walk for the future and, for the ETF, the given linear function
+// of it plus autocorrelated noise, in whole cents.
+static std::vector<PricePair> makeSyntheticPairs(std::size_t count, double ratio, unsigned seed)
+{
+    std::mt19937_64 random{seed};
+    std::normal_distribution<double> step{0.0, 20.0};
+    std::normal_distribution<double> shock{0.0, 15.0};
+
+    std::vector<PricePair> pairs;
+    pairs.reserve(count);
+    double future = 10000.0;
+    double noise = 0.0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        future += step(random);
+        noise = 0.9 * noise + shock(random);
+        pairs.emplace_back(std::round(future), std::round(50.0 + ratio * future + noise));
+    }
+    return pairs;
+}
+
+// Weighted least squares over pairs [begin, end), the last pair having a
+// weight of one and each earlier one the forgetting factor times the next.
+// This is the batch computation the recursive estimator avoids.
+static OlsFit fitOls(const std::vector<PricePair>& pairs, std::size_t begin, std::size_t end, double forgetting)
+{
+    double weight = 0.0;
+    double sumX = 0.0;
+    double sumY = 0.0;
+    double w = 1.0;
+    for (std::size_t i = end; i-- > begin; w *= forgetting)
+    {
+        weight += w;
+        sumX += w * pairs[i].first;
+        sumY += w * pairs[i].second;
+    }
+    const double meanX = sumX / weight;
+    const double meanY = sumY / weight;
+
+    double sxx = 0.0;
+    double sxy = 0.0;
+    w = 1.0;
+    for (std::size_t i = end; i-- > begin; w *= forgetting)
+    {
+        sxx += w * (pairs[i].first - meanX) * (pairs[i].first - meanX);
+        sxy += w * (pairs[i].first - meanX) * (pairs[i].second - meanY);
+    }
+
+    OlsFit fit;
+    fit.mHedgeRatio = sxx > 0.0 ? sxy / sxx : 0.0;
+    fit.mIntercept = meanY - fit.mHedgeRatio * meanX;
+
+    double squaredErrors = 0.0;
+    w = 1.0;
+    for (std::size_t i = end; i-- > begin; w *= forgetting)
+    {
+        const double residual = pairs[i].second - (fit.mIntercept + fit.mHedgeRatio * pairs[i].first);
+        squaredErrors += w * residual * residual;
+    }
+    fit.mResidualVariance = weight > 2.0 ? squaredErrors / (weight - 2.0) : 0.0;
+    return fit;
+}
+
+static double relativeError(double actual, double expected)
+{
+    return std::abs(actual - expected) / std::max(std::abs(expected), 1e-12);
+}
+
+struct Comparison
+{
+    double mRatio = 0.0;
+    double mIntercept = 0.0;
+    double mVariance = 0.0;
+    double mZScore = 0.0;
+
+    void Add(const HedgeRatioEstimate& estimate, const OlsFit& fit, const OlsFit& previous, const PricePair& pair)
+    {
+        mRatio = std::max(mRatio, relativeError(estimate.mHedgeRatio, fit.mHedgeRatio));
+        mIntercept = std::max(mIntercept, std::abs(estimate.mIntercept - fit.mIntercept));
+        mVariance = std::max(mVariance, relativeError(estimate.mResidualVariance, fit.mResidualVariance));
+        const double residual = pair.second - (previous.mIntercept + previous.mHedgeRatio * pair.first);
+        const double zScore = residual / std::sqrt(previous.mResidualVariance);
+        mZScore = std::max(mZScore, std::abs(estimate.mZScore - zScore));
+    }
+};
+
+template<typename Estimator>
+static double nanosecondsPerUpdate(Estimator estimator, const std::vector<PricePair>& pairs)
+{
+    const auto start = std::chrono::steady_clock::now();
+    double sink = 0.0;
+    for (const auto& [future, etf] : pairs)
+    {
+        sink += estimator.Update(future, etf).mZScore;
+    }
+    const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    volatile double keep = sink;
+    (void) keep;
+    return elapsed / double(pairs.size());
+}
+
+int main(int argc, char* argv[])
+{
+    std::string journalName;
+    std::size_t syntheticCount = 0;
+    double syntheticRatio = 0.98;
+    unsigned seed = 1;
+    double forgetting = 0.999;
+    std::size_t checkpoint = 1000;
+    std::size_t window = 1000;
+    double tolerance = 1e-6;
+    bool usage = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--synthetic") == 0 && i + 1 < argc)
+        {
+            syntheticCount = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--ratio") == 0 && i + 1 < argc)
+        {
+            syntheticRatio = std::strtod(argv[++i], nullptr);
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            seed = unsigned(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--forgetting") == 0 && i + 1 < argc)
+        {
+            forgetting = std::strtod(argv[++i], nullptr);
+        }
+        else if (std::strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc)
+        {
+            checkpoint = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--window") == 0 && i + 1 < argc)
+        {
+            window = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+        {
+            tolerance = std::strtod(argv[++i], nullptr);
+        }
+        else if (argv[i][0] != '-' && journalName.empty())
+        {
+            journalName = argv[i];
+        }
+        else
+        {
+            usage = true;
+            break;
+        }
+    }
+
+    if (usage || checkpoint == 0 || window < 3 || journalName.empty() == (syntheticCount == 0))
+    {
+        std::cerr << "usage: " << argv[0] << " [--forgetting FACTOR] [--checkpoint PAIRS] [--window PAIRS]"
+                  << " [--tolerance RELATIVE_ERROR] (JOURNAL_NAME | --synthetic PAIRS [--ratio RATIO] [--seed SEED])"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        const std::vector<PricePair> pairs = journalName.empty()
+                                             ? makeSyntheticPairs(syntheticCount, syntheticRatio, seed)
+                                             : readJournalPairs(journalName);
+        if (pairs.size() < 3)
+        {
+            std::cerr << "need at least three price pairs, found " << pairs.size() << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        if (std::all_of(pairs.begin(), pairs.end(), [&pairs](const auto& p) { return p.first == pairs[0].first; }))
+        {
+            std::cerr << "the future's price never changes, so there is no hedge ratio to estimate" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        // Compare both recursive fits with the batch fit over the same pairs
+        // (and, for the z-score, over all but the last) at every checkpoint.
+        RecursiveLeastSquares exact{1.0};
+        RecursiveLeastSquares forgetful{forgetting};
+        KalmanHedgeRatio kalman;
+        Comparison exactErrors;
+        Comparison forgetfulErrors;
+        double kalmanRatioError = 0.0;
+        std::size_t kalmanCheckpoints = 0;
+
+        for (std::size_t n = 1; n <= pairs.size(); ++n)
+        {
+            const auto& [future, etf] = pairs[n - 1];
+            exact.Update(future, etf);
+            forgetful.Update(future, etf);
+            kalman.Update(future, etf);
+
+            if (n > window && (n % checkpoint == 0 || n == pairs.size()))
+            {
+                exactErrors.Add(exact.GetEstimate(), fitOls(pairs, 0, n, 1.0), fitOls(pairs, 0, n - 1, 1.0),
+                                pairs[n - 1]);
+                forgetfulErrors.Add(forgetful.GetEstimate(), fitOls(pairs, 0, n, forgetting),
+                                    fitOls(pairs, 0, n - 1, forgetting), pairs[n - 1]);
+                kalmanRatioError += std::abs(kalman.GetEstimate().mHedgeRatio
+                                             - fitOls(pairs, n - window, n, 1.0).mHedgeRatio);
+                ++kalmanCheckpoints;
+            }
+        }
+
+        const OlsFit batch = fitOls(pairs, 0, pairs.size(), 1.0);
+        std::cout << "pairs:                      " << pairs.size() << '\n'
+                  << std::setprecision(6)
+                  << "batch ratio/intercept/var:  " << batch.mHedgeRatio << " / " << batch.mIntercept << " / "
+                  << batch.mResidualVariance << '\n'
+                  << "rls(1) ratio/intercept/var: " << exact.GetEstimate().mHedgeRatio << " / "
+                  << exact.GetEstimate().mIntercept << " / " << exact.GetEstimate().mResidualVariance << '\n'
+                  << "kalman ratio/intercept:     " << kalman.GetEstimate().mHedgeRatio << " / "
+                  << kalman.GetEstimate().mIntercept << '\n';
+
+        std::cout << "\nworst errors against batch least squares at " << kalmanCheckpoints << " checkpoints:\n"
+                  << "                  ratio(rel)  intercept(abs)  variance(rel)  z-score(abs)\n"
+                  << std::scientific << std::setprecision(2)
+                  << "rls(1)            " << exactErrors.mRatio << "    " << exactErrors.mIntercept << "        "
+                  << exactErrors.mVariance << "       " << exactErrors.mZScore << '\n'
+                  << "rls(" << std::fixed << std::setprecision(4) << forgetting << ")       " << std::scientific
+                  << std::setprecision(2) << forgetfulErrors.mRatio << "    " << forgetfulErrors.mIntercept
+                  << "        " << forgetfulErrors.mVariance << "       " << forgetfulErrors.mZScore << '\n'
+                  << std::fixed << std::setprecision(6)
+                  << "kalman mean |ratio - " << window << "-pair rolling ratio|: "
+                  << (kalmanCheckpoints ? kalmanRatioError / double(kalmanCheckpoints) : 0.0) << '\n';
+
+        std::cout << "\n" << std::setprecision(1)
+                  << "rls ns/update:              " << nanosecondsPerUpdate(RecursiveLeastSquares{forgetting}, pairs)
+                  << '\n'
+                  << "kalman ns/update:           " << nanosecondsPerUpdate(KalmanHedgeRatio{}, pairs) << '\n';
+
+        const double worst = std::max({exactErrors.mRatio, exactErrors.mVariance, forgetfulErrors.mRatio,
+                                       forgetfulErrors.mVariance});
+        if (worst > tolerance)
+        {
+            std::cerr << "recursive least squares differs from the batch fit by more than " << tolerance << std::endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,352 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/endian/conversion.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/log/core.hpp>
+
+#include <ready_trader_go/connectivity.h>
+#include <ready_trader_go/protocol.h>
+#include <ready_trader_go/types.h>
+
+using namespace ReadyTraderGo;
+namespace interprocess = boost::interprocess;
+
+// The size of the file the exchange's Python publisher creates.
+constexpr std::size_t RING_FILE_SIZE = 8192;
+
+struct PublishOptions
+{
+    double mRate = 1000.0;
+    std::size_t mBurst = 1;
+    double mSeconds = 5.0;
+    long mStartPrice = 10000;
+    double mVolatility = 0.5;
+    double mTradeTicksProbability = 0.2;
+    bool mFuture = true;
+    bool mEtf = true;
+    unsigned mSeed = 1;
+};
+
+// Writes frames into the ring exactly as the exchange's Publisher does: the
+// payload and its size first, then the next frame's flag is cleared, then
+// this frame's flag is set.
+class RingPublisher
+{
+public:
+    explicit RingPublisher(unsigned char* ring) : mRing(ring) {}
+
+    void Publish(unsigned char messageType, const ISerialisable& message)
+    {
+        unsigned char* frame = mRing + mPosition;
+        unsigned char* payload = frame + FRAME_HEADER_SIZE;
+        const std::size_t size = MESSAGE_HEADER_SIZE + message.Size();
+        *(uint16_t*)payload = boost::endian::native_to_big((uint16_t)size);
+        payload[MESSAGE_TYPE_OFFSET] = messageType;
+        message.Serialise(payload + MESSAGE_HEADER_SIZE);
+        *(uint32_t*)(frame + FRAME_PAYLOAD_SIZE_OFFSET) = boost::endian::native_to_big((uint32_t)size);
+
+        mPosition = (mPosition + FRAME_SIZE) & (SUBSCRIPTION_TRANSPORT_BUFFER_SIZE - 1);
+        __atomic_store_n(mRing + mPosition, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(frame, 1, __ATOMIC_RELEASE);
+        ++mFrames;
+    }
+
+    std::uint64_t GetFrames() const { return mFrames; }
+
+private:
+    unsigned char* mRing;
+    std::size_t mPosition = 0;
+    std::uint64_t mFrames = 0;
+};
+
+// A random walk of the future's midpoint, with the ETF a tick or two either
+// side of it, and books of random volume around each.
+class MarketWalk
+{
+public:
+    explicit MarketWalk(const PublishOptions& options)
+        : mOptions(options), mRandom(options.mSeed), mMid(options.mStartPrice / static_cast<long>(TICK_SIZE_IN_CENTS))
+    {
+    }
+
+    void Step()
+    {
+        mMid += std::lround(mStep(mRandom) * mOptions.mVolatility);
+        mMid = std::max(mMid, 10L);
+        mBasis = std::clamp(mBasis + mBasisStep(mRandom), -2L, 2L);
+    }
+
+    bool HasTrade() { return mUniform(mRandom) < mOptions.mTradeTicksProbability; }
+
+    template<typename Message>
+    void Fill(Message& message, Instrument instrument, unsigned long sequenceNumber)
+    {
+        const long mid = mMid + (instrument == Instrument::ETF ? mBasis : 0);
+        message.mInstrument = instrument;
+        message.mSequenceNumber = sequenceNumber;
+        for (std::size_t i = 0; i < TOP_LEVEL_COUNT; ++i)
+        {
+            message.mAskPrices[i] = Price() + Ticks(mid + 1 + long(i));
+            message.mBidPrices[i] = Price() + Ticks(mid - 1 - long(i));
+            message.mAskVolumes[i] = Volume(mVolume(mRandom));
+            message.mBidVolumes[i] = Volume(mVolume(mRandom));
+        }
+    }
+
+private:
+    const PublishOptions& mOptions;
+    std::mt19937_64 mRandom;
+    std::normal_distribution<double> mStep{0.0, 1.0};
+    std::uniform_int_distribution<long> mBasisStep{-1, 1};
+    std::uniform_int_distribution<unsigned long> mVolume{1, 100};
+    std::uniform_real_distribution<double> mUniform{0.0, 1.0};
+    long mMid;
+    long mBasis = 0;
+};
+
+struct PublishResult
+{
+    std::uint64_t mFrames = 0;
+    double mSeconds = 0.0;
+};
+
+// Publish for the configured time, in bursts of the configured size spaced
+// to give the configured average rate (or flat out if the rate is zero).
+static PublishResult publish(unsigned char* ring, const PublishOptions& options)
+{
+    RingPublisher publisher{ring};
+    MarketWalk walk{options};
+    OrderBookMessage book;
+    TradeTicksMessage ticks;
+    std::array<unsigned long, 2> tradeTicksSequenceNumbers{};
+
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    const auto end = start + std::chrono::duration_cast<Clock::duration>(
+                                 std::chrono::duration<double>(options.mSeconds));
+    const double nanosecondsPerFrame = options.mRate > 0.0 ? 1e9 / options.mRate : 0.0;
+
+    auto send = [&](unsigned char messageType, const ISerialisable& message) {
+        if (nanosecondsPerFrame > 0.0 && publisher.GetFrames() % options.mBurst == 0)
+        {
+            const auto due = start + std::chrono::nanoseconds(std::int64_t(double(publisher.GetFrames())
+                                                                             * nanosecondsPerFrame));
+            // Yielding lets a subscription on the same core keep up, as it
+            // would with the exchange's publisher, which sleeps between ticks.
+            while (Clock::now() < due)
+            {
+                std::this_thread::yield();
+            }
+        }
+        publisher.Publish(messageType, message);
+    };
+
+    for (unsigned long tick = 1; Clock::now() < end; ++tick)
+    {
+        walk.Step();
+        for (Instrument instrument : {Instrument::FUTURE, Instrument::ETF})
+        {
+            if (instrument == Instrument::FUTURE ? !options.mFuture : !options.mEtf)
+                continue;
+            walk.Fill(book, instrument, tick);
+            send(MessageType::ORDER_BOOK_UPDATE, book);
+            if (walk.HasTrade())
+            {
+                walk.Fill(ticks, instrument, ++tradeTicksSequenceNumbers[static_cast<std::size_t>(instrument)]);
+                send(MessageType::TRADE_TICKS, ticks);
+            }
+        }
+    }
+
+    return {publisher.GetFrames(), std::chrono::duration<double>(Clock::now() - start).count()};
+}
+
+static void createRingFile(const std::string& filename)
+{
+    std::ofstream file{filename, std::ios::binary | std::ios::trunc};
+    const std::vector<char> zeros(RING_FILE_SIZE, 0);
+    file.write(zeros.data(), std::streamsize(zeros.size()));
+    if (!file)
+        throw std::runtime_error("failed to create '" + filename + "'");
+}
+
+// Publish at doubling rates to a subscription reading on another thread,
+// until the subscription starts missing messages.
+static int sweep(const std::string& filename, PublishOptions options, double maxRate, unsigned char* ring)
+{
+    std::cout << std::setw(12) << "rate" << std::setw(12) << "achieved" << std::setw(12) << "published"
+              << std::setw(12) << "received" << std::setw(12) << "overruns" << std::setw(12) << "missed" << '\n';
+
+    double sustainable = 0.0;
+    double overrunRate = 0.0;
+    for (; options.mRate <= maxRate; options.mRate *= 2.0)
+    {
+        std::memset(ring, 0, RING_FILE_SIZE);
+
+        boost::asio::io_context context;
+        SubscriptionFactory factory{context, "mmap", filename};
+        std::shared_ptr<ISubscription> subscription = factory.Create();
+        subscription->AsyncReceive();
+        std::thread reader{[&context] { context.run(); }};
+
+        const PublishResult result = publish(ring, options);
+        // Give the reader a moment to catch up before stopping it.
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        context.stop();
+        reader.join();
+
+        const SubscriptionCounters& counters = static_cast<Subscription&>(*subscription).GetCounters();
+        const double achieved = double(result.mFrames) / result.mSeconds;
+        std::cout << std::fixed << std::setprecision(0) << std::setw(12) << options.mRate << std::setw(12) << achieved
+                  << std::setw(12) << result.mFrames << std::setw(12) << counters.mFrames << std::setw(12)
+                  << counters.mOverruns << std::setw(12) << counters.mMissedMessages << '\n';
+
+        if (counters.mMissedMessages != 0)
+        {
+            overrunRate = achieved;
+            break;
+        }
+        sustainable = achieved;
+    }
+
+    std::cout << "maximum sustainable rate: " << sustainable << " messages per second\n";
+    if (overrunRate != 0.0)
+        std::cout << "overruns began at:        " << overrunRate << " messages per second\n";
+    else
+        std::cout << "no overruns up to the maximum rate\n";
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[])
+{
+    PublishOptions options;
+    std::string filename;
+    bool isSweep = false;
+    double maxRate = 1e7;
+    bool usage = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--rate") == 0 && i + 1 < argc)
+        {
+            options.mRate = std::strtod(argv[++i], nullptr);
+        }
+        else if (std::strcmp(argv[i], "--burst") == 0 && i + 1 < argc)
+        {
+            options.mBurst = std::max(1UL, std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+        {
+            options.mSeconds = std::strtod(argv[++i], nullptr);
+        }
+        else if (std::strcmp(argv[i], "--start-price") == 0 && i + 1 < argc)
+        {
+            options.mStartPrice = std::strtol(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--volatility") == 0 && i + 1 < argc)
+        {
+            options.mVolatility = std::strtod(argv[++i], nullptr);
+        }
+        else if (std::strcmp(argv[i], "--trade-ticks") == 0 && i + 1 < argc)
+        {
+            options.mTradeTicksProbability = std::strtod(argv[++i], nullptr);
+        }
+        else if (std::strcmp(argv[i], "--instruments") == 0 && i + 1 < argc)
+        {
+            const std::string mix = argv[++i];
+            options.mFuture = mix == "future" || mix == "both";
+            options.mEtf = mix == "etf" || mix == "both";
+            usage = !options.mFuture && !options.mEtf;
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            options.mSeed = unsigned(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--sweep") == 0)
+        {
+            isSweep = true;
+        }
+        else if (std::strcmp(argv[i], "--max-rate") == 0 && i + 1 < argc)
+        {
+            maxRate = std::strtod(argv[++i], nullptr);
+        }
+        else if (filename.empty() && argv[i][0] != '-')
+        {
+            filename = argv[i];
+        }
+        else
+        {
+            usage = true;
+            break;
+        }
+    }
+
+    if (usage || filename.empty() || (isSweep && options.mRate <= 0.0))
+    {
+        std::cerr << "usage: " << argv[0] << " [--rate MESSAGES_PER_SECOND] [--burst MESSAGES] [--seconds SECONDS]"
+                  << " [--start-price CENTS] [--volatility TICKS] [--trade-ticks PROBABILITY]"
+                  << " [--instruments future|etf|both] [--seed SEED] [--sweep [--max-rate MESSAGES_PER_SECOND]]"
+                  << " INFO_FILE" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // A lapped subscription logs every gap, which would swamp the output.
+    boost::log::core::get()->set_logging_enabled(false);
+
+    try
+    {
+        createRingFile(filename);
+        interprocess::file_mapping file{filename.c_str(), interprocess::read_write};
+        interprocess::mapped_region region{file, interprocess::read_write};
+        auto* ring = static_cast<unsigned char*>(region.get_address());
+
+        if (isSweep)
+        {
+            return sweep(filename, options, maxRate, ring);
+        }
+
+        const PublishResult result = publish(ring, options);
+        std::cout << "messages:            " << result.mFrames << '\n'
+                  << "seconds:             " << result.mSeconds << '\n'
+                  << "messages per second: " << double(result.mFrames) / result.mSeconds << '\n';
+        return EXIT_SUCCESS;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
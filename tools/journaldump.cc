@@ -0,0 +1,88 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <ostream>
+
+#include <boost/endian/conversion.hpp>
+
+#include <ready_trader_go/connectivity.h>
+#include <ready_trader_go/error.h>
+#include <ready_trader_go/journal.h>
+#include <ready_trader_go/protocol.h>
+
+using namespace ReadyTraderGo;
+
+static void printTimestamp(std::ostream& out, std::uint64_t realtime)
+{
+    std::time_t seconds = static_cast<std::time_t>(realtime / 1000000000);
+    std::tm tm = *std::localtime(&seconds);
+    out << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << '.' << std::setw(9) << std::setfill('0')
+        << realtime % 1000000000 << std::setfill(' ');
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2)
+    {
+        std::cerr << "usage: " << argv[0] << " JOURNAL_NAME" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        JournalReader reader{argv[1]};
+        JournalRecord record{};
+        std::uint64_t count = 0;
+
+        while (reader.Next(record))
+        {
+            printTimestamp(std::cout, record.mRealtime);
+            std::cout << " tsc=" << record.mTsc << ' ' << record.mDirection << ' ';
+
+            std::size_t length = 0;
+            if (record.mSize >= MESSAGE_HEADER_SIZE)
+            {
+                length = boost::endian::big_to_native(*(uint16_t const*)record.mData);
+            }
+
+            if (length < MESSAGE_HEADER_SIZE || length != record.mSize)
+            {
+                std::cout << "MALFORMED size=" << record.mSize << '\n';
+            }
+            else
+            {
+                printMessage(std::cout, record.mData[MESSAGE_TYPE_OFFSET], record.mData + MESSAGE_HEADER_SIZE,
+                             record.mSize - MESSAGE_HEADER_SIZE);
+                std::cout << '\n';
+            }
+            ++count;
+        }
+
+        std::cerr << count << " records" << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,240 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/log/core.hpp>
+
+#include <ready_trader_go/connectivity.h>
+
+using namespace ReadyTraderGo;
+using boost::asio::ip::tcp;
+
+// An eight byte payload carrying nothing but a sequence number.
+struct PingMessage : public ISerialisable
+{
+    std::size_t Size() const noexcept override { return sizeof(mSequence); }
+    void Deserialise(unsigned char const* data, std::size_t) override
+    {
+        std::memcpy(&mSequence, data, sizeof(mSequence));
+    }
+    void Serialise(unsigned char* data) const override { std::memcpy(data, &mSequence, sizeof(mSequence)); }
+
+    std::uint64_t mSequence = 0;
+};
+
+// Echo every byte straight back on a plain blocking socket, so that the
+// server side costs the same whichever transport the client uses.
+static void runEchoServer(tcp::acceptor& acceptor)
+{
+    boost::asio::io_context context;
+    tcp::socket socket{context};
+    acceptor.accept(socket);
+    socket.set_option(tcp::no_delay(true));
+
+    unsigned char buffer[4096];
+    boost::system::error_code error;
+    for (;;)
+    {
+        const std::size_t size = socket.read_some(boost::asio::buffer(buffer), error);
+        if (error)
+            return;
+        boost::asio::write(socket, boost::asio::buffer(buffer, size), error);
+        if (error)
+            return;
+    }
+}
+
+static double cpuSeconds(int who)
+{
+    rusage usage{};
+    getrusage(who, &usage);
+    return double(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+           + double(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string transport = "asio";
+    bool sqPoll = false;
+    bool busyPoll = false;
+    std::size_t messages = 100000;
+    std::size_t warmup = 1000;
+    bool usage = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--transport") == 0 && i + 1 < argc)
+        {
+            transport = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--sqpoll") == 0)
+        {
+            sqPoll = true;
+        }
+        else if (std::strcmp(argv[i], "--busy-poll") == 0)
+        {
+            busyPoll = true;
+        }
+        else if (std::strcmp(argv[i], "--messages") == 0 && i + 1 < argc)
+        {
+            messages = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+        {
+            warmup = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else
+        {
+            usage = true;
+            break;
+        }
+    }
+
+    if (usage || messages == 0 || (transport != "asio" && transport != "io_uring"))
+    {
+        std::cerr << "usage: " << argv[0] << " [--transport asio|io_uring] [--sqpoll] [--busy-poll]"
+                  << " [--messages COUNT] [--warmup COUNT]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    boost::log::core::get()->set_logging_enabled(false);
+
+    try
+    {
+        boost::asio::io_context serverContext;
+        tcp::acceptor acceptor{serverContext, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)};
+        const unsigned short port = acceptor.local_endpoint().port();
+        std::thread server{[&acceptor] { runEchoServer(acceptor); }};
+
+        boost::asio::io_context context;
+        ConnectionFactory factory{context, "127.0.0.1", port};
+        if (transport == "io_uring")
+        {
+            IoUringOptions options;
+            options.mSqPoll = sqPoll;
+            factory.SetIoUring(options, busyPoll);
+        }
+        std::unique_ptr<IConnection> connection = factory.Create();
+#ifdef __linux__
+        auto* ioUringConnection = dynamic_cast<IoUringConnection*>(connection.get());
+        if (transport == "io_uring" && !ioUringConnection)
+        {
+            std::cerr << "warning: io_uring is unavailable, so the Asio connection is being measured" << std::endl;
+        }
+#endif
+
+        // Ping-pong: each echo is timed and immediately answered by the next
+        // message, so exactly one message is ever in flight.
+        std::vector<double> roundTrips;
+        roundTrips.reserve(messages);
+        PingMessage ping;
+        auto sent = std::chrono::steady_clock::now();
+        double threadCpuStart = 0;
+        double processCpuStart = 0;
+        std::chrono::steady_clock::time_point wallStart;
+
+        connection->Disconnected = [&context] { context.stop(); };
+        connection->MessageReceived = [&](IConnection* c, unsigned char, unsigned char const*, std::size_t) {
+            const auto now = std::chrono::steady_clock::now();
+            if (ping.mSequence == warmup)
+            {
+                threadCpuStart = cpuSeconds(RUSAGE_THREAD);
+                processCpuStart = cpuSeconds(RUSAGE_SELF);
+                wallStart = now;
+            }
+            else if (ping.mSequence > warmup)
+            {
+                roundTrips.push_back(std::chrono::duration<double, std::nano>(now - sent).count());
+            }
+
+            if (roundTrips.size() == messages)
+            {
+                context.stop();
+                return;
+            }
+            ++ping.mSequence;
+            sent = std::chrono::steady_clock::now();
+            c->SendMessage(0, ping);
+        };
+
+        connection->SendMessage(0, ping);
+        connection->AsyncRead();
+        context.run();
+
+        const double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+        const double threadCpu = cpuSeconds(RUSAGE_THREAD) - threadCpuStart;
+        const double processCpu = cpuSeconds(RUSAGE_SELF) - processCpuStart;
+#ifdef __linux__
+        const std::uint64_t enters = ioUringConnection ? ioUringConnection->GetEnterCount() : 0;
+#endif
+
+        connection.reset();
+        server.join();
+
+        if (roundTrips.size() != messages)
+            throw std::runtime_error("connection closed after " + std::to_string(roundTrips.size()) + " messages");
+
+        std::sort(roundTrips.begin(), roundTrips.end());
+        auto percentile = [&roundTrips](double p) {
+            return roundTrips[std::min(roundTrips.size() - 1, std::size_t(p * double(roundTrips.size())))];
+        };
+
+        std::cout << "transport:             " << transport << (sqPoll ? " sqpoll" : "")
+                  << (busyPoll ? " busy-poll" : "") << '\n'
+                  << "round trips:           " << messages << '\n'
+                  << std::fixed << std::setprecision(0)
+                  << "min ns:                " << roundTrips.front() << '\n'
+                  << "p50 ns:                " << percentile(0.5) << '\n'
+                  << "p90 ns:                " << percentile(0.9) << '\n'
+                  << "p99 ns:                " << percentile(0.99) << '\n'
+                  << "p99.9 ns:              " << percentile(0.999) << '\n'
+                  << "max ns:                " << roundTrips.back() << '\n'
+                  << std::setprecision(2)
+                  << "client cpu us/trip:    " << threadCpu * 1e6 / double(messages) << '\n'
+                  << "process cpu us/trip:   " << processCpu * 1e6 / double(messages) << '\n'
+                  << "client cpu share:      " << 100.0 * threadCpu / wallSeconds << "%\n";
+#ifdef __linux__
+        if (ioUringConnection)
+        {
+            std::cout << "io_uring_enter/trip:   " << double(enters) / double(messages + warmup + 1) << '\n';
+        }
+#endif
+        return EXIT_SUCCESS;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
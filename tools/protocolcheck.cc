@@ -0,0 +1,485 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <ready_trader_go/errorcode.h>
+#include <ready_trader_go/protocol.h>
+#include <ready_trader_go/types.h>
+
+using namespace ReadyTraderGo;
+
+using Bytes = std::vector<unsigned char>;
+
+// Builds a message's bytes one field after another, as the exchange
+// documents them, without reference to the message layouts.
+class ReferenceWriter
+{
+public:
+    void Byte(unsigned char value) { mBytes.push_back(value); }
+
+    void Long(std::uint32_t value)
+    {
+        for (int shift = 24; shift >= 0; shift -= 8)
+            mBytes.push_back(static_cast<unsigned char>(value >> shift));
+    }
+
+    void String(const std::string& value)
+    {
+        for (std::size_t i = 0; i < MessageFieldSize::STRING; ++i)
+            mBytes.push_back(i < value.size() ? static_cast<unsigned char>(value[i]) : 0);
+    }
+
+    template<typename T>
+    void Levels(const std::array<T, TOP_LEVEL_COUNT>& values)
+    {
+        for (auto v : values)
+            Long(std::uint32_t(toWire(v)));
+    }
+
+    const Bytes& GetBytes() const { return mBytes; }
+
+private:
+    static unsigned long toWire(Price price) { return price.Cents(); }
+    static unsigned long toWire(Volume volume) { return volume.Lots(); }
+
+    Bytes mBytes;
+};
+
+class Randomiser
+{
+public:
+    explicit Randomiser(unsigned seed) : mRandom(seed) {}
+
+    unsigned long Long() { return mLong(mRandom); }
+    signed long SignedLong() { return std::int32_t(mLong(mRandom)); }
+    unsigned char Byte() { return static_cast<unsigned char>(mLong(mRandom)); }
+    Price NextPrice() { return Price(Long()); }
+    Volume NextVolume() { return Volume(Long()); }
+    template<typename E>
+    E Enum() { return E(mLong(mRandom) & 1); }
+
+    std::string String()
+    {
+        std::string value(mLong(mRandom) % (MessageFieldSize::STRING + 1), ' ');
+        for (char& c : value)
+            c = static_cast<char>(' ' + mLong(mRandom) % 95);
+        return value;
+    }
+
+    template<typename T>
+    void Levels(std::array<T, TOP_LEVEL_COUNT>& values)
+    {
+        for (auto& v : values)
+            v = T(Long());
+    }
+
+    void Fill(Bytes& bytes)
+    {
+        for (auto& b : bytes)
+            b = Byte();
+    }
+
+private:
+    std::mt19937_64 mRandom;
+    std::uniform_int_distribution<std::uint32_t> mLong;
+};
+
+static void randomise(AmendMessage& m, Randomiser& r)
+{
+    m = AmendMessage{r.Long(), r.NextVolume()};
+}
+
+static void reference(const AmendMessage& m, ReferenceWriter& w)
+{
+    w.Long(m.mClientOrderId);
+    w.Long(m.mNewVolume.Lots());
+}
+
+static void randomise(CancelMessage& m, Randomiser& r)
+{
+    m = CancelMessage{r.Long()};
+}
+
+static void reference(const CancelMessage& m, ReferenceWriter& w)
+{
+    w.Long(m.mClientOrderId);
+}
+
+static void randomise(ErrorMessage& m, Randomiser& r)
+{
+    m = ErrorMessage{r.Long(), r.String()};
+}
+
+static void reference(const ErrorMessage& m, ReferenceWriter& w)
+{
+    w.Long(m.mClientOrderId);
+    w.String(m.mMessage);
+}
+
+static void randomise(HedgeMessage& m, Randomiser& r)
+{
+    m = HedgeMessage{r.Long(), r.Enum<Side>(), r.NextPrice(), r.NextVolume()};
+}
+
+static void reference(const HedgeMessage& m, ReferenceWriter& w)
+{
+    w.Long(m.mClientOrderId);
+    w.Byte(static_cast<unsigned char>(m.mSide));
+    w.Long(m.mPrice.Cents());
+    w.Long(m.mVolume.Lots());
+}
+
+static void randomise(HedgeFilledMessage& m, Randomiser& r)
+{
+    m = HedgeFilledMessage{r.Long(), r.NextPrice(), r.NextVolume()};
+}
+
+static void reference(const HedgeFilledMessage& m, ReferenceWriter& w)
+{
+    w.Long(m.mClientOrderId);
+    w.Long(m.mPrice.Cents());
+    w.Long(m.mVolume.Lots());
+}
+
+static void randomise(InsertMessage& m, Randomiser& r)
+{
+    m = InsertMessage{r.Long(), r.Enum<Side>(), r.NextPrice(), r.NextVolume(), r.Enum<Lifespan>()};
+}
+
+static void reference(const InsertMessage& m, ReferenceWriter& w)
+{
+    w.Long(m.mClientOrderId);
+    w.Byte(static_cast<unsigned char>(m.mSide));
+    w.Long(m.mPrice.Cents());
+    w.Long(m.mVolume.Lots());
+    w.Byte(static_cast<unsigned char>(m.mLifespan));
+}
+
+static void randomise(LoginMessage& m, Randomiser& r)
+{
+    m = LoginMessage{r.String(), r.String()};
+}
+
+static void reference(const LoginMessage& m, ReferenceWriter& w)
+{
+    w.String(m.mName);
+    w.String(m.mSecret);
+}
+
+template<typename M>
+static void randomiseLevels(M& m, Randomiser& r)
+{
+    m.mInstrument = r.Enum<Instrument>();
+    m.mSequenceNumber = r.Long();
+    r.Levels(m.mAskPrices);
+    r.Levels(m.mAskVolumes);
+    r.Levels(m.mBidPrices);
+    r.Levels(m.mBidVolumes);
+}
+
+template<typename M>
+static void referenceLevels(const M& m, ReferenceWriter& w)
+{
+    w.Byte(static_cast<unsigned char>(m.mInstrument));
+    w.Long(m.mSequenceNumber);
+    w.Levels(m.mAskPrices);
+    w.Levels(m.mAskVolumes);
+    w.Levels(m.mBidPrices);
+    w.Levels(m.mBidVolumes);
+}
+
+static void randomise(OrderBookMessage& m, Randomiser& r)
+{
+    randomiseLevels(m, r);
+}
+
+static void reference(const OrderBookMessage& m, ReferenceWriter& w)
+{
+    referenceLevels(m, w);
+}
+
+static void randomise(OrderFilledMessage& m, Randomiser& r)
+{
+    m = OrderFilledMessage{r.Long(), r.NextPrice(), r.NextVolume()};
+}
+
+static void reference(const OrderFilledMessage& m, ReferenceWriter& w)
+{
+    w.Long(m.mClientOrderId);
+    w.Long(m.mPrice.Cents());
+    w.Long(m.mVolume.Lots());
+}
+
+static void randomise(OrderStatusMessage& m, Randomiser& r)
+{
+    m = OrderStatusMessage{r.Long(), r.NextVolume(), r.NextVolume(), r.SignedLong()};
+}
+
+static void reference(const OrderStatusMessage& m, ReferenceWriter& w)
+{
+    w.Long(m.mClientOrderId);
+    w.Long(m.mFillVolume.Lots());
+    w.Long(m.mRemainingVolume.Lots());
+    w.Long(std::uint32_t(m.mFees));
+}
+
+static void randomise(TradeTicksMessage& m, Randomiser& r)
+{
+    randomiseLevels(m, r);
+}
+
+static void reference(const TradeTicksMessage& m, ReferenceWriter& w)
+{
+    referenceLevels(m, w);
+}
+
+// What encoding a decoded message should give back: the same bytes, except
+// that anything after a string's terminator is zero.
+static Bytes canonical(Bytes bytes, std::initializer_list<std::size_t> stringOffsets)
+{
+    for (std::size_t offset : stringOffsets)
+    {
+        auto begin = bytes.begin() + offset;
+        auto end = begin + MessageFieldSize::STRING;
+        std::fill(std::find(begin, end, 0), end, 0);
+    }
+    return bytes;
+}
+
+template<typename M>
+static bool check(const char* name, unsigned char messageType, std::initializer_list<std::size_t> stringOffsets,
+                  Randomiser& random, std::size_t iterations)
+{
+    constexpr std::size_t size = M::Layout::SIZE;
+    std::size_t mismatches = 0;
+    std::size_t fuzzMismatches = 0;
+    Bytes bytes(size);
+    Bytes encoded(size);
+    std::ostringstream printed;
+
+    // Random messages must encode as the reference does and decode back to
+    // the same message.
+    for (std::size_t i = 0; i < iterations; ++i)
+    {
+        M message;
+        randomise(message, random);
+        message.Serialise(bytes.data());
+        ReferenceWriter writer;
+        reference(message, writer);
+        makeMessage<M>(bytes.data(), size).Serialise(encoded.data());
+        mismatches += (message.Size() != size || writer.GetBytes() != bytes || encoded != bytes) ? 1 : 0;
+    }
+
+    // Any bytes at all must decode, print and encode again without change.
+    for (std::size_t i = 0; i < iterations; ++i)
+    {
+        random.Fill(bytes);
+        makeMessage<M>(bytes.data(), size).Serialise(encoded.data());
+        fuzzMismatches += (encoded != canonical(bytes, stringOffsets)) ? 1 : 0;
+        printed.str(std::string());
+        printMessage(printed, messageType, bytes.data(), size);
+    }
+
+    // Timed over a pool of different messages, each read back afterwards so
+    // that none of the work can be left out.
+    constexpr std::size_t POOL_SIZE = 256;
+    Bytes input(POOL_SIZE * size);
+    Bytes output(POOL_SIZE * size);
+    random.Fill(input);
+    std::vector<M> pool(POOL_SIZE);
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i)
+    {
+        const std::size_t slot = i % POOL_SIZE;
+        pool[slot].Deserialise(input.data() + slot * size, size);
+    }
+    const double decode = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i)
+    {
+        const std::size_t slot = i % POOL_SIZE;
+        pool[slot].Serialise(output.data() + slot * size);
+    }
+    const double encode = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    unsigned long sink = 0;
+    for (unsigned char b : output)
+        sink += b;
+    volatile unsigned long keep = sink;
+    (void) keep;
+
+    std::cout << std::left << std::setw(20) << name << std::right << std::setw(6) << size << std::setw(12)
+              << mismatches << std::setw(12) << fuzzMismatches << std::fixed << std::setprecision(1)
+              << std::setw(12) << decode / double(iterations) << std::setw(12) << encode / double(iterations)
+              << '\n';
+    return mismatches == 0 && fuzzMismatches == 0;
+}
+
+// Error texts as the exchange, the stub exchange, the order gateway and the
+// autotrader send them, with the codes they should be given.
+static const std::pair<const char*, ErrorCode> ERROR_TEXTS[] = {
+    {"out-of-order client_order_id in amend message", ErrorCode::OUT_OF_ORDER_AMEND},
+    {"amend operation would increase order volume", ErrorCode::AMEND_INCREASES_VOLUME},
+    {"out-of-order client_order_id in cancel message", ErrorCode::OUT_OF_ORDER_CANCEL},
+    {"duplicate or out-of-order client_order_id", ErrorCode::DUPLICATE_ORDER_ID},
+    {"3 is not a valid side", ErrorCode::INVALID_SIDE},
+    {"-100 is not a valid price", ErrorCode::INVALID_PRICE},
+    {"0 is not a valid volume", ErrorCode::INVALID_VOLUME},
+    {"%d is not a valid volume", ErrorCode::INVALID_VOLUME},
+    {"7 is not a valid lifespan", ErrorCode::INVALID_LIFESPAN},
+    {"99 is not a valid message type", ErrorCode::INVALID_MESSAGE_TYPE},
+    {"price is not a multiple of tick size", ErrorCode::PRICE_NOT_ON_TICK},
+    {"order rejected: market not yet open", ErrorCode::MARKET_NOT_OPEN},
+    {"order rejected: cannot determine future price", ErrorCode::NO_FUTURE_PRICE},
+    {"order rejected: active order count limit breached", ErrorCode::ACTIVE_ORDER_COUNT_LIMIT},
+    {"order rejected: active order volume limit breached", ErrorCode::ACTIVE_VOLUME_LIMIT},
+    {"order rejected: in cross with an existing order", ErrorCode::IN_CROSS},
+    {"ETF position limit breached", ErrorCode::ETF_POSITION_LIMIT},
+    {"future position limit breached", ErrorCode::FUTURE_POSITION_LIMIT},
+    {"held unhedged lots for longer than the time limit", ErrorCode::UNHEDGED_LOTS_TIME_LIMIT},
+    {"message frequency limit breached", ErrorCode::MESSAGE_FREQUENCY_LIMIT},
+    {"already logged in", ErrorCode::ALREADY_LOGGED_IN},
+    {"not logged in", ErrorCode::NOT_LOGGED_IN},
+    {"order gateway queue is full", ErrorCode::GATEWAY_QUEUE_FULL},
+    {"execution connection is down", ErrorCode::NOT_CONNECTED},
+};
+
+// Every known text must be given its code after a trip over the wire, and
+// every text one edit away from it none.
+static bool checkErrorCodes(std::size_t iterations)
+{
+    std::size_t mismatches = 0;
+    std::vector<Bytes> encoded;
+    for (const auto& [text, code] : ERROR_TEXTS)
+    {
+        Bytes bytes(ErrorMessage::Layout::SIZE);
+        ErrorMessage{1, text}.Serialise(bytes.data());
+        MessageView<ErrorMessage> view(bytes.data(), bytes.size());
+        mismatches += (ClassifyError(view.Get<&ErrorMessage::mMessage>()) != code) ? 1 : 0;
+        encoded.push_back(std::move(bytes));
+
+        // The value an error about a value begins with may be anything, so
+        // only the text after it is changed.
+        const std::string known{text};
+        const std::size_t first = (known.find(" is not a valid ") != std::string::npos) ? known.find(' ') + 1 : 0;
+        std::vector<std::string> nearMisses{known.substr(0, known.size() - 1), known + "!",
+                                            std::string(known).erase(first, 1)};
+        for (std::size_t i = first; i < known.size(); ++i)
+        {
+            std::string changed = known;
+            changed[i] = (changed[i] == 'x') ? 'y' : 'x';
+            nearMisses.push_back(changed);
+        }
+        for (const std::string& miss : nearMisses)
+        {
+            mismatches += (ClassifyError(miss) != ErrorCode::UNKNOWN) ? 1 : 0;
+        }
+    }
+
+    unsigned long sink = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i)
+    {
+        const Bytes& bytes = encoded[i % encoded.size()];
+        MessageView<ErrorMessage> view(bytes.data(), bytes.size());
+        sink += static_cast<unsigned long>(ClassifyError(view.Get<&ErrorMessage::mMessage>()));
+    }
+    const double classify = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    volatile unsigned long keep = sink;
+    (void) keep;
+
+    std::cout << std::left << std::setw(20) << "ERROR codes" << std::right << std::setw(6) << std::size(ERROR_TEXTS)
+              << std::setw(12) << mismatches << std::fixed << std::setprecision(1) << std::setw(24)
+              << classify / double(iterations) << '\n';
+    return mismatches == 0;
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t iterations = 100000;
+    unsigned seed = 1;
+    bool usage = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+        {
+            iterations = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            seed = unsigned(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else
+        {
+            usage = true;
+            break;
+        }
+    }
+
+    if (usage || iterations == 0)
+    {
+        std::cerr << "usage: " << argv[0] << " [--iterations COUNT] [--seed SEED]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        Randomiser random{seed};
+        std::cout << "message              size  mismatches  fuzz fails   decode ns   encode ns\n";
+        bool ok = true;
+        ok &= check<AmendMessage>("AMEND_ORDER", MessageType::AMEND_ORDER, {}, random, iterations);
+        ok &= check<CancelMessage>("CANCEL_ORDER", MessageType::CANCEL_ORDER, {}, random, iterations);
+        ok &= check<ErrorMessage>("ERROR", MessageType::ERROR_MESSAGE, {4}, random, iterations);
+        ok &= check<HedgeFilledMessage>("HEDGE_FILLED", MessageType::HEDGE_FILLED, {}, random, iterations);
+        ok &= check<HedgeMessage>("HEDGE_ORDER", MessageType::HEDGE_ORDER, {}, random, iterations);
+        ok &= check<InsertMessage>("INSERT_ORDER", MessageType::INSERT_ORDER, {}, random, iterations);
+        ok &= check<LoginMessage>("LOGIN", MessageType::LOGIN, {0, 50}, random, iterations);
+        ok &= check<OrderBookMessage>("ORDER_BOOK_UPDATE", MessageType::ORDER_BOOK_UPDATE, {}, random, iterations);
+        ok &= check<OrderFilledMessage>("ORDER_FILLED", MessageType::ORDER_FILLED, {}, random, iterations);
+        ok &= check<OrderStatusMessage>("ORDER_STATUS", MessageType::ORDER_STATUS, {}, random, iterations);
+        ok &= check<TradeTicksMessage>("TRADE_TICKS", MessageType::TRADE_TICKS, {}, random, iterations);
+        ok &= checkErrorCodes(iterations);
+
+        if (!ok)
+        {
+            std::cerr << "some messages did not encode, decode or classify as the protocol describes" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "protocolcheck: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
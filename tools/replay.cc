@@ -0,0 +1,125 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/log/core.hpp>
+
+#include <ready_trader_go/connectivity.h>
+#include <ready_trader_go/protocol.h>
+#include <ready_trader_go/replay.h>
+
+#include "autotrader.h"
+
+using namespace ReadyTraderGo;
+
+static void printSent(std::ostream& out, const char* label, const std::vector<unsigned char>& message)
+{
+    out << "  " << label << ": ";
+    if (message.empty())
+    {
+        out << "(nothing)";
+    }
+    else
+    {
+        printMessage(out, message[MESSAGE_TYPE_OFFSET], message.data() + MESSAGE_HEADER_SIZE,
+                     message.size() - MESSAGE_HEADER_SIZE);
+    }
+    out << '\n';
+}
+
+int main(int argc, char* argv[])
+{
+    ReplayPacing pacing = ReplayPacing::MAXIMUM;
+    bool verbose = false;
+    std::string journalName;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--original-pacing") == 0)
+        {
+            pacing = ReplayPacing::ORIGINAL;
+        }
+        else if (std::strcmp(argv[i], "--verbose") == 0)
+        {
+            verbose = true;
+        }
+        else if (journalName.empty() && argv[i][0] != '-')
+        {
+            journalName = argv[i];
+        }
+        else
+        {
+            journalName.clear();
+            break;
+        }
+    }
+
+    if (journalName.empty())
+    {
+        std::cerr << "usage: " << argv[0] << " [--original-pacing] [--verbose] JOURNAL_NAME" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Logging would dominate the handler timings, so it is off unless asked for.
+    boost::log::core::get()->set_logging_enabled(verbose);
+
+    try
+    {
+        boost::asio::io_context context;
+        AutoTrader trader{context};
+        JournalReplayer replayer{trader, journalName, pacing};
+        ReplayResult result = replayer.Run();
+
+        const std::uint64_t handled = result.mInformationCount + result.mExecutionCount;
+        std::cout << "records:            " << result.mRecordCount << '\n'
+                  << "information:        " << result.mInformationCount << '\n'
+                  << "execution:          " << result.mExecutionCount << '\n'
+                  << "malformed:          " << result.mMalformedCount << '\n'
+                  << "expected sends:     " << result.mExpectedCount << '\n'
+                  << "captured sends:     " << result.mCapturedCount << '\n'
+                  << "mismatches:         " << result.mMismatchCount << '\n'
+                  << "session seconds:    " << result.mSessionNanoseconds / 1e9 << '\n'
+                  << "handler seconds:    " << result.mHandlerNanoseconds / 1e9 << '\n';
+        if (handled != 0 && result.mHandlerNanoseconds != 0)
+        {
+            std::cout << "ns per message:     " << double(result.mHandlerNanoseconds) / double(handled) << '\n'
+                      << "messages per second: " << 1e9 * double(handled) / double(result.mHandlerNanoseconds)
+                      << '\n';
+        }
+
+        for (auto& mismatch : result.mMismatches)
+        {
+            std::cout << "mismatch at send " << mismatch.mIndex << " (t=" << mismatch.mRealtime << "):\n";
+            printSent(std::cout, "recorded", mismatch.mExpected);
+            printSent(std::cout, "replayed", mismatch.mActual);
+        }
+
+        return result.mMismatchCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,168 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#define BOOST_BIND_GLOBAL_PLACEHOLDERS
+#include <boost/asio/io_context.hpp>
+#include <boost/log/core.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <ready_trader_go/allocationtracker.h>
+#include <ready_trader_go/columnarevents.h>
+#include <ready_trader_go/handlerprofiler.h>
+#include <simulator/simulator.h>
+
+#include "autotrader.h"
+
+using namespace ReadyTraderGo;
+
+int main(int argc, char* argv[])
+{
+    bool verbose = false;
+    bool profile = false;
+    unsigned long allocationWarmup = 0;
+    std::string exchangeConfig;
+    std::string eventsName;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--verbose") == 0)
+        {
+            verbose = true;
+        }
+        else if (std::strcmp(argv[i], "--profile") == 0)
+        {
+            profile = true;
+        }
+        else if (std::strcmp(argv[i], "--allocations") == 0 && i + 1 < argc)
+        {
+            allocationWarmup = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--exchange-config") == 0 && i + 1 < argc)
+        {
+            exchangeConfig = argv[++i];
+        }
+        else if (eventsName.empty() && argv[i][0] != '-')
+        {
+            eventsName = argv[i];
+        }
+        else
+        {
+            eventsName.clear();
+            break;
+        }
+    }
+
+    if (eventsName.empty())
+    {
+        std::cerr << "usage: " << argv[0] << " [--exchange-config EXCHANGE_JSON] [--profile]"
+                  << " [--allocations WARMUP_MESSAGES] [--verbose] COLUMNAR_EVENTS" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Logging would dominate the run time, so it is off unless asked for.
+    boost::log::core::get()->set_logging_enabled(verbose);
+
+    try
+    {
+        SimulatorConfig config;
+        if (!exchangeConfig.empty())
+        {
+            boost::property_tree::ptree tree;
+            boost::property_tree::read_json(exchangeConfig, tree);
+            config.readFromPropertyTree(tree);
+        }
+
+        ColumnarEvents events{eventsName};
+        boost::asio::io_context context;
+        AutoTrader trader{context};
+        trader.SetLoginDetails("Simulated", "secret");
+        Simulator simulator{trader, events, config};
+
+        std::unique_ptr<HandlerProfiler> profiler;
+        if (profile)
+        {
+            if (!HANDLER_PROFILING_ENABLED)
+            {
+                std::cerr << "warning: built without RTG_PERF_COUNTERS, so nothing will be profiled" << std::endl;
+            }
+            profiler = std::make_unique<HandlerProfiler>();
+            trader.SetHandlerProfiler(profiler.get());
+        }
+
+        if (allocationWarmup != 0)
+        {
+            if (!ALLOCATION_TRACKING_ENABLED)
+            {
+                std::cerr << "warning: built without RTG_ALLOCATION_TRACKING, so nothing will be tracked" << std::endl;
+            }
+            trader.SetAllocationWatch(allocationWarmup, AllocationPolicy::REPORT);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        SimulatorResult result = simulator.Run();
+        markTradingStopped();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "market events:      " << result.mMarketEventCount << '\n'
+                  << "ticks:              " << result.mTickCount << '\n'
+                  << "match seconds:      " << double(result.mMatchTime) / MICROSECONDS_PER_SECOND << '\n'
+                  << "messages:           " << result.mMessageCount << '\n'
+                  << "inserts:            " << result.mInsertCount << '\n'
+                  << "amends:             " << result.mAmendCount << '\n'
+                  << "cancels:            " << result.mCancelCount << '\n'
+                  << "hedges:             " << result.mHedgeCount << '\n'
+                  << "errors:             " << result.mErrorCount << '\n'
+                  << "fills:              " << result.mFillCount << " (" << result.mFillVolume << " lots)\n"
+                  << "etf position:       " << result.mEtfPosition << " (max " << result.mMaxEtfPosition << ")\n"
+                  << "future position:    " << result.mFuturePosition << " (max " << result.mMaxFuturePosition
+                  << ")\n"
+                  << "fees:               " << result.mTotalFees << '\n'
+                  << "profit or loss:     " << result.mProfitOrLoss << '\n'
+                  << "max drawdown:       " << result.mMaxDrawdown << '\n'
+                  << "breached:           " << (result.mBreached ? "yes" : "no") << '\n'
+                  << "wall seconds:       " << seconds << '\n'
+                  << "events per second:  " << double(result.mMarketEventCount) / seconds << '\n'
+                  << "speed-up:           " << double(result.mMatchTime) / MICROSECONDS_PER_SECOND / seconds
+                  << "x\n";
+
+        if (profiler)
+        {
+            profiler->WriteReport(std::cout);
+        }
+
+        if (allocationWarmup != 0)
+        {
+            // The simulated exchange shares the thread, so only the trader's call sites are listed.
+            writeAllocationReport(std::cout, "AutoTrader");
+        }
+
+        return EXIT_SUCCESS;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,120 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <ready_trader_go/application.h>
+#include <ready_trader_go/autotraderapphandler.h>
+#include <ready_trader_go/error.h>
+#include <ready_trader_go/strategyhost.h>
+
+#include "autotrader.h"
+
+using namespace ReadyTraderGo;
+
+// Add the strategies listed in the configuration's "Strategies" array, or a
+// single live strategy with the default parameters if there is no such array.
+static void addStrategies(StrategyHost& host, const boost::property_tree::ptree& tree)
+{
+    const auto interval = tree.get<double>("Limits.MessageFrequencyInterval", 1.0);
+    host.SetMessageFrequencyLimit(tree.get<std::size_t>("Limits.MessageFrequencyLimit", 50),
+                                  std::chrono::nanoseconds(static_cast<std::int64_t>(interval * 1e9)));
+    host.SetActiveOrderCountLimit(tree.get<std::size_t>("Limits.ActiveOrderCountLimit", 10));
+
+    const auto strategies = tree.get_child_optional("Strategies");
+    if (!strategies)
+    {
+        host.AddStrategy(StrategyOptions{"AutoTrader", StrategyMode::LIVE}, [](boost::asio::io_context& context) {
+            return std::make_unique<AutoTrader>(context);
+        });
+        return;
+    }
+
+    const AutoTraderParameters defaults;
+    for (const auto& child : *strategies)
+    {
+        const boost::property_tree::ptree& strategy = child.second;
+
+        StrategyOptions options;
+        options.mName = strategy.get<std::string>("Name");
+        const auto mode = strategy.get<std::string>("Mode", "shadow");
+        if (mode == "live")
+            options.mMode = StrategyMode::LIVE;
+        else if (mode != "shadow")
+            throw ReadyTraderGoError("configured strategy mode must be 'live' or 'shadow'");
+        options.mCore = strategy.get<int>("Core", -1);
+        options.mQueueCapacity = strategy.get<std::size_t>("QueueCapacity", options.mQueueCapacity);
+        options.mWeight = strategy.get<unsigned>("Weight", options.mWeight);
+
+        AutoTraderParameters parameters;
+        parameters.mLotSize = strategy.get<unsigned long>("LotSize", defaults.mLotSize);
+        parameters.mThreshold = strategy.get<double>("Threshold", defaults.mThreshold);
+        parameters.mWindowSize = strategy.get<std::size_t>("WindowSize", defaults.mWindowSize);
+        parameters.mOrderLifetime = strategy.get<double>("OrderLifetime", defaults.mOrderLifetime);
+        parameters.mRiskCheckInterval = strategy.get<double>("RiskCheckInterval", defaults.mRiskCheckInterval);
+        const auto spreadModel = strategy.get<std::string>("SpreadModel", "fixed");
+        if (spreadModel == "rls")
+            parameters.mSpreadModel = SpreadModel::RECURSIVE_LEAST_SQUARES;
+        else if (spreadModel == "kalman")
+            parameters.mSpreadModel = SpreadModel::KALMAN;
+        else if (spreadModel != "fixed")
+            throw ReadyTraderGoError("configured spread model must be 'fixed', 'rls' or 'kalman'");
+        parameters.mForgettingFactor = strategy.get<double>("ForgettingFactor", defaults.mForgettingFactor);
+        parameters.mRequeueFillProbability = strategy.get<double>("RequeueFillProbability",
+                                                                   defaults.mRequeueFillProbability);
+
+        host.AddStrategy(options, [parameters](boost::asio::io_context& context) {
+            return std::make_unique<AutoTrader>(context, parameters);
+        });
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        Application app;
+        StrategyHost host{app.GetContext()};
+        AutoTraderAppHandler appHandler{app, host};
+        auto configLoaded = app.ConfigLoaded;
+        app.ConfigLoaded = [&host, configLoaded](const boost::property_tree::ptree& tree) {
+            configLoaded(tree);
+            addStrategies(host, tree);
+        };
+        app.Run(argc, argv);
+    }
+    catch (const ReadyTraderGoError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    catch (...)
+    {
+        // Catch block added so the Application object gets destructed
+        // and the log gets flushed.
+        throw;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,361 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/signal_set.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/log/core.hpp>
+
+#include <ready_trader_go/connectivity.h>
+#include <ready_trader_go/protocol.h>
+#include <ready_trader_go/types.h>
+
+using namespace ReadyTraderGo;
+using boost::asio::ip::tcp;
+
+struct StubExchangeOptions
+{
+    unsigned short mPort = 12345;
+    std::chrono::microseconds mLatency{0};
+    // Probability that an inserted order is filled in full, at its own price.
+    double mFillRatio = 0.0;
+    double mTakerFee = 0.0002;
+    unsigned mSeed = 1;
+};
+
+// A stand-in for the exchange's execution side, just enough to exercise an
+// autotrader's networking: every request is answered as the real exchange
+// would answer it, but fills are decided by a coin toss rather than by
+// matching, and each response can be held back for a fixed latency.
+class StubExchange
+{
+public:
+    StubExchange(boost::asio::io_context& context, const StubExchangeOptions& options)
+        : mContext(context), mOptions(options), mAcceptor(context, tcp::endpoint(tcp::v4(), options.mPort)),
+          mRandom(options.mSeed)
+    {
+        Accept();
+    }
+
+private:
+    struct Order
+    {
+        Price mPrice;
+        Volume mFilled;
+        Volume mRemaining;
+    };
+
+    struct Session
+    {
+        std::shared_ptr<Connection> mConnection;
+        bool mIsLoggedIn = false;
+        unsigned long mLastOrderId = 0;
+        std::unordered_map<unsigned long, Order> mOrders;
+    };
+
+    using SessionIterator = std::list<Session>::iterator;
+
+    void Accept()
+    {
+        mAcceptor.async_accept([this](const boost::system::error_code& error, tcp::socket socket) {
+            if (error)
+            {
+                return;
+            }
+            socket.non_blocking(true);
+            socket.set_option(tcp::no_delay(true));
+            std::cout << "accepted " << socket.remote_endpoint() << std::endl;
+
+            auto session = mSessions.emplace(mSessions.end());
+            session->mConnection = std::make_shared<Connection>(mContext, std::move(socket));
+            session->mConnection->Disconnected = [this, session] {
+                std::cout << "disconnected " << session->mConnection->GetName() << std::endl;
+                // Destroying the connection from inside its own handler is not safe.
+                boost::asio::post(mContext, [this, session] { mSessions.erase(session); });
+            };
+            session->mConnection->MessageReceived = [this, session](IConnection*,
+                                                                    unsigned char messageType,
+                                                                    unsigned char const* data,
+                                                                    std::size_t size) {
+                MessageHandler(session, messageType, data, size);
+            };
+            session->mConnection->AsyncRead();
+            Accept();
+        });
+    }
+
+    // Send the responses now or, if there is a latency, once it has passed.
+    void Respond(SessionIterator session, std::function<void(IConnection&)> respond)
+    {
+        if (mOptions.mLatency.count() == 0)
+        {
+            respond(*session->mConnection);
+            return;
+        }
+
+        auto timer = std::make_shared<boost::asio::steady_timer>(mContext, mOptions.mLatency);
+        std::weak_ptr<Connection> connection = session->mConnection;
+        timer->async_wait([timer, connection, respond = std::move(respond)](const boost::system::error_code& error) {
+            // The session may have disconnected while the response was held back.
+            if (auto alive = connection.lock(); alive && !error)
+            {
+                respond(*alive);
+            }
+        });
+    }
+
+    void SendError(SessionIterator session, unsigned long clientOrderId, const std::string& message)
+    {
+        Respond(session, [clientOrderId, message](IConnection& connection) {
+            connection.SendMessage(MessageType::ERROR_MESSAGE, ErrorMessage{clientOrderId, message});
+        });
+    }
+
+    void MessageHandler(SessionIterator session, unsigned char messageType, unsigned char const* data,
+                        std::size_t size)
+    {
+        if (messageType == MessageType::LOGIN)
+        {
+            auto login = makeMessage<LoginMessage>(data, size);
+            if (session->mIsLoggedIn)
+            {
+                SendError(session, 0, "already logged in");
+                return;
+            }
+            session->mIsLoggedIn = true;
+            session->mConnection->SetName('\'' + login.mName + '\'');
+            std::cout << "logged in " << login.mName << std::endl;
+            return;
+        }
+
+        if (!session->mIsLoggedIn)
+        {
+            SendError(session, 0, "not logged in");
+            return;
+        }
+
+        switch (messageType)
+        {
+        case MessageType::INSERT_ORDER:
+            InsertHandler(session, makeMessage<InsertMessage>(data, size));
+            break;
+        case MessageType::AMEND_ORDER:
+            AmendHandler(session, makeMessage<AmendMessage>(data, size));
+            break;
+        case MessageType::CANCEL_ORDER:
+            CancelHandler(session, makeMessage<CancelMessage>(data, size));
+            break;
+        case MessageType::HEDGE_ORDER:
+            HedgeHandler(session, makeMessage<HedgeMessage>(data, size));
+            break;
+        default:
+            SendError(session, 0, std::to_string(static_cast<int>(messageType)) + " is not a valid message type");
+            break;
+        }
+    }
+
+    void InsertHandler(SessionIterator session, const InsertMessage& insert)
+    {
+        const unsigned long id = insert.mClientOrderId;
+        if (id <= session->mLastOrderId)
+        {
+            SendError(session, id, "duplicate or out-of-order client_order_id");
+            return;
+        }
+        session->mLastOrderId = id;
+
+        if (!insert.mVolume || insert.mPrice != insert.mPrice.RoundDownToTick())
+        {
+            SendError(session, id, !insert.mVolume ? "0 is not a valid volume"
+                                                       : "price is not a multiple of tick size");
+            return;
+        }
+
+        if (mUniform(mRandom) < mOptions.mFillRatio)
+        {
+            const Price price = insert.mPrice;
+            const Volume volume = insert.mVolume;
+            const long fees = std::lround(double(price * volume) * mOptions.mTakerFee);
+            Respond(session, [id, price, volume, fees](IConnection& connection) {
+                connection.SendMessage(MessageType::ORDER_FILLED, OrderFilledMessage{id, price, volume}, SendMode::SOON);
+                connection.SendMessage(MessageType::ORDER_STATUS, OrderStatusMessage{id, volume, Volume(), fees});
+            });
+            return;
+        }
+
+        const Volume remaining = insert.mLifespan == Lifespan::GOOD_FOR_DAY ? insert.mVolume : Volume();
+        if (remaining)
+        {
+            session->mOrders.emplace(id, Order{insert.mPrice, Volume(), remaining});
+        }
+        Respond(session, [id, remaining](IConnection& connection) {
+            connection.SendMessage(MessageType::ORDER_STATUS, OrderStatusMessage{id, Volume(), remaining, 0});
+        });
+    }
+
+    void AmendHandler(SessionIterator session, const AmendMessage& amend)
+    {
+        const unsigned long id = amend.mClientOrderId;
+        auto order = session->mOrders.find(id);
+        if (order == session->mOrders.end())
+        {
+            // Like the exchange, amending an order that has gone is not an error.
+            if (id > session->mLastOrderId)
+                SendError(session, id, "out-of-order client_order_id in amend message");
+            return;
+        }
+
+        const Volume volume = order->second.mFilled + order->second.mRemaining;
+        if (amend.mNewVolume > volume)
+        {
+            SendError(session, id, "amend operation would increase order volume");
+            return;
+        }
+
+        const Volume filled = order->second.mFilled;
+        const Volume remaining = amend.mNewVolume - filled;
+        if (!remaining)
+            session->mOrders.erase(order);
+        else
+            order->second.mRemaining = remaining;
+        Respond(session, [id, filled, remaining](IConnection& connection) {
+            connection.SendMessage(MessageType::ORDER_STATUS, OrderStatusMessage{id, filled, remaining, 0});
+        });
+    }
+
+    void CancelHandler(SessionIterator session, const CancelMessage& cancel)
+    {
+        const unsigned long id = cancel.mClientOrderId;
+        auto order = session->mOrders.find(id);
+        if (order == session->mOrders.end())
+        {
+            if (id > session->mLastOrderId)
+                SendError(session, id, "out-of-order client_order_id in cancel message");
+            return;
+        }
+
+        const Volume filled = order->second.mFilled;
+        session->mOrders.erase(order);
+        Respond(session, [id, filled](IConnection& connection) {
+            connection.SendMessage(MessageType::ORDER_STATUS, OrderStatusMessage{id, filled, Volume(), 0});
+        });
+    }
+
+    void HedgeHandler(SessionIterator session, const HedgeMessage& hedge)
+    {
+        const unsigned long id = hedge.mClientOrderId;
+        if (id <= session->mLastOrderId)
+        {
+            SendError(session, id, "duplicate or out-of-order client_order_id");
+            return;
+        }
+        session->mLastOrderId = id;
+
+        const Price price = hedge.mPrice;
+        const Volume volume = hedge.mVolume;
+        Respond(session, [id, price, volume](IConnection& connection) {
+            connection.SendMessage(MessageType::HEDGE_FILLED, HedgeFilledMessage{id, price, volume});
+        });
+    }
+
+    boost::asio::io_context& mContext;
+    const StubExchangeOptions& mOptions;
+    tcp::acceptor mAcceptor;
+    std::list<Session> mSessions;
+    std::mt19937_64 mRandom;
+    std::uniform_real_distribution<double> mUniform{0.0, 1.0};
+};
+
+int main(int argc, char* argv[])
+{
+    StubExchangeOptions options;
+    bool verbose = false;
+    bool usage = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+        {
+            options.mPort = static_cast<unsigned short>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--latency") == 0 && i + 1 < argc)
+        {
+            options.mLatency = std::chrono::microseconds(std::strtol(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--fill-ratio") == 0 && i + 1 < argc)
+        {
+            options.mFillRatio = std::strtod(argv[++i], nullptr);
+        }
+        else if (std::strcmp(argv[i], "--taker-fee") == 0 && i + 1 < argc)
+        {
+            options.mTakerFee = std::strtod(argv[++i], nullptr);
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            options.mSeed = unsigned(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--verbose") == 0)
+        {
+            verbose = true;
+        }
+        else
+        {
+            usage = true;
+            break;
+        }
+    }
+
+    if (usage)
+    {
+        std::cerr << "usage: " << argv[0] << " [--port PORT] [--latency MICROSECONDS] [--fill-ratio PROBABILITY]"
+                  << " [--taker-fee FEE] [--seed SEED] [--verbose]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    boost::log::core::get()->set_logging_enabled(verbose);
+
+    try
+    {
+        boost::asio::io_context context;
+        StubExchange exchange{context, options};
+        boost::asio::signal_set signals{context, SIGINT, SIGTERM};
+        signals.async_wait([&context](const boost::system::error_code&, int) { context.stop(); });
+        std::cout << "listening on port " << options.mPort << std::endl;
+        context.run();
+        return EXIT_SUCCESS;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
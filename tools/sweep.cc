@@ -0,0 +1,237 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define BOOST_BIND_GLOBAL_PLACEHOLDERS
+#include <boost/asio/io_context.hpp>
+#include <boost/log/core.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <ready_trader_go/columnarevents.h>
+#include <simulator/simulator.h>
+#include <simulator/workstealingpool.h>
+
+#include "autotrader.h"
+
+using namespace ReadyTraderGo;
+
+namespace {
+
+struct SweepJob
+{
+    std::size_t mEventsIndex;
+    AutoTraderParameters mParameters;
+    SimulatorResult mResult;
+    double mSeconds = 0.0;
+};
+
+template<typename T>
+bool parseList(const char* text, std::vector<T>& values)
+{
+    values.clear();
+    std::istringstream in{text};
+    std::string item;
+    while (std::getline(in, item, ','))
+    {
+        std::istringstream itemStream{item};
+        T value;
+        if (!(itemStream >> value) || !itemStream.eof())
+        {
+            return false;
+        }
+        values.push_back(value);
+    }
+    return !values.empty();
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    std::string exchangeConfig;
+    std::string outputName;
+    std::size_t threadCount = 0;
+    std::vector<unsigned long> lotSizes{AutoTraderParameters{}.mLotSize};
+    std::vector<double> thresholds{AutoTraderParameters{}.mThreshold};
+    std::vector<std::size_t> windowSizes{AutoTraderParameters{}.mWindowSize};
+    std::vector<double> lifetimes{AutoTraderParameters{}.mOrderLifetime};
+    std::vector<std::string> eventsNames;
+    bool valid = true;
+
+    for (int i = 1; valid && i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--exchange-config") == 0 && i + 1 < argc)
+        {
+            exchangeConfig = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threadCount = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--lot-sizes") == 0 && i + 1 < argc)
+        {
+            valid = parseList(argv[++i], lotSizes);
+        }
+        else if (std::strcmp(argv[i], "--thresholds") == 0 && i + 1 < argc)
+        {
+            valid = parseList(argv[++i], thresholds);
+        }
+        else if (std::strcmp(argv[i], "--windows") == 0 && i + 1 < argc)
+        {
+            valid = parseList(argv[++i], windowSizes);
+        }
+        else if (std::strcmp(argv[i], "--lifetimes") == 0 && i + 1 < argc)
+        {
+            valid = parseList(argv[++i], lifetimes);
+        }
+        else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+        {
+            outputName = argv[++i];
+        }
+        else if (argv[i][0] != '-')
+        {
+            eventsNames.emplace_back(argv[i]);
+        }
+        else
+        {
+            valid = false;
+        }
+    }
+
+    for (auto windowSize : windowSizes)
+    {
+        valid = valid && windowSize > 0;
+    }
+
+    if (!valid || eventsNames.empty())
+    {
+        std::cerr << "usage: " << argv[0] << " [--exchange-config EXCHANGE_JSON] [--threads N]"
+                  << " [--lot-sizes A,B,...] [--thresholds X,Y,...] [--windows M,N,...]"
+                  << " [--lifetimes SECONDS,...] [--output CSV]"
+                  << " COLUMNAR_EVENTS..." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Every job would otherwise log every message it handles.
+    boost::log::core::get()->set_logging_enabled(false);
+
+    try
+    {
+        SimulatorConfig config;
+        if (!exchangeConfig.empty())
+        {
+            boost::property_tree::ptree tree;
+            boost::property_tree::read_json(exchangeConfig, tree);
+            config.readFromPropertyTree(tree);
+        }
+
+        // Each file is mapped once and shared, read-only, by every job.
+        std::vector<std::unique_ptr<ColumnarEvents>> events;
+        for (const auto& name : eventsNames)
+        {
+            events.push_back(std::make_unique<ColumnarEvents>(name));
+        }
+
+        std::vector<SweepJob> jobs;
+        for (std::size_t e = 0; e < events.size(); ++e)
+        {
+            for (auto lotSize : lotSizes)
+            {
+                for (auto threshold : thresholds)
+                {
+                    for (auto windowSize : windowSizes)
+                    {
+                        for (auto lifetime : lifetimes)
+                        {
+                            AutoTraderParameters parameters{lotSize, threshold, windowSize, lifetime};
+                            jobs.push_back({e, parameters, {}});
+                        }
+                    }
+                }
+            }
+        }
+
+        WorkStealingPool pool{threadCount};
+        auto start = std::chrono::steady_clock::now();
+
+        for (auto& job : jobs)
+        {
+            pool.Submit([&job, &events, &config] {
+                auto jobStart = std::chrono::steady_clock::now();
+                boost::asio::io_context context;
+                AutoTrader trader{context, job.mParameters};
+                trader.SetLoginDetails("Simulated", "secret");
+                Simulator simulator{trader, *events[job.mEventsIndex], config};
+                job.mResult = simulator.Run();
+                job.mSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - jobStart).count();
+            });
+        }
+        pool.Wait();
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::ofstream file;
+        if (!outputName.empty())
+        {
+            file.open(outputName);
+            if (!file)
+            {
+                std::cerr << "failed to open '" << outputName << "'" << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        std::ostream& out = outputName.empty() ? std::cout : file;
+
+        out << "File,LotSize,Threshold,Window,OrderLifetime,ProfitOrLoss,Fees,Messages,Inserts,Hedges,Fills,"
+               "MaxEtfPosition,MaxFuturePosition,Breached,Milliseconds\n";
+        for (const auto& job : jobs)
+        {
+            const auto& result = job.mResult;
+            out << eventsNames[job.mEventsIndex] << ',' << job.mParameters.mLotSize << ','
+                << job.mParameters.mThreshold << ',' << job.mParameters.mWindowSize << ','
+                << job.mParameters.mOrderLifetime << ','
+                << result.mProfitOrLoss << ',' << result.mTotalFees << ',' << result.mMessageCount << ','
+                << result.mInsertCount << ',' << result.mHedgeCount << ',' << result.mFillCount << ','
+                << result.mMaxEtfPosition << ',' << result.mMaxFuturePosition << ','
+                << (result.mBreached ? 1 : 0) << ',' << job.mSeconds * 1000.0 << '\n';
+        }
+        out.flush();
+
+        std::cerr << "threads:            " << pool.GetThreadCount() << '\n'
+                  << "jobs:               " << jobs.size() << '\n'
+                  << "wall seconds:       " << seconds << '\n'
+                  << "jobs per second:    " << double(jobs.size()) / seconds << '\n'
+                  << "steals:             " << pool.GetStealCount() << std::endl;
+
+        return EXIT_SUCCESS;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,183 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <ready_trader_go/clock.h>
+#include <ready_trader_go/scheduler.h>
+
+using namespace ReadyTraderGo;
+
+// Deadlines are spread evenly over this span, starting one second out.
+constexpr std::uint64_t DEADLINE_SPAN = 60 * NANOSECONDS_PER_SECOND;
+
+static double nanosecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void benchmarkWheel(std::size_t timerCount, std::size_t rounds)
+{
+    std::mt19937_64 random{42};
+    std::uniform_int_distribution<std::uint64_t> offsets{NANOSECONDS_PER_SECOND,
+                                                         NANOSECONDS_PER_SECOND + DEADLINE_SPAN};
+    VirtualClock clock{NANOSECONDS_PER_SECOND};
+    TimerScheduler scheduler{clock, timerCount};
+    std::uint64_t fired = 0;
+    std::vector<TimerId> timers(timerCount);
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto& timer : timers)
+    {
+        timer = scheduler.ScheduleAt(clock.Now() + offsets(random), [&fired] { ++fired; });
+    }
+    const double fillNanoseconds = nanosecondsSince(start);
+
+    // Churn at a constant number of live timers: each round cancels and
+    // replaces a random tenth of them.
+    std::vector<std::size_t> victims(timerCount / 10);
+    double cancelNanoseconds = 0.0;
+    double scheduleNanoseconds = 0.0;
+    for (std::size_t r = 0; r < rounds; ++r)
+    {
+        for (auto& victim : victims)
+        {
+            victim = random() % timerCount;
+        }
+
+        start = std::chrono::steady_clock::now();
+        for (auto victim : victims)
+        {
+            scheduler.Cancel(timers[victim]);
+        }
+        cancelNanoseconds += nanosecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        for (auto victim : victims)
+        {
+            if (scheduler.GetPendingCount() < timerCount)
+            {
+                timers[victim] = scheduler.ScheduleAt(clock.Now() + offsets(random), [&fired] { ++fired; });
+            }
+        }
+        scheduleNanoseconds += nanosecondsSince(start);
+    }
+    const std::size_t live = scheduler.GetPendingCount();
+
+    // Let everything expire, polling every millisecond.
+    start = std::chrono::steady_clock::now();
+    std::uint64_t polls = 0;
+    while (scheduler.GetPendingCount() != 0)
+    {
+        clock.Advance(SCHEDULER_DEFAULT_RESOLUTION);
+        scheduler.Poll();
+        ++polls;
+    }
+    const double expireNanoseconds = nanosecondsSince(start);
+
+    const double churn = double(rounds * victims.size());
+    std::cout << "timer wheel\n"
+              << "  live timers:            " << live << '\n'
+              << "  schedule while filling: " << fillNanoseconds / timerCount << " ns\n"
+              << "  cancel at full:         " << cancelNanoseconds / churn << " ns\n"
+              << "  schedule at full:       " << scheduleNanoseconds / churn << " ns\n"
+              << "  polls:                  " << polls << '\n'
+              << "  expire per timer:       " << expireNanoseconds / double(fired) << " ns (including polls)\n";
+}
+
+static void benchmarkAsio(std::size_t timerCount)
+{
+    std::mt19937_64 random{42};
+    std::uniform_int_distribution<std::uint64_t> offsets{NANOSECONDS_PER_SECOND,
+                                                         NANOSECONDS_PER_SECOND + DEADLINE_SPAN};
+    boost::asio::io_context context;
+    std::vector<std::unique_ptr<boost::asio::steady_timer>> timers;
+    timers.reserve(timerCount);
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < timerCount; ++i)
+    {
+        auto& timer = timers.emplace_back(std::make_unique<boost::asio::steady_timer>(context));
+        timer->expires_after(std::chrono::nanoseconds(offsets(random)));
+        timer->async_wait([](const boost::system::error_code&) {});
+    }
+    const double scheduleNanoseconds = nanosecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (auto& timer : timers)
+    {
+        timer->cancel();
+    }
+    const double cancelNanoseconds = nanosecondsSince(start);
+    context.run();
+
+    std::cout << "asio steady_timer\n"
+              << "  live timers:            " << timerCount << '\n'
+              << "  schedule while filling: " << scheduleNanoseconds / timerCount << " ns\n"
+              << "  cancel at full:         " << cancelNanoseconds / timerCount << " ns\n";
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t timerCount = 100000;
+    std::size_t rounds = 10;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--timers") == 0 && i + 1 < argc)
+        {
+            timerCount = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--rounds") == 0 && i + 1 < argc)
+        {
+            rounds = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else
+        {
+            timerCount = 0;
+            break;
+        }
+    }
+
+    if (timerCount < 10)
+    {
+        std::cerr << "usage: " << argv[0] << " [--timers COUNT] [--rounds ROUNDS]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        benchmarkWheel(timerCount, rounds);
+        benchmarkAsio(timerCount);
+        return EXIT_SUCCESS;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,135 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <ready_trader_go/trace.h>
+
+using namespace ReadyTraderGo;
+
+// Keeps the compiler from removing the work done inside each span.
+static volatile std::uint64_t gSink = 0;
+
+static double nanosecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// The spans are recorded whether or not the RTG_TRACE_SPAN macro is compiled
+// in, so the cost can be measured in any build.
+static void __attribute__((noinline)) emptyLoop(std::size_t spans)
+{
+    for (std::size_t i = 0; i < spans; ++i)
+    {
+        gSink = gSink + i;
+    }
+}
+
+static void __attribute__((noinline)) tracedLoop(std::size_t spans)
+{
+    for (std::size_t i = 0; i < spans; ++i)
+    {
+        TraceSpan span{"benchmark"};
+        gSink = gSink + i;
+    }
+}
+
+static void __attribute__((noinline)) nestedLoop(std::size_t spans)
+{
+    for (std::size_t i = 0; i < spans; i += 2)
+    {
+        TraceSpan outer{"outer"};
+        {
+            TraceSpan inner{"inner"};
+            gSink = gSink + i;
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::size_t spans = 10000000;
+    std::string output;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--spans") == 0 && i + 1 < argc)
+        {
+            spans = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+        {
+            output = argv[++i];
+        }
+        else
+        {
+            spans = 0;
+            break;
+        }
+    }
+
+    if (spans == 0)
+    {
+        std::cerr << "usage: " << argv[0] << " [--spans COUNT] [--output TRACE_FILE]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        setTraceThreadName("benchmark");
+
+        // Warm up the ring so that page faults are not measured.
+        tracedLoop(TRACE_RING_CAPACITY);
+
+        auto start = std::chrono::steady_clock::now();
+        emptyLoop(spans);
+        const double emptyNanoseconds = nanosecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        tracedLoop(spans);
+        const double tracedNanoseconds = nanosecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        nestedLoop(spans);
+        const double nestedNanoseconds = nanosecondsSince(start);
+
+        std::cout << "trace spans (macros " << (TRACING_ENABLED ? "compiled in" : "compiled out") << ")\n"
+                  << "  spans:                  " << spans << '\n'
+                  << "  loop overhead:          " << emptyNanoseconds / spans << " ns\n"
+                  << "  per span:               " << (tracedNanoseconds - emptyNanoseconds) / spans << " ns\n"
+                  << "  per nested span:        " << (nestedNanoseconds - emptyNanoseconds / 2) / spans << " ns\n";
+
+        if (!output.empty())
+        {
+            start = std::chrono::steady_clock::now();
+            dumpChromeTrace(output, 1.0);
+            std::cout << "  dump of last second:    " << nanosecondsSince(start) / 1e6 << " ms to '"
+                      << output << "'\n";
+        }
+        return EXIT_SUCCESS;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
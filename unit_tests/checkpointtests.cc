@@ -0,0 +1,241 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <unistd.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <ready_trader_go/checkpoint.h>
+
+using namespace ReadyTraderGo;
+
+constexpr std::uint32_t STATE_VERSION = 7;
+
+struct State
+{
+    std::uint64_t mValue;
+    unsigned char mPadding[100];
+};
+
+// The same slot size as State, but a different state size.
+struct LongerState
+{
+    std::uint64_t mValue;
+    unsigned char mPadding[112];
+};
+
+struct MuchLongerState
+{
+    std::uint64_t mValue;
+    unsigned char mPadding[1000];
+};
+
+static_assert(sizeof(State) != sizeof(LongerState));
+
+static State makeState(std::uint64_t value)
+{
+    State state{};
+    state.mValue = value;
+    for (std::size_t i = 0; i < sizeof(state.mPadding); ++i)
+    {
+        state.mPadding[i] = static_cast<unsigned char>(value + i);
+    }
+    return state;
+}
+
+// A checkpoint file of its own, removed afterwards.
+struct CheckpointFixture
+{
+    ~CheckpointFixture()
+    {
+        std::error_code error;
+        std::filesystem::remove(mFilename, error);
+    }
+
+    // Save the values one to count in turn and close the file.
+    void SaveUpTo(std::uint64_t count)
+    {
+        Checkpoint<State> checkpoint(mFilename, STATE_VERSION);
+        for (std::uint64_t value = 1; value <= count; ++value)
+        {
+            checkpoint.Save(makeState(value));
+        }
+    }
+
+    // Whether the checkpoint restores exactly the state of the given value
+    // as its latest save.
+    static bool RestoresLatest(const Checkpoint<State>& checkpoint, std::uint64_t value)
+    {
+        State state{};
+        const State expected = makeState(value);
+        return checkpoint.Restore(state) && std::memcmp(&state, &expected, sizeof(State)) == 0;
+    }
+
+    // Give the slot holding the given generation another begin generation
+    // and overwrite half its state, as a save stopped part way would.
+    void TearSlot(std::uint64_t generation, std::uint64_t begin)
+    {
+        const std::size_t slotSize = CHECKPOINT_ALIGNMENT + (sizeof(State) + CHECKPOINT_ALIGNMENT - 1)
+                                                            / CHECKPOINT_ALIGNMENT * CHECKPOINT_ALIGNMENT;
+        const std::size_t slot = CHECKPOINT_ALIGNMENT + (generation & 1) * slotSize;
+        const State torn = makeState(999);
+
+        std::fstream file(mFilename, std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+        file.seekp(static_cast<std::streamoff>(slot + offsetof(CheckpointSlotHeader, mBegin)));
+        file.write(reinterpret_cast<const char*>(&begin), sizeof(begin));
+        file.seekp(static_cast<std::streamoff>(slot + CHECKPOINT_ALIGNMENT));
+        file.write(reinterpret_cast<const char*>(&torn), sizeof(torn) / 2);
+        BOOST_REQUIRE(file.good());
+    }
+
+    const std::string mFilename = (std::filesystem::temp_directory_path()
+                                   / ("checkpointtests-" + std::to_string(getpid()) + ".dat")).string();
+};
+
+BOOST_FIXTURE_TEST_SUITE(checkpoint, CheckpointFixture)
+
+BOOST_AUTO_TEST_CASE(restore_latest)
+{
+    {
+        Checkpoint<State> checkpoint(mFilename, STATE_VERSION);
+        State state = makeState(1);
+        BOOST_TEST(!checkpoint.Restore(state));
+        BOOST_TEST(state.mValue == 1U);
+    }
+    SaveUpTo(3);
+
+    Checkpoint<State> checkpoint(mFilename, STATE_VERSION);
+    BOOST_TEST(RestoresLatest(checkpoint, 3));
+    BOOST_TEST(checkpoint.GetFile().GetSaveCount() == 3U);
+}
+
+// A save stopped part way leaves the previous save in the other slot.
+BOOST_AUTO_TEST_CASE(torn_save)
+{
+    for (std::uint64_t count = 2; count <= 3; ++count)
+    {
+        std::filesystem::remove(mFilename);
+        SaveUpTo(count);
+        TearSlot(count - 1, count + 1);
+
+        {
+            Checkpoint<State> checkpoint(mFilename, STATE_VERSION);
+            BOOST_TEST(RestoresLatest(checkpoint, count));
+            BOOST_TEST(checkpoint.GetFile().GetSaveCount() == count);
+            checkpoint.Save(makeState(count + 1));
+        }
+
+        Checkpoint<State> checkpoint(mFilename, STATE_VERSION);
+        BOOST_TEST(RestoresLatest(checkpoint, count + 1));
+    }
+}
+
+// A slot whose begin and end generations differ is passed over for the
+// other, even when its end is the later, whichever slot it is.
+BOOST_AUTO_TEST_CASE(torn_latest_slot)
+{
+    for (std::uint64_t count = 2; count <= 3; ++count)
+    {
+        std::filesystem::remove(mFilename);
+        SaveUpTo(count);
+        TearSlot(count, count + 2);
+
+        {
+            Checkpoint<State> checkpoint(mFilename, STATE_VERSION);
+            BOOST_TEST(RestoresLatest(checkpoint, count - 1));
+            BOOST_TEST(checkpoint.GetFile().GetSaveCount() == count - 1);
+
+            // Saving carries on from the last complete save.
+            checkpoint.Save(makeState(count));
+        }
+
+        Checkpoint<State> checkpoint(mFilename, STATE_VERSION);
+        BOOST_TEST(RestoresLatest(checkpoint, count));
+    }
+}
+
+// With both slots torn there is nothing to restore.
+BOOST_AUTO_TEST_CASE(both_slots_torn)
+{
+    SaveUpTo(2);
+    TearSlot(1, 3);
+    TearSlot(2, 4);
+
+    Checkpoint<State> checkpoint(mFilename, STATE_VERSION);
+    State state{};
+    BOOST_TEST(!checkpoint.Restore(state));
+    BOOST_TEST(checkpoint.GetFile().GetSaveCount() == 0U);
+}
+
+// A file written for another version of the state is started afresh, and
+// then kept for the new version.
+BOOST_AUTO_TEST_CASE(version_mismatch)
+{
+    SaveUpTo(1);
+    {
+        Checkpoint<State> checkpoint(mFilename, STATE_VERSION + 1);
+        State state{};
+        BOOST_TEST(!checkpoint.Restore(state));
+        BOOST_TEST(checkpoint.GetFile().GetSaveCount() == 0U);
+        checkpoint.Save(makeState(2));
+    }
+    {
+        Checkpoint<State> checkpoint(mFilename, STATE_VERSION + 1);
+        BOOST_TEST(RestoresLatest(checkpoint, 2));
+    }
+
+    Checkpoint<State> checkpoint(mFilename, STATE_VERSION);
+    State state{};
+    BOOST_TEST(!checkpoint.Restore(state));
+}
+
+// So is a file written for another size of the state, whether or not the
+// file itself is the same size.
+BOOST_AUTO_TEST_CASE(size_mismatch)
+{
+    SaveUpTo(1);
+    const std::uintmax_t fileSize = std::filesystem::file_size(mFilename);
+    {
+        Checkpoint<LongerState> checkpoint(mFilename, STATE_VERSION);
+        BOOST_TEST(std::filesystem::file_size(mFilename) == fileSize);
+        LongerState state{};
+        BOOST_TEST(!checkpoint.Restore(state));
+    }
+
+    SaveUpTo(1);
+    {
+        Checkpoint<MuchLongerState> checkpoint(mFilename, STATE_VERSION);
+        BOOST_TEST(std::filesystem::file_size(mFilename) > fileSize);
+        MuchLongerState state{};
+        BOOST_TEST(!checkpoint.Restore(state));
+        checkpoint.Save(MuchLongerState{5, {}});
+    }
+
+    Checkpoint<State> checkpoint(mFilename, STATE_VERSION);
+    BOOST_TEST(std::filesystem::file_size(mFilename) == fileSize);
+    State state{};
+    BOOST_TEST(!checkpoint.Restore(state));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,206 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/endian/conversion.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <ready_trader_go/ordergateway.h>
+#include <ready_trader_go/protocol.h>
+#include <ready_trader_go/types.h>
+
+using namespace ReadyTraderGo;
+
+using SentMessage = std::pair<unsigned char, unsigned long>;
+
+// Stands in for the exchange: records the type and client order id of what
+// the gateway sends and hands it responses.
+class FakeExchange : public IConnection
+{
+public:
+    void AsyncRead() override {}
+
+    void SendMessage(unsigned char messageType, const ISerialisable& serialisable, SendMode) override
+    {
+        if (messageType != MessageType::LOGIN)
+        {
+            std::vector<unsigned char> data(serialisable.Size());
+            serialisable.Serialise(data.data());
+            mSent.emplace_back(messageType, boost::endian::load_big_u32(data.data()));
+        }
+    }
+
+    void Respond(unsigned char messageType, const ISerialisable& serialisable)
+    {
+        std::vector<unsigned char> data(serialisable.Size());
+        serialisable.Serialise(data.data());
+        OnMessageReceipt(messageType, data.data(), data.size());
+    }
+
+    std::vector<SentMessage> mSent;
+};
+
+struct GatewayFixture
+{
+    GatewayFixture() : mGateway(mContext, 10000)
+    {
+        mFirst = mGateway.Register("first");
+        mSecond = mGateway.Register("second");
+        mFirst->MessageReceived = [this](IConnection*, unsigned char t, unsigned char const* d, std::size_t) {
+            mReceived.emplace_back(t, boost::endian::load_big_u32(d));
+        };
+        auto exchange = std::make_unique<FakeExchange>();
+        mExchange = exchange.get();
+        mGateway.SetConnection(std::move(exchange));
+    }
+
+    // Has the first strategy insert an order that the gateway must send
+    // under a fresh id, returning the strategy's and the exchange's ids.
+    std::pair<unsigned long, unsigned long> InsertRenamed()
+    {
+        const unsigned long id = mFirst->NextClientOrderId();
+        const unsigned long otherId = mSecond->NextClientOrderId();
+        mSecond->SendMessage(MessageType::INSERT_ORDER,
+                             InsertMessage{otherId, Side::SELL, Price(10100), Volume(1), Lifespan::GOOD_FOR_DAY},
+                             SendMode::ASAP);
+        mFirst->SendMessage(MessageType::INSERT_ORDER,
+                            InsertMessage{id, Side::BUY, Price(9900), Volume(1), Lifespan::GOOD_FOR_DAY},
+                            SendMode::ASAP);
+        return {id, mExchange->mSent.back().second};
+    }
+
+    // The id under which a cancel of the first strategy's order reaches the
+    // exchange.
+    unsigned long CancelAs(unsigned long clientOrderId)
+    {
+        mFirst->SendMessage(MessageType::CANCEL_ORDER, CancelMessage{clientOrderId}, SendMode::ASAP);
+        return mExchange->mSent.back().second;
+    }
+
+    boost::asio::io_context mContext;
+    OrderGateway mGateway;
+    std::unique_ptr<GatewayConnection> mFirst;
+    std::unique_ptr<GatewayConnection> mSecond;
+    FakeExchange* mExchange = nullptr;
+    std::vector<SentMessage> mReceived;
+};
+
+BOOST_FIXTURE_TEST_SUITE(gateway, GatewayFixture)
+
+// A rejected insert is over, so the gateway forgets its fresh id.
+BOOST_AUTO_TEST_CASE(rejected_insert)
+{
+    const auto [id, fresh] = InsertRenamed();
+    BOOST_TEST(fresh != id);
+    mExchange->Respond(MessageType::ERROR_MESSAGE, ErrorMessage{fresh, "order rejected: in cross with an existing order"});
+    BOOST_REQUIRE(!mReceived.empty());
+    BOOST_TEST((mReceived.back() == SentMessage{MessageType::ERROR_MESSAGE, id}));
+    BOOST_TEST(CancelAs(id) == id);
+}
+
+// A refused amend leaves the order live under its fresh id.
+BOOST_AUTO_TEST_CASE(refused_amend)
+{
+    const auto [id, fresh] = InsertRenamed();
+    BOOST_TEST(fresh != id);
+    mExchange->Respond(MessageType::ERROR_MESSAGE, ErrorMessage{fresh, "amend operation would increase order volume"});
+    BOOST_REQUIRE(!mReceived.empty());
+    BOOST_TEST((mReceived.back() == SentMessage{MessageType::ERROR_MESSAGE, id}));
+    BOOST_TEST(CancelAs(id) == fresh);
+}
+
+// However many renamed orders are rejected, a live one keeps its fresh id.
+BOOST_AUTO_TEST_CASE(many_rejections)
+{
+    const auto [liveId, liveFresh] = InsertRenamed();
+    for (std::size_t i = 0; i < 4 * mGateway.GetRenamedCapacity(); ++i)
+    {
+        const auto [id, fresh] = InsertRenamed();
+        mExchange->Respond(MessageType::ERROR_MESSAGE,
+                           ErrorMessage{fresh, "order rejected: active order count limit breached"});
+    }
+    BOOST_TEST(CancelAs(liveId) == liveFresh);
+}
+
+// Renamed orders are never forgotten while they live, however many there are.
+BOOST_AUTO_TEST_CASE(many_live)
+{
+    std::vector<std::pair<unsigned long, unsigned long>> live;
+    for (int i = 0; i < 200; ++i)
+    {
+        live.push_back(InsertRenamed());
+    }
+    for (const auto& [id, fresh] : live)
+    {
+        BOOST_TEST(CancelAs(id) == fresh);
+        mExchange->Respond(MessageType::ORDER_STATUS, OrderStatusMessage{fresh, Volume(0), Volume(0), 0});
+        BOOST_REQUIRE(!mReceived.empty());
+        BOOST_TEST((mReceived.back() == SentMessage{MessageType::ORDER_STATUS, id}));
+        BOOST_TEST(CancelAs(id) == id);
+    }
+}
+
+// An order whose slot was taken while it waited is still renamed, and both
+// orders translate both ways.
+BOOST_AUTO_TEST_CASE(slot_taken)
+{
+    const std::size_t capacity = mGateway.GetRenamedCapacity();
+    const auto slotOf = [capacity](unsigned long id) { return (id >> OrderGateway::OWNER_BITS) & (capacity - 1); };
+
+    const unsigned long waiting = mFirst->NextClientOrderId();
+    unsigned long id;
+    do
+    {
+        id = mFirst->NextClientOrderId();
+    } while (slotOf(id) != slotOf(waiting));
+
+    const unsigned long otherId = mSecond->NextClientOrderId();
+    mSecond->SendMessage(MessageType::INSERT_ORDER,
+                         InsertMessage{otherId, Side::SELL, Price(10100), Volume(1), Lifespan::GOOD_FOR_DAY},
+                         SendMode::ASAP);
+    mFirst->SendMessage(MessageType::INSERT_ORDER,
+                        InsertMessage{id, Side::BUY, Price(9900), Volume(1), Lifespan::GOOD_FOR_DAY},
+                        SendMode::ASAP);
+    const unsigned long fresh = mExchange->mSent.back().second;
+    mFirst->SendMessage(MessageType::INSERT_ORDER,
+                        InsertMessage{waiting, Side::BUY, Price(9900), Volume(1), Lifespan::GOOD_FOR_DAY},
+                        SendMode::ASAP);
+    const unsigned long waitingFresh = mExchange->mSent.back().second;
+
+    BOOST_TEST(slotOf(fresh) == slotOf(id));
+    BOOST_TEST(fresh != id);
+    BOOST_TEST(waitingFresh != waiting);
+    BOOST_TEST(waitingFresh != fresh);
+    BOOST_TEST(CancelAs(id) == fresh);
+    BOOST_TEST(CancelAs(waiting) == waitingFresh);
+
+    mExchange->Respond(MessageType::ORDER_STATUS, OrderStatusMessage{waitingFresh, Volume(1), Volume(0), 0});
+    BOOST_REQUIRE(!mReceived.empty());
+    BOOST_TEST((mReceived.back() == SentMessage{MessageType::ORDER_STATUS, waiting}));
+    BOOST_TEST(CancelAs(waiting) == waiting);
+    BOOST_TEST(CancelAs(id) == fresh);
+
+    mExchange->Respond(MessageType::ERROR_MESSAGE, ErrorMessage{fresh, "order rejected: in cross with an existing order"});
+    BOOST_TEST((mReceived.back() == SentMessage{MessageType::ERROR_MESSAGE, id}));
+    BOOST_TEST(CancelAs(id) == id);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
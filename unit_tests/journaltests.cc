@@ -0,0 +1,169 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <ready_trader_go/error.h>
+#include <ready_trader_go/journal.h>
+
+using namespace ReadyTraderGo;
+
+constexpr std::size_t SEGMENT_SIZE = 64 * 1024;
+
+// Records hold their sequence number followed by up to 63 bytes of padding,
+// so that they fill segments unevenly.
+static void record(Journal& journal, std::uint64_t sequence)
+{
+    unsigned char data[sizeof(sequence) + 63] = {};
+    std::memcpy(data, &sequence, sizeof(sequence));
+    journal.Record(JournalDirection::EXEC_OUT, data, sizeof(sequence) + sequence % 64);
+}
+
+// Reads what the reader has to offer, checking it continues the sequence.
+static bool readAvailable(JournalReader& reader, std::uint64_t& next)
+{
+    JournalRecord r{};
+    while (reader.Next(r))
+    {
+        std::uint64_t sequence;
+        std::memcpy(&sequence, r.mData, sizeof(sequence));
+        if (r.mSize != sizeof(sequence) + sequence % 64 || sequence != next)
+        {
+            BOOST_TEST_MESSAGE("read record " << sequence << " of " << r.mSize << " bytes where record " << next
+                                              << " was expected");
+            return false;
+        }
+        ++next;
+    }
+    return true;
+}
+
+// A journal base name of its own, whose segments are removed afterwards.
+struct JournalFixture
+{
+    ~JournalFixture()
+    {
+        std::error_code error;
+        for (std::uint64_t n = 0; std::filesystem::remove(JournalSegmentFilename(mBaseName, n), error); ++n)
+        {
+        }
+    }
+
+    const std::string mBaseName = (std::filesystem::temp_directory_path()
+                                   / ("journaltests-" + std::to_string(getpid()))).string();
+};
+
+BOOST_FIXTURE_TEST_SUITE(journal, JournalFixture)
+
+// A reader that has caught up with the writer while the next segment is
+// already preallocated must wait for more records in the current one.
+BOOST_AUTO_TEST_CASE(preallocated_spare)
+{
+    Journal journal{mBaseName, SEGMENT_SIZE};
+    std::uint64_t written = 0;
+    for (; written < 10; ++written)
+    {
+        record(journal, written);
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    std::error_code error;
+    while (std::filesystem::file_size(JournalSegmentFilename(mBaseName, 1), error) != SEGMENT_SIZE
+           || error || !JournalSegment(mBaseName, 1).IsReady())
+    {
+        BOOST_REQUIRE_MESSAGE(std::chrono::steady_clock::now() < deadline, "the spare segment was never preallocated");
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    JournalReader reader{mBaseName};
+    std::uint64_t read = 0;
+    BOOST_TEST(readAvailable(reader, read));
+    BOOST_TEST(read == written);
+    for (; written < 20; ++written)
+    {
+        record(journal, written);
+    }
+    BOOST_TEST(readAvailable(reader, read));
+    BOOST_TEST(read == written);
+}
+
+// A reader following the writer from another thread, across many segments,
+// must see every record once and in order.
+BOOST_AUTO_TEST_CASE(live_follow)
+{
+    constexpr std::uint64_t count = 1000000;
+    std::uint64_t read = 0;
+    bool ok = true;
+    auto journal = std::make_unique<Journal>(mBaseName, SEGMENT_SIZE);
+    std::atomic<bool> finished{false};
+    std::thread writer([&] {
+        for (std::uint64_t i = 0; i < count; ++i)
+        {
+            record(*journal, i);
+        }
+        journal.reset();
+        finished.store(true, std::memory_order_release);
+    });
+
+    JournalReader reader{mBaseName};
+    for (;;)
+    {
+        const bool wasFinished = finished.load(std::memory_order_acquire);
+        if (!readAvailable(reader, read))
+        {
+            ok = false;
+            break;
+        }
+        if (wasFinished)
+        {
+            break;
+        }
+    }
+    writer.join();
+    BOOST_TEST(ok);
+    BOOST_TEST(read == count);
+}
+
+// A record too large for an empty segment is refused, rather than written
+// past the end of the next one, and the journal carries on.
+BOOST_AUTO_TEST_CASE(oversized_record)
+{
+    Journal journal{mBaseName, SEGMENT_SIZE};
+    record(journal, 0);
+    const std::vector<unsigned char> data(SEGMENT_SIZE);
+    BOOST_CHECK_THROW(journal.Record(JournalDirection::EXEC_IN, data.data(), data.size()), ReadyTraderGoError);
+    record(journal, 1);
+
+    JournalReader reader{mBaseName};
+    std::uint64_t read = 0;
+    BOOST_TEST(readAvailable(reader, read));
+    BOOST_TEST(read == 2u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
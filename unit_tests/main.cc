@@ -0,0 +1,32 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#define BOOST_TEST_MODULE ready_trader_go
+#define BOOST_BIND_GLOBAL_PLACEHOLDERS
+#include <boost/log/core.hpp>
+#include <boost/test/unit_test.hpp>
+
+// The library logs as it goes; the tests only report their own failures.
+struct QuietLogging
+{
+    QuietLogging()
+    {
+        boost::log::core::get()->set_logging_enabled(false);
+    }
+};
+
+BOOST_TEST_GLOBAL_FIXTURE(QuietLogging);
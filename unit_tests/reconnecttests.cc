@@ -0,0 +1,315 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <ready_trader_go/baseautotrader.h>
+#include <ready_trader_go/connectivity.h>
+#include <ready_trader_go/error.h>
+#include <ready_trader_go/protocol.h>
+#include <ready_trader_go/types.h>
+
+using namespace ReadyTraderGo;
+using boost::asio::ip::tcp;
+
+using Clock = std::chrono::steady_clock;
+
+static const InsertMessage INSERT{1, Side::BUY, Price(9900), Volume(1), Lifespan::GOOD_FOR_DAY};
+
+// Close the socket so that the other end is reset rather than told of an
+// orderly close.
+static void reset(tcp::socket& socket)
+{
+    boost::system::error_code ignored;
+    socket.set_option(boost::asio::socket_base::linger(true, 0), ignored);
+    socket.close(ignored);
+}
+
+// An autotrader that, while connected and until it has logged in again,
+// keeps inserting orders from a ticker, and notes the longest the ticker
+// was kept waiting.
+class Trader : public BaseAutoTrader
+{
+public:
+    explicit Trader(boost::asio::io_context& context) : BaseAutoTrader(context)
+    {
+        SetLoginDetails("reconnectcheck", "secret");
+    }
+
+    void Start()
+    {
+        mLastTick = Clock::now();
+        Tick();
+    }
+
+    // Inserts sent per tick, none once logged in again.
+    unsigned mBurst = 0;
+    Clock::duration mLongestTick{};
+
+private:
+    void Tick()
+    {
+        const Clock::time_point now = Clock::now();
+        mLongestTick = std::max(mLongestTick, now - mLastTick);
+        mLastTick = now;
+        for (unsigned i = 0; i < mBurst && mIsConnected && GetReconnectCounters().mReconnects == 0; ++i)
+        {
+            SendInsertOrder(mNextOrderId++, Side::BUY, Price(9900), Volume(1), Lifespan::GOOD_FOR_DAY);
+        }
+        mTicker.expires_after(std::chrono::milliseconds(10));
+        mTicker.async_wait([this](const boost::system::error_code& error) {
+            if (!error)
+            {
+                Tick();
+            }
+        });
+    }
+
+    boost::asio::steady_timer mTicker{mContext};
+    Clock::time_point mLastTick;
+    unsigned long mNextOrderId = 1;
+};
+
+// Stands in for the exchange: accepts execution connections and, once the
+// first has logged in, stops reading it so that the autotrader's sends back
+// up, then resets it part way through one. Later connections are read and
+// otherwise ignored.
+class ResettingExchange
+{
+public:
+    explicit ResettingExchange(boost::asio::io_context& context)
+        : mContext(context), mAcceptor(context, tcp::v4())
+    {
+        // Small, so that the window soon closes.
+        mAcceptor.set_option(boost::asio::socket_base::receive_buffer_size(4096));
+        mAcceptor.bind(tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+        mAcceptor.listen();
+        Accept();
+    }
+
+    unsigned short GetPort() const { return mAcceptor.local_endpoint().port(); }
+
+private:
+    struct Session
+    {
+        explicit Session(tcp::socket&& socket) : mSocket(std::move(socket)) {}
+        tcp::socket mSocket;
+        std::array<unsigned char, 4096> mBuffer;
+        std::size_t mReceived = 0;
+    };
+
+    void Accept()
+    {
+        mAcceptor.async_accept([this](const boost::system::error_code& error, tcp::socket socket) {
+            if (error)
+            {
+                return;
+            }
+            mSessions.push_back(std::make_unique<Session>(std::move(socket)));
+            Read(*mSessions.back(), mSessions.size() == 1);
+            Accept();
+        });
+    }
+
+    void Read(Session& session, bool isFirst)
+    {
+        const std::size_t login = MESSAGE_HEADER_SIZE + LoginMessage().Size();
+        const std::size_t size = isFirst ? login - session.mReceived : session.mBuffer.size();
+        session.mSocket.async_read_some(boost::asio::buffer(session.mBuffer, size),
+                                        [this, &session, isFirst, login](const boost::system::error_code& error,
+                                                                         std::size_t size) {
+            if (error)
+            {
+                return;
+            }
+            session.mReceived += size;
+            if (isFirst && session.mReceived == login)
+            {
+                mResetTimer.expires_after(std::chrono::milliseconds(200));
+                mResetTimer.async_wait([&session](const boost::system::error_code& error) {
+                    if (!error)
+                    {
+                        reset(session.mSocket);
+                    }
+                });
+                return;
+            }
+            Read(session, isFirst);
+        });
+    }
+
+    boost::asio::io_context& mContext;
+    tcp::acceptor mAcceptor;
+    boost::asio::steady_timer mResetTimer{mContext};
+    std::vector<std::unique_ptr<Session>> mSessions;
+};
+
+// A send that finds the connection reset reports it lost, once, rather than
+// throw. Nothing is read, so only a send can find out.
+static void sendAfterReset(bool useIoUring)
+{
+    boost::asio::io_context context;
+    tcp::acceptor acceptor(context, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+    ConnectionFactory factory(context, "127.0.0.1", acceptor.local_endpoint().port());
+    if (useIoUring)
+    {
+        factory.SetIoUring(IoUringOptions{}, false);
+    }
+    std::unique_ptr<IConnection> connection = factory.Create();
+    tcp::socket peer = acceptor.accept();
+    if (useIoUring && !dynamic_cast<IoUringConnection*>(connection.get()))
+    {
+        BOOST_TEST_MESSAGE("io_uring is unavailable, so the Asio connection is checked again");
+    }
+
+    unsigned disconnects = 0;
+    connection->SetDisconnectOnSendError(true);
+    connection->Disconnected = [&disconnects] { ++disconnects; };
+    reset(peer);
+
+    // A few more once lost, which must not report it again.
+    for (unsigned i = 0; i < 1000 && disconnects == 0; ++i)
+    {
+        BOOST_REQUIRE_NO_THROW(connection->SendMessage(MessageType::INSERT_ORDER, INSERT, SendMode::ASAP));
+        context.restart();
+        BOOST_REQUIRE_NO_THROW(context.run_for(std::chrono::milliseconds(1)));
+    }
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        BOOST_REQUIRE_NO_THROW(connection->SendMessage(MessageType::INSERT_ORDER, INSERT, SendMode::ASAP));
+        context.restart();
+        BOOST_REQUIRE_NO_THROW(context.run_for(std::chrono::milliseconds(1)));
+    }
+    BOOST_TEST(disconnects == 1u);
+}
+
+BOOST_AUTO_TEST_SUITE(reconnect)
+
+BOOST_AUTO_TEST_CASE(send_after_reset)
+{
+    sendAfterReset(false);
+}
+
+#ifdef __linux__
+BOOST_AUTO_TEST_CASE(send_after_reset_io_uring)
+{
+    sendAfterReset(true);
+}
+#endif
+
+// The exchange resets the connection while orders are being sent: the
+// autotrader connects again, and the send left unfinished on the lost
+// connection fails without throwing.
+BOOST_AUTO_TEST_CASE(reset_while_sending)
+{
+    boost::asio::io_context context;
+    ResettingExchange exchange{context};
+    ConnectionFactory factory(context, "127.0.0.1", exchange.GetPort());
+    Trader trader{context};
+    trader.SetReconnectPolicy(&factory, ReconnectPolicy{});
+    trader.SetExecutionConnection(factory.Create());
+    trader.mBurst = 20000;
+    trader.Start();
+
+    boost::asio::steady_timer deadline{context, std::chrono::seconds(5)};
+    deadline.async_wait([&context](const boost::system::error_code&) { context.stop(); });
+    boost::asio::steady_timer poll{context};
+    std::function<void()> waitForReconnect = [&] {
+        poll.expires_after(std::chrono::milliseconds(1));
+        poll.async_wait([&](const boost::system::error_code& error) {
+            if (!error && trader.GetReconnectCounters().mReconnects != 0)
+            {
+                // Long enough for what the lost connection was sending to fail.
+                poll.expires_after(std::chrono::milliseconds(100));
+                poll.async_wait([&context](const boost::system::error_code&) { context.stop(); });
+            }
+            else if (!error)
+            {
+                waitForReconnect();
+            }
+        });
+    };
+    waitForReconnect();
+
+    BOOST_REQUIRE_NO_THROW(context.run());
+    const ReconnectCounters& counters = trader.GetReconnectCounters();
+    BOOST_TEST(counters.mDisconnects == 1u);
+    BOOST_TEST(counters.mReconnects == 1u);
+}
+
+// With the exchange listening but not accepting, each attempt to connect
+// again hangs until its timeout. Market data and timers are handled all the
+// while, and the autotrader gives up once the attempts are used up.
+BOOST_AUTO_TEST_CASE(unreachable_exchange)
+{
+    boost::asio::io_context context;
+    auto acceptor = std::make_unique<tcp::acceptor>(
+        context, tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+    const tcp::endpoint endpoint = acceptor->local_endpoint();
+    ConnectionFactory factory(context, "127.0.0.1", endpoint.port());
+    factory.SetSpareSocket(true);
+
+    ReconnectPolicy policy;
+    policy.mAttempts = 3;
+    policy.mInterval = NANOSECONDS_PER_SECOND / 100;
+    policy.mConnectTimeout = NANOSECONDS_PER_SECOND / 10;
+    Trader trader{context};
+    trader.SetReconnectPolicy(&factory, policy);
+    trader.SetExecutionConnection(factory.Create());
+    tcp::socket session = acceptor->accept();
+
+    // Linux queues one more connection than the backlog, so once a
+    // connection is waiting to be accepted later ones get no answer.
+    acceptor = std::make_unique<tcp::acceptor>(context);
+    acceptor->open(endpoint.protocol());
+    acceptor->set_option(tcp::acceptor::reuse_address(true));
+    acceptor->bind(endpoint);
+    acceptor->listen(0);
+    tcp::socket waiting{context};
+    waiting.connect(endpoint);
+    session.close();
+
+    trader.Start();
+    boost::asio::steady_timer deadline{context, std::chrono::seconds(5)};
+    bool isTimedOut = false;
+    deadline.async_wait([&context, &isTimedOut](const boost::system::error_code& error) {
+        isTimedOut = !error;
+        context.stop();
+    });
+
+    const Clock::time_point start = Clock::now();
+    context.run();
+    const auto elapsed = Clock::now() - start;
+    const ReconnectCounters& counters = trader.GetReconnectCounters();
+    BOOST_TEST(!isTimedOut);
+    BOOST_TEST(counters.mFailedAttempts == policy.mAttempts);
+    BOOST_TEST(counters.mReconnects == 0u);
+    BOOST_TEST((elapsed >= std::chrono::milliseconds(300)));
+    BOOST_TEST((trader.mLongestTick < std::chrono::milliseconds(50)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,401 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <simulator/competitor.h>
+#include <simulator/orderbook.h>
+#include <simulator/simulatorconfig.h>
+
+using namespace ReadyTraderGo;
+
+// The expected events, fees, levels and ticks below are what the exchange
+// simulator (ready_trader_go/order_book.py and competitor.py) produces for
+// the same sequence of requests.
+
+using Events = std::vector<std::string>;
+
+template<typename... Args>
+static std::string event(const Args&... args)
+{
+    std::ostringstream out;
+    ((out << args << ' '), ...);
+    std::string s = out.str();
+    s.pop_back();
+    return s;
+}
+
+struct RecordingListener : IOrderListener
+{
+    void OnOrderAmended(long, Order& order, long volumeRemoved) override
+    {
+        mEvents.push_back(event("amended", order.mClientOrderId, volumeRemoved));
+    }
+    void OnOrderCancelled(long, Order& order, long volumeRemoved) override
+    {
+        mEvents.push_back(event("cancelled", order.mClientOrderId, volumeRemoved));
+    }
+    void OnOrderPlaced(long, Order& order) override
+    {
+        mEvents.push_back(event("placed", order.mClientOrderId));
+    }
+    void OnOrderFilled(long, Order& order, unsigned long price, long volume, long fee) override
+    {
+        mEvents.push_back(event("filled", order.mClientOrderId, price, volume, fee));
+    }
+
+    Events mEvents;
+};
+
+struct RecordingChannel : IExecutionChannel
+{
+    void Close() override { mEvents.push_back("close"); }
+    void SendError(unsigned long clientOrderId, std::string message) override
+    {
+        mEvents.push_back(event("error", clientOrderId, message));
+    }
+    void SendHedgeFilled(unsigned long clientOrderId, unsigned long averagePrice, long volume) override
+    {
+        mEvents.push_back(event("hedge", clientOrderId, averagePrice, volume));
+    }
+    void SendOrderFilled(unsigned long clientOrderId, unsigned long price, long volume) override
+    {
+        mEvents.push_back(event("filled", clientOrderId, price, volume));
+    }
+    void SendOrderStatus(unsigned long clientOrderId, long fillVolume, long remainingVolume, long fees) override
+    {
+        mEvents.push_back(event("status", clientOrderId, fillVolume, remainingVolume, fees));
+    }
+
+    Events mEvents;
+};
+
+// The occupied levels as "asks / bids", best first, e.g. "10000x7 / 9900x1".
+static std::string topLevels(const OrderBook& book)
+{
+    PriceLevels askPrices, bidPrices;
+    VolumeLevels askVolumes, bidVolumes;
+    book.TopLevels(askPrices, askVolumes, bidPrices, bidVolumes);
+
+    std::ostringstream out;
+    for (std::size_t i = 0; i < TOP_LEVEL_COUNT && askPrices[i]; ++i)
+    {
+        out << askPrices[i] << 'x' << askVolumes[i] << ' ';
+    }
+    out << '/';
+    for (std::size_t i = 0; i < TOP_LEVEL_COUNT && bidPrices[i]; ++i)
+    {
+        out << ' ' << bidPrices[i] << 'x' << bidVolumes[i];
+    }
+    return out.str();
+}
+
+struct SimulatorFixture
+{
+    SimulatorFixture()
+        : mEtfBook(Instrument::ETF, mConfig.mMakerFee, mConfig.mTakerFee, mConfig.mTickSize),
+          mFutureBook(Instrument::FUTURE, 0.0, 0.0, mConfig.mTickSize)
+    {
+    }
+
+    Order& Insert(OrderBook& book,
+                  unsigned long clientOrderId,
+                  Side side,
+                  unsigned long price,
+                  long volume,
+                  Lifespan lifespan = Lifespan::GOOD_FOR_DAY,
+                  IOrderListener* listener = nullptr)
+    {
+        Order& order = *mPool.Allocate();
+        order.mClientOrderId = clientOrderId;
+        order.mInstrument = book.GetInstrument();
+        order.mLifespan = lifespan;
+        order.mSide = side;
+        order.mPrice = price;
+        order.mVolume = order.mRemainingVolume = volume;
+        order.mListener = listener;
+        book.Insert(1, order);
+        return order;
+    }
+
+    Order& Insert(unsigned long clientOrderId,
+                  Side side,
+                  unsigned long price,
+                  long volume,
+                  Lifespan lifespan = Lifespan::GOOD_FOR_DAY)
+    {
+        return Insert(mEtfBook, clientOrderId, side, price, volume, lifespan, &mListener);
+    }
+
+    SimulatorConfig mConfig;
+    OrderPool mPool;
+    OrderBook mEtfBook;
+    OrderBook mFutureBook;
+    RecordingListener mListener;
+};
+
+BOOST_FIXTURE_TEST_SUITE(simulator, SimulatorFixture)
+
+// Maker fees are rounded half to even per fill, taker fees per level.
+BOOST_AUTO_TEST_CASE(fee_rounding)
+{
+    Order& a = Insert(1, Side::SELL, 7500, 1);
+    Order& b = Insert(2, Side::SELL, 12500, 1);
+    Order& c = Insert(3, Side::SELL, 12500, 3);
+    Order& d = Insert(4, Side::SELL, 12700, 5);
+    Order& e = Insert(10, Side::BUY, 12500, 5, Lifespan::FILL_AND_KILL);
+    Order& f = Insert(11, Side::BUY, 12700, 5, Lifespan::FILL_AND_KILL);
+
+    const Events expected{"placed 1", "placed 2", "placed 3", "placed 4",
+                          "filled 1 7500 1 -1", "filled 10 7500 1 2",
+                          "filled 2 12500 1 -1", "filled 3 12500 3 -4", "filled 10 12500 4 10",
+                          "filled 4 12700 5 -6", "filled 11 12700 5 13"};
+    BOOST_TEST(mListener.mEvents == expected, boost::test_tools::per_element());
+    BOOST_TEST(a.mTotalFees == -1);
+    BOOST_TEST(b.mTotalFees == -1);
+    BOOST_TEST(c.mTotalFees == -4);
+    BOOST_TEST(d.mTotalFees == -6);
+    BOOST_TEST(e.mTotalFees == 12);
+    BOOST_TEST(f.mTotalFees == 13);
+
+    // Exact halves: -2.5 and 2.5 both go to 2.
+    mListener.mEvents.clear();
+    Insert(5, Side::BUY, 5000, 5);
+    Insert(12, Side::SELL, 5000, 5, Lifespan::FILL_AND_KILL);
+    Insert(6, Side::BUY, 2500, 5);
+    Insert(13, Side::SELL, 2500, 5, Lifespan::FILL_AND_KILL);
+    const Events halves{"placed 5", "filled 5 5000 5 -2", "filled 12 5000 5 5",
+                        "placed 6", "filled 6 2500 5 -1", "filled 13 2500 5 2"};
+    BOOST_TEST(mListener.mEvents == halves, boost::test_tools::per_element());
+}
+
+// What a fill-and-kill order cannot trade is cancelled, never placed.
+BOOST_AUTO_TEST_CASE(fill_and_kill_remainder)
+{
+    Insert(1, Side::SELL, 10000, 2);
+    Insert(2, Side::SELL, 10100, 3);
+    Insert(3, Side::SELL, 10300, 4);
+    Insert(4, Side::BUY, 10100, 10, Lifespan::FILL_AND_KILL);
+    BOOST_TEST(topLevels(mEtfBook) == "10300x4 /");
+    Insert(5, Side::SELL, 9900, 1, Lifespan::FILL_AND_KILL);
+    Insert(6, Side::BUY, 10300, 6);
+
+    const Events expected{"placed 1", "placed 2", "placed 3",
+                          "filled 1 10000 2 -2", "filled 4 10000 2 4",
+                          "filled 2 10100 3 -3", "filled 4 10100 3 6", "cancelled 4 5",
+                          "cancelled 5 1",
+                          "filled 3 10300 4 -4", "filled 6 10300 4 8", "placed 6"};
+    BOOST_TEST(mListener.mEvents == expected, boost::test_tools::per_element());
+    BOOST_TEST(topLevels(mEtfBook) == "/ 10300x2");
+}
+
+// Amending below the filled volume removes only what remains, and the
+// orders queued behind keep their place.
+BOOST_AUTO_TEST_CASE(amend_below_filled)
+{
+    Order& order = Insert(1, Side::SELL, 10000, 10);
+    Insert(2, Side::SELL, 10000, 5);
+    Insert(3, Side::BUY, 10000, 6, Lifespan::FILL_AND_KILL);
+
+    mEtfBook.Amend(1, order, 8);
+    BOOST_TEST(topLevels(mEtfBook) == "10000x7 /");
+    BOOST_TEST(order.mVolume == 8);
+    BOOST_TEST(order.mRemainingVolume == 2);
+
+    mEtfBook.Amend(1, order, 3);
+    BOOST_TEST(topLevels(mEtfBook) == "10000x5 /");
+    BOOST_TEST(order.mVolume == 6);
+    BOOST_TEST(order.mRemainingVolume == 0);
+
+    mEtfBook.Amend(1, order, 1);
+    Insert(4, Side::BUY, 10000, 1, Lifespan::FILL_AND_KILL);
+
+    const Events expected{"placed 1", "placed 2",
+                          "filled 1 10000 6 -6", "filled 3 10000 6 12",
+                          "amended 1 2", "amended 1 2",
+                          "filled 2 10000 1 -1", "filled 4 10000 1 2"};
+    BOOST_TEST(mListener.mEvents == expected, boost::test_tools::per_element());
+    BOOST_TEST(topLevels(mEtfBook) == "10000x4 /");
+}
+
+// Trade ticks add up the volume traded at each price since the last call,
+// best five first: lowest asks and highest bids.
+BOOST_AUTO_TEST_CASE(trade_ticks)
+{
+    for (unsigned long i = 0; i < 7; ++i)
+    {
+        Insert(1 + i, Side::SELL, 10000 + 100 * i, 1);
+    }
+    Insert(8, Side::SELL, 10000, 1);
+    Insert(9, Side::BUY, 9900, 1);
+    Insert(10, Side::BUY, 9800, 2);
+    Insert(11, Side::BUY, 9700, 1);
+    Insert(20, Side::BUY, 10600, 8, Lifespan::FILL_AND_KILL);
+    Insert(21, Side::SELL, 9900, 1, Lifespan::FILL_AND_KILL);
+    Insert(22, Side::SELL, 9800, 1, Lifespan::FILL_AND_KILL);
+    Insert(23, Side::SELL, 9700, 2, Lifespan::FILL_AND_KILL);
+
+    PriceLevels askPrices, bidPrices;
+    VolumeLevels askVolumes, bidVolumes;
+    BOOST_REQUIRE(mEtfBook.TradeTicks(askPrices, askVolumes, bidPrices, bidVolumes));
+    const PriceLevels expectedAskPrices{Price(10000), Price(10100), Price(10200), Price(10300), Price(10400)};
+    const VolumeLevels expectedAskVolumes{Volume(2), Volume(1), Volume(1), Volume(1), Volume(1)};
+    const PriceLevels expectedBidPrices{Price(9900), Price(9800), Price(9700), Price(), Price()};
+    const VolumeLevels expectedBidVolumes{Volume(1), Volume(2), Volume(1), Volume(), Volume()};
+    BOOST_TEST(askPrices == expectedAskPrices, boost::test_tools::per_element());
+    BOOST_TEST(askVolumes == expectedAskVolumes, boost::test_tools::per_element());
+    BOOST_TEST(bidPrices == expectedBidPrices, boost::test_tools::per_element());
+    BOOST_TEST(bidVolumes == expectedBidVolumes, boost::test_tools::per_element());
+
+    BOOST_TEST(!mEtfBook.TradeTicks(askPrices, askVolumes, bidPrices, bidVolumes));
+    BOOST_TEST(topLevels(mEtfBook) == "/");
+}
+
+// Each request the exchange refuses gets its error message, checked in the
+// exchange's order.
+BOOST_AUTO_TEST_CASE(validation_messages)
+{
+    RecordingChannel channel;
+    Competitor competitor(channel, mEtfBook, mFutureBook, mPool, mConfig);
+    const auto invalidSide = static_cast<Side>(2);
+    const auto invalidLifespan = static_cast<Lifespan>(2);
+
+    competitor.OnInsertMessage(0, 1, Side::BUY, 10000, 1, Lifespan::GOOD_FOR_DAY);
+    competitor.OnInsertMessage(1, 1, Side::BUY, 10000, 1, Lifespan::GOOD_FOR_DAY);
+    competitor.OnInsertMessage(1, 2, invalidSide, 10000, 1, Lifespan::GOOD_FOR_DAY);
+    competitor.OnInsertMessage(1, 3, Side::BUY, 10000, 1, invalidLifespan);
+    competitor.OnInsertMessage(1, 4, Side::BUY, 0, 1, Lifespan::GOOD_FOR_DAY);
+    competitor.OnInsertMessage(1, 5, Side::BUY, 10050, 1, Lifespan::GOOD_FOR_DAY);
+    competitor.OnInsertMessage(1, 6, Side::BUY, 10000, 0, Lifespan::GOOD_FOR_DAY);
+    competitor.OnInsertMessage(1, 7, Side::BUY, 10000, 201, Lifespan::GOOD_FOR_DAY);
+    competitor.OnInsertMessage(1, 8, Side::BUY, 10000, 1, Lifespan::GOOD_FOR_DAY);
+    competitor.OnInsertMessage(1, 9, Side::SELL, 10000, 1, Lifespan::GOOD_FOR_DAY);
+    competitor.OnAmendMessage(1, 20, 1);
+    competitor.OnAmendMessage(1, 8, 2);
+    competitor.OnCancelMessage(1, 20);
+    competitor.OnHedgeMessage(1, 10, Side::BUY, 0, 1);
+    competitor.OnHedgeMessage(1, 11, Side::BUY, 10000, 0);
+    competitor.OnHedgeMessage(1, 12, Side::BUY, 10050, 1);
+    competitor.OnHedgeMessage(1, 13, invalidSide, 10000, 1);
+    competitor.OnHedgeMessage(0, 14, Side::BUY, 10000, 1);
+    competitor.OnHedgeMessage(1, 15, Side::BUY, 10000, 1);
+    for (unsigned long i = 0; i < 9; ++i)
+    {
+        competitor.OnInsertMessage(1, 16 + i, Side::BUY, 9000 - 100 * i, 1, Lifespan::GOOD_FOR_DAY);
+    }
+    competitor.OnInsertMessage(1, 25, Side::BUY, 8000, 1, Lifespan::GOOD_FOR_DAY);
+    competitor.OnInsertMessage(1, 26, Side::SELL, 11000, 1, Lifespan::GOOD_FOR_DAY);
+
+    Events expected{"error 1 order rejected: market not yet open",
+                    "error 1 duplicate or out-of-order client_order_id",
+                    "error 2 2 is not a valid side",
+                    "error 3 2 is not a valid lifespan",
+                    "error 4 0 is not a valid price",
+                    "error 5 price is not a multiple of tick size",
+                    "error 6 %d is not a valid volume",
+                    "error 7 order rejected: active order volume limit breached",
+                    "status 8 0 1 0",
+                    "error 9 order rejected: in cross with an existing order",
+                    "error 20 out-of-order client_order_id in amend message",
+                    "error 8 amend operation would increase order volume",
+                    "error 20 out-of-order client_order_id in cancel message",
+                    "error 10 0 is not a valid price",
+                    "error 11 0 is not a valid volume",
+                    "error 12 price is not a multiple of tick size",
+                    "error 13 2 is not a valid side",
+                    "error 14 order rejected: market not yet open",
+                    "error 15 order rejected: cannot determine future price"};
+    for (unsigned long id = 16; id <= 24; ++id)
+    {
+        expected.push_back(event("status", id, 0, 1, 0));
+    }
+    expected.push_back("error 25 order rejected: active order count limit breached");
+    expected.push_back("error 26 order rejected: active order count limit breached");
+    BOOST_TEST(channel.mEvents == expected, boost::test_tools::per_element());
+}
+
+// Fills, hedges and amends reach the competitor's account, which values its
+// ETF position at the ETF price clamped to a band around the future price.
+BOOST_AUTO_TEST_CASE(fills_and_etf_clamp)
+{
+    Insert(mFutureBook, 1000, Side::SELL, 100000, 1);
+    Insert(mFutureBook, 1001, Side::BUY, 100000, 1);
+    Insert(mFutureBook, 1002, Side::BUY, 99900, 5);
+    Insert(mFutureBook, 1003, Side::BUY, 99800, 5);
+    Insert(mEtfBook, 2000, Side::SELL, 101000, 3);
+
+    RecordingChannel channel;
+    Competitor competitor(channel, mEtfBook, mFutureBook, mPool, mConfig);
+    const CompetitorAccount& account = competitor.GetAccount();
+
+    competitor.OnInsertMessage(1, 1, Side::BUY, 101000, 2, Lifespan::GOOD_FOR_DAY);
+    BOOST_TEST(account.GetAccountBalance() == -202040);
+    BOOST_TEST(account.GetProfitOrLoss() == -1640.0);
+
+    competitor.OnInsertMessage(1, 2, Side::SELL, 101200, 4, Lifespan::GOOD_FOR_DAY);
+    Insert(mEtfBook, 2001, Side::BUY, 101200, 2, Lifespan::FILL_AND_KILL);
+    BOOST_TEST(account.GetAccountBalance() == -100830);
+    BOOST_TEST(account.GetProfitOrLoss() == -630.0);
+
+    competitor.OnHedgeMessage(1, 3, Side::SELL, 100, 7);
+    competitor.OnAmendMessage(1, 2, 1);
+
+    const Events expected{"filled 1 101000 2", "status 1 2 0 40",
+                          "status 2 0 4 0", "filled 2 101200 1", "status 2 1 3 -10",
+                          "hedge 3 99871 7",
+                          "status 2 1 0 -10"};
+    BOOST_TEST(channel.mEvents == expected, boost::test_tools::per_element());
+    BOOST_TEST(account.GetAccountBalance() == 598267);
+    BOOST_TEST(account.GetEtfPosition() == 1);
+    BOOST_TEST(account.GetFuturePosition() == -7);
+    BOOST_TEST(account.GetTotalFees() == 30);
+    BOOST_TEST(account.GetProfitOrLoss() == -1533.0);
+    BOOST_TEST(account.GetMaxProfit() == 0.0);
+    BOOST_TEST(account.GetMaxDrawdown() == 1640.0);
+    BOOST_TEST(competitor.GetActiveOrderCount() == 0U);
+}
+
+// The clamp's half-width is rounded half to even, then down to the tick.
+BOOST_AUTO_TEST_CASE(etf_clamp)
+{
+    struct Case
+    {
+        unsigned long mTickSize;
+        double mFuturePrice;
+        double mEtfPrice;
+        double mProfitOrLoss;
+    };
+    const Case cases[] = {{100, 123400, 130000, 43800},
+                          {100, 123400, 100000, 43000},
+                          {100, 123400, 123500, 43600},
+                          {1, 125250, 0, 44750},
+                          {1, 125250, 200000, 45750}};
+    for (const Case& c : cases)
+    {
+        CompetitorAccount account(c.mTickSize, mConfig.mEtfClamp);
+        account.Transact(Instrument::ETF, Side::BUY, 100000, 2, 0);
+        account.Transact(Instrument::FUTURE, Side::SELL, 120000, 1, 0);
+        account.Update(c.mFuturePrice, c.mEtfPrice);
+        BOOST_TEST(account.GetProfitOrLoss() == c.mProfitOrLoss);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,143 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/endian/conversion.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <ready_trader_go/connectivity.h>
+#include <ready_trader_go/journal.h>
+#include <ready_trader_go/protocol.h>
+#include <ready_trader_go/types.h>
+
+using namespace ReadyTraderGo;
+namespace interprocess = boost::interprocess;
+
+// An information file, and a subscription to it that journals what it
+// receives, with a mapping of the same file through which the test writes
+// frames as the exchange would.
+struct SubscriptionFixture
+{
+    SubscriptionFixture()
+    {
+        {
+            std::ofstream file(mFilename, std::ios::binary);
+            const std::vector<char> zeros(SUBSCRIPTION_TRANSPORT_BUFFER_SIZE);
+            file.write(zeros.data(), zeros.size());
+        }
+        interprocess::file_mapping file(mFilename.c_str(), interprocess::read_write);
+        interprocess::mapped_region region(file, interprocess::read_write);
+        mRing = interprocess::mapped_region(file, interprocess::read_write);
+        mSubscription = std::make_shared<Subscription>(mContext, file, region);
+        mSubscription->SetJournal(&mJournal);
+        mSubscription->MessageReceived = [this](ISubscription*, unsigned char type, unsigned char const*,
+                                                std::size_t) { mReceived.push_back(type); };
+        mSubscription->AsyncReceive();
+    }
+
+    ~SubscriptionFixture()
+    {
+        mSubscription.reset();
+        std::error_code error;
+        std::filesystem::remove(mFilename, error);
+        for (std::uint64_t n = 0; std::filesystem::remove(JournalSegmentFilename(mJournalName, n), error); ++n)
+        {
+        }
+    }
+
+    // Writes the message into the next frame, claiming the given payload
+    // size and message length, and publishes it.
+    void Publish(unsigned char messageType, const ISerialisable& message, std::uint32_t payloadSize,
+                 std::uint16_t messageLength)
+    {
+        auto* ring = static_cast<unsigned char*>(mRing.get_address());
+        unsigned char* frame = ring + mPosition;
+        unsigned char* payload = frame + FRAME_HEADER_SIZE;
+        *(std::uint16_t*)payload = boost::endian::native_to_big(messageLength);
+        payload[MESSAGE_TYPE_OFFSET] = messageType;
+        message.Serialise(payload + MESSAGE_HEADER_SIZE);
+        *(std::uint32_t*)(frame + FRAME_PAYLOAD_SIZE_OFFSET) = boost::endian::native_to_big(payloadSize);
+        mPosition += FRAME_SIZE;
+        __atomic_store_n(frame, 1, __ATOMIC_RELEASE);
+    }
+
+    void Publish(unsigned char messageType, const ISerialisable& message)
+    {
+        const std::size_t size = MESSAGE_HEADER_SIZE + message.Size();
+        Publish(messageType, message, static_cast<std::uint32_t>(size), static_cast<std::uint16_t>(size));
+    }
+
+    void Poll()
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            mContext.poll_one();
+        }
+    }
+
+    const std::string mFilename = (std::filesystem::temp_directory_path()
+                                   / ("subscriptiontests-" + std::to_string(getpid()) + ".dat")).string();
+    const std::string mJournalName = mFilename + ".journal";
+    boost::asio::io_context mContext;
+    Journal mJournal{mJournalName, 64 * 1024};
+    interprocess::mapped_region mRing;
+    std::shared_ptr<Subscription> mSubscription;
+    std::size_t mPosition = 0;
+    std::vector<unsigned char> mReceived;
+};
+
+BOOST_FIXTURE_TEST_SUITE(subscription, SubscriptionFixture)
+
+// A frame whose header claims more payload than a frame holds is counted as
+// malformed, and neither journalled nor handled; the next frame still is.
+BOOST_AUTO_TEST_CASE(oversized_payload)
+{
+    const OrderBookMessage book{Instrument::FUTURE, 1, {}, {}, {}, {}};
+    Publish(MessageType::ORDER_BOOK_UPDATE, book, 0xffffffff, MESSAGE_HEADER_SIZE + book.Size());
+    Publish(MessageType::ORDER_BOOK_UPDATE, OrderBookMessage{Instrument::FUTURE, 2, {}, {}, {}, {}});
+    Poll();
+
+    BOOST_TEST(mSubscription->GetCounters().mFrames == 2u);
+    BOOST_TEST(mSubscription->GetCounters().mMalformed == 1u);
+    BOOST_TEST(mJournal.GetRecordCount() == 1u);
+    BOOST_TEST(mReceived == std::vector<unsigned char>{MessageType::ORDER_BOOK_UPDATE},
+               boost::test_tools::per_element());
+}
+
+// A payload too short to hold a message header is malformed too, even when
+// the message claims the same length.
+BOOST_AUTO_TEST_CASE(payload_shorter_than_header)
+{
+    Publish(MessageType::ORDER_BOOK_UPDATE, OrderBookMessage{}, 0, 0);
+    Poll();
+
+    BOOST_TEST(mSubscription->GetCounters().mMalformed == 1u);
+    BOOST_TEST(mReceived.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()